@@ -0,0 +1,65 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Adjoint.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the tape and the elementary functions of adjoint algorithmic differentiation
+
+#include <cmath>
+#include "Adjoint.hpp"
+
+// Propagate the adjoints backwards from the output node
+void Tape::Propagate(TapeNode* output)
+{
+    if (!output)
+        return;
+
+    output->adjoint = 1.0;
+
+    // Walk the nodes from the last one, every node after the nodes it reads
+    for (std::size_t block = m_nodes.blocks(); block-- > 0;)
+    {
+        TapeNode* const first = m_nodes.begin(block);
+        for (TapeNode* node = m_nodes.end(block); node-- != first;)
+        {
+            const double adjoint = node->adjoint;
+            if (adjoint == 0.0)
+                continue;
+
+            for (long i = 0; i < node->arguments; ++i)
+                node->edges[i].node->adjoint += node->edges[i].partial * adjoint;
+        }
+    }
+}
+
+// Exponential
+AReal Exp(const AReal& x)
+{
+    const double value = std::exp(x.value());
+    return Recorded(value, x, value);
+}
+
+// Natural logarithm
+AReal Log(const AReal& x)
+{
+    return Recorded(std::log(x.value()), x, 1.0 / x.value());
+}
+
+// Square root
+AReal Sqrt(const AReal& x)
+{
+    const double value = std::sqrt(x.value());
+    return Recorded(value, x, 0.5 / value);
+}
+
+// Power of a positive base through exp(b * log(x)), so log(x) also gives d(x^b)/db = x^b * log(x)
+AReal Pow(const AReal& x, const AReal& b)
+{
+    const double log_x = std::log(x.value());
+    const double value = std::exp(b.value() * log_x);
+    return Recorded(value, x, b.value() * value / x.value(), b, value * log_x);
+}
+
+// Larger of two numbers
+AReal Max(const AReal& a, const AReal& b)
+{
+    return (a.value() < b.value()) ? b : a;
+}
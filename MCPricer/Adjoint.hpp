@@ -0,0 +1,282 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Adjoint.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the tape and the active numbers of adjoint algorithmic differentiation
+
+// If ADJOINT_HPP is not defined
+#ifndef ADJOINT_HPP
+// Define ADJOINT_HPP
+#define ADJOINT_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Define Arena class, storage handed out in contiguous runs by bumping a pointer through fixed-size blocks
+// Reset rewinds to the first block without freeing, so once the blocks cover the largest use nothing is allocated
+template <class T>
+class Arena
+{
+private:
+
+    // Number of elements of a block, the longest run that can be allocated
+    static const long block_size = 8192;
+
+    // Blocks, kept for the life of the arena
+    std::vector<std::unique_ptr<T[]> > m_blocks;
+    // Block being filled, its next free element and its end
+    std::size_t m_block;
+    T* m_next;
+    T* m_end;
+
+public:
+
+    // Constructor, an empty arena with one block
+    Arena() : m_blocks(), m_block(0), m_next(0), m_end(0)
+    {
+        m_blocks.emplace_back(new T[block_size]);
+        Reset();
+    }
+
+    // The runs point into the blocks, which can be neither copied nor assigned
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Rewind to the first block
+    void Reset()
+    {
+        m_block = 0;
+        m_next = m_blocks[0].get();
+        m_end = m_next + block_size;
+    }
+
+    // Allocate a run of count contiguous elements, count at most block_size, moving to the next block when
+    // the current one is full and creating it the first time it is reached
+    T* Allocate(const long& count)
+    {
+        if (m_end - m_next < count)
+        {
+            if (++m_block == m_blocks.size())
+                m_blocks.emplace_back(new T[block_size]);
+
+            m_next = m_blocks[m_block].get();
+            m_end = m_next + block_size;
+        }
+
+        T* run = m_next;
+        m_next += count;
+        return run;
+    }
+
+    // Get number of blocks in use
+    std::size_t blocks() const { return m_block + 1; }
+    // Get first element and end of the used part of block b
+    T* begin(const std::size_t& b) const { return m_blocks[b].get(); }
+    T* end(const std::size_t& b) const { return (b == m_block) ? m_next : m_blocks[b].get() + block_size; }
+    // Get number of elements the arena holds
+    long capacity() const { return static_cast<long>(m_blocks.size()) * block_size; }
+};
+
+struct TapeNode;
+
+// Define TapeEdge struct, an argument of a recorded operation and the partial derivative of the result with respect to it
+struct TapeEdge
+{
+    TapeNode* node;
+    double partial;
+};
+
+// Define TapeNode struct, one recorded operation: the adjoint of its result and the edges to its arguments
+struct TapeNode
+{
+    double adjoint;
+    long arguments;
+    TapeEdge* edges;
+};
+
+// Define Tape class, the record of the operations of a path for reverse-mode differentiation
+// The nodes and their edges live in two arenas that Reset rewinds, so the tape is reused from path to path
+// without allocating once it has held the longest one. Every thread records on its own tape (see Local)
+class Tape
+{
+private:
+
+    Arena<TapeNode> m_nodes;
+    Arena<TapeEdge> m_edges;
+
+public:
+
+    // Constructor, an empty tape
+    Tape() : m_nodes(), m_edges() {}
+
+    // The nodes point into the arenas, which can be neither copied nor assigned
+    Tape(const Tape&) = delete;
+    Tape& operator=(const Tape&) = delete;
+
+    // Get the tape of the calling thread
+    static Tape& Local()
+    {
+        static thread_local Tape tape;
+        return tape;
+    }
+
+    // Forget every recorded node, keeping the arenas
+    void Reset()
+    {
+        m_nodes.Reset();
+        m_edges.Reset();
+    }
+
+    // Record a node with a number of arguments, whose edges the caller fills
+    TapeNode* Record(const long& arguments)
+    {
+        TapeNode* node = m_nodes.Allocate(1);
+        node->adjoint = 0.0;
+        node->arguments = arguments;
+        node->edges = arguments ? m_edges.Allocate(arguments) : 0;
+        return node;
+    }
+
+    // Declare Propagate function, seeding the adjoint of output with 1 and propagating the adjoints backwards
+    // through every node recorded since the last Reset
+    void Propagate(TapeNode* output);
+
+    // Get number of nodes the tape holds without allocating
+    long capacity() const { return m_nodes.capacity(); }
+};
+
+// Define AReal class, an active number: its value and the tape node of its adjoint, null for a constant
+class AReal
+{
+private:
+
+    // Value
+    double m_value;
+    // Node of the tape of the calling thread, null for a constant
+    TapeNode* m_node;
+
+public:
+
+    // Constructor of a constant, implicit so that doubles mix with active numbers
+    AReal(const double& value = 0.0) : m_value(value), m_node(0) {}
+
+    // Constructor of a recorded result
+    AReal(const double& value, TapeNode* node) : m_value(value), m_node(node) {}
+
+    // Copy constructor
+    AReal(const AReal& source) : m_value(source.m_value), m_node(source.m_node) {}
+
+    // Assignment operator
+    AReal& operator=(const AReal& source)
+    {
+        // Check for self assignment
+        if (this == &source)
+            return *this;
+
+        m_value = source.m_value;
+        m_node = source.m_node;
+        return *this;
+    }
+
+    // Create an input, a node without arguments on the tape of the calling thread
+    static AReal Input(const double& value) { return AReal(value, Tape::Local().Record(0)); }
+
+    // Get value
+    const double& value() const { return m_value; }
+    // Get node, null for a constant
+    TapeNode* node() const { return m_node; }
+    // Get adjoint, the derivative of the propagated output with respect to this number (0 for a constant)
+    double adjoint() const { return m_node ? m_node->adjoint : 0.0; }
+};
+
+// Record the result of an operation of one argument, a constant when the argument is
+inline AReal Recorded(const double& value, const AReal& a, const double& da)
+{
+    if (!a.node())
+        return AReal(value);
+
+    TapeNode* node = Tape::Local().Record(1);
+    node->edges[0].node = a.node();
+    node->edges[0].partial = da;
+    return AReal(value, node);
+}
+
+// Record the result of an operation of two arguments, skipping the constant ones
+inline AReal Recorded(const double& value, const AReal& a, const double& da, const AReal& b, const double& db)
+{
+    if (!a.node())
+        return Recorded(value, b, db);
+    if (!b.node())
+        return Recorded(value, a, da);
+
+    TapeNode* node = Tape::Local().Record(2);
+    node->edges[0].node = a.node();
+    node->edges[0].partial = da;
+    node->edges[1].node = b.node();
+    node->edges[1].partial = db;
+    return AReal(value, node);
+}
+
+// Record the result of an operation of count arguments, skipping the constant ones, so that a whole expression
+// whose partial derivatives are known takes a single node
+inline AReal Recorded(const double& value, const long& count, const AReal* arguments, const double* partials)
+{
+    long active = 0;
+    for (long i = 0; i < count; ++i)
+        if (arguments[i].node()) ++active;
+
+    if (active == 0)
+        return AReal(value);
+
+    TapeNode* node = Tape::Local().Record(active);
+    TapeEdge* edge = node->edges;
+    for (long i = 0; i < count; ++i)
+    {
+        if (!arguments[i].node()) continue;
+        edge->node = arguments[i].node();
+        edge->partial = partials[i];
+        ++edge;
+    }
+
+    return AReal(value, node);
+}
+
+// Record the result of an operation of count arguments that are all active on a given tape, for the hot loops
+// that hold the tape of their thread: neither the thread-local lookup nor the scan for constants is repeated
+inline AReal Recorded(Tape& tape, const double& value, const long& count, const AReal* arguments, const double* partials)
+{
+    TapeNode* node = tape.Record(count);
+    for (long i = 0; i < count; ++i)
+    {
+        node->edges[i].node = arguments[i].node();
+        node->edges[i].partial = partials[i];
+    }
+
+    return AReal(value, node);
+}
+
+// Arithmetic of active numbers, each operation recording one node at most
+inline AReal operator+(const AReal& a, const AReal& b) { return Recorded(a.value() + b.value(), a, 1.0, b, 1.0); }
+inline AReal operator-(const AReal& a, const AReal& b) { return Recorded(a.value() - b.value(), a, 1.0, b, -1.0); }
+inline AReal operator-(const AReal& a) { return Recorded(-a.value(), a, -1.0); }
+inline AReal operator*(const AReal& a, const AReal& b)
+{
+    return Recorded(a.value() * b.value(), a, b.value(), b, a.value());
+}
+inline AReal operator/(const AReal& a, const AReal& b)
+{
+    const double quotient = a.value() / b.value();
+    return Recorded(quotient, a, 1.0 / b.value(), b, -quotient / b.value());
+}
+
+// Declare the elementary functions of active numbers (defined in Adjoint.cpp)
+AReal Exp(const AReal& x);
+AReal Log(const AReal& x);
+AReal Sqrt(const AReal& x);
+// Power of a positive base, with both the base and the exponent active
+AReal Pow(const AReal& x, const AReal& b);
+// Larger of two numbers, the derivative following the larger one
+AReal Max(const AReal& a, const AReal& b);
+
+// End of the conditional inclusion of the header file
+#endif
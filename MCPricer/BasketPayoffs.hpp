@@ -0,0 +1,134 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BasketPayoffs.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the multi-asset payoff policies evaluated by MultiAssetMonteCarlo::PricePayoff
+
+// If BASKETPAYOFFS_HPP is not defined
+#ifndef BASKETPAYOFFS_HPP
+// Define BASKETPAYOFFS_HPP
+#define BASKETPAYOFFS_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Payoffs.hpp"
+
+// A basket payoff policy is any copyable type with a const Assets() member, the number of assets it reads from the
+// first one, and a const call operator taking the terminal spots of the assets of a path.
+
+// Define BasketPayoff policy, a call or put on a weighted sum of the assets
+struct BasketPayoff
+{
+    // +1 for a call, -1 for a put
+    double phi;
+    // Strike price
+    double K;
+    // Weight of every asset
+    std::vector<double> weights;
+
+    BasketPayoff(const std::string& type, const std::vector<double>& asset_weights, const double& strike)
+        : phi(PayoffSign(type, "BasketPayoff")), K(strike), weights(asset_weights) {}
+
+    long Assets() const { return static_cast<long>(weights.size()); }
+
+    double operator()(const double* ST) const
+    {
+        double basket = 0.0;
+        for (std::size_t i = 0; i < weights.size(); ++i)
+            basket += weights[i] * ST[i];
+
+        const double value = phi * (basket - K);
+        return (value > 0.0) ? value : 0.0;
+    }
+};
+
+// Define SpreadPayoff policy, a call or put on the difference of two assets
+struct SpreadPayoff
+{
+    // +1 for a call, -1 for a put
+    double phi;
+    // Strike price
+    double K;
+    // Assets long and short in the spread
+    long first;
+    long second;
+
+    SpreadPayoff(const std::string& type, const long& long_asset, const long& short_asset, const double& strike = 0.0)
+        : phi(PayoffSign(type, "SpreadPayoff")), K(strike), first(long_asset), second(short_asset)
+    {
+        if (long_asset < 0 || short_asset < 0)
+            throw std::invalid_argument("SpreadPayoff: asset indices must be non-negative");
+    }
+
+    long Assets() const { return ((first > second) ? first : second) + 1; }
+
+    double operator()(const double* ST) const
+    {
+        const double value = phi * (ST[first] - ST[second] - K);
+        return (value > 0.0) ? value : 0.0;
+    }
+};
+
+// Define BestOfPayoff policy, a call or put on the best of the first assets
+struct BestOfPayoff
+{
+    // +1 for a call, -1 for a put
+    double phi;
+    // Strike price
+    double K;
+    // Number of assets
+    long assets;
+
+    BestOfPayoff(const std::string& type, const long& n_assets, const double& strike)
+        : phi(PayoffSign(type, "BestOfPayoff")), K(strike), assets(n_assets)
+    {
+        if (n_assets < 1)
+            throw std::invalid_argument("BestOfPayoff: at least one asset is needed");
+    }
+
+    long Assets() const { return assets; }
+
+    double operator()(const double* ST) const
+    {
+        double best = ST[0];
+        for (long i = 1; i < assets; ++i)
+            best = (ST[i] > best) ? ST[i] : best;
+
+        const double value = phi * (best - K);
+        return (value > 0.0) ? value : 0.0;
+    }
+};
+
+// Define WorstOfPayoff policy, a call or put on the worst of the first assets
+struct WorstOfPayoff
+{
+    // +1 for a call, -1 for a put
+    double phi;
+    // Strike price
+    double K;
+    // Number of assets
+    long assets;
+
+    WorstOfPayoff(const std::string& type, const long& n_assets, const double& strike)
+        : phi(PayoffSign(type, "WorstOfPayoff")), K(strike), assets(n_assets)
+    {
+        if (n_assets < 1)
+            throw std::invalid_argument("WorstOfPayoff: at least one asset is needed");
+    }
+
+    long Assets() const { return assets; }
+
+    double operator()(const double* ST) const
+    {
+        double worst = ST[0];
+        for (long i = 1; i < assets; ++i)
+            worst = (ST[i] < worst) ? ST[i] : worst;
+
+        const double value = phi * (worst - K);
+        return (value > 0.0) ? value : 0.0;
+    }
+};
+
+// End of the conditional inclusion of the header file
+#endif
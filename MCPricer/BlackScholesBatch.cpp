@@ -0,0 +1,153 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BlackScholesBatch.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the scalar batch Black - Scholes - Merton kernel, its runtime selection and the book containers
+
+#include <algorithm>
+#include <stdexcept>
+#include "BlackScholesBatch.hpp"
+#include "BlackScholesBatchImpl.hpp"
+#include "Payoffs.hpp"
+
+// Number of options priced together by one chunk of the thread pool, large enough to stream the arrays at memory bandwidth
+static const long book_chunk = 4096;
+
+// Append an option to the book
+void OptionBook::Add(const EuropeanOption& option)
+{
+    phi.push_back(PayoffSign(option.type(), "OptionBook"));
+    T.push_back(option.T());
+    K.push_back(option.K());
+    S.push_back(option.S());
+    r.push_back(option.r());
+    sigma.push_back(option.sigma());
+    b.push_back(option.b());
+}
+
+// Reserve room for a number of options
+void OptionBook::Reserve(const std::size_t& n)
+{
+    phi.reserve(n);
+    T.reserve(n);
+    K.reserve(n);
+    S.reserve(n);
+    r.reserve(n);
+    sigma.reserve(n);
+    b.reserve(n);
+}
+
+// Get the raw arrays of the book
+BookArrays OptionBook::Arrays() const
+{
+    BookArrays arrays = { phi.data(), T.data(), K.data(), S.data(), r.data(), sigma.data(), b.data() };
+    return arrays;
+}
+
+// Resize every array to a number of options
+void GreeksBook::Resize(const std::size_t& n)
+{
+    price.resize(n);
+    delta.resize(n);
+    gamma.resize(n);
+    vega.resize(n);
+    theta.resize(n);
+    rho.resize(n);
+    vanna.resize(n);
+    charm.resize(n);
+    speed.resize(n);
+    color.resize(n);
+    dvega_dtime.resize(n);
+    vomma.resize(n);
+    veta.resize(n);
+    zomma.resize(n);
+    lambda.resize(n);
+    ultima.resize(n);
+}
+
+// Get the raw arrays of the Greeks
+GreeksArrays GreeksBook::Arrays()
+{
+    GreeksArrays arrays = { price.data(), delta.data(), gamma.data(), vega.data(), theta.data(), rho.data(),
+        vanna.data(), charm.data(), speed.data(), color.data(), dvega_dtime.data(), vomma.data(), veta.data(),
+        zomma.data(), lambda.data(), ultima.data() };
+    return arrays;
+}
+
+// Resize every array to a number of quotes
+void ImpliedVolBook::Resize(const std::size_t& n)
+{
+    vol.resize(n);
+    converged.resize(n);
+}
+
+// Get the raw arrays of the implied volatilities
+ImpliedVolArrays ImpliedVolBook::Arrays()
+{
+    ImpliedVolArrays arrays = { vol.data(), converged.data() };
+    return arrays;
+}
+
+// Scalar fallback, used when the CPU has no AVX2
+const BookKernels& BookKernelsScalar()
+{
+    static const BookKernels kernels = MakeBookKernels<ScalarVector>();
+    return kernels;
+}
+
+// Get the kernel table of an instruction set, falling back to the widest one the CPU supports
+const BookKernels& SelectBookKernels(const SimdLevel& level)
+{
+#if defined(MCPRICER_X86)
+    // Never select an instruction set the CPU cannot run
+    const SimdLevel supported = DetectSimdLevel();
+    const SimdLevel selected = (level < supported) ? level : supported;
+
+    if (selected == SimdLevel::AVX512) return BookKernelsAVX512();
+    if (selected == SimdLevel::AVX2) return BookKernelsAVX2();
+#endif
+    return BookKernelsScalar();
+}
+
+// Price every option of a book with its Greeks
+void PriceBook(const OptionBook& book, GreeksBook& greeks, const SimdLevel& level, const Priority& priority)
+{
+    const long n = static_cast<long>(book.size());
+    greeks.Resize(book.size());
+
+    const BookKernel kernel = SelectBookKernels(level).greeks;
+    const BookArrays in = book.Arrays();
+    const GreeksArrays out = greeks.Arrays();
+
+    // Every chunk writes its own slice of the output arrays
+    const long n_chunks = (n + book_chunk - 1) / book_chunk;
+
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        const long first = c * book_chunk;
+        kernel(in, out, first, std::min(book_chunk, n - first));
+    }, priority);
+}
+
+// Solve the implied volatility of every quote of a book
+void ImpliedVolatility(const OptionBook& book, const std::vector<double>& prices, ImpliedVolBook& vols,
+    const SimdLevel& level, const Priority& priority)
+{
+    if (prices.size() != book.size())
+        throw std::invalid_argument("ImpliedVolatility: one market price is needed per option of the book");
+
+    const long n = static_cast<long>(book.size());
+    vols.Resize(book.size());
+
+    const ImpliedVolKernel kernel = SelectBookKernels(level).implied_vol;
+    const BookArrays in = book.Arrays();
+    const ImpliedVolArrays out = vols.Arrays();
+
+    // Every chunk writes its own slice of the output arrays
+    const long n_chunks = (n + book_chunk - 1) / book_chunk;
+
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        const long first = c * book_chunk;
+        kernel(in, prices.data(), out, first, std::min(book_chunk, n - first));
+    }, priority);
+}
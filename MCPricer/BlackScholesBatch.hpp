@@ -0,0 +1,170 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BlackScholesBatch.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the batch Black - Scholes - Merton pricer over option books
+
+// If BLACKSCHOLESBATCH_HPP is not defined
+#ifndef BLACKSCHOLESBATCH_HPP
+// Define BLACKSCHOLESBATCH_HPP
+#define BLACKSCHOLESBATCH_HPP
+
+#include <vector>
+#include "CpuFeatures.hpp"
+#include "EuropeanOption.hpp"
+#include "ThreadPool.hpp"
+
+// Raw input arrays of an option book, one value per option
+struct BookArrays
+{
+    // +1 for calls and -1 for puts
+    const double* phi;
+    const double* T;
+    const double* K;
+    const double* S;
+    const double* r;
+    const double* sigma;
+    const double* b;
+};
+
+// Raw output arrays of the price and the Greeks, one value per option
+// Time derivatives are taken with respect to calendar time (minus the derivative with respect to T), except Veta,
+// and Rho moves the cost of carry with the rate, as EuropeanOption::Rho does
+struct GreeksArrays
+{
+    double* price;
+    // dV/dS, d2V/dS2, dV/dsigma, -dV/dT and dV/dr
+    double* delta;
+    double* gamma;
+    double* vega;
+    double* theta;
+    double* rho;
+    // d2V/dSdsigma, -dDelta/dT, d3V/dS3 and -dGamma/dT
+    double* vanna;
+    double* charm;
+    double* speed;
+    double* color;
+    // -dVega/dT, d2V/dsigma2, dVega/dT and dGamma/dsigma
+    double* dvega_dtime;
+    double* vomma;
+    double* veta;
+    double* zomma;
+    // Elasticity Delta * S / V and d3V/dsigma3
+    double* lambda;
+    double* ultima;
+};
+
+// Raw output arrays of the implied volatility solver, one value per quote
+struct ImpliedVolArrays
+{
+    // Implied volatility, NaN for prices outside the no-arbitrage bounds
+    double* vol;
+    // 1 when the solver met its tolerance, 0 otherwise
+    unsigned char* converged;
+};
+
+// Define OptionBook struct, a book of European options in structure-of-arrays layout
+struct OptionBook
+{
+    std::vector<double> phi;
+    std::vector<double> T;
+    std::vector<double> K;
+    std::vector<double> S;
+    std::vector<double> r;
+    std::vector<double> sigma;
+    std::vector<double> b;
+
+    // Append an option, its type is compared once here instead of in every Greek and must be Call or Put
+    void Add(const EuropeanOption& option);
+
+    // Reserve room for a number of options
+    void Reserve(const std::size_t& n);
+
+    // Number of options
+    std::size_t size() const { return phi.size(); }
+
+    // Get the raw arrays
+    BookArrays Arrays() const;
+};
+
+// Define GreeksBook struct, the price and the 15 Greeks of every option of a book
+struct GreeksBook
+{
+    std::vector<double> price;
+    std::vector<double> delta;
+    std::vector<double> gamma;
+    std::vector<double> vega;
+    std::vector<double> theta;
+    std::vector<double> rho;
+    std::vector<double> vanna;
+    std::vector<double> charm;
+    std::vector<double> speed;
+    std::vector<double> color;
+    std::vector<double> dvega_dtime;
+    std::vector<double> vomma;
+    std::vector<double> veta;
+    std::vector<double> zomma;
+    std::vector<double> lambda;
+    std::vector<double> ultima;
+
+    // Resize every array to a number of options
+    void Resize(const std::size_t& n);
+
+    // Get the raw arrays
+    GreeksArrays Arrays();
+};
+
+// Define ImpliedVolBook struct, the implied volatility of every quote of a book and its convergence flag
+struct ImpliedVolBook
+{
+    std::vector<double> vol;
+    std::vector<unsigned char> converged;
+
+    // Resize every array to a number of quotes
+    void Resize(const std::size_t& n);
+
+    // Get the raw arrays
+    ImpliedVolArrays Arrays();
+};
+
+// Kernel signature: price options [first, first + n) of a book with all their Greeks
+typedef void (*BookKernel)(const BookArrays& in, const GreeksArrays& out, const long& first, const long& n);
+
+// Kernel signature: solve the implied volatilities of quotes [first, first + n) of a book from their market prices
+// (the volatilities of the book are ignored)
+typedef void (*ImpliedVolKernel)(const BookArrays& in, const double* prices, const ImpliedVolArrays& out,
+    const long& first, const long& n);
+
+// Define BookKernels struct, the batch kernels compiled for one instruction set
+struct BookKernels
+{
+    // Price and Greeks
+    BookKernel greeks;
+    // Implied volatility
+    ImpliedVolKernel implied_vol;
+};
+
+// Kernel tables of every instruction set
+const BookKernels& BookKernelsScalar();
+#if defined(MCPRICER_X86)
+const BookKernels& BookKernelsAVX2();
+const BookKernels& BookKernelsAVX512();
+#endif
+
+// Get the kernel table of an instruction set, falling back to the widest one the CPU supports
+const BookKernels& SelectBookKernels(const SimdLevel& level);
+
+// Price every option of a book and compute its 15 Greeks in one fused pass, sharing d1, d2, the normal density
+// and the discount factors, in parallel over fixed chunks of options on the shared thread pool
+void PriceBook(const OptionBook& book, GreeksBook& greeks, const SimdLevel& level = DetectSimdLevel(),
+    const Priority& priority = Priority::Normal);
+
+// Solve the implied volatility of every quote of a book from its discounted market price, in parallel over fixed chunks:
+// a Corrado - Miller rational initial guess refined by Householder steps of third order with the analytic Vega, Vomma
+// and Ultima, kept inside a bracket by bisection, until the volatility moves less than 1e-12 (relative).
+// A quote is only flagged as converged if a few ulps of its forward and strike move its volatility by less than 1e-6
+// (relative); a time value below that resolution, as for a quote at its intrinsic value, has a NaN volatility
+void ImpliedVolatility(const OptionBook& book, const std::vector<double>& prices, ImpliedVolBook& vols,
+    const SimdLevel& level = DetectSimdLevel(), const Priority& priority = Priority::Normal);
+
+// End of the conditional inclusion of the header file
+#endif
@@ -0,0 +1,41 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BlackScholesBatchAVX2.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the AVX2 batch Black - Scholes - Merton kernels, compiled for AVX2 regardless of the project settings
+
+#include "CpuFeatures.hpp"
+
+#if defined(MCPRICER_X86)
+
+// Include the standard headers and the book containers before enabling AVX2, so no shared inline code is compiled for it
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "BlackScholesBatch.hpp"
+
+// Enable AVX2 for the rest of this translation unit (MSVC accepts the intrinsics without flags)
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#define MCPRICER_SIMD_AVX2
+#include "BlackScholesBatchImpl.hpp"
+
+// AVX2 kernels, only selected when DetectSimdLevel reports AVX2
+const BookKernels& BookKernelsAVX2()
+{
+    static const BookKernels kernels = MakeBookKernels<Avx2Vector>();
+    return kernels;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BlackScholesBatchAVX512.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the AVX-512 batch Black - Scholes - Merton kernels, compiled for AVX-512 regardless of the project settings
+
+#include "CpuFeatures.hpp"
+
+#if defined(MCPRICER_X86)
+
+// Include the standard headers and the book containers before enabling AVX-512, so no shared inline code is compiled for it
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "BlackScholesBatch.hpp"
+
+// Enable AVX-512 for the rest of this translation unit (MSVC accepts the intrinsics without flags)
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+#define MCPRICER_SIMD_AVX512
+#include "BlackScholesBatchImpl.hpp"
+
+// AVX-512 kernels, only selected when DetectSimdLevel reports AVX-512
+const BookKernels& BookKernelsAVX512()
+{
+    static const BookKernels kernels = MakeBookKernels<Avx512Vector>();
+    return kernels;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
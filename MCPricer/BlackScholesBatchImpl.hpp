@@ -0,0 +1,317 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BlackScholesBatchImpl.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the generic body of the batch Black - Scholes - Merton kernel, included once per instruction set
+
+// If BLACKSCHOLESBATCHIMPL_HPP is not defined
+#ifndef BLACKSCHOLESBATCHIMPL_HPP
+// Define BLACKSCHOLESBATCHIMPL_HPP
+#define BLACKSCHOLESBATCHIMPL_HPP
+
+#include <limits>
+#include "BlackScholesBatch.hpp"
+#include "SimdMath.hpp"
+
+// Price the V::width options starting at i with every Greek
+// Only the type sign phi distinguishes calls from puts: V = phi * (S * e^((b - r) T) * N(phi * d1) - K * e^(-rT) * N(phi * d2))
+template <class V>
+inline void PriceBookLanes(const BookArrays& in, const GreeksArrays& out, const long& i)
+{
+    typedef typename V::Real Real;
+    typedef SimdMath<V> M;
+
+    const Real phi = V::Load(in.phi + i);
+    const Real T = V::Load(in.T + i);
+    const Real K = V::Load(in.K + i);
+    const Real S = V::Load(in.S + i);
+    const Real r = V::Load(in.r + i);
+    const Real sigma = V::Load(in.sigma + i);
+    const Real b = V::Load(in.b + i);
+
+    const Real half = V::Set(0.5);
+    const Real one = V::Set(1.0);
+
+    // Shared terms: sigma * sqrt(T), d1, d2 and their products
+    const Real sqrt_T = V::Sqrt(T);
+    const Real vol = V::Mul(sigma, sqrt_T);
+    const Real d1 = V::Div(V::MulAdd(V::MulAdd(V::Mul(half, sigma), sigma, b), T, M::Log(V::Div(S, K))), vol);
+    const Real d2 = V::Sub(d1, vol);
+    const Real d1d2 = V::Mul(d1, d2);
+
+    // Discount factors, the forward value of the spot and the discounted strike
+    const Real carry = V::Sub(b, r);
+    const Real eb = M::Exp(V::Mul(carry, T));
+    const Real er = M::Exp(V::Mul(V::Sub(V::Set(0.0), r), T));
+    const Real Fs = V::Mul(S, eb);
+    const Real Kd = V::Mul(K, er);
+
+    // One density and two distribution evaluations for all the Greeks
+    const Real n = M::NormalPdf(d1);
+    const Real Nd1 = M::NormalCdf(V::Mul(phi, d1));
+    const Real Nd2 = M::NormalCdf(V::Mul(phi, d2));
+
+    const Real inv_sigma = V::Div(one, sigma);
+    const Real inv_2T = V::Div(half, T);
+    const Real b_d1_vol = V::Div(V::Mul(b, d1), vol);
+    const Real r_minus_b = V::Sub(r, b);
+
+    const Real price = V::Mul(phi, V::Sub(V::Mul(Fs, Nd1), V::Mul(Kd, Nd2)));
+    const Real delta = V::Mul(phi, V::Mul(eb, Nd1));
+    const Real gamma = V::Div(V::Mul(eb, n), V::Mul(S, vol));
+    const Real vega = V::Mul(V::Mul(Fs, n), sqrt_T);
+
+    // Theta = -Fs * n * sigma / (2 sqrt(T)) - phi * (b - r) * Fs * N(phi d1) - phi * r * Kd * N(phi d2)
+    const Real theta = V::Sub(V::Sub(V::Sub(V::Set(0.0), V::Div(V::Mul(V::Mul(Fs, n), V::Mul(half, sigma)), sqrt_T)),
+        V::Mul(V::Mul(phi, carry), V::Mul(Fs, Nd1))), V::Mul(V::Mul(phi, r), V::Mul(Kd, Nd2)));
+    const Real rho = V::Mul(V::Mul(phi, T), V::Mul(Kd, Nd2));
+
+    // dd1/dT = b / (sigma sqrt(T)) - d2 / (2T)
+    const Real d1_T = V::Sub(V::Div(b, vol), V::Mul(d2, inv_2T));
+
+    const Real vanna = V::Sub(V::Set(0.0), V::Mul(V::Mul(eb, n), V::Mul(d2, inv_sigma)));
+    const Real charm = V::Sub(V::Set(0.0), V::MulAdd(carry, delta, V::Mul(V::Mul(eb, n), d1_T)));
+    const Real speed = V::Sub(V::Set(0.0), V::Mul(V::Div(gamma, S), V::Add(one, V::Div(d1, vol))));
+    const Real color = V::Mul(gamma, V::Add(V::Add(r_minus_b, b_d1_vol), V::Mul(V::Sub(one, d1d2), inv_2T)));
+    const Real dvega_dtime = V::Mul(vega, V::Sub(V::Add(r_minus_b, b_d1_vol), V::Mul(V::Add(one, d1d2), inv_2T)));
+    const Real vomma = V::Mul(vega, V::Mul(d1d2, inv_sigma));
+    const Real veta = V::Sub(V::Set(0.0), dvega_dtime);
+    const Real zomma = V::Mul(gamma, V::Mul(V::Sub(d1d2, one), inv_sigma));
+    const Real lambda = V::Div(V::Mul(delta, S), price);
+
+    // Ultima = -Vega / sigma^2 * (d1 d2 (1 - d1 d2) + d1^2 + d2^2)
+    const Real ultima_terms = V::MulAdd(d1d2, V::Sub(one, d1d2), V::MulAdd(d1, d1, V::Mul(d2, d2)));
+    const Real ultima = V::Sub(V::Set(0.0), V::Mul(V::Mul(vega, V::Mul(inv_sigma, inv_sigma)), ultima_terms));
+
+    V::Store(out.price + i, price);
+    V::Store(out.delta + i, delta);
+    V::Store(out.gamma + i, gamma);
+    V::Store(out.vega + i, vega);
+    V::Store(out.theta + i, theta);
+    V::Store(out.rho + i, rho);
+    V::Store(out.vanna + i, vanna);
+    V::Store(out.charm + i, charm);
+    V::Store(out.speed + i, speed);
+    V::Store(out.color + i, color);
+    V::Store(out.dvega_dtime + i, dvega_dtime);
+    V::Store(out.vomma + i, vomma);
+    V::Store(out.veta + i, veta);
+    V::Store(out.zomma + i, zomma);
+    V::Store(out.lambda + i, lambda);
+    V::Store(out.ultima + i, ultima);
+}
+
+// Price options [first, first + n) of a book, full vectors first and the remainder through padded staging arrays,
+// so every lane goes through the same instructions of V
+template <class V>
+void PriceBookBlock(const BookArrays& in, const GreeksArrays& out, const long& first, const long& n)
+{
+    const long end = first + n;
+    long i = first;
+
+    for (; i + V::width <= end; i += V::width)
+        PriceBookLanes<V>(in, out, i);
+
+    if (i == end)
+        return;
+
+    // Pad the remainder with an at-the-money call, whose Greeks are finite, and copy back the valid lanes
+    const long count = end - i;
+    double staged_in[7][V::width];
+    double staged_out[16][V::width];
+
+    for (long j = 0; j < V::width; ++j)
+    {
+        const bool valid = j < count;
+        staged_in[0][j] = valid ? in.phi[i + j] : 1.0;
+        staged_in[1][j] = valid ? in.T[i + j] : 1.0;
+        staged_in[2][j] = valid ? in.K[i + j] : 1.0;
+        staged_in[3][j] = valid ? in.S[i + j] : 1.0;
+        staged_in[4][j] = valid ? in.r[i + j] : 0.0;
+        staged_in[5][j] = valid ? in.sigma[i + j] : 1.0;
+        staged_in[6][j] = valid ? in.b[i + j] : 0.0;
+    }
+
+    const BookArrays staged_book = { staged_in[0], staged_in[1], staged_in[2], staged_in[3], staged_in[4],
+        staged_in[5], staged_in[6] };
+    const GreeksArrays staged_greeks = { staged_out[0], staged_out[1], staged_out[2], staged_out[3], staged_out[4],
+        staged_out[5], staged_out[6], staged_out[7], staged_out[8], staged_out[9], staged_out[10], staged_out[11],
+        staged_out[12], staged_out[13], staged_out[14], staged_out[15] };
+    PriceBookLanes<V>(staged_book, staged_greeks, 0);
+
+    double* const outputs[16] = { out.price, out.delta, out.gamma, out.vega, out.theta, out.rho, out.vanna, out.charm,
+        out.speed, out.color, out.dvega_dtime, out.vomma, out.veta, out.zomma, out.lambda, out.ultima };
+    for (int k = 0; k < 16; ++k)
+        for (long j = 0; j < count; ++j)
+            outputs[k][i + j] = staged_out[k][j];
+}
+
+// Solve the implied volatilities of the V::width quotes starting at i, on forward prices so calls and puts share the algorithm:
+// p(sigma) = phi * (F * N(phi * d1) - K * N(phi * d2)) with F = S * e^(bT) and p the market price times e^(rT).
+// In-the-money quotes are solved on their out-of-the-money counterpart from put - call parity, whose price is the time value.
+// Prices are only resolved to a few ulps of the forward and the strike: a time value below that resolution has no
+// volatility (NaN), and a volatility that the resolution moves by more than 1e-6 (relative) is flagged as not converged
+template <class V>
+inline void ImpliedVolLanes(const BookArrays& in, const double* prices, double* vol_out, double* converged_out, const long& i)
+{
+    typedef typename V::Real Real;
+    typedef typename V::Mask Mask;
+    typedef SimdMath<V> M;
+
+    const Real T = V::Load(in.T + i);
+    const Real K = V::Load(in.K + i);
+    const Real S = V::Load(in.S + i);
+    const Real r = V::Load(in.r + i);
+    const Real b = V::Load(in.b + i);
+
+    const Real zero = V::Set(0.0);
+    const Real half = V::Set(0.5);
+    const Real one = V::Set(1.0);
+
+    // Forward and undiscounted quoted price
+    const Real sqrt_T = V::Sqrt(T);
+    const Real F = V::Mul(S, M::Exp(V::Mul(b, T)));
+    const Real quoted = V::Mul(V::Load(prices + i), M::Exp(V::Mul(r, T)));
+    const Real log_FK = M::Log(V::Div(F, K));
+
+    // Switch in-the-money quotes to the out-of-the-money option: p = quoted - phi * (F - K) and phi = -phi
+    const Real quoted_phi = V::Load(in.phi + i);
+    const Real moneyness = V::Mul(quoted_phi, V::Sub(F, K));
+    const Mask in_the_money = V::Less(zero, moneyness);
+    const Real phi = V::Select(in_the_money, V::Sub(zero, quoted_phi), quoted_phi);
+    const Real p = V::Select(in_the_money, V::Sub(quoted, moneyness), quoted);
+
+    // Rounding of the out-of-the-money price, a few ulps of the forward and the strike it was computed from
+    const Real resolution = V::Mul(V::Set(4.0 * std::numeric_limits<double>::epsilon()), V::Max(F, K));
+
+    // No-arbitrage bounds of the out-of-the-money price: above its rounding (a quote at its intrinsic value has no
+    // volatility), below the forward for calls and the strike for puts
+    const Real upper = V::Select(V::Less(zero, phi), F, K);
+    const Mask inside = V::MaskAnd(V::Less(resolution, p), V::Less(p, upper));
+
+    // Corrado - Miller: sigma * sqrt(T) = sqrt(2 pi) / (F + K) * (c - (F - K) / 2 + sqrt((c - (F - K) / 2)^2 - (F - K)^2 / pi))
+    // with the call price c from put - call parity
+    const Real c = V::Select(V::Less(zero, phi), p, V::Add(p, V::Sub(F, K)));
+    const Real m = V::Sub(c, V::Mul(half, V::Sub(F, K)));
+    const Real FK2 = V::Mul(V::Sub(F, K), V::Sub(F, K));
+    const Real root = V::Sqrt(V::Max(V::Sub(V::Mul(m, m), V::Mul(V::Set(0.31830988618379067), FK2)), zero));
+    const Real guess = V::Div(V::Mul(V::Set(2.5066282746310002), V::Add(m, root)), V::Mul(V::Add(F, K), sqrt_T));
+
+    Real sigma = V::Min(V::Max(guess, V::Set(0.01)), V::Set(3.0));
+    Real lo = zero;
+    Real hi = V::Set(10.0);
+    Real done = zero;
+
+    for (int iteration = 0; iteration < 64; ++iteration)
+    {
+        const Real vol = V::Mul(sigma, sqrt_T);
+        const Real d1 = V::Add(V::Div(log_FK, vol), V::Mul(half, vol));
+        const Real d2 = V::Sub(d1, vol);
+        const Real f = V::Sub(V::Mul(phi, V::Sub(V::Mul(F, M::NormalCdf(V::Mul(phi, d1))), V::Mul(K, M::NormalCdf(V::Mul(phi, d2))))), p);
+        const Real vega = V::Mul(V::Mul(F, M::NormalPdf(d1)), sqrt_T);
+
+        // The price increases with sigma: shrink the bracket around the root
+        const Mask above = V::Less(zero, f);
+        hi = V::Select(above, V::Min(hi, sigma), hi);
+        lo = V::Select(above, lo, V::Max(lo, sigma));
+
+        // Householder step of third order: delta = -nu * (1 - nu * h2 / 2) / (1 - nu * h2 + nu^2 * h3 / 6)
+        // with nu = f / Vega, h2 = Vomma / Vega = d1 d2 / sigma and h3 = Ultima / Vega
+        const Real nu = V::Div(f, vega);
+        const Real inv_sigma = V::Div(one, sigma);
+        const Real d1d2 = V::Mul(d1, d2);
+        const Real h2 = V::Mul(d1d2, inv_sigma);
+        const Real h3 = V::Mul(V::Sub(zero, V::MulAdd(d1d2, V::Sub(one, d1d2), V::MulAdd(d1, d1, V::Mul(d2, d2)))),
+            V::Mul(inv_sigma, inv_sigma));
+        const Real numerator = V::Sub(one, V::Mul(V::Mul(half, nu), h2));
+        const Real denominator = V::Add(V::Sub(one, V::Mul(nu, h2)), V::Mul(V::Mul(V::Set(1.0 / 6.0), V::Mul(nu, nu)), h3));
+        Real next = V::Sub(sigma, V::Div(V::Mul(nu, numerator), denominator));
+
+        // Fall back to bisection when the step leaves the bracket or is not a number (NaN fails every comparison)
+        const Real bisection = V::Mul(half, V::Add(lo, hi));
+        next = V::Select(V::MaskOr(V::Less(next, lo), V::Less(hi, next)), bisection, next);
+        next = V::Select(V::Equal(next, next), next, bisection);
+
+        // Converge on the relative change of the volatility, or on an exact price
+        const Real change = V::Max(V::Sub(next, sigma), V::Sub(sigma, next));
+        const Mask settled = V::MaskOr(V::Less(change, V::Mul(V::Set(1e-12), sigma)), V::Equal(f, zero));
+
+        // Lanes already converged keep their volatility
+        const Mask active = V::Less(done, half);
+        sigma = V::Select(active, next, sigma);
+        done = V::Select(V::MaskAnd(active, settled), one, done);
+
+        // Stop once every lane has converged
+        alignas(64) double flags[V::width];
+        V::Store(flags, done);
+        bool all = true;
+        for (int j = 0; j < V::width; ++j)
+            all = all && flags[j] > 0.5;
+        if (all)
+            break;
+    }
+
+    // The volatility is only converged if the rounding of the price moves it by less than 1e-6 (relative): once the
+    // Vega underflows any volatility matches the price, and a tolerance on the price alone would accept it
+    const Real vol = V::Mul(sigma, sqrt_T);
+    const Real d1 = V::Add(V::Div(log_FK, vol), V::Mul(half, vol));
+    const Real vega = V::Mul(V::Mul(F, M::NormalPdf(d1)), sqrt_T);
+    const Mask resolved = V::Less(resolution, V::Mul(V::Mul(V::Set(1e-6), sigma), vega));
+
+    V::Store(vol_out + i, V::Select(inside, sigma, V::Set(std::numeric_limits<double>::quiet_NaN())));
+    V::Store(converged_out + i, V::Select(V::MaskAnd(inside, resolved), done, zero));
+}
+
+// Solve the implied volatilities of quotes [first, first + n) of a book, the remainder through padded staging arrays
+template <class V>
+void ImpliedVolBlock(const BookArrays& in, const double* prices, const ImpliedVolArrays& out, const long& first, const long& n)
+{
+    const long end = first + n;
+
+    // Stage a vector of quotes at a time: the flags are converted to bytes and the remainder is padded
+    // with an at-the-money call
+    double staged_in[8][V::width];
+    double staged_vol[V::width];
+    double staged_converged[V::width];
+
+    const BookArrays staged_book = { staged_in[0], staged_in[1], staged_in[2], staged_in[3], staged_in[4],
+        staged_in[5], staged_in[6] };
+
+    for (long i = first; i < end; i += V::width)
+    {
+        const long count = (end - i < V::width) ? end - i : V::width;
+
+        for (long j = 0; j < V::width; ++j)
+        {
+            const bool valid = j < count;
+            staged_in[0][j] = valid ? in.phi[i + j] : 1.0;
+            staged_in[1][j] = valid ? in.T[i + j] : 1.0;
+            staged_in[2][j] = valid ? in.K[i + j] : 1.0;
+            staged_in[3][j] = valid ? in.S[i + j] : 1.0;
+            staged_in[4][j] = valid ? in.r[i + j] : 0.0;
+            staged_in[5][j] = 0.0;
+            staged_in[6][j] = valid ? in.b[i + j] : 0.0;
+            staged_in[7][j] = valid ? prices[i + j] : 0.2;
+        }
+
+        ImpliedVolLanes<V>(staged_book, staged_in[7], staged_vol, staged_converged, 0);
+
+        for (long j = 0; j < count; ++j)
+        {
+            out.vol[i + j] = staged_vol[j];
+            out.converged[i + j] = staged_converged[j] > 0.5 ? 1 : 0;
+        }
+    }
+}
+
+// Build the table of batch kernels for the traits V
+template <class V>
+BookKernels MakeBookKernels()
+{
+    BookKernels kernels;
+    kernels.greeks = PriceBookBlock<V>;
+    kernels.implied_vol = ImpliedVolBlock<V>;
+    return kernels;
+}
+
+// End of the conditional inclusion of the header file
+#endif
@@ -0,0 +1,783 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BookPipeline.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the streaming pricing pipeline over option book files
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "BlackScholesBatch.hpp"
+#include "BookPipeline.hpp"
+#include "MappedFile.hpp"
+#include "MonteCarlo.hpp"
+
+namespace
+{
+    // Number of options parsed, priced and formatted together by one chunk of the thread pool
+    const long pipeline_chunk = 4096;
+
+    // Bytes of a CSV book indexed between two releases of its pages
+    const std::size_t index_release = std::size_t(1) << 24;
+
+    // Tag at the start of the binary column files
+    const char column_tag[8] = { 'M', 'C', 'P', 'C', 'O', 'L', 'S', '1' };
+
+    // Header of the binary column files, the columns follow it 8-byte aligned
+    struct ColumnHeader
+    {
+        char tag[8];
+        unsigned long long rows;
+        unsigned long long columns;
+    };
+
+    // Columns of a book and of the results of each engine
+    const long book_columns = 8;
+    const long analytic_columns = 17;
+    const long montecarlo_columns = 3;
+
+    // Header lines of the CSV files
+    const char book_header[] = "ID,Type,T,K,S,r,sigma,b\n";
+    const char analytic_header[] = "ID,Price,Delta,Gamma,Vega,Theta,Rho,Vanna,Charm,Speed,Color,DvegaDtime,Vomma,"
+        "Veta,Zomma,Lambda,Ultima\n";
+    const char montecarlo_header[] = "ID,Price,SE\n";
+
+    // Trim the spaces and carriage returns around a field
+    void Trim(const char*& first, const char*& last)
+    {
+        while (first < last && (*first == ' ' || *first == '\t')) ++first;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+    }
+
+    // Check whether a line holds only spaces
+    bool Blank(const char* first, const char* last)
+    {
+        Trim(first, last);
+        return first == last;
+    }
+
+    // Define BookSource struct, a book file mapped in memory
+    struct BookSource
+    {
+        std::string path;
+        MappedFile file;
+        bool binary;
+        long rows;
+        // Columns of a binary book
+        const long long* id;
+        BookArrays columns;
+        // Byte offset of the first record of every chunk of a CSV book, and the end of its records
+        std::vector<std::size_t> offsets;
+        std::size_t end;
+
+        // Map the file and index it
+        explicit BookSource(const std::string& book_path);
+
+        // Parse the records of chunk c of a CSV book into the IDs and the book, from index first on
+        void Parse(const long& c, std::vector<long long>& id, OptionBook& book, const long& first) const;
+
+        // Release the pages of options [first, first + size) once they are priced
+        void Release(const long& first, const long& size);
+    };
+
+    // Map a book and recognize its format
+    BookSource::BookSource(const std::string& book_path) :
+        path(book_path),
+        file(book_path, FileMode::Read),
+        binary(false),
+        rows(0),
+        id(0),
+        columns(BookArrays()),
+        end(file.size())
+    {
+        const char* data = static_cast<const char*>(file.data());
+        const std::size_t size = file.size();
+
+        // Binary column files are read in place
+        if (size >= sizeof(ColumnHeader) && std::memcmp(data, column_tag, sizeof(column_tag)) == 0)
+        {
+            ColumnHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            if (header.columns != static_cast<unsigned long long>(book_columns)
+                || header.rows > (size - sizeof(header)) / (book_columns * sizeof(double)))
+                throw std::runtime_error("BookPipeline: " + path + " is not a complete book of " + std::to_string(book_columns)
+                    + " columns");
+
+            binary = true;
+            rows = static_cast<long>(header.rows);
+            const double* column = reinterpret_cast<const double*>(data + sizeof(header));
+            id = reinterpret_cast<const long long*>(column);
+            columns.phi = column + rows;
+            columns.T = column + 2 * rows;
+            columns.K = column + 3 * rows;
+            columns.S = column + 4 * rows;
+            columns.r = column + 5 * rows;
+            columns.sigma = column + 6 * rows;
+            columns.b = column + 7 * rows;
+            return;
+        }
+
+        // Index the CSV records: one pass over the line breaks records where every chunk starts, so the chunks
+        // can be parsed independently. A first line that does not start with a number is the header
+        std::size_t position = (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) ? 3 : 0;
+        std::size_t released = 0;
+        bool first_line = true;
+        while (position < size)
+        {
+            const char* line = data + position;
+            const char* next = static_cast<const char*>(std::memchr(line, '\n', size - position));
+            const char* line_end = next ? next : data + size;
+
+            if (!Blank(line, line_end))
+            {
+                const char* field = line;
+                const char* field_end = line_end;
+                Trim(field, field_end);
+                const bool header = first_line && !(std::isdigit(static_cast<unsigned char>(*field)) || *field == '-'
+                    || *field == '+');
+
+                if (!header)
+                {
+                    if (rows % pipeline_chunk == 0)
+                        offsets.push_back(position);
+                    ++rows;
+                }
+                first_line = false;
+            }
+
+            position = static_cast<std::size_t>(line_end - data) + 1;
+
+            // The batches read the records again, so the indexed pages are released as the pass goes on
+            // instead of keeping the whole book in memory
+            if (position - released >= index_release || position >= size)
+            {
+                file.Release(released, position - released);
+                released = position;
+            }
+        }
+    }
+
+    // Report a record of a CSV book that cannot be read
+    void InvalidRecord(const std::string& path, const long& record, const std::string& reason)
+    {
+        throw std::runtime_error("BookPipeline: record " + std::to_string(record + 1) + " of " + path + " " + reason);
+    }
+
+    // Read a whole field as a number
+    template <class T>
+    bool ReadNumber(const char* first, const char* last, T& value)
+    {
+        return first != last && std::from_chars(first, last, value).ptr == last;
+    }
+
+    // Parse the records of a chunk of a CSV book
+    void BookSource::Parse(const long& c, std::vector<long long>& id, OptionBook& book, const long& first) const
+    {
+        const char* data = static_cast<const char*>(file.data());
+        const char* cursor = data + offsets[c];
+        const char* last = data + end;
+        const long first_record = c * pipeline_chunk;
+        const long count = std::min(pipeline_chunk, rows - first_record);
+
+        // Numeric fields after the type, in the order of the record
+        std::vector<double>* numbers[6] = { &book.T, &book.K, &book.S, &book.r, &book.sigma, &book.b };
+
+        long i = 0;
+        while (i < count)
+        {
+            const char* next = static_cast<const char*>(std::memchr(cursor, '\n', last - cursor));
+            const char* line_end = next ? next : last;
+            const char* line = cursor;
+            cursor = next ? next + 1 : last;
+
+            if (Blank(line, line_end))
+                continue;
+
+            // Split the record in its fields, seven or eight with the cost of carry
+            const long record = first_record + i;
+            const long index = first + i;
+            const char* fields[8][2];
+            long n_fields = 0;
+            const char* field = line;
+            while (true)
+            {
+                if (n_fields == 8)
+                    InvalidRecord(path, record, "has more than 8 fields");
+
+                const char* comma = static_cast<const char*>(std::memchr(field, ',', line_end - field));
+                fields[n_fields][0] = field;
+                fields[n_fields][1] = comma ? comma : line_end;
+                Trim(fields[n_fields][0], fields[n_fields][1]);
+                ++n_fields;
+
+                if (!comma) break;
+                field = comma + 1;
+            }
+            if (n_fields < 7)
+                InvalidRecord(path, record, "has fewer than 7 fields");
+
+            if (!ReadNumber(fields[0][0], fields[0][1], id[index]))
+                InvalidRecord(path, record, "has an invalid ID");
+
+            const std::size_t type_length = static_cast<std::size_t>(fields[1][1] - fields[1][0]);
+            if (type_length == 4 && std::memcmp(fields[1][0], "Call", 4) == 0)
+                book.phi[index] = 1.0;
+            else if (type_length == 3 && std::memcmp(fields[1][0], "Put", 3) == 0)
+                book.phi[index] = -1.0;
+            else
+                InvalidRecord(path, record, "is neither a Call nor a Put");
+
+            for (long k = 0; k < 6; ++k)
+            {
+                // An empty or missing cost of carry is the rate, as in EuropeanOption
+                if (k == 5 && (n_fields < 8 || fields[7][0] == fields[7][1]))
+                    book.b[index] = book.r[index];
+                else if (!ReadNumber(fields[k + 2][0], fields[k + 2][1], (*numbers[k])[index]))
+                    InvalidRecord(path, record, "has an invalid number");
+            }
+
+            if (!(book.T[index] > 0.0 && book.K[index] > 0.0 && book.S[index] > 0.0 && book.sigma[index] > 0.0))
+                InvalidRecord(path, record, "must have a positive T, K, S and sigma");
+
+            ++i;
+        }
+    }
+
+    // Release the pages of a range of options
+    void BookSource::Release(const long& first, const long& size)
+    {
+        if (binary)
+        {
+            for (long k = 0; k < book_columns; ++k)
+                file.Release(sizeof(ColumnHeader) + (static_cast<std::size_t>(k) * rows + first) * sizeof(double),
+                    static_cast<std::size_t>(size) * sizeof(double));
+            return;
+        }
+
+        // Batches are made of whole chunks, so their records start at indexed offsets
+        const std::size_t begin = offsets[first / pipeline_chunk];
+        const std::size_t last = (first + size < rows) ? offsets[(first + size) / pipeline_chunk] : end;
+        file.Release(begin, last - begin);
+    }
+
+    // Define PipelineBatch struct, one batch of options in flight
+    struct PipelineBatch
+    {
+        // Range of the options of the book in the batch
+        long first;
+        long size;
+        // Inputs, in the mapping of a binary book or in the storage below
+        const long long* id;
+        BookArrays in;
+        std::vector<long long> ids;
+        OptionBook book;
+        // Outputs, in the mapping of a binary result file or in the storage below
+        GreeksArrays greeks;
+        double* price;
+        double* se;
+        GreeksBook greeks_storage;
+        std::vector<double> price_storage;
+        std::vector<double> se_storage;
+        // Text of the CSV rows of every chunk
+        std::vector<std::string> text;
+    };
+
+    // Define ResultSink struct, the output file of a run
+    struct ResultSink
+    {
+        std::string path;
+        bool csv;
+        long rows;
+        long columns;
+        // Mapping of a binary column file, or stream of a CSV file
+        std::unique_ptr<MappedFile> file;
+        std::FILE* stream;
+
+        // Open the output, written as CSV when its path ends with .csv
+        ResultSink(const std::string& output_path, const long& n_rows, const long& n_columns, const char* header);
+
+        // Close the stream
+        ~ResultSink();
+
+        // Get column k of the rows of a batch in a binary column file
+        double* Column(const long& k, const long& first) const;
+
+        // Write the rows of a batch and release its pages of a binary column file
+        void Write(const PipelineBatch& batch) const;
+
+        // Flush the stream and check that every write succeeded
+        void Close();
+    };
+
+    // Open the output
+    ResultSink::ResultSink(const std::string& output_path, const long& n_rows, const long& n_columns, const char* header) :
+        path(output_path),
+        csv(output_path.size() >= 4 && output_path.compare(output_path.size() - 4, 4, ".csv") == 0),
+        rows(n_rows),
+        columns(n_columns),
+        stream(0)
+    {
+        if (csv)
+        {
+            stream = std::fopen(path.c_str(), "wb");
+            if (!stream)
+                throw std::runtime_error("BookPipeline: cannot open " + path);
+            std::fputs(header, stream);
+            return;
+        }
+
+        // The size of a binary column file is known from the number of rows, so it is mapped once
+        file.reset(new MappedFile(path, FileMode::Create,
+            sizeof(ColumnHeader) + static_cast<std::size_t>(rows) * columns * sizeof(double)));
+        ColumnHeader column_header;
+        std::memcpy(column_header.tag, column_tag, sizeof(column_tag));
+        column_header.rows = static_cast<unsigned long long>(rows);
+        column_header.columns = static_cast<unsigned long long>(columns);
+        std::memcpy(file->data(), &column_header, sizeof(column_header));
+    }
+
+    // Close the stream
+    ResultSink::~ResultSink()
+    {
+        if (stream)
+            std::fclose(stream);
+    }
+
+    // Get a column of a binary column file
+    double* ResultSink::Column(const long& k, const long& first) const
+    {
+        return reinterpret_cast<double*>(static_cast<char*>(file->data()) + sizeof(ColumnHeader))
+            + static_cast<std::size_t>(k) * rows + first;
+    }
+
+    // Write the rows of a batch
+    void ResultSink::Write(const PipelineBatch& batch) const
+    {
+        if (csv)
+        {
+            for (const std::string& text : batch.text)
+                std::fwrite(text.data(), 1, text.size(), stream);
+        }
+        else
+        {
+            // The values were written in place, only the IDs are copied
+            std::memcpy(Column(0, batch.first), batch.id, static_cast<std::size_t>(batch.size) * sizeof(long long));
+
+            for (long k = 0; k < columns; ++k)
+                file->Release(sizeof(ColumnHeader) + (static_cast<std::size_t>(k) * rows + batch.first) * sizeof(double),
+                    static_cast<std::size_t>(batch.size) * sizeof(double));
+        }
+    }
+
+    // Flush the stream
+    void ResultSink::Close()
+    {
+        if (stream)
+        {
+            const bool failed = std::ferror(stream) != 0;
+            const int closed = std::fclose(stream);
+            stream = 0;
+            if (failed || closed != 0)
+                throw std::runtime_error("BookPipeline: cannot write " + path);
+        }
+    }
+
+    // Append the CSV rows [first, first + count) of a batch, an ID and then the values of every column
+    void FormatRows(std::string& text, const long long* id, const double* const* values, const long& n_values,
+        const long& first, const long& count)
+    {
+        // 24 characters hold any shortest round-trip double or 64-bit integer
+        char row[24 * (analytic_columns + 1)];
+        text.clear();
+        text.reserve(static_cast<std::size_t>(count) * 20 * (n_values + 1));
+
+        for (long i = first; i < first + count; ++i)
+        {
+            char* cursor = std::to_chars(row, row + 24, id[i]).ptr;
+            for (long k = 0; k < n_values; ++k)
+            {
+                *cursor++ = ',';
+                cursor = std::to_chars(cursor, cursor + 24, values[k][i]).ptr;
+            }
+            *cursor++ = '\n';
+            text.append(row, cursor);
+        }
+    }
+
+    // Append the CSV records [first, first + count) of a book, with the type of the option in words
+    void FormatBook(std::string& text, const long long* id, const BookArrays& in, const long& first, const long& count)
+    {
+        const double* values[6] = { in.T, in.K, in.S, in.r, in.sigma, in.b };
+        char row[24 * (book_columns + 1)];
+        text.clear();
+        text.reserve(static_cast<std::size_t>(count) * 20 * book_columns);
+
+        for (long i = first; i < first + count; ++i)
+        {
+            char* cursor = std::to_chars(row, row + 24, id[i]).ptr;
+            const char* type = (in.phi[i] > 0) ? ",Call" : ",Put";
+            const std::size_t length = std::strlen(type);
+            std::memcpy(cursor, type, length);
+            cursor += length;
+            for (long k = 0; k < 6; ++k)
+            {
+                *cursor++ = ',';
+                cursor = std::to_chars(cursor, cursor + 24, values[k][i]).ptr;
+            }
+            *cursor++ = '\n';
+            text.append(row, cursor);
+        }
+    }
+
+    // List the arrays of the price and the Greeks in the order of GreeksBook
+    void ListGreeks(const GreeksArrays& out, const double* arrays[analytic_columns - 1])
+    {
+        const double* list[analytic_columns - 1] = { out.price, out.delta, out.gamma, out.vega, out.theta, out.rho,
+            out.vanna, out.charm, out.speed, out.color, out.dvega_dtime, out.vomma, out.veta, out.zomma, out.lambda,
+            out.ultima };
+        std::copy(list, list + analytic_columns - 1, arrays);
+    }
+
+    // Offset the input arrays of a book to its row first
+    BookArrays OffsetArrays(const BookArrays& arrays, const long& first)
+    {
+        BookArrays offset = { arrays.phi + first, arrays.T + first, arrays.K + first, arrays.S + first, arrays.r + first,
+            arrays.sigma + first, arrays.b + first };
+        return offset;
+    }
+}
+
+// Constructor
+BookPipeline::BookPipeline(const PipelineEngine& engine, const long& batch_size) :
+    m_engine(engine),
+    m_batch_size(pipeline_chunk),
+    m_subintervals(100),
+    m_simulations(10000),
+    m_beta(1.0),
+    m_seed(5489),
+    m_simd(DetectSimdLevel()),
+    m_priority(Priority::Normal)
+{
+    this->batch_size(batch_size);
+}
+
+// Copy constructor
+BookPipeline::BookPipeline(const BookPipeline& source) :
+    m_engine(source.m_engine),
+    m_batch_size(source.m_batch_size),
+    m_subintervals(source.m_subintervals),
+    m_simulations(source.m_simulations),
+    m_beta(source.m_beta),
+    m_seed(source.m_seed),
+    m_simd(source.m_simd),
+    m_priority(source.m_priority)
+{}
+
+// Assignment operator
+BookPipeline& BookPipeline::operator=(const BookPipeline& source)
+{
+    // Check for self assignment
+    if (this == &source)
+        return *this;
+
+    m_engine = source.m_engine;
+    m_batch_size = source.m_batch_size;
+    m_subintervals = source.m_subintervals;
+    m_simulations = source.m_simulations;
+    m_beta = source.m_beta;
+    m_seed = source.m_seed;
+    m_simd = source.m_simd;
+    m_priority = source.m_priority;
+
+    return *this;
+}
+
+// Set the engine
+BookPipeline& BookPipeline::engine(const PipelineEngine& engine)
+{
+    m_engine = engine;
+    return *this;
+}
+
+// Set the number of options per batch
+BookPipeline& BookPipeline::batch_size(const long& size)
+{
+    if (size < 1)
+        throw std::invalid_argument("batch_size: a batch needs at least one option");
+
+    m_batch_size = (size + pipeline_chunk - 1) / pipeline_chunk * pipeline_chunk;
+    return *this;
+}
+
+// Set the number of subintervals of the Monte Carlo engine
+BookPipeline& BookPipeline::subintervals(const long& subintervals)
+{
+    if (subintervals < 1)
+        throw std::invalid_argument("subintervals: a path needs at least one subinterval");
+
+    m_subintervals = subintervals;
+    return *this;
+}
+
+// Set the number of simulations of the Monte Carlo engine
+BookPipeline& BookPipeline::simulations(const long& simulations)
+{
+    if (simulations < 2)
+        throw std::invalid_argument("simulations: at least two simulations are needed to estimate the error");
+
+    m_simulations = simulations;
+    return *this;
+}
+
+// Set the CEV elasticity of the Monte Carlo engine
+BookPipeline& BookPipeline::beta(const double& beta)
+{
+    m_beta = beta;
+    return *this;
+}
+
+// Set the seed of the Monte Carlo engine
+BookPipeline& BookPipeline::seed(const unsigned long long& seed)
+{
+    m_seed = seed;
+    return *this;
+}
+
+// Set the widest instruction set the kernels may use
+BookPipeline& BookPipeline::simd(const SimdLevel& level)
+{
+    m_simd = level;
+    return *this;
+}
+
+// Set the priority in the shared thread pool
+BookPipeline& BookPipeline::priority(const Priority& priority)
+{
+    m_priority = priority;
+    return *this;
+}
+
+// Define the Price function
+PipelineResult BookPipeline::Price(const std::string& input, const std::string& output) const
+{
+    return Run(input, output, false);
+}
+
+// Define the Convert function
+PipelineResult BookPipeline::Convert(const std::string& input, const std::string& output) const
+{
+    return Run(input, output, true);
+}
+
+// Define the Run function
+PipelineResult BookPipeline::Run(const std::string& input, const std::string& output, const bool& convert) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    BookSource source(input);
+    const long rows = source.rows;
+    const long n_batches = (rows + m_batch_size - 1) / m_batch_size;
+
+    const bool analytic = !convert && m_engine == PipelineEngine::Analytic;
+    const long columns = convert ? book_columns : (analytic ? analytic_columns : montecarlo_columns);
+    ResultSink sink(output, rows, columns, convert ? book_header : (analytic ? analytic_header : montecarlo_header));
+
+    const BookKernel kernel = SelectBookKernels(m_simd).greeks;
+
+    // Three batches are in flight, the one being read, the one being priced and the one being written
+    PipelineBatch batches[3];
+    for (PipelineBatch& batch : batches)
+    {
+        const std::size_t capacity = static_cast<std::size_t>(std::min(m_batch_size, rows));
+        const std::size_t n_chunks = (capacity + pipeline_chunk - 1) / pipeline_chunk;
+        if (!source.binary)
+        {
+            batch.ids.resize(capacity);
+            batch.book.phi.resize(capacity);
+            batch.book.T.resize(capacity);
+            batch.book.K.resize(capacity);
+            batch.book.S.resize(capacity);
+            batch.book.r.resize(capacity);
+            batch.book.sigma.resize(capacity);
+            batch.book.b.resize(capacity);
+        }
+        if (sink.csv && analytic)
+            batch.greeks_storage.Resize(capacity);
+        if (sink.csv && !analytic && !convert)
+        {
+            batch.price_storage.resize(capacity);
+            batch.se_storage.resize(capacity);
+        }
+        batch.text.resize(n_chunks);
+    }
+
+    // Read a batch: a binary book is only pointed to, the chunks of a CSV book are parsed in parallel
+    const std::function<void(const long&)> read = [&](const long& b)
+    {
+        PipelineBatch& batch = batches[b % 3];
+        batch.first = b * m_batch_size;
+        batch.size = std::min(m_batch_size, rows - batch.first);
+
+        if (source.binary)
+        {
+            batch.id = source.id + batch.first;
+            batch.in = OffsetArrays(source.columns, batch.first);
+            return;
+        }
+
+        batch.id = batch.ids.data();
+        batch.in = batch.book.Arrays();
+        const long first_chunk = batch.first / pipeline_chunk;
+        ThreadPool::Global().ParallelFor((batch.size + pipeline_chunk - 1) / pipeline_chunk, [&](const long c)
+        {
+            source.Parse(first_chunk + c, batch.ids, batch.book, c * pipeline_chunk);
+        }, m_priority);
+    };
+
+    // Price a batch and format its CSV rows, or write its values in place in a binary column file
+    const std::function<void(const long&)> price = [&](const long& b)
+    {
+        PipelineBatch& batch = batches[b % 3];
+        const long n_chunks = (batch.size + pipeline_chunk - 1) / pipeline_chunk;
+
+        // Copy a book to a binary column file
+        if (convert && !sink.csv)
+        {
+            const double* in[7] = { batch.in.phi, batch.in.T, batch.in.K, batch.in.S, batch.in.r, batch.in.sigma, batch.in.b };
+            for (long k = 0; k < 7; ++k)
+                std::memcpy(sink.Column(k + 1, batch.first), in[k], static_cast<std::size_t>(batch.size) * sizeof(double));
+            return;
+        }
+
+        if (analytic)
+        {
+            if (sink.csv)
+            {
+                batch.greeks = batch.greeks_storage.Arrays();
+            }
+            else
+            {
+                const GreeksArrays out = { sink.Column(1, batch.first), sink.Column(2, batch.first), sink.Column(3, batch.first),
+                    sink.Column(4, batch.first), sink.Column(5, batch.first), sink.Column(6, batch.first),
+                    sink.Column(7, batch.first), sink.Column(8, batch.first), sink.Column(9, batch.first),
+                    sink.Column(10, batch.first), sink.Column(11, batch.first), sink.Column(12, batch.first),
+                    sink.Column(13, batch.first), sink.Column(14, batch.first), sink.Column(15, batch.first),
+                    sink.Column(16, batch.first) };
+                batch.greeks = out;
+            }
+        }
+        else if (!convert)
+        {
+            batch.price = sink.csv ? batch.price_storage.data() : sink.Column(1, batch.first);
+            batch.se = sink.csv ? batch.se_storage.data() : sink.Column(2, batch.first);
+
+            // Split the batch in runs of consecutive options on the same simulated underlying
+            std::vector<long> runs(1, 0);
+            const BookArrays& in = batch.in;
+            for (long i = 1; i < batch.size; ++i)
+            {
+                if (in.T[i] != in.T[i - 1] || in.S[i] != in.S[i - 1] || in.r[i] != in.r[i - 1] || in.b[i] != in.b[i - 1]
+                    || in.sigma[i] != in.sigma[i - 1])
+                    runs.push_back(i);
+            }
+            runs.push_back(batch.size);
+
+            // Price every run with one set of paths, the runs share the pool with the chunks of their own paths
+            ThreadPool::Global().ParallelFor(static_cast<long>(runs.size()) - 1, [&](const long run)
+            {
+                std::vector<EuropeanOption> options;
+                for (long i = runs[run]; i < runs[run + 1]; ++i)
+                {
+                    options.push_back(EuropeanOption(in.phi[i] > 0 ? "Call" : "Put", in.T[i], in.K[i], in.S[i], in.r[i],
+                        in.sigma[i], static_cast<int>(batch.id[i]), in.b[i]));
+                }
+
+                const std::vector<MCResult> results = MonteCarlo(options.front(), m_subintervals, m_simulations, m_seed)
+                    .simd(m_simd).priority(m_priority).PriceBatch(options, m_beta);
+                for (long i = runs[run]; i < runs[run + 1]; ++i)
+                {
+                    batch.price[i] = results[i - runs[run]].price;
+                    batch.se[i] = results[i - runs[run]].se;
+                }
+            }, m_priority);
+        }
+
+        // Fuse the analytic kernel with the formatting of the chunk while its outputs are in cache
+        ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+        {
+            const long first = c * pipeline_chunk;
+            const long count = std::min(pipeline_chunk, batch.size - first);
+
+            if (analytic)
+                kernel(batch.in, batch.greeks, first, count);
+
+            if (!sink.csv)
+                return;
+
+            if (convert)
+            {
+                FormatBook(batch.text[c], batch.id, batch.in, first, count);
+            }
+            else if (analytic)
+            {
+                const double* values[analytic_columns - 1];
+                ListGreeks(batch.greeks, values);
+                FormatRows(batch.text[c], batch.id, values, analytic_columns - 1, first, count);
+            }
+            else
+            {
+                const double* values[2] = { batch.price, batch.se };
+                FormatRows(batch.text[c], batch.id, values, montecarlo_columns - 1, first, count);
+            }
+        }, m_priority);
+
+        // Keep the text of the chunks past the end of a shorter last batch out of the output
+        for (long c = n_chunks; c < static_cast<long>(batch.text.size()); ++c)
+            batch.text[c].clear();
+    };
+
+    // Pipeline the batches: batch b + 1 is read while batch b is priced and batch b - 1 is written
+    {
+        std::future<void> reading;
+        std::future<void> writing;
+
+        if (n_batches > 0)
+            read(0);
+
+        for (long b = 0; b < n_batches; ++b)
+        {
+            if (b + 1 < n_batches)
+                reading = std::async(std::launch::async, read, b + 1);
+
+            price(b);
+
+            if (writing.valid())
+                writing.get();
+            writing = std::async(std::launch::async, [&sink, &source, &batches, b]()
+            {
+                const PipelineBatch& batch = batches[b % 3];
+                sink.Write(batch);
+                source.Release(batch.first, batch.size);
+            });
+
+            if (reading.valid())
+                reading.get();
+        }
+
+        if (writing.valid())
+            writing.get();
+    }
+    sink.Close();
+
+    PipelineResult result = PipelineResult();
+    result.options = rows;
+    result.batches = n_batches;
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,131 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BookPipeline.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the streaming pricing pipeline over option book files
+
+// If BOOKPIPELINE_HPP is not defined
+#ifndef BOOKPIPELINE_HPP
+// Define BOOKPIPELINE_HPP
+#define BOOKPIPELINE_HPP
+
+#include <string>
+#include "CpuFeatures.hpp"
+#include "ThreadPool.hpp"
+
+// Engines that price the options of a pipeline
+enum class PipelineEngine
+{
+    // Black - Scholes - Merton price and 15 Greeks of every option, as PriceBook
+    Analytic,
+    // Monte Carlo price and standard error, one MonteCarlo::PriceBatch per run of consecutive options sharing the
+    // maturity, spot, rate, cost of carry and volatility (the paths drift at the rate, as in MonteCarlo)
+    MonteCarlo
+};
+
+// Summary of a pipeline run
+struct PipelineResult
+{
+    // Number of options written
+    long options;
+    // Number of batches the options were read, priced and written in
+    long batches;
+    // Wall-clock time of the run in seconds
+    double elapsed;
+};
+
+// Define BookPipeline class, pricing option books from files to files in batches with bounded memory
+//
+// Books are read from memory-mapped files in one of two formats, recognized by their content:
+// - CSV, one option per line as ID,Type,T,K,S,r,sigma,b (the fields of EuropeanOption::ConvertToVectorString, Type
+//   Call or Put and b empty for b = r) with an optional header line. The records are indexed once, so the chunks
+//   of a batch are parsed in parallel without building a string per field
+// - binary column files: the 8-byte tag MCPCOLS1, the numbers of rows and columns as 64-bit integers, then every
+//   column in turn as one 64-bit value per row in the byte order of the machine. A book has the columns ID (integer),
+//   phi (+1 call, -1 put), T, K, S, r, sigma and b (doubles), and the analytic engine reads them in place
+//
+// Results are written as CSV when the output path ends with .csv and as a binary column file otherwise, with the
+// columns ID, Price and the 15 Greeks in the order of GreeksBook (analytic engine) or ID, Price and SE (Monte Carlo
+// engine). The analytic engine writes the binary columns in place through a mapping of the output file.
+//
+// The run keeps three batches in flight: the next batch is parsed while the current one is priced on the shared
+// thread pool and the previous one is written, so the memory used does not depend on the size of the book
+class BookPipeline
+{
+private:
+
+    // Declare private member variables
+    PipelineEngine m_engine;
+    long m_batch_size;
+    long m_subintervals;
+    long m_simulations;
+    double m_beta;
+    unsigned long long m_seed;
+    SimdLevel m_simd;
+    Priority m_priority;
+
+    // Declare Run private function, pricing the book at input into output, or copying it when convert is set
+    PipelineResult Run(const std::string& input, const std::string& output, const bool& convert) const;
+
+public:
+
+    // Constructor
+    BookPipeline(const PipelineEngine& engine = PipelineEngine::Analytic, const long& batch_size = 65536);
+
+    // Copy constructor
+    BookPipeline(const BookPipeline& source);
+
+    // Assignement operator
+    BookPipeline& operator=(const BookPipeline& source);
+
+    // Declare the Price function, pricing every option of the book at input and writing the results to output
+    PipelineResult Price(const std::string& input, const std::string& output) const;
+
+    // Declare the Convert function, copying the book at input to output in the format of its extension,
+    // so CSV books can be converted once to binary column files that are read in place
+    PipelineResult Convert(const std::string& input, const std::string& output) const;
+
+    // Set the engine
+    BookPipeline& engine(const PipelineEngine& engine);
+
+    // Set the number of options per batch, rounded up to a multiple of the 4096 options of a chunk
+    BookPipeline& batch_size(const long& size);
+
+    // Set the number of subintervals of the Monte Carlo engine
+    BookPipeline& subintervals(const long& subintervals);
+
+    // Set the number of simulations of the Monte Carlo engine
+    BookPipeline& simulations(const long& simulations);
+
+    // Set the CEV elasticity of the Monte Carlo engine
+    BookPipeline& beta(const double& beta);
+
+    // Set the seed of the Monte Carlo engine
+    BookPipeline& seed(const unsigned long long& seed);
+
+    // Set the widest instruction set the kernels may use (capped to what the CPU supports)
+    BookPipeline& simd(const SimdLevel& level);
+
+    // Set the priority of the chunks of the pipeline in the shared thread pool
+    BookPipeline& priority(const Priority& priority);
+
+    // Get inline functions
+    // Get engine
+    const PipelineEngine& engine() const { return m_engine; }
+    // Get options per batch
+    const long& batch_size() const { return m_batch_size; }
+    // Get subintervals of the Monte Carlo engine
+    const long& subintervals() const { return m_subintervals; }
+    // Get simulations of the Monte Carlo engine
+    const long& simulations() const { return m_simulations; }
+    // Get CEV elasticity of the Monte Carlo engine
+    const double& beta() const { return m_beta; }
+    // Get seed of the Monte Carlo engine
+    const unsigned long long& seed() const { return m_seed; }
+    // Get instruction set of the kernels
+    const SimdLevel& simd() const { return m_simd; }
+    // Get priority in the shared thread pool
+    const Priority& priority() const { return m_priority; }
+};
+
+// End of the conditional inclusion of the header file
+#endif
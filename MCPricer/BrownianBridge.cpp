@@ -0,0 +1,74 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BrownianBridge.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the Brownian-bridge path construction
+
+#include <cmath>
+#include <vector>
+#include "BrownianBridge.hpp"
+
+// Constructor
+BrownianBridge::BrownianBridge(const long& steps) :
+    m_bridge_index(steps, 0),
+    m_left_index(steps, 0),
+    m_right_index(steps, 0),
+    m_left_weight(steps, 0.0),
+    m_right_weight(steps, 0.0),
+    m_std_dev(steps, 0.0)
+{
+    // Unit subintervals: the grid point i sits at time i + 1, so the increments are standard normals
+    // Mark the points already built, the terminal point comes first
+    std::vector<long> built(steps, 0);
+    built[steps - 1] = 1;
+    m_bridge_index[0] = steps - 1;
+    m_std_dev[0] = std::sqrt(static_cast<double>(steps));
+
+    for (long i = 1, j = 0; i < steps; ++i)
+    {
+        // Find the next gap [j, k) of points not built yet
+        while (built[j]) ++j;
+        long k = j;
+        while (!built[k]) ++k;
+
+        // Build its midpoint l conditioned on the points j - 1 (or the origin) and k
+        const long l = j + ((k - 1 - j) >> 1);
+        built[l] = i;
+        m_bridge_index[i] = l;
+        m_left_index[i] = j;
+        m_right_index[i] = k;
+
+        const double tl = static_cast<double>(l + 1);
+        const double tk = static_cast<double>(k + 1);
+        const double tj = static_cast<double>(j);
+
+        m_left_weight[i] = (tk - tl) / (tk - tj);
+        m_right_weight[i] = (tl - tj) / (tk - tj);
+        m_std_dev[i] = std::sqrt((tl - tj) * (tk - tl) / (tk - tj));
+
+        // Move to the next gap, wrapping around to the start at the next level
+        j = k + 1;
+        if (j >= steps) j = 0;
+    }
+}
+
+// Transform normals in bridge order into standard normal increments in time order
+void BrownianBridge::Increments(const double* z, double* increments, double* work) const
+{
+    const long steps = this->steps();
+
+    // Build the Brownian motion on the grid, the terminal value first
+    work[steps - 1] = m_std_dev[0] * z[0];
+    for (long i = 1; i < steps; ++i)
+    {
+        const long j = m_left_index[i];
+        const long k = m_right_index[i];
+        const double left = j ? work[j - 1] : 0.0;
+
+        work[m_bridge_index[i]] = m_left_weight[i] * left + m_right_weight[i] * work[k] + m_std_dev[i] * z[i];
+    }
+
+    // Take the increments between consecutive grid points
+    increments[0] = work[0];
+    for (long i = 1; i < steps; ++i)
+        increments[i] = work[i] - work[i - 1];
+}
@@ -0,0 +1,43 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// BrownianBridge.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the Brownian-bridge path construction
+
+// If BROWNIANBRIDGE_HPP is not defined
+#ifndef BROWNIANBRIDGE_HPP
+// Define BROWNIANBRIDGE_HPP
+#define BROWNIANBRIDGE_HPP
+
+#include <vector>
+
+// Define BrownianBridge class on a uniform grid of subintervals (Jckel 2002)
+// The first normal fixes the terminal value of the Brownian motion, the next ones its midpoints level by level,
+// so the leading (best distributed) coordinates of a low-discrepancy point drive most of the path variance
+class BrownianBridge
+{
+private:
+
+    // Declare the construction order: the point built by every normal and the two points it is conditioned on
+    std::vector<long> m_bridge_index;
+    std::vector<long> m_left_index;
+    std::vector<long> m_right_index;
+    // Declare the interpolation weights and conditional standard deviations
+    std::vector<double> m_left_weight;
+    std::vector<double> m_right_weight;
+    std::vector<double> m_std_dev;
+
+public:
+
+    // Constructor
+    explicit BrownianBridge(const long& steps);
+
+    // Transform steps normals in bridge order into the standard normal increments of the path, in time order
+    // The work buffer holds the Brownian motion on the grid (steps values)
+    void Increments(const double* z, double* increments, double* work) const;
+
+    // Get the number of subintervals
+    long steps() const { return static_cast<long>(m_bridge_index.size()); }
+};
+
+// End of the conditional inclusion of the header file
+#endif
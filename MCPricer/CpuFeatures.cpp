@@ -0,0 +1,68 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// CpuFeatures.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code for the runtime detection of the SIMD instruction sets
+
+#include "CpuFeatures.hpp"
+
+#if defined(MCPRICER_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Detect the widest instruction set supported by the CPU and the operating system
+SimdLevel DetectSimdLevel()
+{
+#if defined(MCPRICER_X86) && defined(_MSC_VER)
+    int info[4];
+
+    // Leaf 1: FMA (ECX bit 12), OSXSAVE (ECX bit 27) and AVX (ECX bit 28)
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    if (!(fma && osxsave && avx))
+        return SimdLevel::Scalar;
+
+    // The operating system must save the YMM (bits 1-2) and ZMM (bits 5-7) registers
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool ymm = (xcr0 & 0x6) == 0x6;
+    const bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+    // Leaf 7: AVX2 (EBX bit 5) and AVX-512F (EBX bit 16)
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool avx512f = (info[1] & (1 << 16)) != 0;
+
+    if (avx512f && zmm)
+        return SimdLevel::AVX512;
+    if (avx2 && ymm)
+        return SimdLevel::AVX2;
+    return SimdLevel::Scalar;
+#elif defined(MCPRICER_X86) && defined(__GNUC__)
+    // The GCC and Clang builtins also check that the operating system enabled the registers
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdLevel::AVX2;
+    return SimdLevel::Scalar;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// Get the name of an instruction set
+const char* SimdLevelName(const SimdLevel& level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX512:
+        return "AVX-512";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    default:
+        return "Scalar";
+    }
+}
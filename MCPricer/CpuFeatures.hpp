@@ -0,0 +1,31 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// CpuFeatures.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code for the runtime detection of the SIMD instruction sets
+
+// If CPUFEATURES_HPP is not defined
+#ifndef CPUFEATURES_HPP
+// Define CPUFEATURES_HPP
+#define CPUFEATURES_HPP
+
+// Define MCPRICER_X86 when compiling for x86 targets, where the AVX2 and AVX-512 kernels are built
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MCPRICER_X86
+#endif
+
+// Instruction sets the path kernels are compiled for, ordered from narrowest to widest
+enum class SimdLevel
+{
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+// Detect the widest instruction set supported by the CPU and the operating system
+SimdLevel DetectSimdLevel();
+
+// Get the name of an instruction set
+const char* SimdLevelName(const SimdLevel& level);
+
+// End of the conditional inclusion of the header file
+#endif
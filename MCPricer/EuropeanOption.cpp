@@ -156,7 +156,7 @@ double EuropeanOption::Vega() const
 	return m_S * sqrt(m_T) * exp((m_b - m_r) * m_T) * N_prime(D1());
 }
 
-// Calculate the Theta of the option
+// Calculate the Theta of the option (minus the derivative with respect to the time to expiration)
 double EuropeanOption::Theta() const
 {
 	double d1 = D1();
@@ -169,7 +169,7 @@ double EuropeanOption::Theta() const
 
 	if (m_type == "Put")
 	{
-		return (-(m_S)*m_sigma * exp((m_b - m_r) * m_T) * N_prime(d1) / (2 * sqrt(m_T))) - ((m_b - m_r) * m_S * exp((m_b - m_r) * m_T) * (1 - N(d1))) - (m_r * m_K * exp(-m_r * m_T) * (1 - N(d2)));
+		return (-(m_S)*m_sigma * exp((m_b - m_r) * m_T) * N_prime(d1) / (2 * sqrt(m_T))) + ((m_b - m_r) * m_S * exp((m_b - m_r) * m_T) * (1 - N(d1))) + (m_r * m_K * exp(-m_r * m_T) * (1 - N(d2)));
 	}
 }
 
@@ -194,24 +194,25 @@ double EuropeanOption::Rho() const
 double EuropeanOption::Vanna() const
 {
 	double d1 = D1();
+	double d2 = D2(d1);
 
-	return exp((m_b - m_r) * m_T) * N_prime(d1) * (d1 / m_sigma - 1) * m_S * sqrt(m_T);
+	return -exp((m_b - m_r) * m_T) * N_prime(d1) * d2 / m_sigma;
 }
 
-// Calculate the Charm of the option
+// Calculate the Charm of the option (minus the derivative of Delta with respect to the time to expiration)
 double EuropeanOption::Charm() const
 {
 	double d1 = D1();
 	double d2 = D2(d1);
-	double term1 = -exp((m_b - m_r) * m_T) * N_prime(d1) * (2 * (m_r - m_b) * m_T - d2 * m_sigma * sqrt(m_T)) / (2 * m_T * m_sigma * sqrt(m_T));
+	double term1 = -exp((m_b - m_r) * m_T) * N_prime(d1) * (m_b / (m_sigma * sqrt(m_T)) - d2 / (2 * m_T));
 
 	if (m_type == "Call")
 	{
-		return term1 - (m_r - m_b) * exp((m_b - m_r) * m_T) * N(d1);
+		return term1 - (m_b - m_r) * exp((m_b - m_r) * m_T) * N(d1);
 	}
 	if (m_type == "Put")
 	{
-		return term1 + (m_r - m_b) * exp((m_b - m_r) * m_T) * (1 - N(d1));
+		return term1 + (m_b - m_r) * exp((m_b - m_r) * m_T) * (1 - N(d1));
 	}
 }
 
@@ -220,47 +221,49 @@ double EuropeanOption::Speed() const
 {
 	double d1 = D1();
 
-	return -N_prime(d1) * exp((m_b - m_r) * m_T) * (d1 / (m_S * m_S * m_sigma * sqrt(m_T)));
+	return -Gamma() / m_S * (1 + d1 / (m_sigma * sqrt(m_T)));
 }
 
-// Calculate the Color of the option
+// Calculate the Color of the option (minus the derivative of Gamma with respect to the time to expiration)
 double EuropeanOption::Color() const
 {
 	double d1 = D1();
+	double d2 = D2(d1);
 
-	return -N_prime(d1) * exp((m_b - m_r) * m_T) * (2 * (m_r - m_b) * m_T - d1 * m_sigma * sqrt(m_T)) / (2 * m_T * m_S * m_sigma * sqrt(m_T));
+	return Gamma() * (m_r - m_b + m_b * d1 / (m_sigma * sqrt(m_T)) + (1 - d1 * d2) / (2 * m_T));
 }
 
-// Calculate the DvegaDtime of the option
+// Calculate the DvegaDtime of the option (minus the derivative of Vega with respect to the time to expiration)
 double EuropeanOption::DvegaDtime() const
 {
 	double d1 = D1();
+	double d2 = D2(d1);
 
-	return m_S * sqrt(m_T) * exp((m_b - m_r) * m_T) * N_prime(d1) * (m_r - m_b - d1 * m_sigma / (2 * sqrt(m_T)));
+	return Vega() * (m_r - m_b + m_b * d1 / (m_sigma * sqrt(m_T)) - (1 + d1 * d2) / (2 * m_T));
 }
 
 // Calculate the Vomma of the option
 double EuropeanOption::Vomma() const
 {
 	double d1 = D1();
+	double d2 = D2(d1);
 
-	return Vega() * d1 * (d1 - 1) / m_sigma;
+	return Vega() * d1 * d2 / m_sigma;
 }
 
-// Calculate the Veta of the option
+// Calculate the Veta of the option (the derivative of Vega with respect to the time to expiration)
 double EuropeanOption::Veta() const
 {
-	double d1 = D1();
-
-	return -m_S * exp((m_b - m_r) * m_T) * N_prime(d1) * sqrt(m_T) * (m_r - m_b + (d1 * m_sigma) / (2 * sqrt(m_T)));
+	return -DvegaDtime();
 }
 
 // Calculate the Zomma of the option
 double EuropeanOption::Zomma() const
 {
 	double d1 = D1();
+	double d2 = D2(d1);
 
-	return Gamma() * (d1 * (d1 - 1) - 1) / m_sigma;
+	return Gamma() * (d1 * d2 - 1) / m_sigma;
 }
 
 // Calculate the Lambda of the option
@@ -275,7 +278,7 @@ double EuropeanOption::Ultima() const
 	double d1 = D1();
 	double d2 = D2(d1);
 
-	return -Vega() * (d1 * (d1 - 3) * (d1 - 1) - 1) / (m_sigma * m_sigma);
+	return -Vega() * (d1 * d2 * (1 - d1 * d2) + d1 * d1 + d2 * d2) / (m_sigma * m_sigma);
 }
 
 // Calculate the numeric Delta of the option
@@ -8,6 +8,7 @@
 // Define EUROPEANOPTION_HPP
 #define EUROPEANOPTION_HPP
 
+#include <limits>
 #include <string>
 #include <ostream>
 #include <vector>
@@ -0,0 +1,139 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Heston.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the Heston semi-analytic pricer
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "Heston.hpp"
+
+namespace
+{
+    // Nodes and weights of 16-point Gauss - Legendre quadrature on [-1, 1], symmetric about 0
+    const double gauss_nodes[8] = { 0.0950125098376374, 0.2816035507792589, 0.4580167776572274, 0.6178762444026438,
+        0.7554044083550030, 0.8656312023878318, 0.9445750230732326, 0.9894009349916499 };
+    const double gauss_weights[8] = { 0.1894506104550685, 0.1826034150449236, 0.1691565193950025, 0.1495959888165767,
+        0.1246289712555339, 0.0951585116824928, 0.0622535239386479, 0.0271524594117541 };
+
+    // Largest number of quadrature panels before the integral is truncated
+    const long max_panels = 4000;
+}
+
+// Check the Heston parameters
+void ValidateHeston(const HestonParams& params, const std::string& name)
+{
+    if (!(params.v0 >= 0.0) || !(params.theta > 0.0))
+        throw std::invalid_argument(name + ": the initial variance must be non-negative and the long-run variance positive");
+    if (!(params.kappa > 0.0) || !(params.xi > 0.0))
+        throw std::invalid_argument(name + ": the mean reversion and the volatility of the variance must be positive");
+    if (!(std::fabs(params.rho) <= 1.0))
+        throw std::invalid_argument(name + ": the correlation must be within [-1, 1]");
+}
+
+// Define the HestonCharacteristic function
+std::complex<double> HestonCharacteristic(const std::complex<double>& u, const double& T, const HestonParams& params)
+{
+    const std::complex<double> i(0.0, 1.0);
+    const double xi2 = params.xi * params.xi;
+
+    // beta - d and beta + d, with d taken on the branch of positive real part
+    const std::complex<double> beta = params.kappa - params.rho * params.xi * i * u;
+    const std::complex<double> d = std::sqrt(beta * beta + xi2 * (i * u + u * u));
+    const std::complex<double> g = (beta - d) / (beta + d);
+    const std::complex<double> decay = std::exp(-d * T);
+
+    // exp(C(T) + D(T) * v0), the log taken of (1 - g * e^(-d * T)) / (1 - g), which never crosses the branch cut
+    const std::complex<double> C = params.kappa * params.theta / xi2
+        * ((beta - d) * T - 2.0 * std::log((1.0 - g * decay) / (1.0 - g)));
+    const std::complex<double> D = (beta - d) / xi2 * (1.0 - decay) / (1.0 - g * decay);
+
+    return std::exp(C + D * params.v0);
+}
+
+// Define the HestonCallPrices function
+std::vector<double> HestonCallPrices(const double& S, const double& r, const double& q, const double& T,
+    const std::vector<double>& strikes, const HestonParams& params)
+{
+    ValidateHeston(params, "HestonCallPrices");
+    if (!(S > 0.0) || !(T > 0.0))
+        throw std::invalid_argument("HestonCallPrices: the spot and the maturity must be positive");
+
+    const std::size_t n = strikes.size();
+    const double F = S * std::exp((r - q) * T);
+    const double discount = std::exp(-r * T);
+
+    // Log-moneyness ln(F / K) of every strike
+    std::vector<double> k(n);
+    for (std::size_t j = 0; j < n; ++j)
+    {
+        if (!(strikes[j] > 0.0))
+            throw std::invalid_argument("HestonCallPrices: the strikes must be positive");
+        k[j] = std::log(F / strikes[j]);
+    }
+
+    // Panels narrow enough for the peak of 1 / (u^2 + 1 / 4) at 0, doubling up to a width scaled to the standard
+    // deviation of the log-spot, over which the characteristic function decays
+    const double deviation = std::sqrt(std::max(params.v0, params.theta) * T);
+    const double largest_width = std::min(4.0, std::max(0.5, 1.0 / deviation));
+
+    // Integrate Re[e^(i * u * k) * phi(u - i / 2)] / (u^2 + 1 / 4) over [0, infinity) panel by panel,
+    // stopping when a panel adds nothing to any strike
+    std::vector<double> integral(n, 0.0);
+    std::vector<double> panel(n);
+    double start = 0.0;
+    double width = 0.25;
+
+    for (long p = 0; p < max_panels; ++p, start += width, width = std::min(2.0 * width, largest_width))
+    {
+        const double centre = start + 0.5 * width;
+        std::fill(panel.begin(), panel.end(), 0.0);
+
+        for (int node = 0; node < 16; ++node)
+        {
+            const double offset = (node < 8) ? -gauss_nodes[7 - node] : gauss_nodes[node - 8];
+            const double weight = (node < 8) ? gauss_weights[7 - node] : gauss_weights[node - 8];
+            const double u = centre + 0.5 * width * offset;
+
+            // One characteristic function for every strike of the strip
+            const std::complex<double> phi = HestonCharacteristic(std::complex<double>(u, -0.5), T, params);
+            const double scale = 0.5 * width * weight / (u * u + 0.25);
+
+            for (std::size_t j = 0; j < n; ++j)
+                panel[j] += scale * (std::cos(u * k[j]) * phi.real() - std::sin(u * k[j]) * phi.imag());
+        }
+
+        double largest = 0.0;
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            integral[j] += panel[j];
+            largest = std::max(largest, std::fabs(panel[j]));
+        }
+
+        if (largest < 1e-15)
+            break;
+    }
+
+    // C = e^(-r * T) * (F - sqrt(F * K) / pi * integral)
+    const double pi = 3.14159265358979323846;
+    std::vector<double> calls(n);
+    for (std::size_t j = 0; j < n; ++j)
+        calls[j] = std::max(discount * (F - std::sqrt(F * strikes[j]) / pi * integral[j]),
+            std::max(discount * (F - strikes[j]), 0.0));
+
+    return calls;
+}
+
+// Define the HestonPrice function
+double HestonPrice(const EuropeanOption& option, const HestonParams& params)
+{
+    const double q = option.r() - option.b();
+    const double call = HestonCallPrices(option.S(), option.r(), q, option.T(),
+        std::vector<double>(1, option.K()), params)[0];
+
+    if (option.type() == "Call")
+        return call;
+
+    // Put-call parity
+    return call - option.S() * std::exp(-q * option.T()) + option.K() * std::exp(-option.r() * option.T());
+}
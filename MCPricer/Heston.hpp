@@ -0,0 +1,50 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Heston.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the Heston model parameters and its semi-analytic pricer
+
+// If HESTON_HPP is not defined
+#ifndef HESTON_HPP
+// Define HESTON_HPP
+#define HESTON_HPP
+
+#include <complex>
+#include <string>
+#include <vector>
+#include "EuropeanOption.hpp"
+
+// Define HestonParams struct, the stochastic variance dv = kappa * (theta - v) * dt + xi * sqrt(v) * dW_v
+// driving the spot dS = b * S * dt + sqrt(v) * S * dW_S, with d<W_S, W_v> = rho * dt
+struct HestonParams
+{
+    // Initial variance
+    double v0;
+    // Speed of mean reversion
+    double kappa;
+    // Long-run variance
+    double theta;
+    // Volatility of the variance
+    double xi;
+    // Correlation of the spot and variance Brownian motions
+    double rho;
+};
+
+// Check the Heston parameters, throwing std::invalid_argument prefixed by name
+void ValidateHeston(const HestonParams& params, const std::string& name);
+
+// Characteristic function E[exp(i * u * X)] of the log-spot X = log(S(T) / F) relative to the forward F,
+// in the "little trap" form of Albrecher et al., continuous over any maturity; u may be complex
+std::complex<double> HestonCharacteristic(const std::complex<double>& u, const double& T, const HestonParams& params);
+
+// Call prices of a strip of strikes by Lewis' single integral of the characteristic function, with a dividend yield q
+// The characteristic function does not depend on the strike, so it is evaluated once per quadrature node for the
+// whole strip, as a calibration prices every strike of a maturity
+std::vector<double> HestonCallPrices(const double& S, const double& r, const double& q, const double& T,
+    const std::vector<double>& strikes, const HestonParams& params);
+
+// Price a European option under Heston, with the dividend yield r - b of its cost of carry (its sigma is not read);
+// puts follow from put-call parity
+double HestonPrice(const EuropeanOption& option, const HestonParams& params);
+
+// End of the conditional inclusion of the header file
+#endif
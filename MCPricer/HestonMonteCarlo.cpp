@@ -0,0 +1,172 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// HestonMonteCarlo.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the derived HestonMonteCarlo class
+
+#include <cmath>
+#include <stdexcept>
+#include "HestonMonteCarlo.hpp"
+
+// Define the static constant, bound to references by std::min
+const long HestonMonteCarlo::chunk_size;
+
+// Constructor
+HestonMonteCarlo::HestonMonteCarlo(const EuropeanOption& option, const HestonParams& heston, const long& subintervals,
+    const long& simulations, const unsigned long long& seed) :
+    EuropeanOption(option),
+    m_heston(heston),
+    m_subintervals(subintervals),
+    m_simulations(simulations),
+    m_seed(seed),
+    m_simd(DetectSimdLevel()),
+    m_variance_reduction(VarianceReduction::None),
+    m_martingale_correction(true),
+    m_priority(Priority::Normal)
+{
+    ValidateHeston(heston, "HestonMonteCarlo");
+    if (subintervals < 1 || simulations < 2)
+        throw std::invalid_argument("HestonMonteCarlo: at least one subinterval and two simulations are needed");
+}
+
+// Copy Constructor
+HestonMonteCarlo::HestonMonteCarlo(const HestonMonteCarlo& source) :
+    EuropeanOption(source),
+    m_heston(source.m_heston),
+    m_subintervals(source.m_subintervals),
+    m_simulations(source.m_simulations),
+    m_seed(source.m_seed),
+    m_simd(source.m_simd),
+    m_variance_reduction(source.m_variance_reduction),
+    m_martingale_correction(source.m_martingale_correction),
+    m_priority(source.m_priority)
+{}
+
+// Assignment operator
+HestonMonteCarlo& HestonMonteCarlo::operator=(const HestonMonteCarlo& source)
+{
+    // Check for self assignment
+    if (this == &source)
+        return *this;
+
+    EuropeanOption::operator=(source);
+    m_heston = source.m_heston;
+    m_subintervals = source.m_subintervals;
+    m_simulations = source.m_simulations;
+    m_seed = source.m_seed;
+    m_simd = source.m_simd;
+    m_variance_reduction = source.m_variance_reduction;
+    m_martingale_correction = source.m_martingale_correction;
+    m_priority = source.m_priority;
+
+    return *this;
+}
+
+// Set the Heston parameters
+HestonMonteCarlo& HestonMonteCarlo::heston(const HestonParams& heston)
+{
+    ValidateHeston(heston, "heston");
+
+    m_heston = heston;
+    return *this;
+}
+
+// Set the number of subintervals
+HestonMonteCarlo& HestonMonteCarlo::subintervals(const long& subintervals)
+{
+    if (subintervals < 1)
+        throw std::invalid_argument("subintervals: at least one subinterval is needed");
+
+    m_subintervals = subintervals;
+    return *this;
+}
+
+// Set the number of simulations
+HestonMonteCarlo& HestonMonteCarlo::simulations(const long& simulations)
+{
+    if (simulations < 2)
+        throw std::invalid_argument("simulations: at least two simulations are needed to estimate the variance");
+
+    m_simulations = simulations;
+    return *this;
+}
+
+// Set the seed of the counter-based random number generator
+HestonMonteCarlo& HestonMonteCarlo::seed(const unsigned long long& seed)
+{
+    m_seed = seed;
+    return *this;
+}
+
+// Set the instruction set of the Heston kernel
+HestonMonteCarlo& HestonMonteCarlo::simd(const SimdLevel& level)
+{
+    m_simd = level;
+    return *this;
+}
+
+// Set the variance-reduction technique
+HestonMonteCarlo& HestonMonteCarlo::variance_reduction(const VarianceReduction& technique)
+{
+    m_variance_reduction = technique;
+    return *this;
+}
+
+// Set whether the martingale correction is applied
+HestonMonteCarlo& HestonMonteCarlo::martingale_correction(const bool& correction)
+{
+    m_martingale_correction = correction;
+    return *this;
+}
+
+// Set the priority of the chunks in the shared thread pool
+HestonMonteCarlo& HestonMonteCarlo::priority(const Priority& priority)
+{
+    m_priority = priority;
+    return *this;
+}
+
+// Select the Heston kernel and fill the constants of the QE scheme
+HestonKernel HestonMonteCarlo::Kernel(HestonKernelParams& params) const
+{
+    // Extract the parameters
+    const double kappa = m_heston.kappa;
+    const double theta = m_heston.theta;
+    const double xi = m_heston.xi;
+    const double rho = m_heston.rho;
+    const double tn = this->T() / m_subintervals;
+
+    // Moments of the variance transition over a subinterval
+    const double decay = std::exp(-kappa * tn);
+
+    params.S = this->S();
+    params.v0 = m_heston.v0;
+    params.steps = m_subintervals;
+    params.seed = m_seed;
+    params.drift = this->b() * tn;
+    params.decay = decay;
+    params.theta = theta;
+    params.variance_v = xi * xi * decay * (1.0 - decay) / kappa;
+    params.variance_const = theta * xi * xi * (1.0 - decay) * (1.0 - decay) / (2.0 * kappa);
+
+    // Log-spot coefficients of the central discretization, gamma1 = gamma2 = 1/2
+    const double gamma = 0.5 * tn;
+    params.k0 = -rho * kappa * theta * tn / xi;
+    params.k1 = gamma * (kappa * rho / xi - 0.5) - rho / xi;
+    params.k2 = gamma * (kappa * rho / xi - 0.5) + rho / xi;
+    params.k3 = gamma * (1.0 - rho * rho);
+    params.k4 = gamma * (1.0 - rho * rho);
+    params.psi_c = 1.5;
+    params.martingale = m_martingale_correction;
+
+    return SelectPathKernels(m_simd).heston_qe;
+}
+
+// Define the Price function
+MCResult HestonMonteCarlo::Price() const
+{
+    // Compare the option type once and dispatch to the payoff specialization
+    if (this->type() == "Call")
+        return PricePayoff(CallPayoff(this->K()));
+
+    return PricePayoff(PutPayoff(this->K()));
+}
@@ -0,0 +1,181 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// HestonMonteCarlo.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the derived HestonMonteCarlo class
+
+// If HESTONMONTECARLO_HPP is not defined
+#ifndef HESTONMONTECARLO_HPP
+// Define HESTONMONTECARLO_HPP
+#define HESTONMONTECARLO_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "CpuFeatures.hpp"
+#include "EuropeanOption.hpp"
+#include "Heston.hpp"
+#include "MCResult.hpp"
+#include "PathKernel.hpp"
+#include "Payoffs.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
+
+// Define HestonMonteCarlo derived class from EuropeanOption, pricing under the Heston model (its sigma is not read)
+// The variance is stepped by Andersen's quadratic-exponential scheme, which matches the first two moments of the
+// exact non-central chi-square transition and never goes negative, so a few subintervals per year suffice where
+// Euler - Maruyama needs hundreds; the log-spot is integrated with the central discretization of the variance and,
+// optionally, Andersen's martingale correction. Blocks of paths are stepped across the SIMD lanes on the same
+// Philox generator and thread pool as MonteCarlo, and HestonPrice validates the prices
+class HestonMonteCarlo : public EuropeanOption
+{
+private:
+
+    // Declare private member variables
+    HestonParams m_heston;
+    long m_subintervals;
+    long m_simulations;
+    unsigned long long m_seed;
+    SimdLevel m_simd;
+    VarianceReduction m_variance_reduction;
+    bool m_martingale_correction;
+    Priority m_priority;
+
+    // Declare Kernel private function, selecting the kernel and filling the constants of the QE scheme
+    HestonKernel Kernel(HestonKernelParams& params) const;
+
+    // Number of paths simulated together by one chunk of the thread pool, the chunks are reduced in order
+    static const long chunk_size = 1024;
+
+public:
+
+    // Constructor
+    HestonMonteCarlo(const EuropeanOption& option, const HestonParams& heston, const long& subintervals = 32,
+        const long& simulations = 1e5, const unsigned long long& seed = 5489);
+
+    // Copy constructor
+    HestonMonteCarlo(const HestonMonteCarlo& source);
+
+    // Assignement operator
+    HestonMonteCarlo& operator=(const HestonMonteCarlo& source);
+
+    // Declare the Price function
+    MCResult Price() const;
+
+    // Declare the PricePayoff function, specialized at compile time for any payoff policy (see Payoffs.hpp)
+    template <class Payoff>
+    MCResult PricePayoff(const Payoff& payoff) const;
+
+    // Set the Heston parameters
+    HestonMonteCarlo& heston(const HestonParams& heston);
+
+    // Set the number of subintervals
+    HestonMonteCarlo& subintervals(const long& subintervals);
+
+    // Set the number of simulations
+    HestonMonteCarlo& simulations(const long& simulations);
+
+    // Set the seed of the counter-based random number generator
+    HestonMonteCarlo& seed(const unsigned long long& seed);
+
+    // Set the widest instruction set the Heston kernel may use (capped to what the CPU supports)
+    HestonMonteCarlo& simd(const SimdLevel& level);
+
+    // Set the variance-reduction technique (plain or antithetic)
+    HestonMonteCarlo& variance_reduction(const VarianceReduction& technique);
+
+    // Set whether the log-spot steps take Andersen's martingale correction, so the discounted spot is an exact martingale
+    HestonMonteCarlo& martingale_correction(const bool& correction);
+
+    // Set the priority of the chunks of this pricer in the shared thread pool
+    HestonMonteCarlo& priority(const Priority& priority);
+
+    // Get inline functions
+    // Get Heston parameters
+    const HestonParams& heston() const { return m_heston; }
+    // Get number of subintervals
+    const long& subintervals() const { return m_subintervals; }
+    // Get number of simulations
+    const long& simulations() const { return m_simulations; }
+    // Get random number generator seed
+    const unsigned long long& seed() const { return m_seed; }
+    // Get instruction set of the Heston kernel
+    const SimdLevel& simd() const { return m_simd; }
+    // Get variance-reduction technique
+    const VarianceReduction& variance_reduction() const { return m_variance_reduction; }
+    // Get whether the martingale correction is applied
+    const bool& martingale_correction() const { return m_martingale_correction; }
+    // Get priority in the shared thread pool
+    const Priority& priority() const { return m_priority; }
+};
+
+// Define the PricePayoff function
+template <class Payoff>
+MCResult HestonMonteCarlo::PricePayoff(const Payoff& payoff) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const double discount = std::exp(-this->r() * this->T());
+
+    if (m_variance_reduction != VarianceReduction::None && m_variance_reduction != VarianceReduction::Antithetic)
+        throw std::invalid_argument("PricePayoff: only plain and antithetic sampling price Heston payoffs");
+
+    // Select the Heston kernel once
+    HestonKernelParams params = HestonKernelParams();
+    const HestonKernel kernel = Kernel(params);
+    const bool antithetic = m_variance_reduction == VarianceReduction::Antithetic;
+
+    // Split the simulations in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (m_simulations + chunk_size - 1) / chunk_size;
+    std::vector<SampleStatistics> chunk_statistics(n_chunks);
+
+    // Run the chunks of simulations on the shared thread pool
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Define the range of simulations of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, m_simulations - first);
+
+        // Simulate the terminal spots
+        std::vector<double> terminal(count);
+        std::vector<double> terminal_antithetic(antithetic ? count : 0);
+
+        PathBuffers out = PathBuffers();
+        out.terminal = terminal.data();
+        out.antithetic = antithetic ? terminal_antithetic.data() : 0;
+        kernel(params, first, count, out);
+
+        // Define chunk-local accumulator
+        SampleStatistics statistics;
+
+        for (long i = 0; i < count; ++i)
+        {
+            // Average the payoffs of the antithetic pair
+            if (antithetic)
+                statistics.Add(0.5 * (payoff(terminal[i]) + payoff(terminal_antithetic[i])));
+            else
+                statistics.Add(payoff(terminal[i]));
+        }
+
+        // Store the chunk results
+        chunk_statistics[c] = statistics;
+    }, m_priority);
+
+    // Merge the chunk statistics in chunk order, so the result is bit-identical for any number of threads
+    SampleStatistics statistics;
+    for (long c = 0; c < n_chunks; ++c)
+        statistics.Merge(chunk_statistics[c]);
+
+    // Discount the mean payoff and its standard error
+    MCResult result;
+    result.price = statistics.MeanX() * discount;
+    result.se = std::sqrt(statistics.VarianceX() / statistics.n) * discount;
+    result.simulations = m_simulations;
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+// End of the conditional inclusion of the header file
+#endif
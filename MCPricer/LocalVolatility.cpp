@@ -0,0 +1,264 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// LocalVolatility.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the LocalVolSurface class and its Dupire construction
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "LocalVolatility.hpp"
+
+namespace
+{
+    // Define NaturalSpline struct, the natural cubic spline through (x[i], y[i]), constant beyond its ends
+    struct NaturalSpline
+    {
+        std::vector<double> x;
+        std::vector<double> y;
+        // Second derivatives at the knots
+        std::vector<double> m;
+
+        NaturalSpline(const std::vector<double>& knots, const std::vector<double>& values) :
+            x(knots), y(values), m(knots.size(), 0.0)
+        {
+            // Solve the tridiagonal system of the second derivatives (Thomas algorithm), m = 0 at both ends
+            const long n = static_cast<long>(x.size());
+            std::vector<double> diagonal(n, 1.0), rhs(n, 0.0), upper(n, 0.0);
+
+            for (long i = 1; i + 1 < n; ++i)
+            {
+                const double h0 = x[i] - x[i - 1];
+                const double h1 = x[i + 1] - x[i];
+                const double lower = h0 / 6.0;
+                diagonal[i] = (h0 + h1) / 3.0 - lower * upper[i - 1];
+                upper[i] = h1 / 6.0 / diagonal[i];
+                rhs[i] = ((y[i + 1] - y[i]) / h1 - (y[i] - y[i - 1]) / h0 - lower * rhs[i - 1]) / diagonal[i];
+            }
+            for (long i = n - 2; i > 0; --i)
+                m[i] = rhs[i] - upper[i] * m[i + 1];
+        }
+
+        // Evaluate the value and the first two derivatives at t
+        void Evaluate(const double& t, double& value, double& first, double& second) const
+        {
+            const long n = static_cast<long>(x.size());
+            first = second = 0.0;
+
+            if (n == 1 || t <= x[0]) { value = y[0]; return; }
+            if (t >= x[n - 1]) { value = y[n - 1]; return; }
+
+            const long i = static_cast<long>(std::upper_bound(x.begin(), x.end(), t) - x.begin()) - 1;
+            const double h = x[i + 1] - x[i];
+            const double a = (x[i + 1] - t) / h;
+            const double b = (t - x[i]) / h;
+
+            value = a * y[i] + b * y[i + 1] + ((a * a * a - a) * m[i] + (b * b * b - b) * m[i + 1]) * h * h / 6.0;
+            first = (y[i + 1] - y[i]) / h + ((1.0 - 3.0 * a * a) * m[i] + (3.0 * b * b - 1.0) * m[i + 1]) * h / 6.0;
+            second = a * m[i] + b * m[i + 1];
+        }
+    };
+
+    // Get the slope at x of the parabola through (t0, w0), (t1, w1) and (t2, w2)
+    double ParabolaSlope(const double& t0, const double& w0, const double& t1, const double& w1, const double& t2,
+        const double& w2, const double& x)
+    {
+        return w0 * ((x - t1) + (x - t2)) / ((t0 - t1) * (t0 - t2))
+            + w1 * ((x - t0) + (x - t2)) / ((t1 - t0) * (t1 - t2))
+            + w2 * ((x - t0) + (x - t1)) / ((t2 - t0) * (t2 - t1));
+    }
+}
+
+// Constructor
+LocalVolSurface::LocalVolSurface(const std::vector<double>& times, const double& spot_min, const double& spot_max,
+    const long& nodes, const std::vector<double>& vols) :
+    m_times(times),
+    m_spot_min(spot_min),
+    m_spot_max(spot_max),
+    m_nodes(nodes),
+    m_stride(0),
+    m_vols()
+{
+    if (times.empty())
+        throw std::invalid_argument("LocalVolSurface: at least one time slice is needed");
+    for (std::size_t i = 0; i < times.size(); ++i)
+        if (!(times[i] >= 0.0) || (i > 0 && !(times[i] > times[i - 1])))
+            throw std::invalid_argument("LocalVolSurface: the times of the slices must be non-negative and increasing");
+    if (!(spot_min > 0.0) || !(spot_max > spot_min) || nodes < 2)
+        throw std::invalid_argument("LocalVolSurface: the nodes need 0 < spot_min < spot_max and at least two nodes");
+    if (vols.size() != times.size() * static_cast<std::size_t>(nodes))
+        throw std::invalid_argument("LocalVolSurface: every slice needs a volatility per node");
+
+    // Pad the rows to whole cache lines
+    const long per_line = static_cast<long>(cache_line_bytes / sizeof(double));
+    m_stride = (nodes + per_line - 1) / per_line * per_line;
+    m_vols.assign(times.size() * m_stride, 0.0);
+
+    for (std::size_t i = 0; i < times.size(); ++i)
+    {
+        for (long j = 0; j < nodes; ++j)
+        {
+            const double sigma = vols[i * nodes + j];
+            if (!(sigma >= 0.0) || !std::isfinite(sigma))
+                throw std::invalid_argument("LocalVolSurface: the volatilities must be finite and non-negative");
+            m_vols[i * m_stride + j] = sigma;
+        }
+    }
+}
+
+// Copy Constructor
+LocalVolSurface::LocalVolSurface(const LocalVolSurface& source) :
+    m_times(source.m_times),
+    m_spot_min(source.m_spot_min),
+    m_spot_max(source.m_spot_max),
+    m_nodes(source.m_nodes),
+    m_stride(source.m_stride),
+    m_vols(source.m_vols)
+{}
+
+// Assignment operator
+LocalVolSurface& LocalVolSurface::operator=(const LocalVolSurface& source)
+{
+    // Check for self assignment
+    if (this == &source)
+        return *this;
+
+    m_times = source.m_times;
+    m_spot_min = source.m_spot_min;
+    m_spot_max = source.m_spot_max;
+    m_nodes = source.m_nodes;
+    m_stride = source.m_stride;
+    m_vols = source.m_vols;
+
+    return *this;
+}
+
+// Get the view of the grid read by the kernels
+LocalVolGrid LocalVolSurface::Grid() const
+{
+    LocalVolGrid grid;
+    grid.times = m_times.data();
+    grid.slices = static_cast<long>(m_times.size());
+    grid.vols = m_vols.data();
+    grid.nodes = m_nodes;
+    grid.stride = m_stride;
+    grid.log_spot_min = std::log(m_spot_min);
+    grid.inverse_spacing = (m_nodes - 1) / std::log(m_spot_max / m_spot_min);
+
+    return grid;
+}
+
+// Get the local volatility at time t and spot S
+double LocalVolSurface::Volatility(const double& t, const double& S) const
+{
+    const LocalVolGrid grid = Grid();
+
+    // Node of the spot, as AdvanceLocalVolBlock
+    const double u = std::min(std::max((std::log(S) - grid.log_spot_min) * grid.inverse_spacing, 0.0),
+        static_cast<double>(m_nodes - 1));
+    const double cell = std::floor(std::min(u, static_cast<double>(m_nodes - 2)));
+    const double fraction = u - cell;
+    const long j = static_cast<long>(cell);
+
+    // Slice before t and the weight of the next one
+    const long slices = grid.slices;
+    long i = 0;
+    while (i + 1 < slices && m_times[i + 1] <= t)
+        ++i;
+    const double weight = (i + 1 < slices && t > m_times[i]) ? (t - m_times[i]) / (m_times[i + 1] - m_times[i]) : 0.0;
+
+    const double* lower = m_vols.data() + i * m_stride;
+    const double* upper = (i + 1 < slices) ? lower + m_stride : lower;
+    const double lower_vol = lower[j] + fraction * (lower[j + 1] - lower[j]);
+    const double upper_vol = upper[j] + fraction * (upper[j + 1] - upper[j]);
+
+    return lower_vol + weight * (upper_vol - lower_vol);
+}
+
+// Define the DupireLocalVolatility function
+LocalVolSurface DupireLocalVolatility(const double& S, const double& r, const double& q,
+    const std::vector<double>& maturities, const std::vector<double>& strikes, const std::vector<double>& implied_vols,
+    const long& nodes)
+{
+    const std::size_t n_maturities = maturities.size();
+    const std::size_t n_strikes = strikes.size();
+
+    if (!(S > 0.0) || n_maturities == 0 || n_strikes < 2 || nodes < 2)
+        throw std::invalid_argument("DupireLocalVolatility: a positive spot, a maturity, two strikes and two nodes are needed");
+    if (implied_vols.size() != n_maturities * n_strikes)
+        throw std::invalid_argument("DupireLocalVolatility: every maturity needs an implied volatility per strike");
+    for (std::size_t i = 0; i < n_maturities; ++i)
+        if (!(maturities[i] > 0.0) || (i > 0 && !(maturities[i] > maturities[i - 1])))
+            throw std::invalid_argument("DupireLocalVolatility: the maturities must be positive and increasing");
+    for (std::size_t j = 0; j < n_strikes; ++j)
+        if (!(strikes[j] > 0.0) || (j > 0 && !(strikes[j] > strikes[j - 1])))
+            throw std::invalid_argument("DupireLocalVolatility: the strikes must be positive and increasing");
+
+    // Total implied variance of every maturity as a spline in log-moneyness
+    std::vector<NaturalSpline> splines;
+    splines.reserve(n_maturities);
+    for (std::size_t i = 0; i < n_maturities; ++i)
+    {
+        const double T = maturities[i];
+        const double log_forward = std::log(S) + (r - q) * T;
+        std::vector<double> y(n_strikes), w(n_strikes);
+        for (std::size_t j = 0; j < n_strikes; ++j)
+        {
+            const double sigma = implied_vols[i * n_strikes + j];
+            if (!(sigma > 0.0))
+                throw std::invalid_argument("DupireLocalVolatility: the implied volatilities must be positive");
+            y[j] = std::log(strikes[j]) - log_forward;
+            w[j] = sigma * sigma * T;
+        }
+        splines.push_back(NaturalSpline(y, w));
+    }
+
+    // Nodes log-spaced over the strikes and the spot
+    const double spot_min = std::min(S, strikes.front());
+    const double spot_max = std::max(S, strikes.back());
+    const double spacing = std::log(spot_max / spot_min) / (nodes - 1);
+
+    const double variance_floor = 1e-8;
+    std::vector<double> vols(n_maturities * nodes);
+
+    for (std::size_t i = 0; i < n_maturities; ++i)
+    {
+        const double T = maturities[i];
+        const double log_forward = std::log(S) + (r - q) * T;
+
+        // Three maturities around the slice for the time derivative, the last slice taking the two before it,
+        // with T = 0 and w = 0 as the maturity before the first one
+        const long centre = std::min(static_cast<long>(i), static_cast<long>(n_maturities) - 2);
+
+        for (long j = 0; j < nodes; ++j)
+        {
+            const double y = std::log(spot_min) + j * spacing - log_forward;
+
+            double w, dw, d2w;
+            splines[i].Evaluate(y, w, dw, d2w);
+
+            // dw/dT at the same log-moneyness, from the parabola through the three maturities, or w / T for one
+            double dw_dT = w / T;
+            if (n_maturities > 1)
+            {
+                double t[3], v[3], first, second;
+                for (long k = 0; k < 3; ++k)
+                {
+                    const long index = centre - 1 + k;
+                    t[k] = (index >= 0) ? maturities[index] : 0.0;
+                    v[k] = 0.0;
+                    if (index >= 0)
+                        splines[index].Evaluate(y, v[k], first, second);
+                }
+                dw_dT = ParabolaSlope(t[0], v[0], t[1], v[1], t[2], v[2], T);
+            }
+
+            const double numerator = std::max(dw_dT, variance_floor);
+            const double denominator = std::max(1.0 - y / w * dw + 0.25 * (-0.25 - 1.0 / w + y * y / (w * w)) * dw * dw
+                + 0.5 * d2w, variance_floor);
+
+            vols[i * nodes + j] = std::min(std::max(std::sqrt(numerator / denominator), 1e-3), 5.0);
+        }
+    }
+
+    return LocalVolSurface(maturities, spot_min, spot_max, nodes, vols);
+}
@@ -0,0 +1,97 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// LocalVolatility.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the LocalVolSurface class and its Dupire construction
+
+// If LOCALVOLATILITY_HPP is not defined
+#ifndef LOCALVOLATILITY_HPP
+// Define LOCALVOLATILITY_HPP
+#define LOCALVOLATILITY_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "PathKernel.hpp"
+
+// Bytes of a cache line, the alignment of the rows of the local volatility grids
+const std::size_t cache_line_bytes = 64;
+
+// Define CacheAlignedAllocator, a standard allocator whose storage starts on a cache line
+template <class T>
+struct CacheAlignedAllocator
+{
+    typedef T value_type;
+
+    CacheAlignedAllocator() {}
+    template <class U> CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(const std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(cache_line_bytes)));
+    }
+
+    void deallocate(T* p, const std::size_t) { ::operator delete(p, std::align_val_t(cache_line_bytes)); }
+
+    template <class U> bool operator==(const CacheAlignedAllocator<U>&) const { return true; }
+    template <class U> bool operator!=(const CacheAlignedAllocator<U>&) const { return false; }
+};
+
+// Define LocalVolSurface class, a local volatility sigma(t, S) sampled once on a grid
+// Every time slice holds the volatilities at nodes equally spaced in log-spot, so the node of a spot is found
+// by arithmetic; the rows are padded to whole cache lines and aligned, and the simulation reads them through
+// LocalVolGrid with linear interpolation in log-spot and time (see PathKernel.hpp)
+class LocalVolSurface
+{
+private:
+
+    // Declare private member variables
+    std::vector<double> m_times;
+    double m_spot_min;
+    double m_spot_max;
+    long m_nodes;
+    long m_stride;
+    std::vector<double, CacheAlignedAllocator<double> > m_vols;
+
+public:
+
+    // Constructor, vols holding the volatility of time slice i at node j at vols[i * nodes + j], the nodes equally
+    // spaced in log-spot from spot_min to spot_max
+    LocalVolSurface(const std::vector<double>& times, const double& spot_min, const double& spot_max, const long& nodes,
+        const std::vector<double>& vols);
+
+    // Copy constructor
+    LocalVolSurface(const LocalVolSurface& source);
+
+    // Assignement operator
+    LocalVolSurface& operator=(const LocalVolSurface& source);
+
+    // Get the view of the grid read by the local-volatility kernels, valid while the surface lives
+    LocalVolGrid Grid() const;
+
+    // Get the local volatility at time t and spot S, interpolated as in the simulation
+    double Volatility(const double& t, const double& S) const;
+
+    // Get inline functions
+    // Get times of the slices
+    const std::vector<double>& times() const { return m_times; }
+    // Get spot of the first node
+    const double& spot_min() const { return m_spot_min; }
+    // Get spot of the last node
+    const double& spot_max() const { return m_spot_max; }
+    // Get number of nodes per slice
+    const long& nodes() const { return m_nodes; }
+};
+
+// Build the local volatility of an implied volatility grid with Dupire's formula in total implied variance w(T, y),
+// y = log(K / F(T)), of Gatheral:
+// sigma^2 = dw/dT / (1 - y / w * dw/dy + (-1/4 - 1/w + y^2 / w^2) * (dw/dy)^2 / 4 + d2w/dy2 / 2)
+// implied_vols holds the volatility of maturity i and strike j at implied_vols[i * strikes.size() + j]; every
+// maturity is interpolated by a natural cubic spline in y, flat beyond the strikes, and dw/dT is taken between
+// the neighbouring maturities (w = 0 at T = 0). The slices are the maturities, with nodes log-spaced over the strikes
+// and the spot; the variances of calendar or butterfly arbitrage are floored and sigma is kept within [1e-3, 5]
+LocalVolSurface DupireLocalVolatility(const double& S, const double& r, const double& q,
+    const std::vector<double>& maturities, const std::vector<double>& strikes, const std::vector<double>& implied_vols,
+    const long& nodes = 201);
+
+// End of the conditional inclusion of the header file
+#endif
@@ -0,0 +1,393 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// LongstaffSchwartz.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the derived LongstaffSchwartz class
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "LongstaffSchwartz.hpp"
+
+// Define the static constant, bound to references by std::min
+const long LongstaffSchwartz::chunk_size;
+
+// Constructor, with every continuation value 0
+ExercisePolicy::ExercisePolicy(const RegressionBasis& basis, const long& degree, const double& K, const long& dates) :
+    m_basis(basis),
+    m_size(degree + 1),
+    m_scale(1.0 / K),
+    m_coefficients((dates + 1) * (degree + 1), 0.0)
+{}
+
+// Evaluate the basis functions at the spot S
+void ExercisePolicy::Basis(const double& S, double* psi) const
+{
+    const double x = S * m_scale;
+    psi[0] = 1.0;
+
+    if (m_basis == RegressionBasis::Monomial)
+    {
+        for (long i = 1; i < m_size; ++i)
+            psi[i] = psi[i - 1] * x;
+        return;
+    }
+
+    // Weighted Laguerre polynomials from the recurrence (n + 1) * L(n + 1) = (2 * n + 1 - x) * L(n) - n * L(n - 1)
+    const double weight = std::exp(-0.5 * x);
+    double previous = 0.0;
+    double current = 1.0;
+    for (long n = 0; n + 1 < m_size; ++n)
+    {
+        psi[n + 1] = weight * current;
+        const double next = ((2 * n + 1 - x) * current - n * previous) / (n + 1);
+        previous = current;
+        current = next;
+    }
+}
+
+// Fit the continuation value of a date
+void ExercisePolicy::Fit(const long& date, const RegressionSums& sums)
+{
+    double* coefficients = m_coefficients.data() + date * m_size;
+
+    for (long i = 0; i < m_size; ++i)
+        coefficients[i] = 0.0;
+
+    if (sums.n == 0)
+        return;
+
+    // With fewer paths than basis functions the continuation value is their mean cash flow
+    const long size = (sums.n < m_size) ? 1 : m_size;
+
+    // Equilibrate the normal equations by the square roots of their diagonal (the powers of x spread over orders
+    // of magnitude), then solve them by Gaussian elimination with partial pivoting
+    double a[max_regression_basis][max_regression_basis];
+    double b[max_regression_basis];
+    double scale[max_regression_basis];
+
+    for (long i = 0; i < size; ++i)
+        scale[i] = (sums.a[i][i] > 0.0) ? 1.0 / std::sqrt(sums.a[i][i]) : 0.0;
+
+    for (long i = 0; i < size; ++i)
+    {
+        for (long j = 0; j < size; ++j)
+            a[i][j] = (j <= i ? sums.a[i][j] : sums.a[j][i]) * scale[i] * scale[j];
+        b[i] = sums.b[i] * scale[i];
+    }
+
+    for (long k = 0; k < size; ++k)
+    {
+        long pivot = k;
+        for (long i = k + 1; i < size; ++i)
+            if (std::fabs(a[i][k]) > std::fabs(a[pivot][k]))
+                pivot = i;
+
+        for (long j = 0; j < size; ++j)
+            std::swap(a[k][j], a[pivot][j]);
+        std::swap(b[k], b[pivot]);
+
+        // A basis function that is a combination of the previous ones on these paths gets no weight
+        if (std::fabs(a[k][k]) < 1e-12)
+        {
+            for (long j = 0; j < size; ++j)
+                a[k][j] = (j == k) ? 1.0 : 0.0;
+            b[k] = 0.0;
+            continue;
+        }
+
+        for (long i = k + 1; i < size; ++i)
+        {
+            const double factor = a[i][k] / a[k][k];
+            for (long j = k; j < size; ++j)
+                a[i][j] -= factor * a[k][j];
+            b[i] -= factor * b[k];
+        }
+    }
+
+    for (long i = size - 1; i >= 0; --i)
+    {
+        double sum = b[i];
+        for (long j = i + 1; j < size; ++j)
+            sum -= a[i][j] * coefficients[j];
+        coefficients[i] = sum / a[i][i];
+    }
+
+    for (long i = 0; i < size; ++i)
+        coefficients[i] *= scale[i];
+}
+
+// Get the continuation value at a date and a spot
+double ExercisePolicy::Continuation(const long& date, const double& S) const
+{
+    double psi[max_regression_basis];
+    Basis(S, psi);
+
+    const double* coefficients = m_coefficients.data() + date * m_size;
+    double value = 0.0;
+    for (long i = 0; i < m_size; ++i)
+        value += coefficients[i] * psi[i];
+
+    return value;
+}
+
+// Constructor
+LongstaffSchwartz::LongstaffSchwartz(const EuropeanOption& option, const long& exercise_dates, const long& simulations,
+    const unsigned long long& seed) :
+    EuropeanOption(option),
+    m_exercise_dates(exercise_dates),
+    m_date_steps(1),
+    m_simulations(simulations),
+    m_pricing_simulations(simulations),
+    m_dual_paths(500),
+    m_inner_paths(500),
+    m_basis(RegressionBasis::Laguerre),
+    m_degree(3),
+    m_storage(PathStorage::Auto),
+    m_memory_limit(1073741824.0),
+    m_seed(seed),
+    m_scheme(Scheme::Auto),
+    m_simd(DetectSimdLevel()),
+    m_priority(Priority::Normal)
+{}
+
+// Copy Constructor
+LongstaffSchwartz::LongstaffSchwartz(const LongstaffSchwartz& source) :
+    EuropeanOption(source),
+    m_exercise_dates(source.m_exercise_dates),
+    m_date_steps(source.m_date_steps),
+    m_simulations(source.m_simulations),
+    m_pricing_simulations(source.m_pricing_simulations),
+    m_dual_paths(source.m_dual_paths),
+    m_inner_paths(source.m_inner_paths),
+    m_basis(source.m_basis),
+    m_degree(source.m_degree),
+    m_storage(source.m_storage),
+    m_memory_limit(source.m_memory_limit),
+    m_seed(source.m_seed),
+    m_scheme(source.m_scheme),
+    m_simd(source.m_simd),
+    m_priority(source.m_priority)
+{}
+
+// Assignment operator
+LongstaffSchwartz& LongstaffSchwartz::operator=(const LongstaffSchwartz& source)
+{
+    // Check for self assignment
+    if (this == &source)
+        return *this;
+
+    EuropeanOption::operator=(source);
+    m_exercise_dates = source.m_exercise_dates;
+    m_date_steps = source.m_date_steps;
+    m_simulations = source.m_simulations;
+    m_pricing_simulations = source.m_pricing_simulations;
+    m_dual_paths = source.m_dual_paths;
+    m_inner_paths = source.m_inner_paths;
+    m_basis = source.m_basis;
+    m_degree = source.m_degree;
+    m_storage = source.m_storage;
+    m_memory_limit = source.m_memory_limit;
+    m_seed = source.m_seed;
+    m_scheme = source.m_scheme;
+    m_simd = source.m_simd;
+    m_priority = source.m_priority;
+
+    return *this;
+}
+
+// Set the number of exercise dates
+LongstaffSchwartz& LongstaffSchwartz::exercise_dates(const long& dates)
+{
+    if (dates < 1)
+        throw std::invalid_argument("exercise_dates: at least one exercise date is needed");
+
+    m_exercise_dates = dates;
+    return *this;
+}
+
+// Set the number of subintervals between two exercise dates
+LongstaffSchwartz& LongstaffSchwartz::date_steps(const long& steps)
+{
+    if (steps < 1)
+        throw std::invalid_argument("date_steps: at least one subinterval per exercise date is needed");
+
+    m_date_steps = steps;
+    return *this;
+}
+
+// Set the number of regression paths
+LongstaffSchwartz& LongstaffSchwartz::simulations(const long& simulations)
+{
+    if (simulations < 1)
+        throw std::invalid_argument("simulations: at least one regression path is needed");
+
+    m_simulations = simulations;
+    return *this;
+}
+
+// Set the number of pricing paths
+LongstaffSchwartz& LongstaffSchwartz::pricing_simulations(const long& simulations)
+{
+    if (simulations < 2)
+        throw std::invalid_argument("pricing_simulations: at least two paths are needed to estimate the variance");
+
+    m_pricing_simulations = simulations;
+    return *this;
+}
+
+// Set the number of outer dual paths
+LongstaffSchwartz& LongstaffSchwartz::dual_paths(const long& paths)
+{
+    if (paths < 0 || paths == 1)
+        throw std::invalid_argument("dual_paths: 0 disables the dual, otherwise at least two paths are needed");
+
+    m_dual_paths = paths;
+    return *this;
+}
+
+// Set the number of inner dual paths
+LongstaffSchwartz& LongstaffSchwartz::inner_paths(const long& paths)
+{
+    if (paths < 1)
+        throw std::invalid_argument("inner_paths: at least one inner path is needed");
+
+    m_inner_paths = paths;
+    return *this;
+}
+
+// Set the regression basis
+LongstaffSchwartz& LongstaffSchwartz::basis(const RegressionBasis& basis)
+{
+    m_basis = basis;
+    return *this;
+}
+
+// Set the degree of the regression basis
+LongstaffSchwartz& LongstaffSchwartz::degree(const long& degree)
+{
+    if (degree < 0 || degree >= max_regression_basis)
+        throw std::invalid_argument("degree: the degree must be between 0 and " + std::to_string(max_regression_basis - 1));
+
+    m_degree = degree;
+    return *this;
+}
+
+// Set the storage of the regression paths
+LongstaffSchwartz& LongstaffSchwartz::storage(const PathStorage& storage)
+{
+    m_storage = storage;
+    return *this;
+}
+
+// Set the memory limit of the stored paths
+LongstaffSchwartz& LongstaffSchwartz::memory_limit(const double& bytes)
+{
+    if (!(bytes > 0.0))
+        throw std::invalid_argument("memory_limit: the limit must be positive");
+
+    m_memory_limit = bytes;
+    return *this;
+}
+
+// Set the seed of the counter-based random number generator
+LongstaffSchwartz& LongstaffSchwartz::seed(const unsigned long long& seed)
+{
+    m_seed = seed;
+    return *this;
+}
+
+// Set the discretization scheme
+LongstaffSchwartz& LongstaffSchwartz::scheme(const Scheme& scheme)
+{
+    m_scheme = scheme;
+    return *this;
+}
+
+// Set the instruction set of the path kernels
+LongstaffSchwartz& LongstaffSchwartz::simd(const SimdLevel& level)
+{
+    m_simd = level;
+    return *this;
+}
+
+// Set the priority of the chunks in the shared thread pool
+LongstaffSchwartz& LongstaffSchwartz::priority(const Priority& priority)
+{
+    m_priority = priority;
+    return *this;
+}
+
+// Select the kernel and constants that simulate the exercise dates
+PathKernel LongstaffSchwartz::ExerciseKernel(const double& beta, KernelParams& params) const
+{
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double sigma = this->sigma();
+    const ModelType model = ClassifyBeta(beta);
+
+    // Precompute the constants of the grid of the exercise dates
+    const long steps = m_exercise_dates * m_date_steps;
+    const double tn = T / steps;
+
+    params = KernelParams();
+    params.S = this->S();
+    params.beta = beta;
+    params.steps = steps;
+    params.seed = m_seed;
+    params.sigma = sigma;
+    params.dt = tn;
+    params.diffusion_const = sigma * std::sqrt(tn);
+    params.first_step = 0;
+    params.date_steps = m_date_steps;
+
+    const PathKernels& kernels = SelectPathKernels(m_simd);
+
+    // GBM takes exact log-normal steps, so the spots at the exercise dates carry no discretization bias
+    if (model == ModelType::GBM && m_scheme == Scheme::Auto)
+    {
+        params.drift_const = (r - 0.5 * sigma * sigma) * tn;
+        return kernels.exercise_exact_steps;
+    }
+
+    params.drift_const = r * tn;
+    return kernels.exercise_euler[static_cast<int>(model)];
+}
+
+// Resolve the storage of the regression paths
+PathStorage LongstaffSchwartz::Storage() const
+{
+    if (m_storage != PathStorage::Auto)
+        return m_storage;
+
+    // Stored paths take a float per path and date
+    const double bytes = static_cast<double>(m_simulations) * m_exercise_dates * sizeof(float);
+    return (bytes <= m_memory_limit) ? PathStorage::Stored : PathStorage::Replay;
+}
+
+// Get the constants of the inner paths started at a date of an outer path
+KernelParams LongstaffSchwartz::InnerParams(const KernelParams& params, const long& path, const long& date,
+    const double& S) const
+{
+    KernelParams inner = params;
+    inner.S = S;
+    inner.first_step = date * m_date_steps;
+    inner.steps = (m_exercise_dates - date) * m_date_steps;
+
+    // Every date of every outer path draws from its own Philox key, independent of the outer paths
+    const unsigned long long stream = static_cast<unsigned long long>(path) * (m_exercise_dates + 1) + date + 1;
+    inner.seed = m_seed + stream * 0x9E3779B97F4A7C15ull;
+
+    return inner;
+}
+
+// Define the Price function
+LSMResult LongstaffSchwartz::Price(const double& beta) const
+{
+    // Compare the option type once and dispatch to the payoff specialization
+    if (this->type() == "Call")
+        return PricePayoff(CallPayoff(this->K()), beta);
+
+    return PricePayoff(PutPayoff(this->K()), beta);
+}
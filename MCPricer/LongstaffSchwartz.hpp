@@ -0,0 +1,628 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// LongstaffSchwartz.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the derived LongstaffSchwartz class
+
+// If LONGSTAFFSCHWARTZ_HPP is not defined
+#ifndef LONGSTAFFSCHWARTZ_HPP
+// Define LONGSTAFFSCHWARTZ_HPP
+#define LONGSTAFFSCHWARTZ_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "CpuFeatures.hpp"
+#include "EuropeanOption.hpp"
+#include "MCResult.hpp"
+#include "Models.hpp"
+#include "PathKernel.hpp"
+#include "Payoffs.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
+
+// Regression bases of the continuation values, in the moneyness x = S / K
+enum class RegressionBasis
+{
+    // 1, x, x^2, ..., x^degree
+    Monomial,
+    // 1 and the weighted Laguerre polynomials exp(-x / 2) * L_n(x) for n < degree (Longstaff and Schwartz, 2001)
+    Laguerre
+};
+
+// Storage of the regression paths between the forward simulation and the backward regressions
+enum class PathStorage
+{
+    // Stored when they fit in the memory limit, replayed otherwise
+    Auto,
+    // Spots at every exercise date stored as float, dates x paths
+    Stored,
+    // Spots stored in double every sqrt(dates) dates, the dates in between recomputed from these checkpoints with the
+    // same normals when the backward regressions reach them, for one extra forward simulation in total
+    Replay
+};
+
+// Largest number of basis functions of a regression
+const long max_regression_basis = 9;
+
+// Define RegressionSums struct, the normal equations of a least-squares regression on the basis functions
+struct RegressionSums
+{
+    // Sums of psi_i * psi_j (lower triangle) and of psi_i * y over the samples, and the number of samples
+    double a[max_regression_basis][max_regression_basis];
+    double b[max_regression_basis];
+    long n;
+
+    RegressionSums() : a(), b(), n(0) {}
+
+    // Add a sample y with the basis functions psi
+    void Add(const double* psi, const long& size, const double& y)
+    {
+        for (long i = 0; i < size; ++i)
+        {
+            for (long j = 0; j <= i; ++j)
+                a[i][j] += psi[i] * psi[j];
+            b[i] += psi[i] * y;
+        }
+        ++n;
+    }
+
+    // Merge the sums of another set of samples
+    void Merge(const RegressionSums& other, const long& size)
+    {
+        for (long i = 0; i < size; ++i)
+        {
+            for (long j = 0; j <= i; ++j)
+                a[i][j] += other.a[i][j];
+            b[i] += other.b[i];
+        }
+        n += other.n;
+    }
+};
+
+// Define ExercisePolicy class, the regressed continuation values of every exercise date
+// The policy exercises at date d when the discounted payoff is positive and not below the continuation value,
+// which is 0 at the last date
+class ExercisePolicy
+{
+private:
+
+    RegressionBasis m_basis;
+    long m_size;
+    double m_scale;
+    // Coefficients of dates 0 to dates, date after date
+    std::vector<double> m_coefficients;
+
+public:
+
+    // Constructor, with every continuation value 0
+    ExercisePolicy(const RegressionBasis& basis, const long& degree, const double& K, const long& dates);
+
+    // Evaluate the basis functions at the spot S
+    void Basis(const double& S, double* psi) const;
+
+    // Fit the continuation value of a date to the normal equations of its in-the-money paths
+    void Fit(const long& date, const RegressionSums& sums);
+
+    // Get the continuation value at a date and a spot
+    double Continuation(const long& date, const double& S) const;
+
+    // Get the number of basis functions
+    const long& size() const { return m_size; }
+};
+
+// Define LongstaffSchwartz derived class from EuropeanOption (Longstaff and Schwartz, 2001)
+// Prices the option with early exercise at exercise_dates equally spaced dates up to maturity (American as the
+// dates grow), on the Euler - Maruyama grid of every beta or exact log-normal steps for GBM.
+// The continuation values are regressed backwards on the in-the-money regression paths, with the normal equations
+// of every date accumulated in parallel over fixed chunks. The policy is then applied to independent paths for a
+// low-biased price, and the Andersen - Broadie dual with inner simulations gives a high-biased price, so the two
+// bound the price
+class LongstaffSchwartz : public EuropeanOption
+{
+private:
+
+    // Declare private member variables
+    long m_exercise_dates;
+    long m_date_steps;
+    long m_simulations;
+    long m_pricing_simulations;
+    long m_dual_paths;
+    long m_inner_paths;
+    RegressionBasis m_basis;
+    long m_degree;
+    PathStorage m_storage;
+    double m_memory_limit;
+    unsigned long long m_seed;
+    Scheme m_scheme;
+    SimdLevel m_simd;
+    Priority m_priority;
+
+    // Declare ExerciseKernel private function, selecting the kernel and constants that simulate the exercise dates
+    PathKernel ExerciseKernel(const double& beta, KernelParams& params) const;
+
+    // Declare Storage private function, resolving PathStorage::Auto against the memory limit
+    PathStorage Storage() const;
+
+    // Declare InnerParams private function, the constants of the inner paths started at a date of an outer path,
+    // each with its own Philox key
+    KernelParams InnerParams(const KernelParams& params, const long& path, const long& date, const double& S) const;
+
+    // Declare Regress private function, simulating the regression paths and fitting the policy backwards
+    // Returns the in-sample mean of the discounted cash flows of the policy after date 0
+    template <class Payoff>
+    double Regress(const Payoff& payoff, const PathKernel& kernel, const KernelParams& params,
+        const std::vector<double>& discounts, ExercisePolicy& policy, double& path_bytes) const;
+
+    // Declare InnerContinuation private function, the continuation value of the policy at a date of an outer path
+    // estimated by inner paths; dates and terminal hold the spots of the inner paths
+    template <class Payoff>
+    double InnerContinuation(const Payoff& payoff, const PathKernel& kernel, const KernelParams& params,
+        const std::vector<double>& discounts, const ExercisePolicy& policy, const long& path, const long& date,
+        const double& S, std::vector<float>& dates, std::vector<double>& terminal) const;
+
+    // Number of paths simulated together by one chunk of the thread pool, the chunks are reduced in order
+    static const long chunk_size = 1024;
+
+public:
+
+    // Constructor
+    LongstaffSchwartz(const EuropeanOption& option, const long& exercise_dates = 50, const long& simulations = 1e5,
+        const unsigned long long& seed = 5489);
+
+    // Copy constructor
+    LongstaffSchwartz(const LongstaffSchwartz& source);
+
+    // Assignement operator
+    LongstaffSchwartz& operator=(const LongstaffSchwartz& source);
+
+    // Declare the Price function
+    LSMResult Price(const double& beta = 1) const;
+
+    // Declare the PricePayoff function, specialized at compile time for any payoff policy (see Payoffs.hpp)
+    template <class Payoff>
+    LSMResult PricePayoff(const Payoff& payoff, const double& beta = 1) const;
+
+    // Set the number of exercise dates, equally spaced up to maturity
+    LongstaffSchwartz& exercise_dates(const long& dates);
+
+    // Set the number of subintervals between two exercise dates
+    LongstaffSchwartz& date_steps(const long& steps);
+
+    // Set the number of regression paths
+    LongstaffSchwartz& simulations(const long& simulations);
+
+    // Set the number of independent paths the policy is priced on
+    LongstaffSchwartz& pricing_simulations(const long& simulations);
+
+    // Set the number of outer paths of the dual upper bound (0 disables it)
+    LongstaffSchwartz& dual_paths(const long& paths);
+
+    // Set the number of inner paths estimating every continuation value of the dual
+    LongstaffSchwartz& inner_paths(const long& paths);
+
+    // Set the regression basis
+    LongstaffSchwartz& basis(const RegressionBasis& basis);
+
+    // Set the degree of the regression basis
+    LongstaffSchwartz& degree(const long& degree);
+
+    // Set the storage of the regression paths
+    LongstaffSchwartz& storage(const PathStorage& storage);
+
+    // Set the bytes the stored regression paths may take before PathStorage::Auto replays them
+    LongstaffSchwartz& memory_limit(const double& bytes);
+
+    // Set the seed of the counter-based random number generator
+    LongstaffSchwartz& seed(const unsigned long long& seed);
+
+    // Set the discretization scheme (Scheme::Auto takes exact log-normal steps for GBM)
+    LongstaffSchwartz& scheme(const Scheme& scheme);
+
+    // Set the widest instruction set the path kernels may use (capped to what the CPU supports)
+    LongstaffSchwartz& simd(const SimdLevel& level);
+
+    // Set the priority of the chunks of this pricer in the shared thread pool
+    LongstaffSchwartz& priority(const Priority& priority);
+
+    // Get inline functions
+    // Get number of exercise dates
+    const long& exercise_dates() const { return m_exercise_dates; }
+    // Get number of subintervals between two exercise dates
+    const long& date_steps() const { return m_date_steps; }
+    // Get number of regression paths
+    const long& simulations() const { return m_simulations; }
+    // Get number of pricing paths
+    const long& pricing_simulations() const { return m_pricing_simulations; }
+    // Get number of outer dual paths
+    const long& dual_paths() const { return m_dual_paths; }
+    // Get number of inner dual paths
+    const long& inner_paths() const { return m_inner_paths; }
+    // Get regression basis
+    const RegressionBasis& basis() const { return m_basis; }
+    // Get degree of the regression basis
+    const long& degree() const { return m_degree; }
+    // Get storage of the regression paths
+    const PathStorage& storage() const { return m_storage; }
+    // Get memory limit of the stored paths in bytes
+    const double& memory_limit() const { return m_memory_limit; }
+    // Get random number generator seed
+    const unsigned long long& seed() const { return m_seed; }
+    // Get discretization scheme
+    const Scheme& scheme() const { return m_scheme; }
+    // Get instruction set of the path kernels
+    const SimdLevel& simd() const { return m_simd; }
+    // Get priority in the shared thread pool
+    const Priority& priority() const { return m_priority; }
+};
+
+// Define the Regress function
+template <class Payoff>
+double LongstaffSchwartz::Regress(const Payoff& payoff, const PathKernel& kernel, const KernelParams& params,
+    const std::vector<double>& discounts, ExercisePolicy& policy, double& path_bytes) const
+{
+    const long dates = m_exercise_dates;
+    const long n_paths = m_simulations;
+    const long n_chunks = (n_paths + chunk_size - 1) / chunk_size;
+    const long size = policy.size();
+
+    // Replay splits the dates in segments of about sqrt(dates) dates, only the spots of one segment are held as float
+    // with the double spots at the end of every other segment; stored paths are a single segment
+    const bool replay = Storage() == PathStorage::Replay;
+    const long segment = replay ? static_cast<long>(std::ceil(std::sqrt(static_cast<double>(dates)))) : dates;
+    const long n_segments = (dates + segment - 1) / segment;
+
+    std::vector<float> spots(static_cast<std::size_t>(segment) * n_paths);
+    std::vector<double> checkpoints(static_cast<std::size_t>(n_segments - 1) * n_paths);
+    // Discounted cash flow of every path following the policy after the date being regressed
+    std::vector<double> cash(n_paths);
+
+    path_bytes = static_cast<double>(spots.size() * sizeof(float) + checkpoints.size() * sizeof(double)
+        + cash.size() * sizeof(double));
+
+    // Simulate the dates of a segment into the spots, from its checkpoint
+    const auto simulate_segment = [&](const long& g)
+    {
+        KernelParams segment_params = params;
+        segment_params.first_step = g * segment * params.date_steps;
+        segment_params.steps = (std::min(dates, (g + 1) * segment) - g * segment) * params.date_steps;
+
+        ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+        {
+            const long first = c * chunk_size;
+            const long count = std::min(chunk_size, n_paths - first);
+            double terminal[chunk_size];
+
+            PathBuffers out = PathBuffers();
+            out.terminal = terminal;
+            out.initial = (g > 0) ? checkpoints.data() + (g - 1) * n_paths + first : 0;
+            out.dates = spots.data() + first;
+            out.date_stride = n_paths;
+            kernel(segment_params, first, count, out);
+        }, m_priority);
+    };
+
+    // Forward pass of the replay: keep the spots at the end of every segment but the last one
+    if (replay)
+    {
+        ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+        {
+            const long first = c * chunk_size;
+            const long count = std::min(chunk_size, n_paths - first);
+
+            KernelParams segment_params = params;
+            segment_params.steps = segment * params.date_steps;
+
+            PathBuffers out = PathBuffers();
+            for (long g = 0; g + 1 < n_segments; ++g)
+            {
+                segment_params.first_step = g * segment * params.date_steps;
+                out.initial = (g > 0) ? checkpoints.data() + (g - 1) * n_paths + first : 0;
+                out.terminal = checkpoints.data() + g * n_paths + first;
+                kernel(segment_params, first, count, out);
+            }
+        }, m_priority);
+    }
+
+    // Spots of the last segment, the whole paths when stored
+    long loaded = n_segments - 1;
+    simulate_segment(loaded);
+
+    // Get the spots of a date of the loaded segment
+    const auto date_spots = [&](const long& d) -> const float*
+    {
+        return spots.data() + static_cast<std::size_t>(d - 1 - loaded * segment) * n_paths;
+    };
+
+    // The cash flows at maturity are the discounted payoffs
+    const float* last = date_spots(dates);
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        const long first = c * chunk_size;
+        const long end = std::min(first + chunk_size, n_paths);
+        for (long i = first; i < end; ++i)
+            cash[i] = discounts[dates] * payoff(static_cast<double>(last[i]));
+    }, m_priority);
+
+    std::vector<RegressionSums> chunk_sums(n_chunks);
+
+    for (long d = dates - 1; d >= 1; --d)
+    {
+        // Recompute the segment of the date from its checkpoint when the regressions leave the loaded one
+        if ((d - 1) / segment != loaded)
+        {
+            loaded = (d - 1) / segment;
+            simulate_segment(loaded);
+        }
+        const float* S = date_spots(d);
+
+        // Accumulate the normal equations of the in-the-money paths of every chunk
+        ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+        {
+            const long first = c * chunk_size;
+            const long end = std::min(first + chunk_size, n_paths);
+
+            RegressionSums sums;
+            double psi[max_regression_basis];
+            for (long i = first; i < end; ++i)
+            {
+                if (payoff(static_cast<double>(S[i])) > 0.0)
+                {
+                    policy.Basis(S[i], psi);
+                    sums.Add(psi, size, cash[i]);
+                }
+            }
+            chunk_sums[c] = sums;
+        }, m_priority);
+
+        // Merge the chunk sums in chunk order, so the regression is bit-identical for any number of threads
+        RegressionSums sums;
+        for (long c = 0; c < n_chunks; ++c)
+            sums.Merge(chunk_sums[c], size);
+        policy.Fit(d, sums);
+
+        // Exercise the paths where the payoff beats the regressed continuation value
+        ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+        {
+            const long first = c * chunk_size;
+            const long end = std::min(first + chunk_size, n_paths);
+            for (long i = first; i < end; ++i)
+            {
+                const double h = discounts[d] * payoff(static_cast<double>(S[i]));
+                if (h > 0.0 && h >= policy.Continuation(d, S[i]))
+                    cash[i] = h;
+            }
+        }, m_priority);
+    }
+
+    // Average the cash flows in chunk order
+    SampleStatistics statistics;
+    for (long c = 0; c < n_chunks; ++c)
+    {
+        SampleStatistics chunk;
+        for (long i = c * chunk_size; i < std::min((c + 1) * chunk_size, n_paths); ++i)
+            chunk.Add(cash[i]);
+        statistics.Merge(chunk);
+    }
+
+    return statistics.MeanX();
+}
+
+// Define the InnerContinuation function
+template <class Payoff>
+double LongstaffSchwartz::InnerContinuation(const Payoff& payoff, const PathKernel& kernel, const KernelParams& params,
+    const std::vector<double>& discounts, const ExercisePolicy& policy, const long& path, const long& date,
+    const double& S, std::vector<float>& dates, std::vector<double>& terminal) const
+{
+    const long n_inner = m_inner_paths;
+
+    // Simulate the inner paths from the spot of the outer path to maturity
+    PathBuffers out = PathBuffers();
+    out.terminal = terminal.data();
+    out.dates = dates.data();
+    out.date_stride = n_inner;
+    kernel(InnerParams(params, path, date, S), 0, n_inner, out);
+
+    // Follow the policy on every inner path from the next date on
+    double sum = 0.0;
+    for (long j = 0; j < n_inner; ++j)
+    {
+        for (long d = date + 1; d <= m_exercise_dates; ++d)
+        {
+            const double spot = dates[(d - date - 1) * n_inner + j];
+            const double h = discounts[d] * payoff(spot);
+            if (h > 0.0 && h >= policy.Continuation(d, spot))
+            {
+                sum += h;
+                break;
+            }
+        }
+    }
+
+    return sum / n_inner;
+}
+
+// Define the PricePayoff function
+template <class Payoff>
+LSMResult LongstaffSchwartz::PricePayoff(const Payoff& payoff, const double& beta) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const long dates = m_exercise_dates;
+
+    // Select the path kernel once
+    KernelParams params = KernelParams();
+    const PathKernel kernel = ExerciseKernel(beta, params);
+
+    // Discount factors of the exercise dates
+    std::vector<double> discounts(dates + 1);
+    for (long d = 0; d <= dates; ++d)
+        discounts[d] = std::exp(-this->r() * this->T() * d / dates);
+
+    LSMResult result;
+
+    // Fit the exercise policy on the regression paths
+    ExercisePolicy policy(m_basis, m_degree, this->K(), dates);
+    const double continuation = Regress(payoff, kernel, params, discounts, policy, result.path_bytes);
+    result.regression_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Exercise at once when the payoff beats the in-sample continuation value
+    const double h0 = payoff(this->S());
+    const bool exercise_now = h0 > 0.0 && h0 >= continuation;
+    result.regression_price = std::max(h0, continuation);
+
+    // Apply the policy to independent paths, the pricing paths follow the regression paths in the Philox counter
+    const long n_pricing = m_pricing_simulations;
+    const long n_chunks = (n_pricing + chunk_size - 1) / chunk_size;
+    std::vector<SampleStatistics> chunk_statistics(exercise_now ? 0 : n_chunks);
+
+    ThreadPool::Global().ParallelFor(static_cast<long>(chunk_statistics.size()), [&](const long c)
+    {
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, n_pricing - first);
+
+        // Step the chunk from date to date, in place, until every path has exercised
+        double s[chunk_size];
+        double value[chunk_size];
+        bool alive[chunk_size];
+        long n_alive = count;
+        for (long i = 0; i < count; ++i)
+        {
+            value[i] = 0.0;
+            alive[i] = true;
+        }
+
+        KernelParams step_params = params;
+        step_params.steps = params.date_steps;
+
+        PathBuffers out = PathBuffers();
+        out.terminal = s;
+
+        for (long d = 1; d <= dates && n_alive > 0; ++d)
+        {
+            step_params.first_step = (d - 1) * params.date_steps;
+            out.initial = (d > 1) ? s : 0;
+            kernel(step_params, m_simulations + first, count, out);
+
+            for (long i = 0; i < count; ++i)
+            {
+                if (!alive[i]) continue;
+
+                // Decide on the spot rounded to float, as the regression paths
+                const double spot = static_cast<float>(s[i]);
+                const double h = discounts[d] * payoff(spot);
+                if (h > 0.0 && h >= policy.Continuation(d, spot))
+                {
+                    value[i] = h;
+                    alive[i] = false;
+                    --n_alive;
+                }
+            }
+        }
+
+        SampleStatistics statistics;
+        for (long i = 0; i < count; ++i)
+            statistics.Add(value[i]);
+        chunk_statistics[c] = statistics;
+    }, m_priority);
+
+    // Merge the chunk statistics in chunk order, so the result is bit-identical for any number of threads
+    SampleStatistics lower;
+    for (const SampleStatistics& chunk : chunk_statistics)
+        lower.Merge(chunk);
+
+    result.price = exercise_now ? h0 : lower.MeanX();
+    result.se = exercise_now ? 0.0 : std::sqrt(lower.VarianceX() / lower.n);
+
+    // Andersen - Broadie dual: the martingale of the policy values, with the continuation values estimated by inner
+    // paths, bounds the price by E[max over the dates of (h_d - M_d)]
+    result.upper = std::numeric_limits<double>::quiet_NaN();
+    result.upper_se = std::numeric_limits<double>::quiet_NaN();
+
+    if (m_dual_paths > 0)
+    {
+        const long n_outer = m_dual_paths;
+        const long first_outer = m_simulations + n_pricing;
+        const long n_blocks = (n_outer + block_paths - 1) / block_paths;
+        std::vector<SampleStatistics> block_statistics(n_blocks);
+
+        ThreadPool::Global().ParallelFor(n_blocks, [&](const long c)
+        {
+            const long first = c * block_paths;
+            const long count = std::min(block_paths, n_outer - first);
+
+            // Simulate the outer paths of the block, the dual paths follow the pricing paths in the Philox counter
+            std::vector<float> outer(static_cast<std::size_t>(dates) * block_paths);
+            double terminal[block_paths];
+
+            PathBuffers out = PathBuffers();
+            out.terminal = terminal;
+            out.dates = outer.data();
+            out.date_stride = block_paths;
+            kernel(params, first_outer + first, count, out);
+
+            std::vector<float> inner_dates(static_cast<std::size_t>(dates) * m_inner_paths);
+            std::vector<double> inner_terminal(m_inner_paths);
+
+            SampleStatistics statistics;
+            for (long i = 0; i < count; ++i)
+            {
+                const long path = first_outer + first + i;
+
+                // Between two exercises the increments L(d + 1) - L(d) of the martingale telescope, so it is kept
+                // as M(d) = base + L(d), with the policy value L(d) only estimated where the max reads it: at the
+                // in-the-money dates, as a holder never exercises out of the money, and at maturity. An exercise
+                // at d adds h(d) - Q(d), with Q(d) the continuation value estimated by inner paths
+                double base = -InnerContinuation(payoff, kernel, params, discounts, policy, path, 0, this->S(),
+                    inner_dates, inner_terminal);
+                double best = h0;
+
+                for (long d = 1; d <= dates; ++d)
+                {
+                    const double spot = outer[(d - 1) * block_paths + i];
+                    const double h = discounts[d] * payoff(spot);
+
+                    if (d == dates)
+                    {
+                        best = std::max(best, -base);
+                        break;
+                    }
+
+                    if (!(h > 0.0))
+                        continue;
+
+                    const double continuation = InnerContinuation(payoff, kernel, params, discounts, policy, path, d,
+                        spot, inner_dates, inner_terminal);
+
+                    if (h >= policy.Continuation(d, spot))
+                    {
+                        best = std::max(best, -base);
+                        base += h - continuation;
+                    }
+                    else
+                        best = std::max(best, h - base - continuation);
+                }
+
+                statistics.Add(best);
+            }
+            block_statistics[c] = statistics;
+        }, m_priority);
+
+        SampleStatistics upper;
+        for (const SampleStatistics& block : block_statistics)
+            upper.Merge(block);
+
+        result.upper = upper.MeanX();
+        result.upper_se = std::sqrt(upper.VarianceX() / upper.n);
+    }
+
+    result.simulations = m_simulations + n_pricing + m_dual_paths;
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+// End of the conditional inclusion of the header file
+#endif
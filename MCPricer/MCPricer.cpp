@@ -3,14 +3,264 @@
 // lvaro Snchez de Carlos
 // Description: This file contains the main function of the MCPricer
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
+#include "BlackScholesBatch.hpp"
+#include "BookPipeline.hpp"
 #include "EuropeanOption.hpp"
+#include "HestonMonteCarlo.hpp"
+#include "LongstaffSchwartz.hpp"
 #include "MonteCarlo.hpp"
+#include "MultiAssetMonteCarlo.hpp"
+#include "MultilevelMonteCarlo.hpp"
+#include "NormalGenerators.hpp"
 
-// Define main function of the program
-int main()
+// Run the book pipeline from the command line:
+//   price <book> <results> [--engine analytic|mc] [--batch n] [--simulations n] [--subintervals n] [--beta b] [--seed n]
+//   convert <book> <output>
+// Books and results are CSV files when their name ends with .csv and binary column files otherwise (see BookPipeline.hpp)
+static int RunPipeline(int argc, char* argv[])
 {
+    const std::string usage = "Usage: " + std::string(argv[0]) + " price <book> <results> [--engine analytic|mc]"
+        " [--batch n] [--simulations n] [--subintervals n] [--beta b] [--seed n]\n       " + std::string(argv[0])
+        + " convert <book> <output>\n       " + std::string(argv[0]) + " check";
+
+    const std::string command = argv[1];
+    if ((command != "price" && command != "convert") || argc < 4 || argc % 2 != 0)
+    {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        // Read the options of the pipeline
+        BookPipeline pipeline;
+        for (int i = 4; i < argc; i += 2)
+        {
+            const std::string option = argv[i];
+            const std::string value = argv[i + 1];
+
+            if (option == "--engine" && (value == "analytic" || value == "mc"))
+                pipeline.engine(value == "mc" ? PipelineEngine::MonteCarlo : PipelineEngine::Analytic);
+            else if (option == "--batch")
+                pipeline.batch_size(std::stol(value));
+            else if (option == "--simulations")
+                pipeline.simulations(std::stol(value));
+            else if (option == "--subintervals")
+                pipeline.subintervals(std::stol(value));
+            else if (option == "--beta")
+                pipeline.beta(std::stod(value));
+            else if (option == "--seed")
+                pipeline.seed(std::stoull(value));
+            else
+            {
+                std::cerr << usage << std::endl;
+                return 1;
+            }
+        }
+
+        // Stream the book through the pipeline and print the throughput
+        const PipelineResult result = (command == "price") ? pipeline.Price(argv[2], argv[3]) : pipeline.Convert(argv[2], argv[3]);
+        std::cout << result.options << " options in " << result.batches << " batches in " << result.elapsed << " s ("
+            << result.options / result.elapsed << " options/s)" << std::endl;
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// Run the statistical checks of the engines with fixed seeds, failing when a statistic leaves its bound:
+//   check
+static int RunChecks()
+{
+    // Largest deviation of a statistic from its expected value, in standard errors
+    const double max_deviation = 5.0;
+    bool passed = true;
+
+    // Every normal generator on every instruction set of the CPU: moments, tails and goodness of fit against N(0, 1)
+    const NormalGenerator generators[3] = { NormalGenerator::BoxMuller, NormalGenerator::InverseCdf, NormalGenerator::Ziggurat };
+    const std::string generator_names[3] = { "Box - Muller", "Inverse CDF", "Ziggurat" };
+    const std::string level_names[3] = { "scalar", "AVX2", "AVX-512" };
+    for (int level = 0; level <= static_cast<int>(DetectSimdLevel()); ++level)
+    {
+        for (int g = 0; g < 3; ++g)
+        {
+            const std::vector<NormalTest> tests = TestNormalGenerator(generators[g], static_cast<SimdLevel>(level));
+            for (const NormalTest& test : tests)
+            {
+                const double deviation = (test.value - test.expected) / test.se;
+                const bool ok = std::fabs(deviation) <= max_deviation;
+                passed = passed && ok;
+                std::cout << generator_names[g] << " (" << level_names[level] << ") " << test.name << ": " << test.value
+                    << ", expected " << test.expected << ", " << deviation << " SE" << (ok ? "" : " FAILED") << std::endl;
+            }
+        }
+    }
+
+    // Round trip of the inverse normal CDF within Acklam's bound on the relative error
+    for (int vectorized = 0; vectorized < 2; ++vectorized)
+    {
+        const double error = InverseNormalError(vectorized == 1);
+        const bool ok = error <= 1.15e-9;
+        passed = passed && ok;
+        std::cout << (vectorized ? "Vector" : "Scalar") << " inverse normal CDF: largest relative error " << error
+            << ", bound 1.15e-09" << (ok ? "" : " FAILED") << std::endl;
+    }
+
+    // PriceBatch against PriceToTarget without a target, which runs the paths of PricePayoff through its statistics:
+    // on the same seed both see the same payoffs, so their prices and standard errors agree to rounding, at a rate
+    // and maturity where an undiscounted standard error would be off by exp(2 r T) = 1.49
+    const double max_relative_error = 1e-9;
+    std::vector<EuropeanOption> batch;
+    for (int k = 0; k < 3; ++k)
+    {
+        batch.push_back(EuropeanOption("Call", 2.0, 90.0 + 10.0 * k, 100, 0.1, 0.2, 2 * k));
+        batch.push_back(EuropeanOption("Put", 2.0, 90.0 + 10.0 * k, 100, 0.1, 0.2, 2 * k + 1));
+    }
+
+    for (int b = 0; b < 2; ++b)
+    {
+        const double beta = (b == 0) ? 1.0 : 0.8;
+        std::vector<EuropeanOption> options(batch);
+        for (EuropeanOption& option : options)
+            option.sigma(0.2 * std::pow(100.0, 1.0 - beta));
+
+        const std::vector<MCResult> batch_prices = MonteCarlo(options.front(), 50, 200000, 42).scheme(Scheme::Euler)
+            .PriceBatch(options, beta);
+
+        for (std::size_t j = 0; j < options.size(); ++j)
+        {
+            const MCResult single = MonteCarlo(options[j], 50, 200000, 42).scheme(Scheme::Euler).PriceToTarget(beta);
+            const double price_error = std::fabs(batch_prices[j].price - single.price) / single.price;
+            const double se_error = std::fabs(batch_prices[j].se - single.se) / single.se;
+            const bool ok = price_error <= max_relative_error && se_error <= max_relative_error;
+            passed = passed && ok;
+            std::cout << "PriceBatch " << options[j].type() << " K = " << options[j].K() << " (beta " << beta << "): SE "
+                << batch_prices[j].se << ", PricePayoff SE " << single.se << ", relative errors " << price_error
+                << " and " << se_error << (ok ? "" : " FAILED") << std::endl;
+        }
+    }
+
+    // A book through the Monte Carlo engine of the pipeline against PriceToTarget on the same seed, option by option:
+    // two runs of calls and puts, the second with a cost of carry below the rate, written to and read back from CSV
+    // files of the temporary directory, whose numbers round-trip
+    const char* directory = std::getenv("TMPDIR");
+    const std::string folder = (directory && *directory) ? directory : "/tmp";
+    const std::string book_path = folder + "/MCPricer_check_book.csv";
+    const std::string results_path = folder + "/MCPricer_check_results.csv";
+
+    std::vector<EuropeanOption> book;
+    for (int k = 0; k < 4; ++k)
+    {
+        const double b = (k < 2) ? 0.1 : 0.04;
+        book.push_back(EuropeanOption("Call", 2.0, 90.0 + 20.0 * (k % 2), 100, 0.1, 0.6, 2 * k, b));
+        book.push_back(EuropeanOption("Put", 2.0, 90.0 + 20.0 * (k % 2), 100, 0.1, 0.6, 2 * k + 1, b));
+    }
+
+    {
+        std::ofstream file(book_path);
+        file << "ID,Type,T,K,S,r,sigma,b\n";
+        for (const EuropeanOption& option : book)
+        {
+            const std::vector<std::string> fields = option.ConvertToVectorString();
+            for (std::size_t f = 0; f < fields.size(); ++f)
+                file << (f ? "," : "") << fields[f];
+            file << "\n";
+        }
+    }
+
+    BookPipeline(PipelineEngine::MonteCarlo).simulations(200000).subintervals(50).beta(0.8).seed(42)
+        .Price(book_path, results_path);
+
+    std::ifstream results(results_path);
+    std::string line;
+    std::getline(results, line);
+    for (const EuropeanOption& option : book)
+    {
+        std::getline(results, line);
+        const std::size_t price_start = line.find(',') + 1;
+        const std::size_t se_start = line.find(',', price_start) + 1;
+        const double price = std::stod(line.substr(price_start, se_start - price_start - 1));
+        const double se = std::stod(line.substr(se_start));
+
+        const MCResult single = MonteCarlo(option, 50, 200000, 42).PriceToTarget(0.8);
+        const double price_error = std::fabs(price - single.price) / single.price;
+        const double se_error = std::fabs(se - single.se) / single.se;
+        const bool ok = price_error <= max_relative_error && se_error <= max_relative_error;
+        passed = passed && ok;
+        std::cout << "Pipeline " << option.type() << " K = " << option.K() << " (b " << option.b() << "): SE " << se
+            << ", PricePayoff SE " << single.se << ", relative errors " << price_error << " and " << se_error
+            << (ok ? "" : " FAILED") << std::endl;
+    }
+
+    results.close();
+    std::remove(book_path.c_str());
+    std::remove(results_path.c_str());
+
+    // Single precision paths against double precision paths driven by the same normals, the float normals being the
+    // rounded double ones, for calls and puts over strikes 80 to 120 and several betas, the volatility scaled by
+    // S^(1 - beta) to a 25% local volatility at the spot; beta = 1 samples S_T exactly and the other betas take 100
+    // Euler - Maruyama steps. The mean of the paired payoff differences must stay within 5 of its own standard errors
+    // and 1e-4 of the double precision price: rounding the constants and the spots to float biases the paths by a
+    // deterministic amount, about 1e-7 of the price, many times the standard error of the pairs
+    const double max_relative_bias = 1e-4;
+    std::vector<EuropeanOption> chain;
+    for (int k = 0; k < 5; ++k)
+    {
+        chain.push_back(EuropeanOption("Call", 1.0, 80.0 + 10.0 * k, 100, 0.05, 0.25, 2 * k));
+        chain.push_back(EuropeanOption("Put", 1.0, 80.0 + 10.0 * k, 100, 0.05, 0.25, 2 * k + 1));
+    }
+
+    const double betas[4] = { 0.5, 0.8, 1.0, 1.2 };
+    for (int b = 0; b < 4; ++b)
+    {
+        const double beta = betas[b];
+        const double sigma = 0.25 * std::pow(100.0, 1.0 - beta);
+        std::vector<EuropeanOption> options(chain);
+        for (EuropeanOption& option : options)
+            option.sigma(sigma);
+
+        const Scheme scheme = (beta == 1.0) ? Scheme::Auto : Scheme::Euler;
+        const std::vector<MCResult> double_prices = MonteCarlo(options.front(), 100, 1000000, 5489 + b).scheme(scheme)
+            .PriceBatch(options, beta);
+        const std::vector<MCResult> biases = MonteCarlo(options.front(), 100, 1000000, 5489 + b).scheme(scheme)
+            .PriceBatchBias(options, beta);
+
+        for (std::size_t j = 0; j < options.size(); ++j)
+        {
+            const double relative_bias = biases[j].price / double_prices[j].price;
+            const bool ok = std::fabs(biases[j].price) <= max_deviation * biases[j].se
+                + max_relative_bias * double_prices[j].price;
+            passed = passed && ok;
+            std::cout << "Single precision " << options[j].type() << " K = " << options[j].K() << " (beta " << beta
+                << "): bias " << biases[j].price << " (SE " << biases[j].se << "), " << relative_bias
+                << " of the double precision price " << double_prices[j].price << (ok ? "" : " FAILED") << std::endl;
+        }
+    }
+
+    std::cout << (passed ? "All checks passed" : "Some checks FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
+
+// Define main function of the program, running the checks or the book pipeline when it is given arguments
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        return (std::string(argv[1]) == "check") ? RunChecks() : RunPipeline(argc, argv);
+
     // Create a European call option with specified parameters
     EuropeanOption call_option("Call", 0.25, 65, 60, 0.08, 0.3, 1);
     // Print the details of the call option
@@ -34,12 +284,236 @@ int main()
     for (int i = 1; i <= 7; ++i)
     {
         // Create a Monte Carlo simulation with the call option, n_subintervals subintervals, and 1000 simulations
+        // Force the Euler - Maruyama scheme, beta = 1 would otherwise be sampled exactly
         // Price the option and print the results
-        MonteCarlo(call_option, n_subintervals, 1000).Price(1, true);
+        MonteCarlo(call_option, n_subintervals, 1000).scheme(Scheme::Euler).Price(1, true);
         // Increase the number of subintervals by a factor of 10
         n_subintervals *= 10;
     }
 
+    // Loop over the variance-reduction techniques on the Euler - Maruyama grid
+    const VarianceReduction techniques[] = { VarianceReduction::None, VarianceReduction::Antithetic,
+        VarianceReduction::SpotControl, VarianceReduction::BSMControl, VarianceReduction::MomentMatching };
+    for (const VarianceReduction& technique : techniques)
+    {
+        // Create a Monte Carlo simulation with the call option, 100 subintervals, and 100000 simulations
+        // Price the option and print the results with the variance-reduction factor
+        MonteCarlo(call_option, 100, 100000).scheme(Scheme::Euler).variance_reduction(technique).Price(1, true);
+    }
+
+    // Initialize the number of quasi-Monte Carlo simulations
+    n_simulations = 1024;
+    // Loop to increase the number of simulations and price the option with scrambled Sobol points
+    for (int i = 1; i <= 5; ++i)
+    {
+        // Create a quasi-Monte Carlo simulation with the call option, 100 subintervals, and n_simulations
+        // split in 16 scrambled replicates, on the Euler - Maruyama grid so every subinterval is a Sobol dimension
+        // Price the option and print the results
+        MonteCarlo(call_option, 100, n_simulations).sampling(Sampling::Sobol).scheme(Scheme::Euler).Price(1, true);
+        // Increase the number of simulations by a factor of 4
+        n_simulations *= 4;
+    }
+
+    // Price the call option to a target standard error, with 1e8 simulations as the largest budget
+    const MCResult result = MonteCarlo(call_option, 100, 100000000).target_se(1e-3).PriceToTarget(1);
+    // Print the price with the simulations and the time it took
+    std::cout << "Target SE 0.001: price " << result.price << ", SE " << result.se << ", "
+        << result.simulations << " simulations in " << result.elapsed << " s" << std::endl;
+
+    // Start an expensive Euler - Maruyama repricing in the background with a deadline of 0.5 s, poll its estimate
+    // while it runs and take the best estimate available when the deadline stops it
+    const PricingHandle handle = MonteCarlo(call_option, 1000, 100000000).scheme(Scheme::Euler).target_se(1e-4)
+        .PriceAsync(1, 0.5);
+    while (!handle.WaitFor(0.1))
+    {
+        MCResult partial;
+        if (handle.Progress(partial))
+            std::cout << "Running: price " << partial.price << ", SE " << partial.se << std::endl;
+        else
+            std::cout << "Running: no estimate yet" << std::endl;
+    }
+    const MCResult best = handle.Get();
+    std::cout << (handle.status() == PricingStatus::DeadlineReached ? "Deadline reached" : "Completed") << ": price "
+        << best.price << ", SE " << best.se << ", " << best.simulations << " simulations in " << best.elapsed << " s" << std::endl;
+
+    // Estimate the price and the Greeks of the call option from one set of 1000000 exact GBM paths
+    const MCGreeks greeks = MonteCarlo(call_option, 100, 1000000).PriceGreeks(1);
+    // Print every estimate with its standard error next to the Black - Scholes - Merton value
+    std::cout << "Price " << greeks.price.value << " (SE " << greeks.price.se << ", BSM " << call_option.Price() << ")" << std::endl;
+    std::cout << "Delta " << greeks.delta.value << " (SE " << greeks.delta.se << ", BSM " << call_option.Delta() << ")" << std::endl;
+    std::cout << "Gamma " << greeks.gamma.value << " (SE " << greeks.gamma.se << ", BSM " << call_option.Gamma() << ")" << std::endl;
+    std::cout << "Vega " << greeks.vega.value << " (SE " << greeks.vega.se << ", BSM " << call_option.Vega() << ")" << std::endl;
+    std::cout << "Rho " << greeks.rho.value << " (SE " << greeks.rho.se << ", BSM " << call_option.Rho() << ")" << std::endl;
+
+    // Bump the spot by 1% on the Euler - Maruyama grid with beta = 0.8, the three pricings read the same cached normals
+    // so the central difference of the prices is a smooth Delta and the normals are only drawn once
+    const std::shared_ptr<NormalCache> cache = std::make_shared<NormalCache>();
+    const double bump = 0.01 * call_option.S();
+    const double up = MonteCarlo(EuropeanOption(call_option).S(call_option.S() + bump), 100, 100000).scheme(Scheme::Euler)
+        .normal_cache(cache).Price(0.8, false);
+    const double down = MonteCarlo(EuropeanOption(call_option).S(call_option.S() - bump), 100, 100000).scheme(Scheme::Euler)
+        .normal_cache(cache).Price(0.8, false);
+    std::cout << "Bumped Delta with common random numbers (beta 0.8): " << (up - down) / (2.0 * bump) << std::endl;
+
+    // Build a book of calls and puts on a grid of strikes around the call option
+    OptionBook book;
+    std::vector<EuropeanOption> strikes;
+    for (int strike = 50; strike <= 80; strike += 5)
+    {
+        book.Add(EuropeanOption(call_option).K(strike));
+        book.Add(EuropeanOption(call_option).type("Put").K(strike));
+        strikes.push_back(EuropeanOption(call_option).K(strike));
+        strikes.push_back(EuropeanOption(call_option).type("Put").K(strike));
+    }
+
+    // Price the strikes under a grid of spot and volatility shocks from one set of 1000000 exact GBM paths
+    ScenarioGrid grid;
+    grid.spot_shocks = { -0.1, -0.05, 0.0, 0.05, 0.1 };
+    grid.vol_shifts = { -0.05, 0.0, 0.05 };
+    const std::vector<ScenarioResult> scenarios = MonteCarlo(call_option, 100, 1000000).PriceScenarios(strikes, grid, 1);
+    // Print the at-the-money call of every scenario
+    for (const ScenarioResult& scenario : scenarios)
+    {
+        std::cout << "Scenario S " << scenario.S << ", sigma " << scenario.sigma << ": call K 65 " << scenario.prices[6].price
+            << " (SE " << scenario.prices[6].se << ")" << std::endl;
+    }
+    // Price path-dependent options on the call option from 100000 exact GBM paths monitored at 252 dates,
+    // streaming the averages, extremes and barrier survival of every path
+    const MonteCarlo path_pricer = MonteCarlo(call_option, 252, 100000);
+    const double barrier = 0.9 * call_option.S();
+    const MCResult asian = path_pricer.PricePathPayoff(AsianPayoff("Call", call_option.K()));
+    const MCResult knock_out = path_pricer.PricePathPayoff(BarrierPayoff("Call", call_option.K(), barrier,
+        BarrierType::DownAndOut, BarrierMonitoring::Continuous));
+    const MCResult lookback = path_pricer.PricePathPayoff(LookbackPayoff("Call"));
+    std::cout << "Arithmetic Asian call " << asian.price << " (SE " << asian.se << ")" << std::endl;
+    std::cout << "Continuous down-and-out call, barrier " << barrier << ": " << knock_out.price << " (SE " << knock_out.se
+        << ")" << std::endl;
+    std::cout << "Floating-strike lookback call " << lookback.price << " (SE " << lookback.se << ")" << std::endl;
+
+    // Price the whole book with its 15 Greeks in one batch pass and print a few of them
+    GreeksBook book_greeks;
+    PriceBook(book, book_greeks);
+    for (std::size_t i = 0; i < book.size(); ++i)
+    {
+        std::cout << (book.phi[i] > 0 ? "Call" : "Put") << " K " << book.K[i] << ": price " << book_greeks.price[i]
+            << ", delta " << book_greeks.delta[i] << ", gamma " << book_greeks.gamma[i] << ", vega " << book_greeks.vega[i]
+            << ", theta " << book_greeks.theta[i] << std::endl;
+    }
+
+    // Back out the implied volatilities of the book from its own prices, which should return the volatility of the call option
+    ImpliedVolBook book_vols;
+    ImpliedVolatility(book, book_greeks.price, book_vols);
+    for (std::size_t i = 0; i < book.size(); ++i)
+    {
+        std::cout << (book.phi[i] > 0 ? "Call" : "Put") << " K " << book.K[i] << ": implied volatility " << book_vols.vol[i]
+            << (book_vols.converged[i] ? "" : " (not converged)") << std::endl;
+    }
+
+    // Loop to decrease the target RMSE and price the call option with beta = 0.8 by multilevel Monte Carlo,
+    // the levels replace the sweep over the subintervals and the bias is controlled with the variance
+    for (const double& rmse : { 1e-2, 5e-3, 2e-3, 1e-3 })
+    {
+        const MLMCResult mlmc = MultilevelMonteCarlo(call_option, rmse).Price(0.8);
+        // Print the price with the finest grid and the cost against plain Monte Carlo on that grid
+        std::cout << "MLMC RMSE " << rmse << ": price " << mlmc.price << ", SE " << mlmc.se << ", bias " << mlmc.bias
+            << ", " << mlmc.levels.back().subintervals << " subintervals on the finest level, cost " << mlmc.cost
+            << " steps against " << mlmc.standard_cost << " for plain Monte Carlo" << std::endl;
+    }
+
+    // Price the American put of Longstaff and Schwartz (S 36, K 40, r 6%, sigma 20%, T 1) with 50 exercise dates,
+    // bounded by the low-biased price of the regressed policy and the high-biased price of its dual
+    const LSMResult american = LongstaffSchwartz(EuropeanOption("Put", 1.0, 40, 36, 0.06, 0.2), 50, 100000).Price(1);
+    std::cout << "American put: low " << american.price << " (SE " << american.se << "), high " << american.upper
+        << " (SE " << american.upper_se << "), regressions " << american.regression_time << " s on "
+        << american.path_bytes / 1048576.0 << " MB of paths" << std::endl;
+
+    // Price an equally weighted basket call, a best-of call and a worst-of put on 20 correlated assets,
+    // and a spread call on the first two, from one Cholesky factor of the correlation matrix
+    const long n_assets = 20;
+    std::vector<double> basket_spots(n_assets, 100.0), basket_vols(n_assets), basket_correlation(n_assets * n_assets);
+    for (long i = 0; i < n_assets; ++i)
+    {
+        basket_vols[i] = 0.15 + 0.01 * i;
+        for (long j = 0; j < n_assets; ++j)
+            basket_correlation[i * n_assets + j] = (i == j) ? 1.0 : 0.4;
+    }
+    const MultiAssetMonteCarlo basket_pricer(basket_spots, basket_vols, basket_correlation, 0.03, 1.0, 1000000);
+    const MCResult basket = basket_pricer.PricePayoff(BasketPayoff("Call", std::vector<double>(n_assets, 1.0 / n_assets), 100));
+    const MCResult best_of = basket_pricer.PricePayoff(BestOfPayoff("Call", n_assets, 100));
+    const MCResult worst_of = basket_pricer.PricePayoff(WorstOfPayoff("Put", n_assets, 100));
+    const MCResult spread = basket_pricer.PricePayoff(SpreadPayoff("Call", 0, 1));
+    std::cout << "Basket call " << basket.price << " (SE " << basket.se << "), best-of call " << best_of.price
+        << ", worst-of put " << worst_of.price << ", spread call " << spread.price << std::endl;
+
+    // Price Andersen's hard Heston case (kappa 0.5, theta 4%, xi 1, rho -0.9, T 10) with 32 QE subintervals,
+    // against the semi-analytic price of the characteristic function
+    const EuropeanOption heston_call("Call", 10.0, 100, 100, 0.0, 0.2, 3);
+    const HestonParams heston_params = { 0.04, 0.5, 0.04, 1.0, -0.9 };
+    const MCResult heston = HestonMonteCarlo(heston_call, heston_params, 32, 1000000)
+        .variance_reduction(VarianceReduction::Antithetic).Price();
+    std::cout << "Heston call: QE " << heston.price << " (SE " << heston.se << ") in " << heston.elapsed
+        << " s, characteristic function " << HestonPrice(heston_call, heston_params) << std::endl;
+
+    // Build the Dupire local volatility of a skewed implied volatility grid and reprice its one-year at-the-money call
+    std::vector<double> smile_maturities, smile_strikes, smile_vols;
+    for (int i = 1; i <= 20; ++i)
+        smile_maturities.push_back(0.1 * i);
+    for (int j = 0; j <= 42; ++j)
+        smile_strikes.push_back(40.0 + 5.0 * j);
+    for (const double& maturity : smile_maturities)
+        for (const double& strike : smile_strikes)
+            smile_vols.push_back(0.2 - 0.1 * std::log(strike / 100.0) + 0.02 * maturity);
+    const std::shared_ptr<const LocalVolSurface> surface = std::make_shared<const LocalVolSurface>(
+        DupireLocalVolatility(100, 0.03, 0.0, smile_maturities, smile_strikes, smile_vols));
+    const EuropeanOption smile_call("Call", 1.0, 100, 100, 0.03, 0.22, 4);
+    const MCResult local_vol = MonteCarlo(smile_call, 100, 1000000).local_volatility(surface)
+        .variance_reduction(VarianceReduction::Antithetic).PricePayoffToTarget(CallPayoff(100));
+    std::cout << "Local volatility call: " << local_vol.price << " (SE " << local_vol.se << "), implied volatility price "
+        << smile_call.Price() << std::endl;
+
+    // Time every normal generator alone, drawing the normals of 100 subintervals for 1024 paths at a time into the
+    // same buffer, then inside an Euler - Maruyama pricing of the call option with beta = 0.8 on 100000 paths
+    const NormalGenerator generators[3] = { NormalGenerator::BoxMuller, NormalGenerator::InverseCdf, NormalGenerator::Ziggurat };
+    const std::string generator_names[3] = { "Box - Muller", "Inverse CDF", "Ziggurat" };
+    std::vector<double> normal_buffer(NormalTable::Size(1024, 100));
+    for (int g = 0; g < 3; ++g)
+    {
+        KernelParams normal_params = KernelParams();
+        normal_params.seed = 5489;
+        normal_params.steps = 100;
+        normal_params.generator = generators[g];
+        const NormalKernel draw = SelectPathKernels(DetectSimdLevel()).grid_normals;
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (long first = 0; first < 102400; first += 1024)
+            draw(normal_params, first, 1024, normal_buffer.data());
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const MCResult euler = MonteCarlo(call_option, 100, 100000).scheme(Scheme::Euler).normal_generator(generators[g])
+            .PriceBatch(std::vector<EuropeanOption>(1, call_option), 0.8)[0];
+        std::cout << generator_names[g] << ": " << seconds / 1.024e7 * 1e9 << " ns per normal, Euler price (beta 0.8) "
+            << euler.price << " (SE " << euler.se << ") in " << euler.elapsed << " s" << std::endl;
+    }
+
+    // Price the call option with beta = 0.8 on double and on single precision paths, driven by different normals,
+    // and measure the difference of the prices in combined standard errors
+    const MCResult double_paths = MonteCarlo(call_option, 100, 1000000).scheme(Scheme::Euler)
+        .PriceBatch(std::vector<EuropeanOption>(1, call_option), 0.8)[0];
+    const MCResult single_paths = MonteCarlo(call_option, 100, 1000000).scheme(Scheme::Euler).precision(Precision::Single)
+        .PriceBatch(std::vector<EuropeanOption>(1, call_option), 0.8)[0];
+    std::cout << "Euler price (beta 0.8), double paths: " << double_paths.price << " (SE " << double_paths.se << ") in "
+        << double_paths.elapsed << " s, single paths: " << single_paths.price << " (SE " << single_paths.se << ") in "
+        << single_paths.elapsed << " s, difference "
+        << (single_paths.price - double_paths.price) / std::hypot(double_paths.se, single_paths.se) << " SE" << std::endl;
+
+    // Estimate the whole gradient of the call option with beta = 0.8 by adjoint differentiation, in one pass over
+    // the Euler - Maruyama paths of the price above
+    const MCGradient gradient = MonteCarlo(call_option, 100, 1000000).scheme(Scheme::Euler).PriceAdjoint(0.8);
+    std::cout << "Adjoint gradient (beta 0.8): price " << gradient.price.value << " (SE " << gradient.price.se << "), dS "
+        << gradient.delta.value << ", dK " << gradient.strike.value << ", rho " << gradient.rho.value << ", dsigma "
+        << gradient.vega.value << ", dbeta " << gradient.elasticity.value << " in "
+        << gradient.elapsed << " s" << std::endl;
+
     // Create a European put option with specified parameters
     EuropeanOption put_option("Put", 1.0, 100, 100, 0.00, 0.2, 2);
     // Print the details of the put option
@@ -63,8 +537,9 @@ int main()
     for (int i = 1; i <= 7; ++i)
     {
         // Create a Monte Carlo simulation with the put option, n_subintervals subintervals, and 1000 simulations
+        // Force the Euler - Maruyama scheme, beta = 1 would otherwise be sampled exactly
         // Price the option and print the results
-        MonteCarlo(put_option, n_subintervals, 1000).Price(1, true);
+        MonteCarlo(put_option, n_subintervals, 1000).scheme(Scheme::Euler).Price(1, true);
         // Increase the number of subintervals by a factor of 10
         n_subintervals *= 10;
     }
@@ -0,0 +1,122 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// MCResult.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the result structure returned by the Monte Carlo engines
+
+// If MCRESULT_HPP is not defined
+#ifndef MCRESULT_HPP
+// Define MCRESULT_HPP
+#define MCRESULT_HPP
+
+#include <vector>
+
+// Define MCResult struct, the estimate of a price and its error
+struct MCResult
+{
+    // Discounted price
+    double price;
+    // Standard error of the price
+    double se;
+    // Number of simulations used
+    long simulations;
+    // Wall-clock time of the simulation in seconds
+    double elapsed;
+};
+
+// Define MCEstimate struct, a Monte Carlo estimate and its standard error
+struct MCEstimate
+{
+    double value;
+    double se;
+};
+
+// Define MCGreeks struct, the price and the Greeks estimated from one set of paths
+struct MCGreeks
+{
+    MCEstimate price;
+    MCEstimate delta;
+    MCEstimate gamma;
+    MCEstimate vega;
+    MCEstimate rho;
+    // Number of simulations used
+    long simulations;
+    // Wall-clock time of the simulation in seconds
+    double elapsed;
+};
+
+// Define MCGradient struct, the price and its derivatives with respect to every input, estimated from one set of paths
+struct MCGradient
+{
+    MCEstimate price;
+    // Derivatives with respect to the spot, the strike, the rate (the drift and the discount of the paths), the
+    // volatility, the cost of carry and the CEV elasticity. The paths drift at r as in every engine, so rho is the
+    // rho of MCGreeks and the derivative with respect to the cost of carry, which no Monte Carlo price reads, is zero
+    MCEstimate delta;
+    MCEstimate strike;
+    MCEstimate rho;
+    MCEstimate vega;
+    MCEstimate carry;
+    MCEstimate elasticity;
+    // Number of simulations used
+    long simulations;
+    // Wall-clock time of the simulation in seconds
+    double elapsed;
+};
+
+// Define MLMCLevel struct, the estimator of one level of multilevel Monte Carlo
+struct MLMCLevel
+{
+    // Number of subintervals of the fine paths of the level
+    long subintervals;
+    // Number of samples of the level
+    long samples;
+    // Mean and variance of the discounted payoff difference between the fine and coarse paths
+    double mean;
+    double variance;
+};
+
+// Define MLMCResult struct, the estimate of a price by multilevel Monte Carlo
+struct MLMCResult
+{
+    // Discounted price, the sum of the level means
+    double price;
+    // Standard error of the price
+    double se;
+    // Estimated discretization bias of the finest level
+    double bias;
+    // Whether the bias fell below its share of the target RMSE before the finest level allowed
+    bool converged;
+    // Number of samples over every level
+    long simulations;
+    // Number of Euler - Maruyama steps simulated, fine and coarse
+    double cost;
+    // Number of steps plain Monte Carlo would need on the finest grid for the same RMSE
+    double standard_cost;
+    // Wall-clock time of the simulation in seconds
+    double elapsed;
+    // Estimators of every level
+    std::vector<MLMCLevel> levels;
+};
+
+// Define LSMResult struct, the bounds of an American or Bermudan price by Longstaff - Schwartz regression
+struct LSMResult
+{
+    // Low-biased price, the regressed exercise policy applied to independent paths, and its standard error
+    double price;
+    double se;
+    // High-biased price of the Andersen - Broadie dual of the policy and its standard error (NaN without dual paths)
+    double upper;
+    double upper_se;
+    // In-sample price of the regression paths, biased high by their foresight
+    double regression_price;
+    // Number of regression, pricing and outer dual paths
+    long simulations;
+    // Bytes of the stored or checkpointed regression paths and of their cash flows
+    double path_bytes;
+    // Wall-clock time of the backward regressions and of the whole pricing in seconds
+    double regression_time;
+    double elapsed;
+};
+
+// End of the conditional inclusion of the header file
+#endif
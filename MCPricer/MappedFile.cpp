@@ -0,0 +1,217 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// MappedFile.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the memory-mapped temporary and named files
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "MappedFile.hpp"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Constructor
+MappedFile::MappedFile(const std::size_t& size, const std::string& directory) :
+    m_data(0),
+    m_size(size)
+{
+    if (size == 0)
+        throw std::invalid_argument("MappedFile: the file must not be empty");
+
+#if defined(_WIN32)
+    // Create a uniquely named file that Windows deletes once its last handle is closed
+    char folder[MAX_PATH + 1];
+    if (directory.empty())
+        GetTempPathA(MAX_PATH + 1, folder);
+    else
+        folder[directory.copy(folder, MAX_PATH)] = '\0';
+
+    char name[MAX_PATH + 1];
+    if (!GetTempFileNameA(folder, "mcp", 0, name))
+        throw std::runtime_error("MappedFile: cannot create a temporary file in " + std::string(folder));
+
+    m_file = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, 0);
+    if (m_file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("MappedFile: cannot open " + std::string(name));
+
+    // The mapping of the whole size also extends the file
+    const unsigned long long bytes = size;
+    m_mapping = CreateFileMappingA(m_file, 0, PAGE_READWRITE, static_cast<DWORD>(bytes >> 32),
+        static_cast<DWORD>(bytes & 0xFFFFFFFFull), 0);
+    if (!m_mapping)
+    {
+        CloseHandle(m_file);
+        throw std::runtime_error("MappedFile: cannot map " + std::to_string(size) + " bytes");
+    }
+
+    m_data = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!m_data)
+    {
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        throw std::runtime_error("MappedFile: cannot map " + std::to_string(size) + " bytes");
+    }
+#else
+    // Create a uniquely named file and remove its name at once, the space is freed when the descriptor is closed
+    std::string folder = directory;
+    if (folder.empty())
+    {
+        const char* tmpdir = std::getenv("TMPDIR");
+        folder = (tmpdir && *tmpdir) ? tmpdir : "/tmp";
+    }
+
+    std::string pattern = folder + "/mcpricer-XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+
+    m_descriptor = mkstemp(name.data());
+    if (m_descriptor < 0)
+        throw std::runtime_error("MappedFile: cannot create a temporary file in " + folder);
+    unlink(name.data());
+
+    if (ftruncate(m_descriptor, static_cast<off_t>(size)) != 0)
+    {
+        close(m_descriptor);
+        throw std::runtime_error("MappedFile: cannot extend the file to " + std::to_string(size) + " bytes");
+    }
+
+    void* data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_descriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        close(m_descriptor);
+        throw std::runtime_error("MappedFile: cannot map " + std::to_string(size) + " bytes");
+    }
+    m_data = data;
+#endif
+}
+
+// Constructor of a named file
+MappedFile::MappedFile(const std::string& path, const FileMode& mode, const std::size_t& size) :
+    m_data(0),
+    m_size(size)
+{
+    if (mode == FileMode::Create && size == 0)
+        throw std::invalid_argument("MappedFile: the file must not be empty");
+
+#if defined(_WIN32)
+    const bool read = (mode == FileMode::Read);
+    m_file = CreateFileA(path.c_str(), read ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE, read ? FILE_SHARE_READ : 0, 0,
+        read ? OPEN_EXISTING : CREATE_ALWAYS, read ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, 0);
+    if (m_file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("MappedFile: cannot open " + path);
+
+    // Read the size of an existing file, the mapping of a new file extends it to the size
+    if (read)
+    {
+        LARGE_INTEGER bytes;
+        GetFileSizeEx(m_file, &bytes);
+        m_size = static_cast<std::size_t>(bytes.QuadPart);
+        if (m_size == 0)
+        {
+            CloseHandle(m_file);
+            throw std::runtime_error("MappedFile: " + path + " is empty");
+        }
+    }
+
+    const unsigned long long bytes = m_size;
+    m_mapping = CreateFileMappingA(m_file, 0, read ? PAGE_READONLY : PAGE_READWRITE, static_cast<DWORD>(bytes >> 32),
+        static_cast<DWORD>(bytes & 0xFFFFFFFFull), 0);
+    if (!m_mapping)
+    {
+        CloseHandle(m_file);
+        throw std::runtime_error("MappedFile: cannot map " + path);
+    }
+
+    m_data = MapViewOfFile(m_mapping, read ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS, 0, 0, m_size);
+    if (!m_data)
+    {
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        throw std::runtime_error("MappedFile: cannot map " + path);
+    }
+#else
+    const bool read = (mode == FileMode::Read);
+    m_descriptor = open(path.c_str(), read ? O_RDONLY : O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_descriptor < 0)
+        throw std::runtime_error("MappedFile: cannot open " + path);
+
+    // Read the size of an existing file, or extend a new file to the size
+    if (read)
+    {
+        struct stat status;
+        if (fstat(m_descriptor, &status) != 0 || status.st_size == 0)
+        {
+            close(m_descriptor);
+            throw std::runtime_error("MappedFile: " + path + " is empty or cannot be read");
+        }
+        m_size = static_cast<std::size_t>(status.st_size);
+    }
+    else if (ftruncate(m_descriptor, static_cast<off_t>(size)) != 0)
+    {
+        close(m_descriptor);
+        throw std::runtime_error("MappedFile: cannot extend " + path + " to " + std::to_string(size) + " bytes");
+    }
+
+    void* data = mmap(0, m_size, read ? PROT_READ : PROT_READ | PROT_WRITE, read ? MAP_PRIVATE : MAP_SHARED,
+        m_descriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        close(m_descriptor);
+        throw std::runtime_error("MappedFile: cannot map " + path);
+    }
+    m_data = data;
+
+    // Books are read from the first record to the last, so the pages can be read ahead aggressively
+    if (read)
+        madvise(m_data, m_size, MADV_SEQUENTIAL);
+#endif
+}
+
+// Release the pages of a range
+void MappedFile::Release(const std::size_t& offset, const std::size_t& size)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    const std::size_t page = system.dwPageSize;
+#else
+    const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    const std::size_t first = (offset + page - 1) / page * page;
+    const std::size_t last = std::min(offset + size, m_size) / page * page;
+    if (first >= last)
+        return;
+
+    char* data = static_cast<char*>(m_data) + first;
+#if defined(_WIN32)
+    // Unlocking pages that are not locked removes them from the working set
+    VirtualUnlock(data, last - first);
+#else
+    // Shared pages are written back to the file and private read-only pages are read again if they are touched
+    madvise(data, last - first, MADV_DONTNEED);
+#endif
+}
+
+// Destructor
+MappedFile::~MappedFile()
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+#else
+    munmap(m_data, m_size);
+    close(m_descriptor);
+#endif
+}
@@ -0,0 +1,68 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// MappedFile.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the memory-mapped temporary and named files
+
+// If MAPPEDFILE_HPP is not defined
+#ifndef MAPPEDFILE_HPP
+// Define MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// Modes of the mappings of named files
+enum class FileMode
+{
+    // Map an existing file for reading only, the pages are read ahead sequentially
+    Read,
+    // Create (or truncate) a file of a given size and map it for reading and writing, the file is kept when it is closed
+    Create
+};
+
+// Define MappedFile class, a file of a fixed size mapped in memory
+// The operating system pages its contents in and out on demand, so buffers larger than the physical memory can be
+// used as arrays. Temporary files are deleted when they are closed
+class MappedFile
+{
+private:
+
+    // Declare private member variables
+    void* m_data;
+    std::size_t m_size;
+#if defined(_WIN32)
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_descriptor;
+#endif
+
+public:
+
+    // Constructor, creating a temporary file of size bytes in directory (the temporary directory when empty)
+    MappedFile(const std::size_t& size, const std::string& directory = "");
+
+    // Constructor, mapping the file at path for reading or creating it with size bytes
+    MappedFile(const std::string& path, const FileMode& mode, const std::size_t& size = 0);
+
+    // Destructor, unmapping the file and deleting it if it is temporary
+    ~MappedFile();
+
+    // The mapping is owned by one object, which can be neither copied nor assigned
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Release the pages of a range that will not be used again from the memory of the process, their contents
+    // stay in the file (only the pages entirely inside the range are released)
+    void Release(const std::size_t& offset, const std::size_t& size);
+
+    // Get the first byte of the mapping, read-only mappings must not be written
+    void* data() { return m_data; }
+    const void* data() const { return m_data; }
+
+    // Get the size of the file in bytes
+    const std::size_t& size() const { return m_size; }
+};
+
+// End of the conditional inclusion of the header file
+#endif
@@ -0,0 +1,140 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Models.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the model policies of the CEV diffusion dS = r * S * dt + sigma * S^beta * dW
+
+// If MODELS_HPP is not defined
+#ifndef MODELS_HPP
+// Define MODELS_HPP
+#define MODELS_HPP
+
+#include <cfloat>
+
+// Declare the vector math functions used by the general CEV and log-normal policies (defined in SimdMath.hpp)
+template <class V> struct SimdMath;
+
+// Special cases of beta, each one compiled in its own kernel instantiation
+enum class ModelType
+{
+    GBM,
+    Sqrt,
+    Quadratic,
+    CEV
+};
+
+// Discretization schemes of the path kernels
+enum class Scheme
+{
+    // Exact log-normal sampling when beta = 1 (a single draw per path for terminal payoffs), Euler - Maruyama otherwise
+    Auto,
+    // Euler - Maruyama for every beta, e.g. to study the discretization error
+    Euler
+};
+
+// Declare the ClassifyBeta function, classifying beta once, outside the simulation loops
+// (defined in PathKernel.cpp: an inline definition would be compiled again for every instruction set of the kernels)
+ModelType ClassifyBeta(const double& beta);
+
+// Every policy returns S^beta for a vector of spots, generic over the traits of SimdVector.hpp,
+// and its derivative beta * S^(beta - 1) for the pathwise Greeks
+// The non-linear betas evaluate the power at max(S, 0) (full truncation), so paths never produce NaN
+
+// Define GBMModel policy (beta = 1)
+struct GBMModel
+{
+    template <class V>
+    static typename V::Real Power(const typename V::Real& S, const typename V::Real&)
+    {
+        return S;
+    }
+
+    template <class V>
+    static typename V::Real Slope(const typename V::Real&, const typename V::Real&)
+    {
+        return V::Set(1.0);
+    }
+};
+
+// Define SqrtModel policy (beta = 0.5)
+struct SqrtModel
+{
+    template <class V>
+    static typename V::Real Power(const typename V::Real& S, const typename V::Real&)
+    {
+        return V::Sqrt(V::Max(S, V::Set(0.0)));
+    }
+
+    template <class V>
+    static typename V::Real Slope(const typename V::Real& S, const typename V::Real&)
+    {
+        const typename V::Real positive = V::Max(S, V::Set(0.0));
+        return V::Select(V::Less(positive, V::Set(V::min_normal)), V::Set(0.0), V::Div(V::Set(0.5), V::Sqrt(positive)));
+    }
+};
+
+// Define QuadraticModel policy (beta = 2)
+struct QuadraticModel
+{
+    template <class V>
+    static typename V::Real Power(const typename V::Real& S, const typename V::Real&)
+    {
+        return V::Mul(S, S);
+    }
+
+    template <class V>
+    static typename V::Real Slope(const typename V::Real& S, const typename V::Real&)
+    {
+        return V::Add(S, S);
+    }
+};
+
+// Define CEVModel policy (any other beta)
+struct CEVModel
+{
+    template <class V>
+    static typename V::Real Power(const typename V::Real& S, const typename V::Real& beta)
+    {
+        const typename V::Real positive = V::Max(S, V::Set(0.0));
+        return V::Select(V::Less(positive, V::Set(V::min_normal)), V::Set(0.0), SimdMath<V>::Pow(positive, beta));
+    }
+
+    template <class V>
+    static typename V::Real Slope(const typename V::Real& S, const typename V::Real& beta)
+    {
+        const typename V::Real positive = V::Max(S, V::Set(0.0));
+        return V::Select(V::Less(positive, V::Set(V::min_normal)), V::Set(0.0),
+            V::Div(V::Mul(beta, SimdMath<V>::Pow(positive, beta)), positive));
+    }
+};
+
+// Every step policy advances a vector of spots by one subinterval given a vector of normals Z,
+// using the constants of KernelParams (their meaning depends on the scheme)
+
+// Define EulerStep policy: SN = S0 + drift_const * S0 + diffusion_const * S0^beta * Z
+// with drift_const = r * dt and diffusion_const = sigma * sqrt(dt)
+template <class Model>
+struct EulerStep
+{
+    template <class V>
+    static typename V::Real Advance(const typename V::Real& S0, const typename V::Real& Z, const typename V::Real& drift,
+        const typename V::Real& diffusion, const typename V::Real& beta)
+    {
+        const typename V::Real power = Model::template Power<V>(S0, beta);
+        return V::MulAdd(V::Mul(diffusion, power), Z, V::MulAdd(drift, S0, S0));
+    }
+};
+
+// Define LogNormalStep policy, exact for GBM: SN = S0 * exp(drift_const + diffusion_const * Z)
+// with drift_const = (r - sigma^2 / 2) * dt and diffusion_const = sigma * sqrt(dt)
+struct LogNormalStep
+{
+    template <class V>
+    static typename V::Real Advance(const typename V::Real& S0, const typename V::Real& Z, const typename V::Real& drift,
+        const typename V::Real& diffusion, const typename V::Real&)
+    {
+        return V::Mul(S0, SimdMath<V>::Exp(V::MulAdd(diffusion, Z, drift)));
+    }
+};
+
+// End of the conditional inclusion of the header file
+#endif
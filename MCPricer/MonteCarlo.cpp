@@ -4,35 +4,62 @@
 // Description: this file contains the source code of the derived MonteCarlo class
 
 #include <algorithm>
-#include <functional>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
 #include <iomanip>
-#include <boost/random.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "Adjoint.hpp"
 #include "MonteCarlo.hpp"
+#include "Sobol.hpp"
 
-// Define SD private function
-double MonteCarlo::SD(const double& sum_payoff, const double& sum_square_payoff) const
-{
-    return std::sqrt(((sum_square_payoff - (sum_payoff * sum_payoff / m_simulations)) / (m_simulations - 1))) * exp(this->r() * this->T());
-}
-
-// Define SE private function
-double MonteCarlo::SE(const double& sd) const
-{
-    return sd / std::sqrt(m_simulations);
-}
+// Define the static constants, bound to references by std::min
+const long MonteCarlo::chunk_size;
+const long MonteCarlo::first_batch;
 
 // Constructor 
-MonteCarlo::MonteCarlo(const EuropeanOption& option, const long& subintervals, const long& simulations) :
+MonteCarlo::MonteCarlo(const EuropeanOption& option, const long& subintervals, const long& simulations,
+    const unsigned long long& seed) :
     EuropeanOption(option),
     m_subintervals(subintervals),
-    m_simulations(simulations)
+    m_simulations(simulations),
+    m_seed(seed),
+    m_simd(DetectSimdLevel()),
+    m_scheme(Scheme::Auto),
+    m_variance_reduction(VarianceReduction::None),
+    m_sampling(Sampling::PseudoRandom),
+    m_normal_generator(NormalGenerator::BoxMuller),
+    m_precision(Precision::Double),
+    m_replicates(16),
+    m_target_se(0.0),
+    m_relative_tolerance(0.0),
+    m_time_budget(0.0),
+    m_priority(Priority::Normal),
+    m_normal_cache(),
+    m_local_volatility()
 {}
 
 // Copy Constructor
 MonteCarlo::MonteCarlo(const MonteCarlo& source) :
     EuropeanOption(source),
     m_subintervals(source.m_subintervals),
-    m_simulations(source.m_simulations)
+    m_simulations(source.m_simulations),
+    m_seed(source.m_seed),
+    m_simd(source.m_simd),
+    m_scheme(source.m_scheme),
+    m_variance_reduction(source.m_variance_reduction),
+    m_sampling(source.m_sampling),
+    m_normal_generator(source.m_normal_generator),
+    m_precision(source.m_precision),
+    m_replicates(source.m_replicates),
+    m_target_se(source.m_target_se),
+    m_relative_tolerance(source.m_relative_tolerance),
+    m_time_budget(source.m_time_budget),
+    m_priority(source.m_priority),
+    m_normal_cache(source.m_normal_cache),
+    m_local_volatility(source.m_local_volatility)
 {}
 
 // Assignment operator
@@ -45,114 +72,1152 @@ MonteCarlo& MonteCarlo::operator=(const MonteCarlo& source)
     EuropeanOption::operator=(source);
     m_subintervals = source.m_subintervals;
     m_simulations = source.m_simulations;
+    m_seed = source.m_seed;
+    m_simd = source.m_simd;
+    m_scheme = source.m_scheme;
+    m_variance_reduction = source.m_variance_reduction;
+    m_sampling = source.m_sampling;
+    m_normal_generator = source.m_normal_generator;
+    m_precision = source.m_precision;
+    m_replicates = source.m_replicates;
+    m_target_se = source.m_target_se;
+    m_relative_tolerance = source.m_relative_tolerance;
+    m_time_budget = source.m_time_budget;
+    m_priority = source.m_priority;
+    m_normal_cache = source.m_normal_cache;
+    m_local_volatility = source.m_local_volatility;
 
     return *this;
 }
 
-// Define the Price function
-double MonteCarlo::Price(const double& beta, const bool& error_analysis) const
-{   
+// Set the seed of the counter-based random number generator
+MonteCarlo& MonteCarlo::seed(const unsigned long long& seed)
+{
+    m_seed = seed;
+    return *this;
+}
+
+// Set the widest instruction set the path kernel may use
+MonteCarlo& MonteCarlo::simd(const SimdLevel& level)
+{
+    m_simd = level;
+    return *this;
+}
+
+// Set the discretization scheme
+MonteCarlo& MonteCarlo::scheme(const Scheme& scheme)
+{
+    m_scheme = scheme;
+    return *this;
+}
+
+// Set the variance-reduction technique of Price and PricePayoff
+MonteCarlo& MonteCarlo::variance_reduction(const VarianceReduction& technique)
+{
+    m_variance_reduction = technique;
+    return *this;
+}
+
+// Set the source of the normals
+MonteCarlo& MonteCarlo::sampling(const Sampling& sampling)
+{
+    m_sampling = sampling;
+    return *this;
+}
+
+// Set the transform of the pseudo-random numbers into normals
+MonteCarlo& MonteCarlo::normal_generator(const NormalGenerator& generator)
+{
+    m_normal_generator = generator;
+    return *this;
+}
+
+// Set the precision of the simulated paths
+MonteCarlo& MonteCarlo::precision(const Precision& precision)
+{
+    m_precision = precision;
+    return *this;
+}
+
+// Set the number of quasi-Monte Carlo replicates
+MonteCarlo& MonteCarlo::replicates(const long& replicates)
+{
+    if (replicates < 2)
+        throw std::invalid_argument("replicates: at least two replicates are needed to estimate the error");
+
+    m_replicates = replicates;
+    return *this;
+}
+
+// Set the standard error the adaptive engine stops at
+MonteCarlo& MonteCarlo::target_se(const double& se)
+{
+    m_target_se = se;
+    return *this;
+}
+
+// Set the standard error relative to the price the adaptive engine stops at
+MonteCarlo& MonteCarlo::relative_tolerance(const double& tolerance)
+{
+    m_relative_tolerance = tolerance;
+    return *this;
+}
+
+// Set the wall-clock time after which the adaptive engine stops
+MonteCarlo& MonteCarlo::time_budget(const double& seconds)
+{
+    m_time_budget = seconds;
+    return *this;
+}
+
+// Set the priority of the chunks in the shared thread pool
+MonteCarlo& MonteCarlo::priority(const Priority& priority)
+{
+    m_priority = priority;
+    return *this;
+}
+
+// Set the cache of common random numbers
+MonteCarlo& MonteCarlo::normal_cache(const std::shared_ptr<NormalCache>& cache)
+{
+    m_normal_cache = cache;
+    return *this;
+}
+
+// Set the local volatility surface
+MonteCarlo& MonteCarlo::local_volatility(const std::shared_ptr<const LocalVolSurface>& surface)
+{
+    m_local_volatility = surface;
+    return *this;
+}
+
+// Get the number of quasi-Monte Carlo replicates, 1 for pseudo-random sampling
+long MonteCarlo::Replicates() const
+{
+    return (m_sampling == Sampling::Sobol) ? m_replicates : 1;
+}
+
+// Get the number of kernel paths simulating n_simulations
+long MonteCarlo::KernelPaths(const long& n_simulations) const
+{
+    return (m_variance_reduction == VarianceReduction::Antithetic) ? (n_simulations + 1) / 2 : n_simulations;
+}
+
+// Select the kernel and constants that simulate terminal spots
+PathKernel MonteCarlo::TerminalKernel(const double& beta, KernelParams& params) const
+{
     // Extract option parameters
-    const double K = this->K();
     const double T = this->T();
     const double r = this->r();
     const double sigma = this->sigma();
-    const double S = this->S();
-    const std::string type = this->type();
+    const ModelType model = ClassifyBeta(beta);
+
+    params.S = this->S();
+    params.beta = beta;
+    params.steps = m_subintervals;
+    params.seed = m_seed;
+    params.generator = m_normal_generator;
+    params.sigma = sigma;
+
+    // Quasi-Monte Carlo uses one Sobol dimension per subinterval and splits the simulations between the replicates
+    const bool sobol = m_sampling == Sampling::Sobol;
+    if (sobol && m_simulations < m_replicates)
+        throw std::invalid_argument("Sobol sampling needs at least one simulation per replicate");
+
+    // Single precision paths draw their own pseudo-random Box - Muller normals in float, or round the cached ones
+    const bool single = m_precision == Precision::Single;
+    if (single && (sobol || m_local_volatility || m_normal_generator != NormalGenerator::BoxMuller))
+        throw std::invalid_argument("Single precision paths only support pseudo-random Box - Muller normals "
+            "without local volatility");
+
+    // A local volatility surface replaces the CEV diffusion, stepping the log-spot with the volatility of the surface
+    // at the start of every subinterval; the GBM control path takes exact steps at sigma on the same normals
+    if (m_local_volatility)
+    {
+        if (sobol)
+            throw std::invalid_argument("Local volatility only supports pseudo-random sampling");
+        if (model != ModelType::GBM)
+            throw std::invalid_argument("Local volatility replaces the CEV diffusion, beta must be 1");
+
+        const double tn = T / m_subintervals;
+        params.dt = tn;
+        params.drift_const = r * tn;
+        params.diffusion_const = sigma * std::sqrt(tn);
+        params.control_drift = (r - 0.5 * sigma * sigma) * tn;
+        params.control_diffusion = params.diffusion_const;
+        params.local_vol = m_local_volatility->Grid();
+
+        return SelectPathKernels(m_simd).local_vol_steps;
+    }
+
+    // Terminal payoffs of GBM only need S_T: sample it exactly with one draw per path, without discretization bias
+    if (model == ModelType::GBM && m_scheme == Scheme::Auto)
+    {
+        params.drift_const = (r - 0.5 * sigma * sigma) * T;
+        params.diffusion_const = sigma * std::sqrt(T);
+        params.control_drift = params.drift_const;
+        params.control_diffusion = params.diffusion_const;
+        params.dt = T;
+
+        if (single)
+            return SelectPathKernels(m_simd).exact_terminal_single;
+
+        return sobol ? PathKernelsSobol().exact_terminal : SelectPathKernels(m_simd).exact_terminal;
+    }
+
+    if (sobol && m_subintervals > static_cast<long>(SobolSequence::max_dimension))
+        throw std::invalid_argument("Sobol sampling supports up to " + std::to_string(SobolSequence::max_dimension)
+            + " subintervals");
 
-    // Precompute MC parameters to optimize speed
+    // Precompute MC parameters of the Euler - Maruyama grid to optimize speed
     const double tn = T / m_subintervals;
-    const double drift_const = r * tn;
-    const double diffusion_const = sigma * std::sqrt(tn);
+    params.dt = tn;
+    params.drift_const = r * tn;
+    params.diffusion_const = sigma * std::sqrt(tn);
+
+    // The GBM control path takes exact log-normal steps on the same grid
+    params.control_drift = (r - 0.5 * sigma * sigma) * tn;
+    params.control_diffusion = params.diffusion_const;
+
+    if (sobol)
+        return PathKernelsSobol().euler[static_cast<int>(model)];
+
+    if (single)
+        return SelectPathKernels(m_simd).euler_single[static_cast<int>(model)];
+
+    return SelectPathKernel(m_simd, model, Scheme::Euler);
+}
+
+// Point the kernel parameters to the cached normals
+std::shared_ptr<const NormalTable> MonteCarlo::AttachNormals(const double& beta, const long& n_paths,
+    KernelParams& params, const bool& grid) const
+{
+    // Quasi-Monte Carlo draws its points from the scrambled Sobol sequence and is never cached; single precision
+    // paths round the cached double normals, so they share the normals of the double precision paths
+    if (!m_normal_cache || m_sampling != Sampling::PseudoRandom)
+        return std::shared_ptr<const NormalTable>();
+
+    // Exact terminal sampling takes a single normal per path, every other kernel one per subinterval
+    const bool terminal = !grid && !m_local_volatility && ClassifyBeta(beta) == ModelType::GBM && m_scheme == Scheme::Auto;
+    const std::shared_ptr<const NormalTable> table = m_normal_cache->Acquire(m_seed, m_normal_generator, n_paths,
+        terminal ? 1 : m_subintervals, terminal, m_simd);
+
+    params.normals = table->data();
+    return table;
+}
+
+// Select the kernel and constants that stream the statistics of the monitored spots
+PathKernel MonteCarlo::MonitorKernel(const double& beta, const PathMonitoring& monitoring, KernelParams& params) const
+{
+    if (m_sampling != Sampling::PseudoRandom)
+        throw std::invalid_argument("PricePathPayoff: only pseudo-random sampling streams the monitored spots");
+    if (m_local_volatility)
+        throw std::invalid_argument("PricePathPayoff: local volatility only prices terminal payoffs");
+    if (m_precision == Precision::Single)
+        throw std::invalid_argument("PricePathPayoff: the monitored spots are only streamed in double precision");
+
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double sigma = this->sigma();
+    const ModelType model = ClassifyBeta(beta);
+
+    params.S = this->S();
+    params.beta = beta;
+    params.steps = m_subintervals;
+    params.seed = m_seed;
+    params.generator = m_normal_generator;
+    params.sigma = sigma;
+
+    // Every path payoff is monitored on the subinterval grid
+    const double tn = T / m_subintervals;
+    params.dt = tn;
+    params.diffusion_const = sigma * std::sqrt(tn);
+
+    // Without a barrier the paths never knock
+    params.lower_barrier = monitoring.barrier ? monitoring.lower_barrier : 0.0;
+    params.upper_barrier = monitoring.barrier ? monitoring.upper_barrier : std::numeric_limits<double>::infinity();
+    params.bridge = monitoring.barrier && monitoring.continuous;
+
+    const PathKernels& kernels = SelectPathKernels(m_simd);
+
+    // GBM takes exact log-normal steps, so the spots at the monitoring dates carry no discretization bias
+    if (model == ModelType::GBM && m_scheme == Scheme::Auto)
+    {
+        params.drift_const = (r - 0.5 * sigma * sigma) * tn;
+        return kernels.monitor_exact_steps;
+    }
+
+    params.drift_const = r * tn;
+    return kernels.monitor_euler[static_cast<int>(model)];
+}
+
+// Select the kernel and constants that simulate terminal spots with the tangents of the pathwise Greeks
+PathKernel MonteCarlo::GreeksKernel(const double& beta, KernelParams& params) const
+{
+    if (m_sampling != Sampling::PseudoRandom || m_variance_reduction != VarianceReduction::None)
+        throw std::invalid_argument("Greeks: only plain pseudo-random sampling propagates the pathwise tangents");
+    if (m_local_volatility)
+        throw std::invalid_argument("Greeks: the pathwise tangents are not propagated through a local volatility");
+    if (m_precision == Precision::Single)
+        throw std::invalid_argument("Greeks: the pathwise tangents are only propagated in double precision");
+
+    // Share the constants of the pricing kernel, so the price matches Price exactly
+    TerminalKernel(beta, params);
+
+    const ModelType model = ClassifyBeta(beta);
+    const PathKernels& kernels = SelectPathKernels(m_simd);
+
+    if (model == ModelType::GBM && m_scheme == Scheme::Auto)
+        return kernels.greeks_exact_terminal;
+
+    return kernels.greeks_euler[static_cast<int>(model)];
+}
+
+// Calculate the exact expectation of the simulated terminal spot
+double MonteCarlo::ExpectedTerminal(const double& beta) const
+{
+    // Exact GBM sampling and the log-spot steps of a local volatility: E[ST] = S * exp(r * T)
+    if (m_local_volatility || (ClassifyBeta(beta) == ModelType::GBM && m_scheme == Scheme::Auto))
+        return this->S() * std::exp(this->r() * this->T());
+
+    // Euler - Maruyama: every step has E[S(n + 1) | S(n)] = S(n) * (1 + r * dt), whatever the diffusion
+    return this->S() * std::pow(1.0 + this->r() * this->T() / m_subintervals, static_cast<double>(m_subintervals));
+}
+
+// Combine the statistics of every replicate into the mean payoff and its variance
+void MonteCarlo::Estimate(const std::vector<SampleStatistics>& samples, const std::vector<SampleStatistics>& paths,
+    const double& beta, const double& control_price, double& mean, double& variance_of_mean,
+    double& plain_variance_of_mean) const
+{
+    const long replicates = static_cast<long>(samples.size());
+
+    // Define the statistics of the replicate estimates and of every single path
+    SampleStatistics estimates;
+    SampleStatistics all_paths;
+
+    for (long replicate = 0; replicate < replicates; ++replicate)
+    {
+        const SampleStatistics& sample = samples[replicate];
+        const SampleStatistics& path = paths[replicate];
+
+        // Estimate the mean payoff and the variance of one sample
+        double estimate = sample.MeanX();
+        double variance = sample.VarianceX();
+
+        // Control variates: subtract b * (Y - E[Y]) with the variance-minimizing coefficient b = Cov(X, Y) / Var(Y)
+        if ((m_variance_reduction == VarianceReduction::SpotControl || m_variance_reduction == VarianceReduction::BSMControl)
+            && sample.VarianceY() > 0)
+        {
+            const double expected = (m_variance_reduction == VarianceReduction::SpotControl)
+                ? ExpectedTerminal(beta) : control_price * std::exp(this->r() * this->T());
+            const double b = sample.Covariance() / sample.VarianceY();
+
+            estimate -= b * (sample.MeanY() - expected);
+            variance -= b * sample.Covariance();
+        }
+
+        // Moment matching is, to first order, a control variate on ST with the implied coefficient
+        // b = (plain mean - matched mean) / (mean ST - E[ST]); the matched samples are not independent,
+        // so the variance is that of X - b * ST over the plain paths
+        if (m_variance_reduction == VarianceReduction::MomentMatching && path.MeanY() != ExpectedTerminal(beta))
+        {
+            const double b = (path.MeanX() - estimate) / (path.MeanY() - ExpectedTerminal(beta));
+
+            variance = path.VarianceX() - 2.0 * b * path.Covariance() + b * b * path.VarianceY();
+        }
+
+        mean = estimate;
+        variance_of_mean = variance / sample.n;
+        estimates.Add(estimate);
+        all_paths.Merge(path);
+    }
+
+    // The spread of the independent replicates measures the error of the quasi-Monte Carlo estimate
+    if (replicates > 1)
+    {
+        mean = estimates.MeanX();
+        variance_of_mean = estimates.VarianceX() / replicates;
+    }
+
+    plain_variance_of_mean = all_paths.VarianceX() / all_paths.n;
+}
+
+// Print the error analysis of a simulation as a table
+void MonteCarlo::ErrorAnalysis(const double& price, const double& sd, const double& se, const double& vr_factor) const
+{
+    // Print the error results as a table
+    std::cout << std::setw(20) << "Simulations"
+        << std::setw(20) << "Subintervals"
+        << std::setw(20) << "BSM Price"
+        << std::setw(20) << "MC Price"
+        << std::setw(20) << "SD"
+        << std::setw(20) << "SE";
+    if (vr_factor > 0) std::cout << std::setw(20) << "VR Factor";
+    std::cout << std::endl;
+
+    std::cout << std::setw(20) << m_simulations
+        << std::setw(20) << m_subintervals
+        << std::setw(20) << this->EuropeanOption::Price()
+        << std::setw(20) << price
+        << std::setw(20) << sd
+        << std::setw(20) << se;
+    if (vr_factor > 0) std::cout << std::setw(20) << vr_factor;
+    std::cout << std::endl;
+}
+
+// Define the PriceBatch function
+std::vector<MCResult> MonteCarlo::PriceBatch(const std::vector<EuropeanOption>& options, const double& beta) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (m_variance_reduction != VarianceReduction::None)
+        throw std::invalid_argument("PriceBatch: the chain is priced from plain paths, without variance reduction");
+
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double sigma = this->sigma();
+    const double S = this->S();
+    const double b = this->b();
+    const long n_options = static_cast<long>(options.size());
+
+    // Store strikes and payoff signs (+1 call, -1 put) as arrays, comparing the option types only once
+    std::vector<double> strike(n_options);
+    std::vector<double> sign(n_options);
+    for (long j = 0; j < n_options; ++j)
+    {
+        const EuropeanOption& option = options[j];
+
+        // Every option must share the simulated terminal distribution
+        if (option.T() != T || option.S() != S || option.r() != r || option.b() != b || option.sigma() != sigma)
+            throw std::invalid_argument("PriceBatch: option " + std::to_string(option.id())
+                + " does not share the maturity, spot, rate, cost of carry and volatility of the simulation");
+
+        strike[j] = option.K();
+        sign[j] = PayoffSign(option.type(), "PriceBatch");
+    }
+
+    // Select the path kernel specialized for the model, the scheme and the instruction set once
+    KernelParams params = KernelParams();
+    const PathKernel kernel = TerminalKernel(beta, params);
+
+    // Split the simulations between the randomized replicates, a single one for pseudo-random sampling
+    const long replicates = Replicates();
+    const long n_simulations = m_simulations / replicates;
+
+    // Read the normals from the cache of common random numbers when one is set
+    const std::shared_ptr<const NormalTable> normals = AttachNormals(beta, n_simulations, params);
+
+    // Split the simulations in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (n_simulations + chunk_size - 1) / chunk_size;
+
+    // Define a matrix (chunk x option) to store the payoff statistics of every chunk
+    std::vector<SampleStatistics> chunk_statistics(n_chunks * n_options);
+
+    // Define the results and the statistics of the replicate prices of every option
+    std::vector<MCResult> results(n_options);
+    std::vector<SampleStatistics> estimates(n_options);
+
+    for (long replicate = 0; replicate < replicates; ++replicate)
+    {
+        // Every replicate scrambles the Sobol points with its own seed
+        params.seed = m_seed + replicate;
+
+        // Run the chunks of simulations on the shared thread pool
+        ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+        {
+            // Define the range of simulations of the chunk
+            const long first = c * chunk_size;
+            const long count = std::min(chunk_size, n_simulations - first);
+
+            // Simulate the terminal spots of the chunk once for every option
+            double terminal[chunk_size];
+            PathBuffers out = PathBuffers();
+            out.terminal = terminal;
+            kernel(params, first, count, out);
+
+            // Take the mean and then the centred sum of squares of the payoffs of the chunk in two passes, exact
+            // for the chunk like Welford's updates, in worker buffers whose loops over strikes have no
+            // dependencies and vectorize
+            static thread_local std::vector<double> mean;
+            static thread_local std::vector<double> m2;
+            mean.assign(n_options, 0.0);
+            m2.assign(n_options, 0.0);
+            const double* K = strike.data();
+            const double* w = sign.data();
+
+            for (long i = 0; i < count; ++i)
+            {
+                const double SN = terminal[i];
+
+                // max(SN - K, 0) for calls and max(K - SN, 0) for puts
+                for (long j = 0; j < n_options; ++j)
+                    mean[j] += std::max(w[j] * (SN - K[j]), 0.0);
+            }
+            for (long j = 0; j < n_options; ++j)
+                mean[j] /= count;
+
+            for (long i = 0; i < count; ++i)
+            {
+                const double SN = terminal[i];
+
+                for (long j = 0; j < n_options; ++j)
+                {
+                    const double deviation = std::max(w[j] * (SN - K[j]), 0.0) - mean[j];
+                    m2[j] += deviation * deviation;
+                }
+            }
+
+            // Store the chunk row
+            SampleStatistics* statistics = chunk_statistics.data() + c * n_options;
+            for (long j = 0; j < n_options; ++j)
+            {
+                statistics[j] = SampleStatistics();
+                statistics[j].n = static_cast<double>(count);
+                statistics[j].mean_x = mean[j];
+                statistics[j].m2_x = m2[j];
+            }
+        }, m_priority);
+
+        // Merge the chunk statistics in chunk order and discount the mean payoff and standard error of every option
+        const double discount = std::exp(-r * T);
+        for (long j = 0; j < n_options; ++j)
+        {
+            SampleStatistics statistics;
+            for (long c = 0; c < n_chunks; ++c)
+                statistics.Merge(chunk_statistics[c * n_options + j]);
+
+            results[j].price = statistics.MeanX() * discount;
+            results[j].se = std::sqrt(statistics.VarianceX() / statistics.n) * discount;
+            estimates[j].Add(results[j].price);
+        }
+    }
+
+    // The spread of the independent replicates measures the error of the quasi-Monte Carlo prices
+    if (replicates > 1)
+    {
+        for (long j = 0; j < n_options; ++j)
+        {
+            results[j].price = estimates[j].MeanX();
+            results[j].se = std::sqrt(estimates[j].VarianceX() / replicates);
+        }
+    }
+
+    // Every option shares the simulations and the time
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (long j = 0; j < n_options; ++j)
+    {
+        results[j].simulations = n_simulations * replicates;
+        results[j].elapsed = elapsed;
+    }
+
+    return results;
+}
+
+// Define the PriceBatchBias function
+std::vector<MCResult> MonteCarlo::PriceBatchBias(const std::vector<EuropeanOption>& options, const double& beta) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (m_sampling != Sampling::PseudoRandom || m_variance_reduction != VarianceReduction::None)
+        throw std::invalid_argument("PriceBatchBias: the paths are paired on plain pseudo-random normals");
+
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double sigma = this->sigma();
+    const double S = this->S();
+    const double b = this->b();
+    const long n_options = static_cast<long>(options.size());
+
+    // Store strikes and payoff signs (+1 call, -1 put) as arrays, comparing the option types only once
+    std::vector<double> strike(n_options);
+    std::vector<double> sign(n_options);
+    for (long j = 0; j < n_options; ++j)
+    {
+        const EuropeanOption& option = options[j];
+
+        // Every option must share the simulated terminal distribution
+        if (option.T() != T || option.S() != S || option.r() != r || option.b() != b || option.sigma() != sigma)
+            throw std::invalid_argument("PriceBatchBias: option " + std::to_string(option.id())
+                + " does not share the maturity, spot, rate, cost of carry and volatility of the simulation");
+
+        strike[j] = option.K();
+        sign[j] = PayoffSign(option.type(), "PriceBatchBias");
+    }
+
+    // Select the double and the single precision kernels of the model, the scheme and the instruction set once
+    MonteCarlo paths(*this);
+    KernelParams double_params = KernelParams();
+    const PathKernel double_kernel = paths.precision(Precision::Double).TerminalKernel(beta, double_params);
+    KernelParams single_params = KernelParams();
+    const PathKernel single_kernel = paths.precision(Precision::Single).TerminalKernel(beta, single_params);
+
+    // Both kernels read the normals of the double precision paths, drawn chunk by chunk in the layout of NormalKernel:
+    // one per path for exact GBM sampling, one per subinterval otherwise
+    const bool exact = ClassifyBeta(beta) == ModelType::GBM && m_scheme == Scheme::Auto;
+    const NormalKernel draw = exact ? SelectPathKernels(m_simd).terminal_normals : SelectPathKernels(m_simd).grid_normals;
+    KernelParams normal_params = double_params;
+    normal_params.steps = exact ? 1 : m_subintervals;
+
+    // Split the simulations in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (m_simulations + chunk_size - 1) / chunk_size;
+    std::vector<SampleStatistics> chunk_statistics(n_chunks * n_options);
+
+    // Run the chunks of simulations on the shared thread pool
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Define the range of simulations of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, m_simulations - first);
+
+        // Draw the normals of the chunk in a buffer of the worker, only grown by its first chunk
+        static thread_local std::vector<double> normals;
+        normals.resize(NormalTable::Size(count, normal_params.steps));
+        draw(normal_params, first, count, normals.data());
+
+        // Simulate the terminal spots of the chunk in both precisions, the paths counted from the chunk in its table
+        double double_terminal[chunk_size];
+        double single_terminal[chunk_size];
+        KernelParams params = double_params;
+        params.normals = normals.data();
+        PathBuffers out = PathBuffers();
+        out.terminal = double_terminal;
+        double_kernel(params, 0, count, out);
+
+        params = single_params;
+        params.normals = normals.data();
+        out.terminal = single_terminal;
+        single_kernel(params, 0, count, out);
+
+        // Add the difference of the payoffs of every pair of paths to the statistics of the chunk
+        SampleStatistics* statistics = chunk_statistics.data() + c * n_options;
+        for (long j = 0; j < n_options; ++j)
+        {
+            for (long i = 0; i < count; ++i)
+            {
+                // max(SN - K, 0) for calls and max(K - SN, 0) for puts
+                statistics[j].Add(std::max(sign[j] * (single_terminal[i] - strike[j]), 0.0)
+                    - std::max(sign[j] * (double_terminal[i] - strike[j]), 0.0));
+            }
+        }
+    }, m_priority);
+
+    // Merge the chunk statistics in chunk order and discount the mean difference and its standard error
+    const double discount = std::exp(-r * T);
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::vector<MCResult> results(n_options);
+    for (long j = 0; j < n_options; ++j)
+    {
+        SampleStatistics statistics;
+        for (long c = 0; c < n_chunks; ++c)
+            statistics.Merge(chunk_statistics[c * n_options + j]);
+
+        results[j].price = statistics.MeanX() * discount;
+        results[j].se = std::sqrt(statistics.VarianceX() / statistics.n) * discount;
+        results[j].simulations = m_simulations;
+        results[j].elapsed = elapsed;
+    }
+
+    return results;
+}
+
+// Define the PriceScenarios function
+std::vector<ScenarioResult> MonteCarlo::PriceScenarios(const std::vector<EuropeanOption>& options,
+    const ScenarioGrid& grid, const double& beta) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const bool antithetic = m_variance_reduction == VarianceReduction::Antithetic;
+    if (m_sampling != Sampling::PseudoRandom || (m_variance_reduction != VarianceReduction::None && !antithetic))
+        throw std::invalid_argument("PriceScenarios: only plain and antithetic pseudo-random sampling are supported");
+    if (m_local_volatility)
+        throw std::invalid_argument("PriceScenarios: the volatility shocks do not apply to a local volatility");
+    if (m_precision == Precision::Single)
+        throw std::invalid_argument("PriceScenarios: the scenario sweeps reuse double precision normals");
+
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double sigma = this->sigma();
+    const double S = this->S();
+    const double b = this->b();
+    const long n_options = static_cast<long>(options.size());
+
+    // Store strikes and payoff signs (+1 call, -1 put) as arrays, comparing the option types only once
+    std::vector<double> strike(n_options);
+    std::vector<double> sign(n_options);
+    for (long j = 0; j < n_options; ++j)
+    {
+        const EuropeanOption& option = options[j];
+
+        // Every option must share the simulated terminal distribution
+        if (option.T() != T || option.S() != S || option.r() != r || option.b() != b || option.sigma() != sigma)
+            throw std::invalid_argument("PriceScenarios: option " + std::to_string(option.id())
+                + " does not share the maturity, spot, rate, cost of carry and volatility of the simulation");
+
+        strike[j] = option.K();
+        sign[j] = PayoffSign(option.type(), "PriceScenarios");
+    }
+
+    // An empty list of shocks stands for no shock
+    const std::vector<double> no_shock(1, 0.0);
+    const std::vector<double>& spot_shocks = grid.spot_shocks.empty() ? no_shock : grid.spot_shocks;
+    const std::vector<double>& vol_shifts = grid.vol_shifts.empty() ? no_shock : grid.vol_shifts;
+    const std::vector<double>& rate_shifts = grid.rate_shifts.empty() ? no_shock : grid.rate_shifts;
+
+    const long n_spots = static_cast<long>(spot_shocks.size());
+    const long n_vols = static_cast<long>(vol_shifts.size());
+    const long n_rates = static_cast<long>(rate_shifts.size());
+    const long n_scenarios = n_spots * n_vols * n_rates;
+
+    for (const double& shock : spot_shocks)
+        if (!(shock > -1.0))
+            throw std::invalid_argument("PriceScenarios: the shocked spot must be positive");
+    for (const double& shift : vol_shifts)
+        if (!(sigma + shift > 0.0))
+            throw std::invalid_argument("PriceScenarios: the shocked volatility must be positive");
+
+    // How far the paths are reused: exact GBM sampling draws the normals once for every scenario, and GBM paths
+    // on the grid are proportional to the initial spot; the other betas simulate every scenario
+    const ModelType model = ClassifyBeta(beta);
+    const bool exact = model == ModelType::GBM && m_scheme == Scheme::Auto;
+    const bool linear = model == ModelType::GBM;
+
+    // Define the simulation groups, one per volatility, one per volatility and rate, or one per scenario,
+    // and for every scenario (spot-major, then volatility, then rate) its group and how its discounted payoff
+    // weight * max(sign * (scale * X - strike_factor * K), 0) follows from the terminal values X of its group
+    const long n_groups = exact ? n_vols : (linear ? n_vols * n_rates : n_scenarios);
+    std::vector<long> scenario_group(n_scenarios);
+    std::vector<double> scenario_scale(n_scenarios);
+    std::vector<double> scenario_weight(n_scenarios);
+    std::vector<double> scenario_strike(n_scenarios);
+    std::vector<ScenarioResult> results(n_scenarios);
+
+    for (long s = 0; s < n_spots; ++s)
+    {
+        for (long v = 0; v < n_vols; ++v)
+        {
+            for (long q = 0; q < n_rates; ++q)
+            {
+                const long index = (s * n_vols + v) * n_rates + q;
+                const double discount = std::exp(-(r + rate_shifts[q]) * T);
+
+                results[index].S = S * (1.0 + spot_shocks[s]);
+                results[index].sigma = sigma + vol_shifts[v];
+                results[index].r = r + rate_shifts[q];
 
-    // Create a random number generator (Mersenne Twister)
-    boost::random::mt19937 wiener_process;
+                if (exact)
+                {
+                    // X = exp(-sigma^2 * T / 2 + sigma * sqrt(T) * Z), so exp(-r * T) * ST = S * X
+                    scenario_group[index] = v;
+                    scenario_scale[index] = results[index].S;
+                    scenario_weight[index] = 1.0;
+                    scenario_strike[index] = discount;
+                }
+                else
+                {
+                    // X is the terminal spot of the group, simulated from the unshocked spot for GBM
+                    scenario_group[index] = linear ? v * n_rates + q : index;
+                    scenario_scale[index] = linear ? 1.0 + spot_shocks[s] : 1.0;
+                    scenario_weight[index] = discount;
+                    scenario_strike[index] = 1.0;
+                }
+            }
+        }
+    }
+
+    // Select the kernel and constants of every simulation group from a shocked copy of the pricer
+    std::vector<KernelParams> group_params(n_groups, KernelParams());
+    std::vector<PathKernel> group_kernels(n_groups, PathKernel(0));
+    std::shared_ptr<const NormalTable> normals;
+
+    const long n_paths = KernelPaths(m_simulations);
+
+    for (long index = 0; index < n_scenarios && !exact; ++index)
+    {
+        const long g = scenario_group[index];
+        if (group_kernels[g]) continue;
+
+        MonteCarlo shocked(*this);
+        shocked.sigma(results[index].sigma);
+        shocked.r(results[index].r);
+        if (!linear) shocked.S(results[index].S);
+
+        group_kernels[g] = shocked.TerminalKernel(beta, group_params[g]);
+        normals = shocked.AttachNormals(beta, n_paths, group_params[g]);
+    }
+
+    // Exact sampling reads the normals from the cache of common random numbers or draws them once per chunk
+    const PathKernels& kernels = SelectPathKernels(m_simd);
+    KernelParams normal_params = KernelParams();
+    normal_params.seed = m_seed;
+    normal_params.generator = m_normal_generator;
+    normal_params.steps = 1;
+    if (exact)
+        normals = AttachNormals(beta, n_paths, normal_params);
 
-    // Define a normal distribution
-    boost::random::normal_distribution<> dist(0, 1);
+    // Split the paths in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (n_paths + chunk_size - 1) / chunk_size;
+    const long n_cells = n_scenarios * n_options;
 
-    // Define a variable to store payoffs
-    double sum_payoff = 0.0;
+    // Define matrices (chunk x scenario x option) to store the payoffs and squared payoffs of every chunk
+    std::vector<double> chunk_payoff(n_chunks * n_cells, 0.0);
+    std::vector<double> chunk_square_payoff(n_chunks * n_cells, 0.0);
 
-    // Define a variable to store squared payoffs
-    double sum_square_payoff = 0.0;
+    // Run the chunks of paths on the shared thread pool, every chunk sweeps all the scenarios
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Define the range of paths of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, n_paths - first);
 
-    // Declare double SN variable
-    double SN;
+        double z[chunk_size];
+        double X[chunk_size];
+        double XA[chunk_size];
+        double sum_X[chunk_size + 1];
+        double sum_square_X[chunk_size + 1];
 
-    // Precompute beta-specific logic outside loops to avoid runtime branching
-    auto pow_function = [beta](double x) 
+        // Get the normals of the chunk once for every scenario of exact sampling
+        const double* Z = z;
+        if (exact)
         {
-        if (beta == 1.0) return x;
-        else if (beta == 0.5) return std::sqrt(x);
-        else if (beta == 2.0) return x * x;
-        else return std::pow(x, beta);
-        };
-
-    // Parallelize the loop over m_simulations
-       #pragma omp parallel reduction(+:sum_payoff, sum_square_payoff)
-    {
-        // Thread-local random number generator
-        boost::random::mt19937 local_wiener_process(wiener_process);
-        #pragma omp for
-        for (long i = 1; i <= m_simulations; ++i)
+            if (normals)
+                Z = normal_params.normals + first;
+            else
+                kernels.terminal_normals(normal_params, first, count, z);
+        }
+
+        for (long g = 0; g < n_groups; ++g)
         {
-            // Re start the S0 variable to the current underlying spot price (S) every simulation
-            double S0 = S;
+            if (exact)
+            {
+                // Rescale the normals to the volatility of the group
+                const double vol = sigma + vol_shifts[g];
+                const double drift = -0.5 * vol * vol * T;
+                const double diffusion = vol * std::sqrt(T);
 
-            // Simulate one path in the underlying for N subintervals
-            for (long a = 1; a <= m_subintervals; ++a)
+                for (long i = 0; i < count; ++i)
+                {
+                    X[i] = std::exp(drift + diffusion * Z[i]);
+                    if (antithetic) XA[i] = std::exp(drift - diffusion * Z[i]);
+                }
+            }
+            else
             {
-                // Avoid unnecessary std::pow calls
-                SN = S0 + drift_const * S0 + diffusion_const * pow_function(S0) * dist(local_wiener_process);
+                // Simulate the terminal spots of the group
+                PathBuffers out = PathBuffers();
+                out.terminal = X;
+                out.antithetic = antithetic ? XA : 0;
+                group_kernels[g](group_params[g], first, count, out);
+            }
 
-                // Update the initial Spot Value for the next subinterval
-                S0 = SN;
+            // Without antithetic pairs, sort the terminal values of the chunk and sum them and their squares in order:
+            // every payoff is linear in X on one side of its kink, so the sums of a scenario and an option are read
+            // from the running sums at the kink, instead of evaluating the payoff on every path
+            if (!antithetic)
+            {
+                std::sort(X, X + count);
+
+                sum_X[0] = sum_square_X[0] = 0.0;
+                for (long i = 0; i < count; ++i)
+                {
+                    sum_X[i + 1] = sum_X[i] + X[i];
+                    sum_square_X[i + 1] = sum_square_X[i] + X[i] * X[i];
+                }
             }
 
-            // Calculate the payoff at the end of the simulation
-            double payoff = (type == "Call")
-                ? std::max(SN - K, 0.0)
-                : std::max(K - SN, 0.0);
+            // Accumulate the payoffs of every scenario of the group straight into the chunk row
+            for (long index = 0; index < n_scenarios; ++index)
+            {
+                if (scenario_group[index] != g) continue;
+
+                const double scale = scenario_scale[index];
+                const double weight = scenario_weight[index];
+                const double factor = scenario_strike[index];
+                double* sum_payoff = chunk_payoff.data() + c * n_cells + index * n_options;
+                double* sum_square_payoff = chunk_square_payoff.data() + c * n_cells + index * n_options;
+                const double* K = strike.data();
+                const double* w = sign.data();
+
+                if (!antithetic)
+                {
+                    for (long j = 0; j < n_options; ++j)
+                    {
+                        // The paths below the kink scale * X = strike are [0, k), those above [k, count)
+                        const double kink = factor * K[j];
+                        const long k = static_cast<long>(std::lower_bound(X, X + count, kink / scale) - X);
 
-            // Add the payoff to accumulated payoffs
-            sum_payoff += payoff;
+                        // Calls pay scale * X - strike above the kink, puts strike - scale * X below it
+                        const long n = (w[j] > 0) ? count - k : k;
+                        const double s1 = (w[j] > 0) ? sum_X[count] - sum_X[k] : sum_X[k];
+                        const double s2 = (w[j] > 0) ? sum_square_X[count] - sum_square_X[k] : sum_square_X[k];
 
-            // Add the squared payoff to accumulated squared payoffs
-            if (error_analysis) sum_square_payoff += (payoff * payoff);
+                        sum_payoff[j] += weight * w[j] * (scale * s1 - kink * n);
+                        sum_square_payoff[j] += std::max(weight * weight
+                            * (scale * scale * s2 - 2.0 * scale * kink * s1 + kink * kink * n), 0.0);
+                    }
+
+                    continue;
+                }
+
+                for (long i = 0; i < count; ++i)
+                {
+                    const double SN = scale * X[i];
+                    const double SA = scale * XA[i];
+
+                    for (long j = 0; j < n_options; ++j)
+                    {
+                        // Average the payoffs of the antithetic pair
+                        const double value = 0.5 * weight
+                            * (std::max(w[j] * (SN - factor * K[j]), 0.0) + std::max(w[j] * (SA - factor * K[j]), 0.0));
+
+                        sum_payoff[j] += value;
+                        sum_square_payoff[j] += value * value;
+                    }
+                }
+            }
+        }
+    }, m_priority);
+
+    // Reduce the chunk results in chunk order, the payoffs are already discounted
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (long index = 0; index < n_scenarios; ++index)
+    {
+        results[index].prices.resize(n_options);
+
+        for (long j = 0; j < n_options; ++j)
+        {
+            const long cell = index * n_options + j;
+            double sum_payoff = 0.0;
+            double sum_square_payoff = 0.0;
+            for (long c = 0; c < n_chunks; ++c)
+            {
+                sum_payoff += chunk_payoff[c * n_cells + cell];
+                sum_square_payoff += chunk_square_payoff[c * n_cells + cell];
+            }
+
+            const double mean = sum_payoff / n_paths;
+            const double variance = std::max((sum_square_payoff - sum_payoff * mean) / (n_paths - 1), 0.0);
+
+            MCResult& result = results[index].prices[j];
+            result.price = mean;
+            result.se = std::sqrt(variance / n_paths);
+            result.simulations = m_simulations;
+            result.elapsed = elapsed;
         }
     }
 
-    // Calculate the average payoff
-    const double average_payoff = sum_payoff / m_simulations;
+    return results;
+}
+
+// Define the Price function
+double MonteCarlo::Price(const double& beta, const bool& error_analysis) const
+{
+    // The BSM control variate is the same option on a GBM path, whose price has a closed form
+    // The paths drift at the risk-free rate, so the cost of carry of the control is r
+    double control_price = -1;
+    if (m_variance_reduction == VarianceReduction::BSMControl)
+        control_price = EuropeanOption(*this).b(this->r()).Price();
+
+    // Compare the option type once and dispatch to the payoff specialization
+    if (this->type() == "Call")
+        return PricePayoff(CallPayoff(this->K()), beta, error_analysis, control_price);
 
-    // Calculate the price with exponential discount of the average payoff
-    double price = average_payoff * exp(-r * T);
+    return PricePayoff(PutPayoff(this->K()), beta, error_analysis, control_price);
+}
+
+// Define the PriceToTarget function
+MCResult MonteCarlo::PriceToTarget(const double& beta) const
+{
+    // The BSM control variate is the same option on a GBM path, whose price has a closed form
+    double control_price = -1;
+    if (m_variance_reduction == VarianceReduction::BSMControl)
+        control_price = EuropeanOption(*this).b(this->r()).Price();
+
+    // Compare the option type once and dispatch to the payoff specialization
+    if (this->type() == "Call")
+        return PricePayoffToTarget(CallPayoff(this->K()), beta, control_price);
+
+    return PricePayoffToTarget(PutPayoff(this->K()), beta, control_price);
+}
+
+// Define the PriceAsync function
+PricingHandle MonteCarlo::PriceAsync(const double& beta, const double& deadline) const
+{
+    // The BSM control variate is the same option on a GBM path, whose price has a closed form
+    double control_price = -1;
+    if (m_variance_reduction == VarianceReduction::BSMControl)
+        control_price = EuropeanOption(*this).b(this->r()).Price();
+
+    // Compare the option type once and dispatch to the payoff specialization
+    if (this->type() == "Call")
+        return PricePayoffAsync(CallPayoff(this->K()), beta, control_price, deadline);
+
+    return PricePayoffAsync(PutPayoff(this->K()), beta, control_price, deadline);
+}
+
+// Define the PriceGreeks function
+MCGreeks MonteCarlo::PriceGreeks(const double& beta) const
+{
+    // Compare the option type once and dispatch to the payoff specialization
+    if (this->type() == "Call")
+        return PricePayoffGreeks(CallPayoff(this->K()), beta);
+
+    return PricePayoffGreeks(PutPayoff(this->K()), beta);
+}
+
+// Define the PriceAdjoint function
+MCGradient MonteCarlo::PriceAdjoint(const double& beta) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (m_sampling != Sampling::PseudoRandom || m_variance_reduction != VarianceReduction::None)
+        throw std::invalid_argument("PriceAdjoint: only plain pseudo-random sampling is recorded on the tape");
+    if (m_local_volatility)
+        throw std::invalid_argument("PriceAdjoint: the nodes of a local volatility surface are not recorded on the tape");
+    if (m_precision == Precision::Single)
+        throw std::invalid_argument("PriceAdjoint: the paths are only recorded in double precision");
+
+    // Extract option parameters
+    const double T = this->T();
+    const double dt = T / m_subintervals;
+    const double sqrt_dt = std::sqrt(dt);
+    const double growth = 1.0 + this->r() * dt;
+    const double diffusion = this->sigma() * sqrt_dt;
+    const bool gbm = ClassifyBeta(beta) == ModelType::GBM;
+    const bool call = PayoffSign(this->type(), "PriceAdjoint") > 0;
+
+    // Draw the normals of a block of paths at a time with the grid kernel of the Euler - Maruyama kernels
+    KernelParams params = KernelParams();
+    params.seed = m_seed;
+    params.generator = m_normal_generator;
+    params.steps = m_subintervals;
+    const NormalKernel draw = SelectPathKernels(m_simd).grid_normals;
 
-    // If error_analysis, print an analysis of the errors
-    if (error_analysis)
-    {   
-        // Calculate SD
-        double sd = SD(sum_payoff, sum_square_payoff);
+    // Split the simulations in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (m_simulations + chunk_size - 1) / chunk_size;
 
-        // Print the error results as a table
-        std::cout << std::setw(20) << "Simulations"
-            << std::setw(20) << "Subintervals"
-            << std::setw(20) << "BSM Price"
-            << std::setw(20) << "MC Price"
-            << std::setw(20) << "SD"
-            << std::setw(20) << "SE"
-            << std::endl;
+    // Define vectors to store the statistics of every chunk, one per estimate: the price and the adjoints of S, K, r,
+    // sigma and beta; the cost of carry does not enter the paths, which drift at r as in Price
+    const int n_estimates = 6;
+    std::vector<SampleStatistics> chunk_statistics(n_chunks * n_estimates);
 
-        std::cout << std::setw(20) << m_simulations
-            << std::setw(20) << m_subintervals
-            << std::setw(20) << this->EuropeanOption::Price()
-            << std::setw(20) << price
-            << std::setw(20) << sd
-            << std::setw(20) << SE(sd)
-            << std::endl;
+    // Run the chunks of simulations on the shared thread pool, every worker recording on its own tape
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Define the range of simulations of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, m_simulations - first);
+
+        // Normals of a block of paths, subinterval after subinterval (see NormalKernel), followed by the spots, their
+        // logarithms and their powers S^beta at the start of every subinterval, in a buffer of the worker that, like
+        // its tape, is only grown by the first chunk and reused by the next ones and the next pricings
+        static thread_local std::vector<double> buffer;
+        const std::size_t size = NormalTable::Size(block_paths, m_subintervals);
+        const std::size_t states = block_paths * m_subintervals;
+        buffer.resize(size + 3 * states);
+        double* const normals = buffer.data();
+        double* const spots = normals + size;
+        double* const logs = spots + states;
+        double* const powers = logs + states;
+
+        Tape& tape = Tape::Local();
+        SampleStatistics* statistics = chunk_statistics.data() + c * n_estimates;
+
+        for (long b = 0; b < count; b += block_paths)
+        {
+            draw(params, first + b, block_paths, normals);
+
+            // Step the paths of the block in lockstep, so the logarithms and powers of independent paths overlap
+            // instead of waiting on each other along a path, which took most of the time of a recorded step;
+            // S^beta = 0 once the spot leaves the positive normal range, as in the CEV policy, and S for GBM
+            double spot[block_paths];
+            std::fill(spot, spot + block_paths, this->S());
+            for (long k = 0; k < m_subintervals; ++k)
+            {
+                for (long j = 0; j < block_paths; ++j)
+                {
+                    const long i = k * block_paths + j;
+                    const double s = spot[j];
+                    const bool positive = s >= DBL_MIN;
+                    spots[i] = s;
+                    logs[i] = positive ? std::log(s) : 0.0;
+                    powers[i] = gbm ? s : (positive ? std::exp(beta * logs[i]) : 0.0);
+                    spot[j] = s * growth + diffusion * normals[i] * powers[i];
+                }
+            }
+
+            for (long j = 0; j < block_paths && b + j < count; ++j)
+            {
+                // Record the path from its inputs on the rewound tape, reusing the arenas of the previous paths
+                tape.Reset();
+                const AReal S = AReal::Input(this->S());
+                const AReal K = AReal::Input(this->K());
+                const AReal r = AReal::Input(this->r());
+                const AReal sigma = AReal::Input(this->sigma());
+                const AReal elasticity = AReal::Input(beta);
+
+                const AReal recorded_growth = 1.0 + r * dt;
+                const AReal recorded_diffusion = sigma * sqrt_dt;
+
+                // Record every step from the stored states as a single node of the spot, the growth, the diffusion
+                // and beta: S(t + dt) = S(t) * (1 + r * dt) + sigma * sqrt(dt) * Z * S(t)^beta
+                AReal recorded_spot = S;
+                for (long k = 0; k < m_subintervals; ++k)
+                {
+                    const long i = k * block_paths + j;
+                    const double s = spots[i];
+                    const double z = normals[i];
+                    const double power = powers[i];
+                    const double shock = diffusion * z;
+                    const double slope = gbm ? shock : ((power > 0.0) ? shock * beta * power / s : 0.0);
+
+                    const AReal arguments[4] = { recorded_spot, recorded_growth, recorded_diffusion, elasticity };
+                    const double partials[4] = { growth + slope, s, z * power, shock * power * logs[i] };
+                    recorded_spot = Recorded(tape, s * growth + shock * power, 4, arguments, partials);
+                }
+
+                const AReal payoff = call ? Max(recorded_spot - K, 0.0) : Max(K - recorded_spot, 0.0);
+                const AReal price = Exp(r * -T) * payoff;
+                tape.Propagate(price.node());
+
+                statistics[0].Add(price.value());
+                statistics[1].Add(S.adjoint());
+                statistics[2].Add(K.adjoint());
+                statistics[3].Add(r.adjoint());
+                statistics[4].Add(sigma.adjoint());
+                statistics[5].Add(elasticity.adjoint());
+            }
+        }
+    }, m_priority);
+
+    // Merge the chunk statistics in chunk order, so the result is bit-identical for any number of threads
+    SampleStatistics statistics[n_estimates];
+    for (long c = 0; c < n_chunks; ++c)
+        for (int e = 0; e < n_estimates; ++e)
+            statistics[e].Merge(chunk_statistics[c * n_estimates + e]);
+
+    // The recorded payoffs are already discounted
+    MCEstimate estimates[n_estimates];
+    for (int e = 0; e < n_estimates; ++e)
+    {
+        estimates[e].value = statistics[e].MeanX();
+        estimates[e].se = std::sqrt(statistics[e].VarianceX() / statistics[e].n);
     }
 
-    // Return the price
-    return price;
+    MCGradient gradient;
+    gradient.price = estimates[0];
+    gradient.delta = estimates[1];
+    gradient.strike = estimates[2];
+    gradient.rho = estimates[3];
+    gradient.vega = estimates[4];
+    gradient.carry = MCEstimate();
+    gradient.elasticity = estimates[5];
+    gradient.simulations = m_simulations;
+    gradient.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return gradient;
 }
@@ -8,7 +8,30 @@
 // Define MONTECARLO_HPP
 #define MONTECARLO_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "CpuFeatures.hpp"
 #include "EuropeanOption.hpp"
+#include "LocalVolatility.hpp"
+#include "MCResult.hpp"
+#include "Models.hpp"
+#include "NormalCache.hpp"
+#include "PathKernel.hpp"
+#include "PathPayoffs.hpp"
+#include "Payoffs.hpp"
+#include "PricingHandle.hpp"
+#include "ScenarioGrid.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
 
 // Define MonteCarlo derived class from EuropeanOption
 class MonteCarlo : public EuropeanOption
@@ -18,16 +41,75 @@ private:
     // Declare private member variables
     long m_subintervals;
     long m_simulations;
+    unsigned long long m_seed;
+    SimdLevel m_simd;
+    Scheme m_scheme;
+    VarianceReduction m_variance_reduction;
+    Sampling m_sampling;
+    NormalGenerator m_normal_generator;
+    Precision m_precision;
+    long m_replicates;
+    double m_target_se;
+    double m_relative_tolerance;
+    double m_time_budget;
+    Priority m_priority;
+    std::shared_ptr<NormalCache> m_normal_cache;
+    std::shared_ptr<const LocalVolSurface> m_local_volatility;
 
-    // Declare SD private function
-    double SD(const double& sum_payoff, const double& sum_square_payoff) const;
-    // Declare SE private function
-    double SE(const double& sd) const;
+    // Declare ErrorAnalysis private function, a vr_factor of 0 hides the variance-reduction column
+    void ErrorAnalysis(const double& price, const double& sd, const double& se, const double& vr_factor) const;
+
+    // Declare TerminalKernel private function, selecting the kernel and constants that simulate terminal spots
+    PathKernel TerminalKernel(const double& beta, KernelParams& params) const;
+
+    // Declare GreeksKernel private function, selecting the kernel that also propagates the pathwise tangents
+    PathKernel GreeksKernel(const double& beta, KernelParams& params) const;
+
+    // Declare MonitorKernel private function, selecting the kernel and constants that stream the statistics
+    // of the monitored spots on the subinterval grid
+    PathKernel MonitorKernel(const double& beta, const PathMonitoring& monitoring, KernelParams& params) const;
+
+    // Declare AttachNormals private function, pointing the kernel parameters to the cached normals of n_paths
+    // kernel paths when a normal cache is set and the sampling is pseudo-random; the table must outlive the simulation
+    // A grid kernel reads one normal per subinterval even where terminal pricing samples GBM exactly
+    std::shared_ptr<const NormalTable> AttachNormals(const double& beta, const long& n_paths, KernelParams& params,
+        const bool& grid = false) const;
+
+    // Declare ExpectedTerminal private function, the exact expectation of the simulated terminal spot
+    double ExpectedTerminal(const double& beta) const;
+
+    // Declare Replicates private function, the number of quasi-Monte Carlo replicates (1 for pseudo-random sampling)
+    long Replicates() const;
+
+    // Declare KernelPaths private function, the number of kernel paths simulating n_simulations
+    // (an antithetic pair counts as two simulations)
+    long KernelPaths(const long& n_simulations) const;
+
+    // Declare SimulatePayoff private function, simulating the kernel paths [first_path, first_path + n_paths)
+    // and adding the samples of the variance-reduced estimator and the payoff of every single path to the statistics
+    // Returns false, leaving the statistics unchanged, when the progress of an asynchronous run is interrupted
+    template <class Payoff>
+    bool SimulatePayoff(const Payoff& payoff, const double& beta, const PathKernel& kernel, const KernelParams& params,
+        const long& first_path, const long& n_paths, SampleStatistics& samples, SampleStatistics& paths,
+        PricingProgress* progress = 0) const;
+
+    // Declare Estimate private function, combining the statistics of every replicate into the undiscounted
+    // mean payoff, the variance of that mean and the variance of the mean of plain Monte Carlo
+    void Estimate(const std::vector<SampleStatistics>& samples, const std::vector<SampleStatistics>& paths,
+        const double& beta, const double& control_price, double& mean, double& variance_of_mean,
+        double& plain_variance_of_mean) const;
+
+    // Number of simulations per chunk, fixed so the reduction order is independent of the number of threads
+    static const long chunk_size = 1024;
+
+    // Number of kernel paths of the first batch of the adaptive engine, shared by the replicates
+    static const long first_batch = 16 * chunk_size;
 
 public:
 
     // Constructor 
-    MonteCarlo(const EuropeanOption& option, const long& subintervals = 1e2, const long& simulations = 1e4);
+    MonteCarlo(const EuropeanOption& option, const long& subintervals = 1e2, const long& simulations = 1e4,
+        const unsigned long long& seed = 5489);
 
     // Copy constructor
     MonteCarlo(const MonteCarlo& source);
@@ -37,7 +119,682 @@ public:
 
     // Declare the Price function
     double Price(const double& beta = 1, const bool& error_analysis = true) const;
+
+    // Declare the PriceBatch function, pricing calls and puts on the same underlying, spot, rate, cost of
+    // carry, volatility and maturity as this option from a single set of simulated paths, without variance reduction
+    std::vector<MCResult> PriceBatch(const std::vector<EuropeanOption>& options, const double& beta = 1) const;
+
+    // Declare the PriceBatchBias function, the bias of single precision paths for every option of a batch (as
+    // PriceBatch): the discounted mean and standard error of the difference between the payoffs of float and double
+    // paths driven by the same normals, the float normals being the rounded double ones; the precision of this
+    // pricer is ignored, its sampling must be plain pseudo-random with Box - Muller normals
+    std::vector<MCResult> PriceBatchBias(const std::vector<EuropeanOption>& options, const double& beta = 1) const;
+
+    // Declare the PriceScenarios function, pricing a batch of options (as PriceBatch) under every scenario of a grid
+    // in one sweep over the paths, all the scenarios driven by the same normals. Exact GBM sampling draws the normals
+    // once and rescales them for every volatility, with the spot and rate shocks only scaling the terminal spot and
+    // the strike; Euler - Maruyama GBM paths are simulated once per volatility and rate and scaled for every spot,
+    // and the other betas are simulated once per scenario. Plain and antithetic pseudo-random sampling are supported;
+    // without antithetic pairs the payoffs of a chunk are summed from its sorted terminal values instead of path by path
+    std::vector<ScenarioResult> PriceScenarios(const std::vector<EuropeanOption>& options, const ScenarioGrid& grid,
+        const double& beta = 1) const;
+
+    // Declare the PricePayoff function, specialized at compile time for any payoff policy (see Payoffs.hpp)
+    // control_price is the discounted price of the payoff under GBM, only needed by VarianceReduction::BSMControl
+    template <class Payoff>
+    double PricePayoff(const Payoff& payoff, const double& beta = 1, const bool& error_analysis = true,
+        const double& control_price = -1) const;
+
+    // Declare the PricePathPayoff function for path-dependent payoff policies (see PathPayoffs.hpp), streaming
+    // the statistics of every path on the subinterval grid. Scheme::Auto takes exact log-normal steps for GBM;
+    // only pseudo-random sampling, plain or antithetic, is supported
+    template <class PathPayoff>
+    MCResult PricePathPayoff(const PathPayoff& payoff, const double& beta = 1) const;
+
+    // Declare the PriceToTarget function, simulating batches of paths until the target SE, the relative tolerance
+    // or the time budget is met, with the number of simulations as the largest budget
+    MCResult PriceToTarget(const double& beta = 1) const;
+
+    // Declare the PricePayoffToTarget function, the adaptive engine for any payoff policy
+    // A progress receives the estimate of every batch and can interrupt the run, keeping the batches finished before
+    template <class Payoff>
+    MCResult PricePayoffToTarget(const Payoff& payoff, const double& beta = 1, const double& control_price = -1,
+        PricingProgress* progress = 0) const;
+
+    // Declare the PriceAsync function, running PriceToTarget on a background thread and returning a handle to read
+    // the estimate so far, cancel the run or wait for the result. A deadline in seconds (0 for none) stops the run
+    // with the batches finished by then. The run uses copies of the pricer and is cancelled and joined when its
+    // last handle is destroyed
+    PricingHandle PriceAsync(const double& beta = 1, const double& deadline = 0) const;
+
+    // Declare the PricePayoffAsync function, the asynchronous adaptive engine for any payoff policy
+    template <class Payoff>
+    PricingHandle PricePayoffAsync(const Payoff& payoff, const double& beta = 1, const double& control_price = -1,
+        const double& deadline = 0) const;
+
+    // Declare the PriceGreeks function, estimating the price, Delta, Gamma, Vega and Rho in one pass:
+    // pathwise Delta, Vega and Rho, and Gamma from the likelihood-ratio / pathwise mixed estimator
+    MCGreeks PriceGreeks(const double& beta = 1) const;
+
+    // Declare the PricePayoffGreeks function for payoff policies with a Derivative(ST) member (see Payoffs.hpp)
+    template <class Payoff>
+    MCGreeks PricePayoffGreeks(const Payoff& payoff, const double& beta = 1) const;
+
+    // Declare the PriceAdjoint function, estimating the price and its derivatives with respect to S, K, r, sigma,
+    // b and beta by adjoint algorithmic differentiation: every path is recorded on the tape of its thread and the
+    // adjoints propagated backwards. The paths take the Euler - Maruyama steps of Price under Scheme::Euler for every
+    // beta, so beta stays on the tape, drifting and discounted at r; plain pseudo-random sampling in double precision
+    // only. Measured on 1000000 paths of 100 steps, the whole gradient costs about 3.5x an AVX-512 Euler - Maruyama
+    // price for beta = 0.8 and 5x for beta = 1, whose price takes no powers
+    MCGradient PriceAdjoint(const double& beta = 1) const;
+
+    // Set the seed of the counter-based random number generator
+    MonteCarlo& seed(const unsigned long long& seed);
+
+    // Set the widest instruction set the path kernel may use (capped to what the CPU supports)
+    MonteCarlo& simd(const SimdLevel& level);
+
+    // Set the discretization scheme (Scheme::Auto samples GBM exactly, Scheme::Euler always steps the grid)
+    MonteCarlo& scheme(const Scheme& scheme);
+
+    // Set the variance-reduction technique of Price and PricePayoff
+    MonteCarlo& variance_reduction(const VarianceReduction& technique);
+
+    // Set the source of the normals (Sampling::Sobol for quasi-Monte Carlo)
+    MonteCarlo& sampling(const Sampling& sampling);
+
+    // Set the transform of the pseudo-random numbers into normals (quasi-Monte Carlo always uses the inverse CDF)
+    MonteCarlo& normal_generator(const NormalGenerator& generator);
+
+    // Set the precision of the paths of the terminal payoffs (Precision::Single steps float spots on pseudo-random
+    // Box - Muller normals, or on the cached normals rounded to float, and rejects the Greeks, path payoffs, scenario
+    // sweeps and local volatility)
+    MonteCarlo& precision(const Precision& precision);
+
+    // Set the number of independently scrambled replicates the quasi-Monte Carlo simulations are split in
+    MonteCarlo& replicates(const long& replicates);
+
+    // Set the standard error the adaptive engine stops at (0 disables the criterion)
+    MonteCarlo& target_se(const double& se);
+
+    // Set the standard error relative to the price the adaptive engine stops at (0 disables the criterion)
+    MonteCarlo& relative_tolerance(const double& tolerance);
+
+    // Set the wall-clock time in seconds after which the adaptive engine stops (0 disables the criterion)
+    MonteCarlo& time_budget(const double& seconds);
+
+    // Set the priority of the chunks of this pricer in the shared thread pool
+    MonteCarlo& priority(const Priority& priority);
+
+    // Set the cache of common random numbers (null to draw the normals), shared by the pricings of every
+    // bumped or stressed copy of this pricer with the same seed, normal generator, subintervals and simulations
+    MonteCarlo& normal_cache(const std::shared_ptr<NormalCache>& cache);
+
+    // Set the local volatility surface sigma(t, S) replacing sigma (null for the CEV diffusion); the terminal payoffs
+    // of Price, PricePayoff, PriceBatch and the adaptive engines then step the log-spot on the subinterval grid with
+    // the volatility read from the surface, and the BSM control variate uses a GBM path at sigma
+    MonteCarlo& local_volatility(const std::shared_ptr<const LocalVolSurface>& surface);
+
+    // Get inline functions
+    // Get number of subintervals
+    const long& subintervals() const { return m_subintervals; }
+    // Get number of simulations
+    const long& simulations() const { return m_simulations; }
+    // Get random number generator seed
+    const unsigned long long& seed() const { return m_seed; }
+    // Get instruction set of the path kernel
+    const SimdLevel& simd() const { return m_simd; }
+    // Get discretization scheme
+    const Scheme& scheme() const { return m_scheme; }
+    // Get variance-reduction technique
+    const VarianceReduction& variance_reduction() const { return m_variance_reduction; }
+    // Get source of the normals
+    const Sampling& sampling() const { return m_sampling; }
+    // Get generator of the pseudo-random normals
+    const NormalGenerator& normal_generator() const { return m_normal_generator; }
+    // Get precision of the simulated paths
+    const Precision& precision() const { return m_precision; }
+    // Get number of quasi-Monte Carlo replicates
+    const long& replicates() const { return m_replicates; }
+    // Get target standard error
+    const double& target_se() const { return m_target_se; }
+    // Get target relative standard error
+    const double& relative_tolerance() const { return m_relative_tolerance; }
+    // Get time budget in seconds
+    const double& time_budget() const { return m_time_budget; }
+    // Get priority in the shared thread pool
+    const Priority& priority() const { return m_priority; }
+    // Get cache of common random numbers
+    const std::shared_ptr<NormalCache>& normal_cache() const { return m_normal_cache; }
+    // Get local volatility surface
+    const std::shared_ptr<const LocalVolSurface>& local_volatility() const { return m_local_volatility; }
 };
 
+// Define the PricePayoff function
+template <class Payoff>
+double MonteCarlo::PricePayoff(const Payoff& payoff, const double& beta, const bool& error_analysis,
+    const double& control_price) const
+{
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double discount = std::exp(-r * T);
+
+    if (m_variance_reduction == VarianceReduction::BSMControl && control_price < 0)
+        throw std::invalid_argument("PricePayoff: the BSM control variate needs the GBM price of the payoff");
+
+    // Select the path kernel specialized for the model, the scheme, the sampling and the instruction set once
+    // Every lane draws its own Philox stream keyed by (seed, path, step), or its own Sobol point
+    KernelParams params = KernelParams();
+    const PathKernel kernel = TerminalKernel(beta, params);
+
+    // Split the simulations between the randomized replicates, a single one for pseudo-random sampling
+    const long replicates = Replicates();
+    const long n_paths = KernelPaths(m_simulations / replicates);
+
+    // Read the normals from the cache of common random numbers when one is set
+    const std::shared_ptr<const NormalTable> normals = AttachNormals(beta, n_paths, params);
+
+    // Define the statistics of every replicate
+    std::vector<SampleStatistics> samples(replicates);
+    std::vector<SampleStatistics> paths(replicates);
+
+    for (long replicate = 0; replicate < replicates; ++replicate)
+    {
+        // Every replicate scrambles the Sobol points with its own seed
+        params.seed = m_seed + replicate;
+        SimulatePayoff(payoff, beta, kernel, params, 0, n_paths, samples[replicate], paths[replicate]);
+    }
+
+    // Estimate the mean payoff and its variance
+    double mean, variance_of_mean, plain_variance_of_mean;
+    Estimate(samples, paths, beta, control_price, mean, variance_of_mean, plain_variance_of_mean);
+
+    // Calculate the price with exponential discount of the average payoff
+    const double price = mean * discount;
+
+    // If error_analysis, print an analysis of the errors
+    if (error_analysis)
+    {
+        // SE of the estimator and SD of an equivalent single simulation
+        const double se = std::sqrt(variance_of_mean) * discount;
+        const double sd = se * std::sqrt(static_cast<double>(m_simulations));
+
+        // Variance of plain Monte Carlo with the same number of simulations over the variance of the estimator
+        const bool plain = m_variance_reduction == VarianceReduction::None && replicates == 1;
+        const double vr_factor = plain ? 0.0 : plain_variance_of_mean / variance_of_mean;
+
+        ErrorAnalysis(price, sd, se, vr_factor);
+    }
+
+    // Return the price
+    return price;
+}
+
+// Define the PricePayoffToTarget function
+template <class Payoff>
+MCResult MonteCarlo::PricePayoffToTarget(const Payoff& payoff, const double& beta, const double& control_price,
+    PricingProgress* progress) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double discount = std::exp(-r * T);
+
+    if (m_variance_reduction == VarianceReduction::BSMControl && control_price < 0)
+        throw std::invalid_argument("PricePayoffToTarget: the BSM control variate needs the GBM price of the payoff");
+    if (m_variance_reduction == VarianceReduction::MomentMatching)
+        throw std::invalid_argument("PricePayoffToTarget: moment matching needs the whole sample up front");
+
+    // Select the path kernel once
+    KernelParams params = KernelParams();
+    const PathKernel kernel = TerminalKernel(beta, params);
+
+    // The number of simulations is the largest budget, split between the replicates
+    const long replicates = Replicates();
+    const long max_paths = KernelPaths(m_simulations / replicates);
+
+    // Read the normals from the cache of common random numbers when one is set
+    const std::shared_ptr<const NormalTable> normals = AttachNormals(beta, max_paths, params);
+
+    // Define the statistics of every replicate, extended batch after batch
+    std::vector<SampleStatistics> samples(replicates);
+    std::vector<SampleStatistics> paths(replicates);
+
+    // Without any finished batch there is no estimate
+    MCResult result;
+    result.price = std::numeric_limits<double>::quiet_NaN();
+    result.se = std::numeric_limits<double>::infinity();
+    result.simulations = 0;
+
+    long n_paths = 0;
+    long batch = std::min(std::max(chunk_size, first_batch / replicates), max_paths);
+
+    while (true)
+    {
+        // Simulate the next batch of paths of every replicate, continuing their random streams or Sobol points,
+        // on copies of the statistics so an interrupted batch is dropped as a whole
+        std::vector<SampleStatistics> batch_samples(samples);
+        std::vector<SampleStatistics> batch_paths(paths);
+        bool interrupted = false;
+
+        for (long replicate = 0; replicate < replicates && !interrupted; ++replicate)
+        {
+            params.seed = m_seed + replicate;
+            interrupted = !SimulatePayoff(payoff, beta, kernel, params, n_paths, batch, batch_samples[replicate],
+                batch_paths[replicate], progress);
+        }
+
+        if (interrupted) break;
+
+        samples.swap(batch_samples);
+        paths.swap(batch_paths);
+        n_paths += batch;
+
+        // Estimate the price and its SE so far
+        double mean, variance_of_mean, plain_variance_of_mean;
+        Estimate(samples, paths, beta, control_price, mean, variance_of_mean, plain_variance_of_mean);
+
+        result.price = mean * discount;
+        result.se = std::sqrt(variance_of_mean) * discount;
+        result.simulations = 0;
+        for (long replicate = 0; replicate < replicates; ++replicate)
+            result.simulations += static_cast<long>(paths[replicate].n);
+        result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (progress)
+            progress->Publish(result);
+
+        // Take the tighter of the standard error targets
+        double target = 0.0;
+        if (m_target_se > 0) target = m_target_se;
+        if (m_relative_tolerance > 0 && (target == 0.0 || m_relative_tolerance * std::fabs(result.price) < target))
+            target = m_relative_tolerance * std::fabs(result.price);
+
+        // Stop when a target is met, the time is over or the budget is spent
+        if (target > 0 && result.se <= target) break;
+        if (m_time_budget > 0 && result.elapsed >= m_time_budget) break;
+        if (n_paths >= max_paths) break;
+
+        // Project the paths needed from SE ~ 1 / sqrt(n), growing by at most a factor of 2 per batch
+        // The projection only depends on the statistics, so the stopping point does not depend on the threads
+        batch = n_paths;
+        if (target > 0)
+        {
+            const double needed = n_paths * (result.se / target) * (result.se / target);
+            batch = std::max(chunk_size, std::min(n_paths, static_cast<long>(std::ceil(needed)) - n_paths));
+        }
+
+        // Do not plan beyond the time left of the budget or before the deadline at the speed measured so far
+        double time_left = (m_time_budget > 0) ? m_time_budget - result.elapsed : std::numeric_limits<double>::infinity();
+        if (progress)
+            time_left = std::min(time_left, progress->TimeLeft());
+
+        if (time_left < std::numeric_limits<double>::infinity())
+        {
+            const double rate = n_paths / result.elapsed;
+            batch = std::max(chunk_size, static_cast<long>(std::min(static_cast<double>(batch), rate * time_left)));
+        }
+
+        batch = std::min(batch, max_paths - n_paths);
+    }
+
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+// Define the PricePayoffAsync function
+template <class Payoff>
+PricingHandle MonteCarlo::PricePayoffAsync(const Payoff& payoff, const double& beta, const double& control_price,
+    const double& deadline) const
+{
+    std::shared_ptr<PricingProgress> progress = std::make_shared<PricingProgress>(deadline);
+
+    // Create the thread pool before the handle, so a handle with static storage is destroyed, and its run joined,
+    // before the pool
+    ThreadPool::Global();
+
+    // The run owns copies of the pricer and the payoff, and is driven by its own thread, owned by the handles,
+    // which runs chunks of its batches next to the workers of the thread pool
+    const MonteCarlo pricer(*this);
+    std::thread driver([pricer, payoff, beta, control_price, progress]()
+    {
+        try
+        {
+            progress->Finish(pricer.PricePayoffToTarget(payoff, beta, control_price, progress.get()));
+        }
+        catch (...)
+        {
+            progress->Fail(std::current_exception());
+        }
+    });
+
+    return PricingHandle(progress, std::move(driver));
+}
+
+// Define the PricePayoffGreeks function
+template <class Payoff>
+MCGreeks MonteCarlo::PricePayoffGreeks(const Payoff& payoff, const double& beta) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double discount = std::exp(-r * T);
+
+    // Select the kernel that simulates the terminal spots and their tangents once
+    KernelParams params = KernelParams();
+    const PathKernel kernel = GreeksKernel(beta, params);
+
+    // Read the normals from the cache of common random numbers when one is set
+    const std::shared_ptr<const NormalTable> normals = AttachNormals(beta, m_simulations, params);
+
+    // Split the simulations in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (m_simulations + chunk_size - 1) / chunk_size;
+
+    // Define vectors to store the statistics of every chunk, one per estimate:
+    // price f(ST), Delta f'(ST) * dST/dS0, Gamma f'(ST) * G, Vega f'(ST) * dST/dsigma and Rho f'(ST) * dST/dr - T * f(ST)
+    const int n_estimates = 5;
+    std::vector<SampleStatistics> chunk_statistics(n_chunks * n_estimates);
+
+    // Run the chunks of simulations on the shared thread pool
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Define the range of simulations of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, m_simulations - first);
+
+        // Simulate the terminal spots of the chunk with their tangents
+        double terminal[chunk_size];
+        double delta[chunk_size];
+        double vega[chunk_size];
+        double rho[chunk_size];
+        double gamma[chunk_size];
+
+        PathBuffers out = PathBuffers();
+        out.terminal = terminal;
+        out.delta = delta;
+        out.vega = vega;
+        out.rho = rho;
+        out.gamma = gamma;
+        kernel(params, first, count, out);
+
+        // Accumulate every estimate in the chunk row
+        SampleStatistics* statistics = chunk_statistics.data() + c * n_estimates;
+
+        for (long i = 0; i < count; ++i)
+        {
+            // The payoff and its derivative at the end of the simulation
+            const double value = payoff(terminal[i]);
+            const double slope = payoff.Derivative(terminal[i]);
+
+            statistics[0].Add(value);
+            statistics[1].Add(slope * delta[i]);
+            statistics[2].Add(slope * gamma[i]);
+            statistics[3].Add(slope * vega[i]);
+            statistics[4].Add(slope * rho[i] - T * value);
+        }
+    }, m_priority);
+
+    // Merge the chunk statistics in chunk order, so the result is bit-identical for any number of threads
+    SampleStatistics statistics[n_estimates];
+    for (long c = 0; c < n_chunks; ++c)
+        for (int e = 0; e < n_estimates; ++e)
+            statistics[e].Merge(chunk_statistics[c * n_estimates + e]);
+
+    // Discount every estimate and its standard error
+    MCEstimate estimates[n_estimates];
+    for (int e = 0; e < n_estimates; ++e)
+    {
+        estimates[e].value = statistics[e].MeanX() * discount;
+        estimates[e].se = std::sqrt(statistics[e].VarianceX() / statistics[e].n) * discount;
+    }
+
+    MCGreeks greeks;
+    greeks.price = estimates[0];
+    greeks.delta = estimates[1];
+    greeks.gamma = estimates[2];
+    greeks.vega = estimates[3];
+    greeks.rho = estimates[4];
+    greeks.simulations = m_simulations;
+    greeks.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return greeks;
+}
+
+// Define the PricePathPayoff function
+template <class PathPayoff>
+MCResult MonteCarlo::PricePathPayoff(const PathPayoff& payoff, const double& beta) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double discount = std::exp(-r * T);
+
+    if (m_variance_reduction != VarianceReduction::None && m_variance_reduction != VarianceReduction::Antithetic)
+        throw std::invalid_argument("PricePathPayoff: only plain and antithetic sampling price path payoffs");
+
+    // Select the monitoring kernel once
+    const PathMonitoring monitoring = payoff.Monitoring();
+    KernelParams params = KernelParams();
+    const PathKernel kernel = MonitorKernel(beta, monitoring, params);
+
+    const bool antithetic = m_variance_reduction == VarianceReduction::Antithetic;
+    const long n_paths = KernelPaths(m_simulations);
+
+    // Read the normals from the cache of common random numbers when one is set
+    const std::shared_ptr<const NormalTable> normals = AttachNormals(beta, n_paths, params, true);
+
+    // Split the paths in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (n_paths + chunk_size - 1) / chunk_size;
+    std::vector<SampleStatistics> chunk_statistics(n_chunks);
+
+    // Run the chunks of paths on the shared thread pool
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Define the range of paths of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, n_paths - first);
+
+        // Stream the statistics of the chunk, and of its antithetic paths, into the buffers the payoff reads
+        const int n_statistics = 6;
+        double buffers[2][n_statistics][chunk_size];
+
+        PathBuffers out = PathBuffers();
+        out.terminal = buffers[0][0];
+        out.antithetic = antithetic ? buffers[1][0] : 0;
+
+        MonitorBuffers* monitor[2] = { &out.monitor, &out.monitor_antithetic };
+        for (int side = 0; side < (antithetic ? 2 : 1); ++side)
+        {
+            monitor[side]->average = monitoring.average ? buffers[side][1] : 0;
+            monitor[side]->geometric = monitoring.geometric ? buffers[side][2] : 0;
+            monitor[side]->minimum = monitoring.extremes ? buffers[side][3] : 0;
+            monitor[side]->maximum = monitoring.extremes ? buffers[side][4] : 0;
+            monitor[side]->survival = monitoring.barrier ? buffers[side][5] : 0;
+        }
+
+        kernel(params, first, count, out);
+
+        // Define chunk-local accumulator
+        SampleStatistics statistics;
+
+        for (long i = 0; i < count; ++i)
+        {
+            // Calculate the payoff of the path, averaged with the payoff of the antithetic path
+            double value = 0.0;
+            for (int side = 0; side < (antithetic ? 2 : 1); ++side)
+            {
+                PathSummary path = PathSummary();
+                path.terminal = buffers[side][0][i];
+                if (monitoring.average) path.average = buffers[side][1][i];
+                if (monitoring.geometric) path.geometric = buffers[side][2][i];
+                if (monitoring.extremes)
+                {
+                    path.minimum = buffers[side][3][i];
+                    path.maximum = buffers[side][4][i];
+                }
+                if (monitoring.barrier) path.survival = buffers[side][5][i];
+
+                value += payoff(path);
+            }
+
+            statistics.Add(antithetic ? 0.5 * value : value);
+        }
+
+        // Store the chunk results
+        chunk_statistics[c] = statistics;
+    }, m_priority);
+
+    // Merge the chunk statistics in chunk order, so the result is bit-identical for any number of threads
+    SampleStatistics statistics;
+    for (long c = 0; c < n_chunks; ++c)
+        statistics.Merge(chunk_statistics[c]);
+
+    // Discount the mean payoff and its standard error
+    MCResult result;
+    result.price = statistics.MeanX() * discount;
+    result.se = std::sqrt(statistics.VarianceX() / statistics.n) * discount;
+    result.simulations = m_simulations;
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+// Define the SimulatePayoff function
+template <class Payoff>
+bool MonteCarlo::SimulatePayoff(const Payoff& payoff, const double& beta, const PathKernel& kernel,
+    const KernelParams& params, const long& first_path, const long& n_paths, SampleStatistics& all_samples,
+    SampleStatistics& all_paths, PricingProgress* progress) const
+{
+    // Check the variance-reduction technique once
+    const bool antithetic = m_variance_reduction == VarianceReduction::Antithetic;
+    const bool spot_control = m_variance_reduction == VarianceReduction::SpotControl;
+    const bool bsm_control = m_variance_reduction == VarianceReduction::BSMControl;
+    const bool moment_matching = m_variance_reduction == VarianceReduction::MomentMatching;
+
+    // Split the paths in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (n_paths + chunk_size - 1) / chunk_size;
+
+    // Define vectors to store the statistics of every chunk: the estimator samples and, to measure the
+    // variance reduction, the payoff of every single path
+    std::vector<SampleStatistics> chunk_samples(n_chunks);
+    std::vector<SampleStatistics> chunk_paths(n_chunks);
+
+    // Moment matching needs the mean of every terminal spot before evaluating any payoff
+    std::vector<double> terminals(moment_matching ? n_paths : 0);
+
+    // Set when a chunk is skipped because the run was interrupted
+    std::atomic<bool> skipped(false);
+
+    // Run the chunks of paths on the shared thread pool
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Skip the chunks of an interrupted run, whose batch is dropped
+        if (progress && progress->Interrupted())
+        {
+            skipped = true;
+            return;
+        }
+
+        // Define the range of paths of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, n_paths - first);
+
+        // Simulate the terminal spots of the chunk, a block of paths at a time,
+        // together with the antithetic and GBM control paths driven by the same normals
+        double terminal[chunk_size];
+        double terminal_antithetic[chunk_size];
+        double control[chunk_size];
+        double control_antithetic[chunk_size];
+
+        PathBuffers out = PathBuffers();
+        out.terminal = moment_matching ? terminals.data() + first : terminal;
+        out.antithetic = antithetic ? terminal_antithetic : 0;
+        out.control = bsm_control ? control : 0;
+        out.control_antithetic = (bsm_control && antithetic) ? control_antithetic : 0;
+        kernel(params, first_path + first, count, out);
+
+        // The payoffs of moment matching are evaluated once every terminal spot is known
+        if (moment_matching) return;
+
+        // Define chunk-local accumulators
+        SampleStatistics samples;
+        SampleStatistics paths;
+
+        for (long i = 0; i < count; ++i)
+        {
+            // Calculate the payoff at the end of the simulation
+            double value = payoff(terminal[i]);
+            paths.Add(value);
+
+            // Average the payoffs of the antithetic pair
+            if (antithetic)
+            {
+                const double value_antithetic = payoff(terminal_antithetic[i]);
+                paths.Add(value_antithetic);
+                value = 0.5 * (value + value_antithetic);
+            }
+
+            // Pair the payoff with its control variate
+            if (spot_control)
+                samples.Add(value, terminal[i]);
+            else if (bsm_control)
+                samples.Add(value, antithetic ? 0.5 * (payoff(control[i]) + payoff(control_antithetic[i])) : payoff(control[i]));
+            else
+                samples.Add(value);
+        }
+
+        // Store the chunk results
+        chunk_samples[c] = samples;
+        chunk_paths[c] = paths;
+    }, m_priority);
+
+    if (moment_matching)
+    {
+        // Rescale the terminal spots so their sample mean, summed in path order, matches the exact expectation
+        double sum_terminal = 0.0;
+        for (long i = 0; i < n_paths; ++i)
+            sum_terminal += terminals[i];
+        const double scale = ExpectedTerminal(beta) / (sum_terminal / n_paths);
+
+        ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+        {
+            const long first = c * chunk_size;
+            const long count = std::min(chunk_size, n_paths - first);
+
+            SampleStatistics samples;
+            SampleStatistics paths;
+
+            for (long i = first; i < first + count; ++i)
+            {
+                samples.Add(payoff(terminals[i] * scale));
+                paths.Add(payoff(terminals[i]), terminals[i]);
+            }
+
+            chunk_samples[c] = samples;
+            chunk_paths[c] = paths;
+        }, m_priority);
+    }
+
+    if (skipped)
+        return false;
+
+    // Merge the chunk statistics in chunk order, so the result is bit-identical for any number of threads
+    for (long c = 0; c < n_chunks; ++c)
+    {
+        all_samples.Merge(chunk_samples[c]);
+        all_paths.Merge(chunk_paths[c]);
+    }
+
+    return true;
+}
+
 // End of the conditional inclusion of the header file
 #endif
\ No newline at end of file
@@ -0,0 +1,310 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// MultiAssetMonteCarlo.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the MultiAssetMonteCarlo class
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "MultiAssetMonteCarlo.hpp"
+
+// Define the static constant, bound to references by std::min
+const long MultiAssetMonteCarlo::chunk_size;
+
+namespace
+{
+    // Diagonalize a symmetric n x n matrix by cyclic Jacobi rotations, overwriting it with its eigenvalues on the
+    // diagonal and returning the eigenvectors as the columns of vectors
+    void JacobiEigen(std::vector<double>& a, const long& n, std::vector<double>& vectors)
+    {
+        vectors.assign(n * n, 0.0);
+        for (long i = 0; i < n; ++i)
+            vectors[i * n + i] = 1.0;
+
+        for (int sweep = 0; sweep < 100; ++sweep)
+        {
+            // Stop when the off-diagonal entries are negligible against the diagonal ones
+            double off = 0.0, diagonal = 0.0;
+            for (long i = 0; i < n; ++i)
+            {
+                diagonal += a[i * n + i] * a[i * n + i];
+                for (long j = i + 1; j < n; ++j)
+                    off += a[i * n + j] * a[i * n + j];
+            }
+            if (off <= 1e-30 * diagonal)
+                return;
+
+            for (long p = 0; p < n; ++p)
+            {
+                for (long q = p + 1; q < n; ++q)
+                {
+                    const double apq = a[p * n + q];
+                    if (apq == 0.0) continue;
+
+                    // Rotation angle that zeroes a(p, q)
+                    const double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+                    const double t = ((theta >= 0.0) ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                    const double c = 1.0 / std::sqrt(t * t + 1.0);
+                    const double s = t * c;
+
+                    for (long k = 0; k < n; ++k)
+                    {
+                        const double akp = a[k * n + p];
+                        const double akq = a[k * n + q];
+                        a[k * n + p] = c * akp - s * akq;
+                        a[k * n + q] = s * akp + c * akq;
+                    }
+                    for (long k = 0; k < n; ++k)
+                    {
+                        const double apk = a[p * n + k];
+                        const double aqk = a[q * n + k];
+                        a[p * n + k] = c * apk - s * aqk;
+                        a[q * n + k] = s * apk + c * aqk;
+                    }
+                    for (long k = 0; k < n; ++k)
+                    {
+                        const double vkp = vectors[k * n + p];
+                        const double vkq = vectors[k * n + q];
+                        vectors[k * n + p] = c * vkp - s * vkq;
+                        vectors[k * n + q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Constructor
+MultiAssetMonteCarlo::MultiAssetMonteCarlo(const std::vector<double>& spots, const std::vector<double>& vols,
+    const std::vector<double>& correlation, const double& r, const double& T, const long& simulations,
+    const unsigned long long& seed) :
+    m_spots(spots),
+    m_vols(vols),
+    m_dividends(spots.size(), 0.0),
+    m_correlation(correlation),
+    m_r(r),
+    m_T(T),
+    m_simulations(simulations),
+    m_factors(0),
+    m_seed(seed),
+    m_simd(DetectSimdLevel()),
+    m_variance_reduction(VarianceReduction::None),
+    m_priority(Priority::Normal)
+{
+    const std::size_t n = spots.size();
+
+    if (n == 0 || n > static_cast<std::size_t>(max_basket_assets))
+        throw std::invalid_argument("MultiAssetMonteCarlo: the number of assets must be between 1 and "
+            + std::to_string(max_basket_assets));
+    if (vols.size() != n || correlation.size() != n * n)
+        throw std::invalid_argument("MultiAssetMonteCarlo: every asset needs a volatility and a row of correlations");
+    if (!(T > 0.0) || simulations < 2)
+        throw std::invalid_argument("MultiAssetMonteCarlo: the maturity must be positive, with at least two simulations");
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (!(spots[i] > 0.0) || !(vols[i] > 0.0))
+            throw std::invalid_argument("MultiAssetMonteCarlo: spots and volatilities must be positive");
+        if (correlation[i * n + i] != 1.0)
+            throw std::invalid_argument("MultiAssetMonteCarlo: the correlation matrix must have a unit diagonal");
+        for (std::size_t j = 0; j < i; ++j)
+            if (correlation[i * n + j] != correlation[j * n + i] || !(std::fabs(correlation[i * n + j]) <= 1.0))
+                throw std::invalid_argument("MultiAssetMonteCarlo: the correlation matrix must be symmetric, within [-1, 1]");
+    }
+
+    Factorize();
+}
+
+// Copy Constructor
+MultiAssetMonteCarlo::MultiAssetMonteCarlo(const MultiAssetMonteCarlo& source) :
+    m_spots(source.m_spots),
+    m_vols(source.m_vols),
+    m_dividends(source.m_dividends),
+    m_correlation(source.m_correlation),
+    m_r(source.m_r),
+    m_T(source.m_T),
+    m_simulations(source.m_simulations),
+    m_factors(source.m_factors),
+    m_seed(source.m_seed),
+    m_simd(source.m_simd),
+    m_variance_reduction(source.m_variance_reduction),
+    m_priority(source.m_priority),
+    m_loading(source.m_loading),
+    m_residual(source.m_residual)
+{}
+
+// Assignment operator
+MultiAssetMonteCarlo& MultiAssetMonteCarlo::operator=(const MultiAssetMonteCarlo& source)
+{
+    // Check for self assignment
+    if (this == &source)
+        return *this;
+
+    m_spots = source.m_spots;
+    m_vols = source.m_vols;
+    m_dividends = source.m_dividends;
+    m_correlation = source.m_correlation;
+    m_r = source.m_r;
+    m_T = source.m_T;
+    m_simulations = source.m_simulations;
+    m_factors = source.m_factors;
+    m_seed = source.m_seed;
+    m_simd = source.m_simd;
+    m_variance_reduction = source.m_variance_reduction;
+    m_priority = source.m_priority;
+    m_loading = source.m_loading;
+    m_residual = source.m_residual;
+
+    return *this;
+}
+
+// Compute the loading matrix of the correlation
+void MultiAssetMonteCarlo::Factorize()
+{
+    const long n = assets();
+
+    // Exact correlation: lower-triangular Cholesky factor L with L * L' = correlation
+    if (m_factors == 0 || m_factors >= n)
+    {
+        m_loading.assign(n * n, 0.0);
+        m_residual.clear();
+
+        for (long i = 0; i < n; ++i)
+        {
+            for (long j = 0; j <= i; ++j)
+            {
+                double sum = m_correlation[i * n + j];
+                for (long k = 0; k < j; ++k)
+                    sum -= m_loading[i * n + k] * m_loading[j * n + k];
+
+                if (i == j)
+                {
+                    if (!(sum > 0.0))
+                        throw std::invalid_argument("correlation: the correlation matrix must be positive definite");
+                    m_loading[i * n + i] = std::sqrt(sum);
+                }
+                else
+                    m_loading[i * n + j] = sum / m_loading[j * n + j];
+            }
+        }
+        return;
+    }
+
+    // Factor model: the eigenvectors of the largest eigenvalues, scaled by their square roots, and the
+    // idiosyncratic scale that brings every variance back to 1
+    std::vector<double> a(m_correlation);
+    std::vector<double> vectors;
+    JacobiEigen(a, n, vectors);
+
+    std::vector<long> order(n);
+    std::iota(order.begin(), order.end(), 0L);
+    std::sort(order.begin(), order.end(), [&](const long& x, const long& y) { return a[x * n + x] > a[y * n + y]; });
+
+    if (a[order[n - 1] * n + order[n - 1]] < -1e-10)
+        throw std::invalid_argument("correlation: the correlation matrix must be positive semidefinite");
+
+    m_loading.assign(n * m_factors, 0.0);
+    m_residual.assign(n, 0.0);
+
+    for (long i = 0; i < n; ++i)
+    {
+        double explained = 0.0;
+        for (long f = 0; f < m_factors; ++f)
+        {
+            const long k = order[f];
+            const double loading = vectors[i * n + k] * std::sqrt(std::max(a[k * n + k], 0.0));
+            m_loading[i * m_factors + f] = loading;
+            explained += loading * loading;
+        }
+        m_residual[i] = std::sqrt(std::max(1.0 - explained, 0.0));
+    }
+}
+
+// Set the dividend yields
+MultiAssetMonteCarlo& MultiAssetMonteCarlo::dividends(const std::vector<double>& dividends)
+{
+    if (dividends.size() != m_spots.size())
+        throw std::invalid_argument("dividends: every asset needs a dividend yield");
+
+    m_dividends = dividends;
+    return *this;
+}
+
+// Set the number of factors
+MultiAssetMonteCarlo& MultiAssetMonteCarlo::factors(const long& factors)
+{
+    if (factors < 0)
+        throw std::invalid_argument("factors: the number of factors must be non-negative");
+
+    m_factors = factors;
+    Factorize();
+    return *this;
+}
+
+// Set the number of simulations
+MultiAssetMonteCarlo& MultiAssetMonteCarlo::simulations(const long& simulations)
+{
+    if (simulations < 2)
+        throw std::invalid_argument("simulations: at least two simulations are needed to estimate the variance");
+
+    m_simulations = simulations;
+    return *this;
+}
+
+// Set the seed of the counter-based random number generator
+MultiAssetMonteCarlo& MultiAssetMonteCarlo::seed(const unsigned long long& seed)
+{
+    m_seed = seed;
+    return *this;
+}
+
+// Set the instruction set of the basket kernel
+MultiAssetMonteCarlo& MultiAssetMonteCarlo::simd(const SimdLevel& level)
+{
+    m_simd = level;
+    return *this;
+}
+
+// Set the variance-reduction technique
+MultiAssetMonteCarlo& MultiAssetMonteCarlo::variance_reduction(const VarianceReduction& technique)
+{
+    m_variance_reduction = technique;
+    return *this;
+}
+
+// Set the priority of the chunks in the shared thread pool
+MultiAssetMonteCarlo& MultiAssetMonteCarlo::priority(const Priority& priority)
+{
+    m_priority = priority;
+    return *this;
+}
+
+// Select the basket kernel and fill its parameters
+BasketKernel MultiAssetMonteCarlo::Kernel(BasketParams& params, std::vector<double>& drift,
+    std::vector<double>& diffusion) const
+{
+    const long n = assets();
+
+    // Precompute the log-forward and the diffusion of every asset over the whole maturity
+    drift.resize(n);
+    diffusion.resize(n);
+    for (long i = 0; i < n; ++i)
+    {
+        drift[i] = std::log(m_spots[i]) + (m_r - m_dividends[i] - 0.5 * m_vols[i] * m_vols[i]) * m_T;
+        diffusion[i] = m_vols[i] * std::sqrt(m_T);
+    }
+
+    params.assets = n;
+    params.factors = m_residual.empty() ? n : m_factors;
+    params.triangular = m_residual.empty();
+    params.loading = m_loading.data();
+    params.residual = m_residual.empty() ? 0 : m_residual.data();
+    params.drift = drift.data();
+    params.diffusion = diffusion.data();
+    params.seed = m_seed;
+
+    return SelectPathKernels(m_simd).basket_terminal;
+}
@@ -0,0 +1,210 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// MultiAssetMonteCarlo.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the MultiAssetMonteCarlo class
+
+// If MULTIASSETMONTECARLO_HPP is not defined
+#ifndef MULTIASSETMONTECARLO_HPP
+// Define MULTIASSETMONTECARLO_HPP
+#define MULTIASSETMONTECARLO_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "BasketPayoffs.hpp"
+#include "CpuFeatures.hpp"
+#include "MCResult.hpp"
+#include "PathKernel.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
+
+// Define MultiAssetMonteCarlo class, pricing European payoffs on correlated GBM assets
+// The terminal spots are sampled exactly, so a path takes a single step whatever the maturity. The correlation
+// matrix is factorized once: by Cholesky, with assets * (assets + 1) / 2 multiply-adds per path, or with a number
+// of factors by its leading eigenvectors plus an idiosyncratic normal per asset that keeps every variance exact,
+// with assets * (factors + 1) multiply-adds per path, linear in the number of assets
+class MultiAssetMonteCarlo
+{
+private:
+
+    // Declare private member variables
+    std::vector<double> m_spots;
+    std::vector<double> m_vols;
+    std::vector<double> m_dividends;
+    std::vector<double> m_correlation;
+    double m_r;
+    double m_T;
+    long m_simulations;
+    long m_factors;
+    unsigned long long m_seed;
+    SimdLevel m_simd;
+    VarianceReduction m_variance_reduction;
+    Priority m_priority;
+    // Loading matrix (assets x factors) and idiosyncratic scales of the correlated normals
+    std::vector<double> m_loading;
+    std::vector<double> m_residual;
+
+    // Declare Factorize private function, computing the loading matrix of the correlation
+    void Factorize();
+
+    // Declare BasketKernel private function, selecting the kernel and filling its parameters and constants
+    BasketKernel Kernel(BasketParams& params, std::vector<double>& drift, std::vector<double>& diffusion) const;
+
+    // Number of paths simulated together by one chunk of the thread pool, the chunks are reduced in order
+    static const long chunk_size = 1024;
+
+public:
+
+    // Constructor, correlation is the row-major assets x assets correlation matrix
+    MultiAssetMonteCarlo(const std::vector<double>& spots, const std::vector<double>& vols,
+        const std::vector<double>& correlation, const double& r, const double& T, const long& simulations = 1e5,
+        const unsigned long long& seed = 5489);
+
+    // Copy constructor
+    MultiAssetMonteCarlo(const MultiAssetMonteCarlo& source);
+
+    // Assignement operator
+    MultiAssetMonteCarlo& operator=(const MultiAssetMonteCarlo& source);
+
+    // Declare the PricePayoff function, specialized at compile time for any basket payoff policy (see BasketPayoffs.hpp)
+    template <class Payoff>
+    MCResult PricePayoff(const Payoff& payoff) const;
+
+    // Set the continuous dividend yield of every asset
+    MultiAssetMonteCarlo& dividends(const std::vector<double>& dividends);
+
+    // Set the number of factors of the correlation (0 for its exact Cholesky factor)
+    MultiAssetMonteCarlo& factors(const long& factors);
+
+    // Set the number of simulations
+    MultiAssetMonteCarlo& simulations(const long& simulations);
+
+    // Set the seed of the counter-based random number generator
+    MultiAssetMonteCarlo& seed(const unsigned long long& seed);
+
+    // Set the widest instruction set the basket kernel may use (capped to what the CPU supports)
+    MultiAssetMonteCarlo& simd(const SimdLevel& level);
+
+    // Set the variance-reduction technique (plain or antithetic)
+    MultiAssetMonteCarlo& variance_reduction(const VarianceReduction& technique);
+
+    // Set the priority of the chunks of this pricer in the shared thread pool
+    MultiAssetMonteCarlo& priority(const Priority& priority);
+
+    // Get inline functions
+    // Get number of assets
+    long assets() const { return static_cast<long>(m_spots.size()); }
+    // Get spot prices
+    const std::vector<double>& spots() const { return m_spots; }
+    // Get volatilities
+    const std::vector<double>& vols() const { return m_vols; }
+    // Get dividend yields
+    const std::vector<double>& dividends() const { return m_dividends; }
+    // Get correlation matrix
+    const std::vector<double>& correlation() const { return m_correlation; }
+    // Get risk-free interest rate
+    const double& r() const { return m_r; }
+    // Get time to maturity
+    const double& T() const { return m_T; }
+    // Get number of simulations
+    const long& simulations() const { return m_simulations; }
+    // Get number of factors
+    const long& factors() const { return m_factors; }
+    // Get random number generator seed
+    const unsigned long long& seed() const { return m_seed; }
+    // Get instruction set of the basket kernel
+    const SimdLevel& simd() const { return m_simd; }
+    // Get variance-reduction technique
+    const VarianceReduction& variance_reduction() const { return m_variance_reduction; }
+    // Get priority in the shared thread pool
+    const Priority& priority() const { return m_priority; }
+};
+
+// Define the PricePayoff function
+template <class Payoff>
+MCResult MultiAssetMonteCarlo::PricePayoff(const Payoff& payoff) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const long assets = this->assets();
+    const double discount = std::exp(-m_r * m_T);
+
+    if (payoff.Assets() > assets)
+        throw std::invalid_argument("PricePayoff: the payoff reads more assets than are simulated");
+    if (m_variance_reduction != VarianceReduction::None && m_variance_reduction != VarianceReduction::Antithetic)
+        throw std::invalid_argument("PricePayoff: only plain and antithetic sampling price multi-asset payoffs");
+
+    // Select the basket kernel once
+    BasketParams params = BasketParams();
+    std::vector<double> drift, diffusion;
+    const BasketKernel kernel = Kernel(params, drift, diffusion);
+    const bool antithetic = m_variance_reduction == VarianceReduction::Antithetic;
+
+    // Split the simulations in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (m_simulations + chunk_size - 1) / chunk_size;
+    std::vector<SampleStatistics> chunk_statistics(n_chunks);
+
+    // Run the chunks of simulations on the shared thread pool
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Define the range of simulations of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, m_simulations - first);
+
+        // Simulate the terminal spots of every asset, in whole blocks of paths
+        const long blocks = (count + block_paths - 1) / block_paths;
+        std::vector<double> terminal(blocks * assets * block_paths);
+        std::vector<double> terminal_antithetic(antithetic ? terminal.size() : 0);
+
+        PathBuffers out = PathBuffers();
+        out.terminal = terminal.data();
+        out.antithetic = antithetic ? terminal_antithetic.data() : 0;
+        kernel(params, first, count, out);
+
+        // Define chunk-local accumulator
+        SampleStatistics statistics;
+        double ST[max_basket_assets];
+
+        for (long i = 0; i < count; ++i)
+        {
+            // Gather the assets of the path from its block
+            const std::size_t offset = static_cast<std::size_t>(i / block_paths) * assets * block_paths + i % block_paths;
+
+            for (long a = 0; a < assets; ++a)
+                ST[a] = terminal[offset + a * block_paths];
+            double value = payoff(ST);
+
+            // Average the payoffs of the antithetic pair
+            if (antithetic)
+            {
+                for (long a = 0; a < assets; ++a)
+                    ST[a] = terminal_antithetic[offset + a * block_paths];
+                value = 0.5 * (value + payoff(ST));
+            }
+
+            statistics.Add(value);
+        }
+
+        // Store the chunk results
+        chunk_statistics[c] = statistics;
+    }, m_priority);
+
+    // Merge the chunk statistics in chunk order, so the result is bit-identical for any number of threads
+    SampleStatistics statistics;
+    for (long c = 0; c < n_chunks; ++c)
+        statistics.Merge(chunk_statistics[c]);
+
+    // Discount the mean payoff and its standard error
+    MCResult result;
+    result.price = statistics.MeanX() * discount;
+    result.se = std::sqrt(statistics.VarianceX() / statistics.n) * discount;
+    result.simulations = m_simulations;
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+// End of the conditional inclusion of the header file
+#endif
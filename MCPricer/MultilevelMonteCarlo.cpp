@@ -0,0 +1,159 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// MultilevelMonteCarlo.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the derived MultilevelMonteCarlo class
+
+#include <cmath>
+#include <stdexcept>
+#include "MultilevelMonteCarlo.hpp"
+
+// Define the static constant, bound to references by std::min
+const long MultilevelMonteCarlo::chunk_size;
+
+// Constructor
+MultilevelMonteCarlo::MultilevelMonteCarlo(const EuropeanOption& option, const double& target_rmse,
+    const long& base_subintervals, const unsigned long long& seed) :
+    EuropeanOption(option),
+    m_target_rmse(target_rmse),
+    m_base_subintervals(base_subintervals),
+    m_max_level(12),
+    m_initial_samples(10000),
+    m_seed(seed),
+    m_simd(DetectSimdLevel()),
+    m_priority(Priority::Normal)
+{}
+
+// Copy Constructor
+MultilevelMonteCarlo::MultilevelMonteCarlo(const MultilevelMonteCarlo& source) :
+    EuropeanOption(source),
+    m_target_rmse(source.m_target_rmse),
+    m_base_subintervals(source.m_base_subintervals),
+    m_max_level(source.m_max_level),
+    m_initial_samples(source.m_initial_samples),
+    m_seed(source.m_seed),
+    m_simd(source.m_simd),
+    m_priority(source.m_priority)
+{}
+
+// Assignment operator
+MultilevelMonteCarlo& MultilevelMonteCarlo::operator=(const MultilevelMonteCarlo& source)
+{
+    // Check for self assignment
+    if (this == &source)
+        return *this;
+
+    EuropeanOption::operator=(source);
+    m_target_rmse = source.m_target_rmse;
+    m_base_subintervals = source.m_base_subintervals;
+    m_max_level = source.m_max_level;
+    m_initial_samples = source.m_initial_samples;
+    m_seed = source.m_seed;
+    m_simd = source.m_simd;
+    m_priority = source.m_priority;
+
+    return *this;
+}
+
+// Set the target root mean square error
+MultilevelMonteCarlo& MultilevelMonteCarlo::target_rmse(const double& rmse)
+{
+    if (!(rmse > 0.0))
+        throw std::invalid_argument("target_rmse: the target must be positive");
+
+    m_target_rmse = rmse;
+    return *this;
+}
+
+// Set the number of subintervals of level 0
+MultilevelMonteCarlo& MultilevelMonteCarlo::base_subintervals(const long& subintervals)
+{
+    if (subintervals < 1)
+        throw std::invalid_argument("base_subintervals: level 0 needs at least one subinterval");
+
+    m_base_subintervals = subintervals;
+    return *this;
+}
+
+// Set the finest level
+MultilevelMonteCarlo& MultilevelMonteCarlo::max_level(const long& level)
+{
+    if (level < 2 || level > 24)
+        throw std::invalid_argument("max_level: the finest level must be between 2 and 24");
+
+    m_max_level = level;
+    return *this;
+}
+
+// Set the initial samples per level
+MultilevelMonteCarlo& MultilevelMonteCarlo::initial_samples(const long& samples)
+{
+    if (samples < 2)
+        throw std::invalid_argument("initial_samples: at least two samples are needed to estimate the variance");
+
+    m_initial_samples = samples;
+    return *this;
+}
+
+// Set the seed of the counter-based random number generator
+MultilevelMonteCarlo& MultilevelMonteCarlo::seed(const unsigned long long& seed)
+{
+    m_seed = seed;
+    return *this;
+}
+
+// Set the instruction set of the path kernels
+MultilevelMonteCarlo& MultilevelMonteCarlo::simd(const SimdLevel& level)
+{
+    m_simd = level;
+    return *this;
+}
+
+// Set the priority of the chunks in the shared thread pool
+MultilevelMonteCarlo& MultilevelMonteCarlo::priority(const Priority& priority)
+{
+    m_priority = priority;
+    return *this;
+}
+
+// Select the kernel and constants of a level
+PathKernel MultilevelMonteCarlo::LevelKernel(const long& level, const double& beta, KernelParams& params) const
+{
+    // Extract option parameters
+    const double T = this->T();
+    const double r = this->r();
+    const double sigma = this->sigma();
+    const ModelType model = ClassifyBeta(beta);
+
+    // Precompute the constants of the fine grid of the level
+    const long steps = m_base_subintervals << level;
+    const double tn = T / steps;
+
+    params = KernelParams();
+    params.S = this->S();
+    params.beta = beta;
+    params.steps = steps;
+    params.sigma = sigma;
+    params.dt = tn;
+    params.drift_const = r * tn;
+    params.diffusion_const = sigma * std::sqrt(tn);
+
+    // Every level draws from its own Philox key, so the levels are independent
+    params.seed = m_seed + static_cast<unsigned long long>(level) * 0x9E3779B97F4A7C15ull;
+
+    const PathKernels& kernels = SelectPathKernels(m_simd);
+
+    if (level == 0)
+        return kernels.euler[static_cast<int>(model)];
+
+    return kernels.coupled_euler[static_cast<int>(model)];
+}
+
+// Define the Price function
+MLMCResult MultilevelMonteCarlo::Price(const double& beta) const
+{
+    // Compare the option type once and dispatch to the payoff specialization
+    if (this->type() == "Call")
+        return PricePayoff(CallPayoff(this->K()), beta);
+
+    return PricePayoff(PutPayoff(this->K()), beta);
+}
@@ -0,0 +1,297 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// MultilevelMonteCarlo.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the derived MultilevelMonteCarlo class
+
+// If MULTILEVELMONTECARLO_HPP is not defined
+#ifndef MULTILEVELMONTECARLO_HPP
+// Define MULTILEVELMONTECARLO_HPP
+#define MULTILEVELMONTECARLO_HPP
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include "CpuFeatures.hpp"
+#include "EuropeanOption.hpp"
+#include "MCResult.hpp"
+#include "Models.hpp"
+#include "PathKernel.hpp"
+#include "Payoffs.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
+
+// Define MultilevelMonteCarlo derived class from EuropeanOption (Giles, 2008)
+// Level l simulates base_subintervals * 2^l Euler - Maruyama subintervals, and every level above 0 estimates the
+// difference between the payoffs of a fine path and of a coarse path driven by the same Brownian increments.
+// The levels are added and the samples of every level chosen from the estimated variances until the RMSE of
+// the price is below the target, at a cost of O(eps^-2) instead of the O(eps^-3) of MonteCarlo::Price
+class MultilevelMonteCarlo : public EuropeanOption
+{
+private:
+
+    // Declare private member variables
+    double m_target_rmse;
+    long m_base_subintervals;
+    long m_max_level;
+    long m_initial_samples;
+    unsigned long long m_seed;
+    SimdLevel m_simd;
+    Priority m_priority;
+
+    // Declare LevelKernel private function, selecting the kernel and constants of a level
+    PathKernel LevelKernel(const long& level, const double& beta, KernelParams& params) const;
+
+    // Declare SimulateLevel private function, adding the discounted payoff differences of samples
+    // [first_path, first_path + n_paths) of a level to its statistics, with the fine payoffs as y
+    template <class Payoff>
+    void SimulateLevel(const Payoff& payoff, const long& level, const double& beta, const long& first_path,
+        const long& n_paths, SampleStatistics& statistics) const;
+
+    // Number of paths simulated together by one chunk of the thread pool, the chunks are reduced in order
+    static const long chunk_size = 1024;
+
+public:
+
+    // Constructor
+    MultilevelMonteCarlo(const EuropeanOption& option, const double& target_rmse = 1e-2,
+        const long& base_subintervals = 2, const unsigned long long& seed = 5489);
+
+    // Copy constructor
+    MultilevelMonteCarlo(const MultilevelMonteCarlo& source);
+
+    // Assignement operator
+    MultilevelMonteCarlo& operator=(const MultilevelMonteCarlo& source);
+
+    // Declare the Price function
+    MLMCResult Price(const double& beta = 1) const;
+
+    // Declare the PricePayoff function, specialized at compile time for any payoff policy (see Payoffs.hpp)
+    template <class Payoff>
+    MLMCResult PricePayoff(const Payoff& payoff, const double& beta = 1) const;
+
+    // Set the root mean square error of the price the estimator stops at
+    MultilevelMonteCarlo& target_rmse(const double& rmse);
+
+    // Set the number of subintervals of level 0
+    MultilevelMonteCarlo& base_subintervals(const long& subintervals);
+
+    // Set the finest level the estimator may add
+    MultilevelMonteCarlo& max_level(const long& level);
+
+    // Set the number of samples every new level starts with
+    MultilevelMonteCarlo& initial_samples(const long& samples);
+
+    // Set the seed of the counter-based random number generator
+    MultilevelMonteCarlo& seed(const unsigned long long& seed);
+
+    // Set the widest instruction set the path kernels may use (capped to what the CPU supports)
+    MultilevelMonteCarlo& simd(const SimdLevel& level);
+
+    // Set the priority of the chunks of this pricer in the shared thread pool
+    MultilevelMonteCarlo& priority(const Priority& priority);
+
+    // Get inline functions
+    // Get target root mean square error
+    const double& target_rmse() const { return m_target_rmse; }
+    // Get number of subintervals of level 0
+    const long& base_subintervals() const { return m_base_subintervals; }
+    // Get finest level
+    const long& max_level() const { return m_max_level; }
+    // Get initial samples per level
+    const long& initial_samples() const { return m_initial_samples; }
+    // Get random number generator seed
+    const unsigned long long& seed() const { return m_seed; }
+    // Get instruction set of the path kernels
+    const SimdLevel& simd() const { return m_simd; }
+    // Get priority in the shared thread pool
+    const Priority& priority() const { return m_priority; }
+};
+
+// Define the SimulateLevel function
+template <class Payoff>
+void MultilevelMonteCarlo::SimulateLevel(const Payoff& payoff, const long& level, const double& beta,
+    const long& first_path, const long& n_paths, SampleStatistics& statistics) const
+{
+    KernelParams params = KernelParams();
+    const PathKernel kernel = LevelKernel(level, beta, params);
+    const double discount = std::exp(-this->r() * this->T());
+
+    // Split the samples in fixed-size chunks so the reduction order does not depend on the number of threads
+    const long n_chunks = (n_paths + chunk_size - 1) / chunk_size;
+    std::vector<SampleStatistics> chunk_statistics(n_chunks);
+
+    // Run the chunks of samples on the shared thread pool
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        // Define the range of samples of the chunk
+        const long first = c * chunk_size;
+        const long count = std::min(chunk_size, n_paths - first);
+
+        // Simulate the terminal spots of the fine paths, and of the coarse paths above level 0
+        double terminal[chunk_size];
+        double coarse[chunk_size];
+
+        PathBuffers out = PathBuffers();
+        out.terminal = terminal;
+        if (level > 0)
+            out.coarse = coarse;
+        kernel(params, first_path + first, count, out);
+
+        for (long i = 0; i < count; ++i)
+        {
+            const double fine = payoff(terminal[i]) * discount;
+            const double difference = (level > 0) ? fine - payoff(coarse[i]) * discount : fine;
+
+            chunk_statistics[c].Add(difference, fine);
+        }
+    }, m_priority);
+
+    // Merge the chunk statistics in chunk order, so the result is bit-identical for any number of threads
+    for (long c = 0; c < n_chunks; ++c)
+        statistics.Merge(chunk_statistics[c]);
+}
+
+// Define the PricePayoff function
+template <class Payoff>
+MLMCResult MultilevelMonteCarlo::PricePayoff(const Payoff& payoff, const double& beta) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Share of the mean square error given to the squared bias, the rest goes to the variance
+    const double theta = 0.25;
+    const double eps2 = m_target_rmse * m_target_rmse;
+
+    // Start with levels 0, 1 and 2 and the initial samples on each
+    long L = 2;
+    std::vector<SampleStatistics> statistics(L + 1);
+    std::vector<long> extra(L + 1, m_initial_samples);
+    std::vector<double> variance(L + 1, 0.0);
+    std::vector<double> cost(L + 1, 0.0);
+
+    // Weak and strong convergence rates, estimated from the levels above 0
+    double alpha = 0.5;
+    double beta_rate = 0.5;
+    double bias = 0.0;
+    bool converged = true;
+
+    while (true)
+    {
+        // Simulate the extra samples of every level, each level continuing its own path counter
+        for (long l = 0; l <= L; ++l)
+            if (extra[l] > 0)
+                SimulateLevel(payoff, l, beta, static_cast<long>(statistics[l].n), extra[l], statistics[l]);
+
+        // Cost of a sample in steps: the fine path, plus the coarse path above level 0
+        for (long l = 0; l <= L; ++l)
+        {
+            const double steps = static_cast<double>(m_base_subintervals << l);
+            cost[l] = (l > 0) ? 1.5 * steps : steps;
+            variance[l] = statistics[l].VarianceX();
+        }
+
+        // Estimate the rates by least squares on log2 |mean| and log2 variance over levels 1 to L
+        double sum_l = 0.0, sum_ll = 0.0, sum_m = 0.0, sum_lm = 0.0, sum_v = 0.0, sum_lv = 0.0;
+        for (long l = 1; l <= L; ++l)
+        {
+            const double m = std::log2(std::max(std::fabs(statistics[l].MeanX()), DBL_MIN));
+            const double v = std::log2(std::max(variance[l], DBL_MIN));
+            sum_l += l; sum_ll += l * l; sum_m += m; sum_lm += l * m; sum_v += v; sum_lv += l * v;
+        }
+        const double denominator = L * sum_ll - sum_l * sum_l;
+        alpha = std::max(0.5, -(L * sum_lm - sum_l * sum_m) / denominator);
+        beta_rate = std::max(0.5, -(L * sum_lv - sum_l * sum_v) / denominator);
+
+        // Guard the variances of the finest levels against unlucky small samples
+        for (long l = 2; l <= L; ++l)
+            variance[l] = std::max(variance[l], 0.5 * variance[l - 1] / std::pow(2.0, beta_rate));
+
+        // Optimal samples per level for a variance of (1 - theta) * eps^2 (Lagrange multiplier)
+        double sum = 0.0;
+        for (long l = 0; l <= L; ++l)
+            sum += std::sqrt(variance[l] * cost[l]);
+
+        bool settled = true;
+        for (long l = 0; l <= L; ++l)
+        {
+            const double optimal = std::ceil(std::sqrt(variance[l] / cost[l]) * sum / ((1.0 - theta) * eps2));
+            extra[l] = std::max(0L, static_cast<long>(optimal) - static_cast<long>(statistics[l].n));
+            if (extra[l] > 0.01 * statistics[l].n)
+                settled = false;
+        }
+
+        if (!settled)
+            continue;
+
+        // Extrapolate the remaining bias from the means of the last three levels, which decay like 2^(-alpha * l)
+        bias = 0.0;
+        for (long i = 0; i <= std::min(2L, L - 1); ++i)
+            bias = std::max(bias, std::fabs(statistics[L - i].MeanX()) / std::pow(2.0, i * alpha));
+        bias /= std::pow(2.0, alpha) - 1.0;
+
+        if (bias <= std::sqrt(theta) * m_target_rmse)
+            break;
+
+        // Stop at the finest level allowed, the result reports the bias it could not remove
+        if (L == m_max_level)
+        {
+            converged = false;
+            break;
+        }
+
+        // Add a level, with a variance and a cost extrapolated from the previous one
+        ++L;
+        statistics.push_back(SampleStatistics());
+        variance.push_back(variance[L - 1] / std::pow(2.0, beta_rate));
+        cost.push_back(2.0 * cost[L - 1]);
+        extra.push_back(0);
+
+        sum = 0.0;
+        for (long l = 0; l <= L; ++l)
+            sum += std::sqrt(variance[l] * cost[l]);
+
+        for (long l = 0; l <= L; ++l)
+        {
+            const double optimal = std::ceil(std::sqrt(variance[l] / cost[l]) * sum / ((1.0 - theta) * eps2));
+            extra[l] = std::max(0L, static_cast<long>(optimal) - static_cast<long>(statistics[l].n));
+        }
+
+        // Every new level needs enough samples to estimate its variance
+        extra[L] = std::max(extra[L], m_initial_samples);
+    }
+
+    // Sum the telescoping estimators of every level
+    MLMCResult result;
+    result.price = 0.0;
+    result.bias = bias;
+    result.converged = converged;
+    result.simulations = 0;
+    result.cost = 0.0;
+
+    double variance_of_price = 0.0;
+    for (long l = 0; l <= L; ++l)
+    {
+        MLMCLevel level;
+        level.subintervals = m_base_subintervals << l;
+        level.samples = static_cast<long>(statistics[l].n);
+        level.mean = statistics[l].MeanX();
+        level.variance = statistics[l].VarianceX();
+        result.levels.push_back(level);
+
+        result.price += level.mean;
+        variance_of_price += level.variance / level.samples;
+        result.simulations += level.samples;
+        result.cost += level.samples * cost[l];
+    }
+    result.se = std::sqrt(variance_of_price);
+
+    // Plain Monte Carlo on the finest grid needs Var(P_L) / ((1 - theta) * eps^2) paths of base_subintervals * 2^L steps
+    result.standard_cost = statistics[L].VarianceY() / ((1.0 - theta) * eps2) * static_cast<double>(m_base_subintervals << L);
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+// End of the conditional inclusion of the header file
+#endif
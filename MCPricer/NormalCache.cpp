@@ -0,0 +1,133 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// NormalCache.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the cache of common random numbers
+
+#include <algorithm>
+#include <stdexcept>
+#include "NormalCache.hpp"
+#include "PathKernel.hpp"
+#include "ThreadPool.hpp"
+
+// Number of paths whose normals are drawn together by one chunk of the thread pool, a multiple of block_paths
+static const long normal_chunk = 1024;
+
+// Constructor
+NormalTable::NormalTable(const unsigned long long& seed, const NormalGenerator& generator, const long& paths,
+    const long& steps, const bool& terminal, const SimdLevel& level, const bool& mapped, const std::string& directory) :
+    m_seed(seed),
+    m_generator(generator),
+    m_paths(paths),
+    m_steps(steps),
+    m_terminal(terminal),
+    m_data(0)
+{
+    if (paths < 1 || steps < 1 || (terminal && steps != 1))
+        throw std::invalid_argument("NormalTable: a table needs at least one path and one subinterval per path");
+
+    const std::size_t size = Size(paths, steps);
+    if (mapped)
+    {
+        m_file.reset(new MappedFile(size * sizeof(double), directory));
+        m_data = static_cast<double*>(m_file->data());
+    }
+    else
+    {
+        m_memory.resize(size);
+        m_data = m_memory.data();
+    }
+
+    // Draw every block, including the spare one, with the kernels of the instruction set
+    const PathKernels& kernels = SelectPathKernels(level);
+    const NormalKernel kernel = terminal ? kernels.terminal_normals : kernels.grid_normals;
+
+    KernelParams params = KernelParams();
+    params.seed = seed;
+    params.generator = generator;
+    params.steps = steps;
+
+    const long n_paths = static_cast<long>(size / steps);
+    const long n_chunks = (n_paths + normal_chunk - 1) / normal_chunk;
+
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        const long first = c * normal_chunk;
+        kernel(params, first, std::min(normal_chunk, n_paths - first), m_data + static_cast<std::ptrdiff_t>(first) * steps);
+    });
+}
+
+// Get the number of doubles of a table
+std::size_t NormalTable::Size(const long& paths, const long& steps)
+{
+    const std::size_t blocks = static_cast<std::size_t>((paths + block_paths - 1) / block_paths) + 1;
+    return blocks * block_paths * steps;
+}
+
+// Constructor
+NormalCache::NormalCache(const std::size_t& memory_limit, const std::string& directory) :
+    m_memory_limit(memory_limit),
+    m_directory(directory)
+{}
+
+// Get the table of a seed, a generator and a grid
+std::shared_ptr<const NormalTable> NormalCache::Acquire(const unsigned long long& seed, const NormalGenerator& generator,
+    const long& paths, const long& steps, const bool& terminal, const SimdLevel& level)
+{
+    // Hold the lock while drawing, so concurrent pricings of the same simulation wait for one table
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::size_t memory = 0;
+    for (const std::shared_ptr<const NormalTable>& table : m_tables)
+    {
+        if (table->Covers(seed, generator, paths, steps, terminal))
+            return table;
+
+        if (!table->mapped())
+            memory += table->bytes();
+    }
+
+    // Keep the table in memory while it fits in what is left of the limit
+    const std::size_t bytes = NormalTable::Size(paths, steps) * sizeof(double);
+    const bool mapped = memory + bytes > m_memory_limit;
+
+    m_tables.push_back(std::make_shared<const NormalTable>(seed, generator, paths, steps, terminal, level, mapped, m_directory));
+    return m_tables.back();
+}
+
+// Drop every table
+void NormalCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tables.clear();
+}
+
+// Get the number of tables
+std::size_t NormalCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tables.size();
+}
+
+// Get the bytes of the tables kept in memory
+std::size_t NormalCache::memory_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::size_t bytes = 0;
+    for (const std::shared_ptr<const NormalTable>& table : m_tables)
+        if (!table->mapped()) bytes += table->bytes();
+
+    return bytes;
+}
+
+// Get the bytes of the tables in mapped files
+std::size_t NormalCache::mapped_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::size_t bytes = 0;
+    for (const std::shared_ptr<const NormalTable>& table : m_tables)
+        if (table->mapped()) bytes += table->bytes();
+
+    return bytes;
+}
@@ -0,0 +1,114 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// NormalCache.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the cache of common random numbers
+
+// If NORMALCACHE_HPP is not defined
+#ifndef NORMALCACHE_HPP
+// Define NORMALCACHE_HPP
+#define NORMALCACHE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "CpuFeatures.hpp"
+#include "MappedFile.hpp"
+#include "NormalGenerators.hpp"
+
+// Define NormalTable class, the normals that drive the first paths of a simulation for one seed, generator and grid
+// The normals are stored in the block layout of the normal kernels (see NormalKernel in PathKernel.hpp),
+// in memory or in a memory-mapped file, and are read-only once drawn
+class NormalTable
+{
+private:
+
+    // Declare private member variables
+    unsigned long long m_seed;
+    NormalGenerator m_generator;
+    long m_paths;
+    long m_steps;
+    bool m_terminal;
+    std::vector<double> m_memory;
+    std::unique_ptr<MappedFile> m_file;
+    double* m_data;
+
+public:
+
+    // Constructor, drawing the normals of paths [0, paths) on steps subintervals, or the single normal per path
+    // of exact terminal sampling, with the kernels of an instruction set, in a file of directory when mapped
+    NormalTable(const unsigned long long& seed, const NormalGenerator& generator, const long& paths, const long& steps, const bool& terminal,
+        const SimdLevel& level, const bool& mapped, const std::string& directory);
+
+    // The table owns its storage, which can be neither copied nor assigned
+    NormalTable(const NormalTable&) = delete;
+    NormalTable& operator=(const NormalTable&) = delete;
+
+    // Get the number of doubles stored for paths paths on steps subintervals, with one spare block so
+    // the kernels can read a whole block starting at any of the paths
+    static std::size_t Size(const long& paths, const long& steps);
+
+    // Get the normals
+    const double* data() const { return m_data; }
+
+    // Get the size of the table in bytes
+    std::size_t bytes() const { return Size(m_paths, m_steps) * sizeof(double); }
+
+    // Check whether the table has the normals of a simulation
+    bool Covers(const unsigned long long& seed, const NormalGenerator& generator, const long& paths, const long& steps,
+        const bool& terminal) const
+    {
+        return seed == m_seed && generator == m_generator && steps == m_steps && terminal == m_terminal && paths <= m_paths;
+    }
+
+    // Get inline functions
+    const unsigned long long& seed() const { return m_seed; }
+    const NormalGenerator& generator() const { return m_generator; }
+    const long& paths() const { return m_paths; }
+    const long& steps() const { return m_steps; }
+    const bool& terminal() const { return m_terminal; }
+    bool mapped() const { return m_file.get() != 0; }
+};
+
+// Define NormalCache class, an opt-in store of common random numbers shared by repeated pricings
+// Pricings with the same seed, normal generator, grid and number of paths (or fewer) read the normals drawn by the first one
+// instead of generating them again, so bumped and stressed repricings pay the random number generation once.
+// Tables are kept in memory up to memory_limit bytes in total, the larger ones go to memory-mapped files
+class NormalCache
+{
+private:
+
+    // Declare private member variables
+    mutable std::mutex m_mutex;
+    std::vector<std::shared_ptr<const NormalTable> > m_tables;
+    std::size_t m_memory_limit;
+    std::string m_directory;
+
+public:
+
+    // Constructor, the mapped files are created in directory (the temporary directory when empty)
+    explicit NormalCache(const std::size_t& memory_limit = std::size_t(1) << 30, const std::string& directory = "");
+
+    // The tables are shared by the pricers, the cache can be neither copied nor assigned
+    NormalCache(const NormalCache&) = delete;
+    NormalCache& operator=(const NormalCache&) = delete;
+
+    // Get the table with the normals of paths [0, paths) for a seed, a generator and a grid, drawing it on the first
+    // request; steps is the number of subintervals, or 1 with terminal for exact terminal sampling
+    std::shared_ptr<const NormalTable> Acquire(const unsigned long long& seed, const NormalGenerator& generator,
+        const long& paths, const long& steps, const bool& terminal, const SimdLevel& level);
+
+    // Drop every table, the pricers still running keep theirs until they finish
+    void Clear();
+
+    // Get the number of tables
+    std::size_t size() const;
+
+    // Get the bytes of the tables kept in memory and in mapped files
+    std::size_t memory_bytes() const;
+    std::size_t mapped_bytes() const;
+};
+
+// End of the conditional inclusion of the header file
+#endif
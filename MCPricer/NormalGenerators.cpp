@@ -0,0 +1,207 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// NormalGenerators.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the ziggurat tables and of the tests of the normal generators
+
+#include <algorithm>
+#include <cmath>
+#include "InverseNormal.hpp"
+#include "NormalGenerators.hpp"
+#include "PathKernel.hpp"
+#include "SimdMath.hpp"
+#include "ThreadPool.hpp"
+
+// Constants of the 256-layer ziggurat
+const double ZigguratTable::r = 3.6541528853610088;
+const double ZigguratTable::v = 4.92867323399e-3;
+
+namespace
+{
+    // Build the layers from the top of the tail upwards, x[i + 1] = f^-1(v / x[i] + f(x[i]))
+    ZigguratTable MakeZiggurat()
+    {
+        ZigguratTable table;
+
+        const double r = ZigguratTable::r;
+        const double f_r = std::exp(-0.5 * r * r);
+
+        table.x[0] = ZigguratTable::v / f_r;
+        table.x[1] = r;
+        for (long i = 1; i < ziggurat_layers - 1; ++i)
+            table.x[i + 1] = std::sqrt(-2.0 * std::log(ZigguratTable::v / table.x[i] + std::exp(-0.5 * table.x[i] * table.x[i])));
+        table.x[ziggurat_layers] = 0.0;
+
+        for (long i = 0; i <= ziggurat_layers; ++i)
+        {
+            table.ratio[i] = (i < ziggurat_layers) ? table.x[i + 1] / table.x[i] : 0.0;
+            table.f[i] = std::exp(-0.5 * table.x[i] * table.x[i]);
+        }
+
+        // The base layer has no wedge, its density is that of the tail start
+        table.f[0] = f_r;
+
+        table.tail = 0.5 * std::erfc(r / std::sqrt(2.0));
+        return table;
+    }
+}
+
+// Get the ziggurat tables
+const ZigguratTable& Ziggurat()
+{
+    static const ZigguratTable table = MakeZiggurat();
+    return table;
+}
+
+namespace
+{
+    // Number of paths drawn by one chunk of the generator tests
+    const long test_chunk = 1024;
+
+    // Number of equiprobable bins of the chi-square test
+    const long test_bins = 100;
+
+    // Standard normal CDF and density
+    double NormalCdf(const double& x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+    double NormalDensity(const double& x) { return 0.3989422804014327 * std::exp(-0.5 * x * x); }
+
+    // Quantile of p, refined from a starting point by Newton steps on the tail of min(p, 1 - p), which erfc
+    // evaluates without cancellation
+    double RefinedQuantile(const double& p, double x)
+    {
+        const bool upper = p > 0.5;
+        const double tail = upper ? 1.0 - p : p;
+
+        for (int step = 0; step < 3; ++step)
+        {
+            const double tail_x = upper ? 0.5 * std::erfc(x / std::sqrt(2.0)) : NormalCdf(x);
+            x += (upper ? tail_x - tail : tail - tail_x) / NormalDensity(x);
+        }
+
+        return x;
+    }
+}
+
+// Test a generator on paths x steps normals
+std::vector<NormalTest> TestNormalGenerator(const NormalGenerator& generator, const SimdLevel& level,
+    const long& paths, const long& steps, const std::uint64_t& seed)
+{
+    // Bin edges, the quantiles of k / 100
+    std::vector<double> edges(test_bins - 1);
+    for (long k = 1; k < test_bins; ++k)
+        edges[k - 1] = RefinedQuantile(static_cast<double>(k) / test_bins, InverseCumulativeNormal(static_cast<double>(k) / test_bins));
+
+    KernelParams params = KernelParams();
+    params.seed = seed;
+    params.steps = steps;
+    params.generator = generator;
+    const NormalKernel draw = SelectPathKernels(level).grid_normals;
+
+    // Power sums, counts beyond 3 and 4 and bin counts of every chunk
+    const long n_chunks = (paths + test_chunk - 1) / test_chunk;
+    std::vector<double> chunk_sums(n_chunks * 4, 0.0);
+    std::vector<long> chunk_tails(n_chunks * 2, 0);
+    std::vector<long> chunk_bins(n_chunks * test_bins, 0);
+
+    ThreadPool::Global().ParallelFor(n_chunks, [&](const long c)
+    {
+        const long first = c * test_chunk;
+        const long count = std::min(test_chunk, paths - first);
+
+        // Whole blocks of paths are drawn, only the normals of the paths of the chunk are tested
+        const long padded = (count + block_paths - 1) / block_paths * block_paths;
+        std::vector<double> normals(padded * steps);
+        draw(params, first, padded, normals.data());
+
+        double* sums = chunk_sums.data() + c * 4;
+        long* tails = chunk_tails.data() + c * 2;
+        long* bins = chunk_bins.data() + c * test_bins;
+
+        for (long b = 0; b < padded; b += block_paths)
+        {
+            const double* block = normals.data() + b * steps;
+            const long lanes = std::min(block_paths, count - b);
+
+            for (long a = 0; a < steps; ++a)
+            {
+                for (long j = 0; j < lanes; ++j)
+                {
+                    const double z = block[a * block_paths + j];
+                    const double z2 = z * z;
+                    sums[0] += z;
+                    sums[1] += z2;
+                    sums[2] += z2 * z;
+                    sums[3] += z2 * z2;
+                    tails[0] += std::fabs(z) > 3.0;
+                    tails[1] += std::fabs(z) > 4.0;
+                    ++bins[std::upper_bound(edges.begin(), edges.end(), z) - edges.begin()];
+                }
+            }
+        }
+    });
+
+    // Reduce the chunks in chunk order
+    double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    long tails[2] = { 0, 0 };
+    std::vector<long> bins(test_bins, 0);
+    for (long c = 0; c < n_chunks; ++c)
+    {
+        for (int k = 0; k < 4; ++k)
+            sums[k] += chunk_sums[c * 4 + k];
+        for (int k = 0; k < 2; ++k)
+            tails[k] += chunk_tails[c * 2 + k];
+        for (long k = 0; k < test_bins; ++k)
+            bins[k] += chunk_bins[c * test_bins + k];
+    }
+
+    // Central moments of the sample
+    const double n = static_cast<double>(paths) * steps;
+    const double mean = sums[0] / n;
+    const double m2 = sums[1] / n - mean * mean;
+    const double m3 = sums[2] / n - 3.0 * mean * sums[1] / n + 2.0 * mean * mean * mean;
+    const double m4 = sums[3] / n - 4.0 * mean * sums[2] / n + 6.0 * mean * mean * sums[1] / n - 3.0 * mean * mean * mean * mean;
+
+    double chi_square = 0.0;
+    const double expected_count = n / test_bins;
+    for (long k = 0; k < test_bins; ++k)
+        chi_square += (bins[k] - expected_count) * (bins[k] - expected_count) / expected_count;
+
+    // Two-sided tail probabilities of N(0, 1)
+    const double p3 = std::erfc(3.0 / std::sqrt(2.0));
+    const double p4 = std::erfc(4.0 / std::sqrt(2.0));
+
+    std::vector<NormalTest> tests;
+    tests.push_back({ "mean", mean, 0.0, std::sqrt(1.0 / n) });
+    tests.push_back({ "variance", m2, 1.0, std::sqrt(2.0 / n) });
+    tests.push_back({ "skewness", m3 / std::pow(m2, 1.5), 0.0, std::sqrt(6.0 / n) });
+    tests.push_back({ "excess kurtosis", m4 / (m2 * m2) - 3.0, 0.0, std::sqrt(24.0 / n) });
+    tests.push_back({ "P(|z| > 3)", tails[0] / n, p3, std::sqrt(p3 * (1.0 - p3) / n) });
+    tests.push_back({ "P(|z| > 4)", tails[1] / n, p4, std::sqrt(p4 * (1.0 - p4) / n) });
+    tests.push_back({ "chi-square", chi_square, test_bins - 1.0, std::sqrt(2.0 * (test_bins - 1.0)) });
+
+    return tests;
+}
+
+// Get the largest relative error of the inverse normal CDF
+double InverseNormalError(const bool& vectorized)
+{
+    double error = 0.0;
+
+    // Tails 0.5 * 10^(-k / 100) from 0.5 down to 1e-300 below the median and to 1e-16 above it
+    for (int side = 0; side < 2; ++side)
+    {
+        const double smallest = (side == 0) ? 1e-300 : 1e-16;
+        const long n_points = static_cast<long>(100.0 * std::log10(0.5 / smallest));
+
+        for (long k = 1; k <= n_points; ++k)
+        {
+            const double tail = 0.5 * std::pow(10.0, -k / 100.0);
+            const double p = (side == 0) ? tail : 1.0 - tail;
+            const double x = vectorized ? SimdMath<ScalarVector>::InverseNormal(p) : InverseCumulativeNormal(p);
+
+            const double exact = RefinedQuantile(p, x);
+            error = std::max(error, std::fabs(x - exact) / std::fabs(exact));
+        }
+    }
+
+    return error;
+}
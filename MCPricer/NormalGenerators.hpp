@@ -0,0 +1,75 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// NormalGenerators.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the generators of standard normals and the ziggurat tables
+
+// If NORMALGENERATORS_HPP is not defined
+#ifndef NORMALGENERATORS_HPP
+// Define NORMALGENERATORS_HPP
+#define NORMALGENERATORS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CpuFeatures.hpp"
+
+// Transforms of the Philox words into standard normals, the vector versions are in SimdMath.hpp
+// Every generator maps the counter (path, index, stream) to two normals, so the paths stay reproducible
+// whatever the instruction set and the thread that simulates them
+enum class NormalGenerator
+{
+    // Box - Muller transform of the two uniforms of a Philox block (log, square root, sine and cosine)
+    BoxMuller,
+    // Inverse normal CDF of each uniform (Acklam's rational approximations, relative error below 1.15e-9)
+    InverseCdf,
+    // Marsaglia - Tsang ziggurat with 256 layers on 64 bits per normal: two gathers, a multiply and a compare
+    // for about 99.3% of the draws, the tail and the wedges resolved on a second Philox block
+    Ziggurat
+};
+
+// Number of layers of the ziggurat
+const long ziggurat_layers = 256;
+
+// Define ZigguratTable struct, the layers of the ziggurat of the normal density f(x) = exp(-x^2 / 2)
+// Layer i spans [0, x[i]) above f(x[i]) and below f(x[i + 1]), every layer with the same area, x[1] = r the start
+// of the tail and x[0] = v / f(r) the width of the base layer, which holds the tail beyond r; x[256] = 0
+struct ZigguratTable
+{
+    // Start of the tail and area of every layer
+    static const double r;
+    static const double v;
+
+    // Widths of the layers, ratios x[i + 1] / x[i] below which a point of layer i is under the density,
+    // and densities f(x[i]), one spare entry at 256 so every layer reads i + 1
+    double x[ziggurat_layers + 1];
+    double ratio[ziggurat_layers + 1];
+    double f[ziggurat_layers + 1];
+
+    // Probability of the tail beyond r, N(-r)
+    double tail;
+};
+
+// Get the ziggurat tables, built once on the first call
+const ZigguratTable& Ziggurat();
+
+// Define NormalTest struct, a statistic of a sample of normals next to its value and standard error under N(0, 1)
+struct NormalTest
+{
+    std::string name;
+    double value;
+    double expected;
+    double se;
+};
+
+// Draw paths x steps normals of a generator with the grid kernel of an instruction set and test their mean, variance,
+// skewness, excess kurtosis, frequencies beyond 3 and 4 standard deviations and the chi-square statistic over
+// 100 equiprobable bins; the statistics are reduced in chunk order, so they do not depend on the threads
+std::vector<NormalTest> TestNormalGenerator(const NormalGenerator& generator, const SimdLevel& level,
+    const long& paths = 131072, const long& steps = 128, const std::uint64_t& seed = 5489);
+
+// Get the largest relative error of the inverse normal CDF, the scalar InverseCumulativeNormal or the vector version
+// of the generators, against the quantile refined by Newton steps on erfc, for p from 1e-300 to 1 - 1e-16
+double InverseNormalError(const bool& vectorized);
+
+// End of the conditional inclusion of the header file
+#endif
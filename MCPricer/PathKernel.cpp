@@ -0,0 +1,48 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// PathKernel.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the scalar path kernels and the runtime selection of the kernels
+
+#include "PathKernel.hpp"
+#include "PathKernelImpl.hpp"
+
+// Classify beta once, outside the simulation loops
+ModelType ClassifyBeta(const double& beta)
+{
+    if (beta == 1.0) return ModelType::GBM;
+    if (beta == 0.5) return ModelType::Sqrt;
+    if (beta == 2.0) return ModelType::Quadratic;
+    return ModelType::CEV;
+}
+
+// Scalar fallback, used when the CPU has no AVX2
+const PathKernels& PathKernelsScalar()
+{
+    static const PathKernels kernels = MakePathKernels<ScalarVector, ScalarFloatVector>();
+    return kernels;
+}
+
+// Get the kernel table of an instruction set, falling back to the widest one the CPU supports
+const PathKernels& SelectPathKernels(const SimdLevel& level)
+{
+#if defined(MCPRICER_X86)
+    // Never select an instruction set the CPU cannot run
+    const SimdLevel supported = DetectSimdLevel();
+    const SimdLevel selected = (level < supported) ? level : supported;
+
+    if (selected == SimdLevel::AVX512) return PathKernelsAVX512();
+    if (selected == SimdLevel::AVX2) return PathKernelsAVX2();
+#endif
+    return PathKernelsScalar();
+}
+
+// Select the path kernel for a model, a scheme and an instruction set
+PathKernel SelectPathKernel(const SimdLevel& level, const ModelType& model, const Scheme& scheme)
+{
+    const PathKernels& kernels = SelectPathKernels(level);
+
+    if (model == ModelType::GBM && scheme == Scheme::Auto)
+        return kernels.exact_steps;
+
+    return kernels.euler[static_cast<int>(model)];
+}
@@ -0,0 +1,270 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// PathKernel.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the batched Euler - Maruyama path kernels
+
+// If PATHKERNEL_HPP is not defined
+#ifndef PATHKERNEL_HPP
+// Define PATHKERNEL_HPP
+#define PATHKERNEL_HPP
+
+#include "CpuFeatures.hpp"
+#include "Models.hpp"
+#include "NormalGenerators.hpp"
+
+// Sources of the normals driving the paths
+enum class Sampling
+{
+    // Philox pseudo-random normals, one independent stream per path
+    PseudoRandom,
+    // Owen-scrambled Sobol points mapped by the inverse normal CDF, in Brownian-bridge order over the subintervals
+    Sobol
+};
+
+// Floating-point precision of the simulated paths
+enum class Precision
+{
+    // Spots and normals in double
+    Double,
+    // Spots and normals in float, twice the lanes per vector; the terminal spots are widened to double
+    // before the payoffs, so the payoffs and their statistics stay in double
+    Single
+};
+
+// Number of paths stepped together in a structure-of-arrays block
+const long block_paths = 16;
+
+// Local volatilities read by the local-volatility kernels, sampled at time slices on uniform log-spot nodes
+// The volatility at time t and log-spot x is linear in x between two nodes, flat beyond the first and last ones,
+// and linear in t between the slices around t, flat before the first slice and after the last one
+struct LocalVolGrid
+{
+    // Ascending times of the slices
+    const double* times;
+    long slices;
+    // Volatility of slice i at node j at vols[i * stride + j], every row starting on a cache line
+    const double* vols;
+    long nodes;
+    long stride;
+    // Log-spot of node 0 and inverse of the spacing of the nodes
+    double log_spot_min;
+    double inverse_spacing;
+};
+
+// Parameters shared by every path of a simulation
+struct KernelParams
+{
+    // Spot price at the start of every path
+    double S;
+    // Drift per subinterval, r * dt for Euler - Maruyama and (r - sigma^2 / 2) * dt for the exact log-normal kernels
+    double drift_const;
+    // Diffusion per subinterval, sigma * sqrt(dt)
+    double diffusion_const;
+    // CEV elasticity of the diffusion (only read by the general CEV model)
+    double beta;
+    // Number of subintervals per path
+    long steps;
+    // Seed of the counter-based random number generator
+    unsigned long long seed;
+    // Transform of the Philox words into normals, Box - Muller when the parameters are value-initialized
+    NormalGenerator generator;
+    // Drift and diffusion per subinterval of the GBM control path, (r - sigma^2 / 2) * dt and sigma * sqrt(dt)
+    double control_drift;
+    double control_diffusion;
+    // Volatility and length of a subinterval (the whole maturity for exact terminal sampling), read by the Greeks kernels
+    double sigma;
+    double dt;
+    // Cached normals of the pseudo-random kernels in the layout of the normal kernels, null to draw them
+    const double* normals;
+    // Barriers of the monitoring kernels (0 and infinity when absent), and whether a path may also cross them
+    // between two spots of the grid, with the Brownian-bridge probability, or only at the spots
+    double lower_barrier;
+    double upper_barrier;
+    bool bridge;
+    // First subinterval and subintervals between two exercise dates of the exercise kernels, which simulate
+    // params.steps subintervals from first_step on with the normals of the paths started at 0
+    long first_step;
+    long date_steps;
+    // Local volatility surface of the local-volatility kernels, which read dt and ignore sigma and beta
+    LocalVolGrid local_vol;
+};
+
+// Output buffers of the statistics of the monitored spots, one value per path; null buffers are not computed
+// The spots are monitored at the end of every subinterval, the extremes and barriers also at the start of the path
+struct MonitorBuffers
+{
+    // Arithmetic and geometric averages of the spots at the end of the subintervals
+    double* average;
+    double* geometric;
+    // Minimum and maximum of the spots
+    double* minimum;
+    double* maximum;
+    // Probability that the path stays strictly between the barriers of KernelParams
+    double* survival;
+};
+
+// Output buffers of a kernel, one value per path; null buffers are not computed
+struct PathBuffers
+{
+    // Terminal spots
+    double* terminal;
+    // Terminal spots of the antithetic paths (normals with the opposite sign)
+    double* antithetic;
+    // Terminal spots of the GBM control paths, sampled exactly from the same normals
+    double* control;
+    // Terminal spots of the antithetic GBM control paths
+    double* control_antithetic;
+    // Pathwise derivatives of the terminal spot with respect to S0, sigma and r (Greeks kernels only)
+    double* delta;
+    double* vega;
+    double* rho;
+    // Mixed likelihood-ratio / pathwise Gamma weight G, so that Gamma = exp(-r * T) * E[f'(ST) * G] (Greeks kernels only)
+    double* gamma;
+    // Terminal spots of the coarse paths of a multilevel coupling (coupled kernels only)
+    double* coarse;
+    // Statistics of the monitored spots of the paths and of the antithetic paths (monitoring kernels only),
+    // the antithetic paths stream the statistics requested for the paths
+    MonitorBuffers monitor;
+    MonitorBuffers monitor_antithetic;
+    // Spots the paths start from at params.first_step, null to start at params.S (input of the exercise kernels,
+    // may be the terminal buffer)
+    const double* initial;
+    // Spots at the exercise dates rounded to float, the spot of path p at the end of date d (counted from 0 after
+    // params.first_step) at dates[d * date_stride + p] with p counted from first_path (exercise kernels only)
+    float* dates;
+    long date_stride;
+};
+
+// Kernel signature: simulate paths [first_path, first_path + n_paths) and write their terminal spots
+typedef void (*PathKernel)(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out);
+
+// Normal kernel signature: write the normals that drive paths [first_path, first_path + n_paths), first_path a multiple
+// of block_paths, with params.seed and params.steps. Block b of block_paths paths stores its normals step after step,
+// so the normal of path p and subinterval k is normals[((p / block_paths) * steps + k) * block_paths + p % block_paths]
+// with p counted from first_path
+typedef void (*NormalKernel)(const KernelParams& params, const long& first_path, const long& n_paths, double* normals);
+
+// Largest number of assets of the basket kernels
+const long max_basket_assets = 256;
+
+// Parameters of the basket kernels, correlated GBM assets sampled exactly at maturity
+// The correlated normal of asset i is X_i = sum_j loading[i * factors + j] * Z_j + residual[i] * E_i, with factors
+// common normals Z drawn on Philox stream 0 and one idiosyncratic normal E_i per asset on stream 1
+struct BasketParams
+{
+    long assets;
+    long factors;
+    // Whether the loading is lower triangular (a Cholesky factor), row i only reading Z_0 to Z_i
+    bool triangular;
+    // Row-major loading matrix (assets x factors), and the idiosyncratic scales (null for none)
+    const double* loading;
+    const double* residual;
+    // Log of the spot plus (r - q - sigma^2 / 2) * T, and sigma * sqrt(T), of every asset
+    const double* drift;
+    const double* diffusion;
+    // Seed of the counter-based random number generator
+    unsigned long long seed;
+};
+
+// Basket kernel signature: simulate paths [first_path, first_path + n_paths), first_path a multiple of block_paths,
+// and write the terminal spots of every asset to out.terminal and out.antithetic (null for none) in whole blocks:
+// the spot of asset i on path p at [((p / block_paths) * assets + i) * block_paths + p % block_paths],
+// p counted from first_path
+typedef void (*BasketKernel)(const BasketParams& params, const long& first_path, const long& n_paths, const PathBuffers& out);
+
+// Parameters of the Heston kernels, the constants of Andersen's quadratic-exponential (QE) scheme per subinterval
+// The variance v' is drawn from its moments m = theta + (v - theta) * decay and s^2 = v * variance_v + variance_const,
+// quadratic in a normal when psi = s^2 / m^2 <= psi_c and exponential with a mass at 0 otherwise; the log-spot moves
+// by drift + k0 + k1 * v + k2 * v' + sqrt(k3 * v + k4 * v') * Z with the central (gamma = 1/2) discretization
+struct HestonKernelParams
+{
+    // Spot and variance at the start of every path, number of subintervals and seed
+    double S;
+    double v0;
+    long steps;
+    unsigned long long seed;
+    // Drift of the log-spot per subinterval, b * dt
+    double drift;
+    // Mean reversion e^(-kappa * dt) and long-run variance
+    double decay;
+    double theta;
+    // Conditional variance coefficients of v'
+    double variance_v;
+    double variance_const;
+    // Log-spot coefficients
+    double k0;
+    double k1;
+    double k2;
+    double k3;
+    double k4;
+    // Threshold of psi between the quadratic and the exponential branches
+    double psi_c;
+    // Whether k0 is replaced by the martingale correction, so E[S(t + dt) | S(t), v(t)] = S(t) * e^(b * dt)
+    bool martingale;
+};
+
+// Heston kernel signature: simulate paths [first_path, first_path + n_paths) and write their terminal spots
+// to out.terminal, and those of the antithetic paths to out.antithetic (null for none)
+typedef void (*HestonKernel)(const HestonKernelParams& params, const long& first_path, const long& n_paths,
+    const PathBuffers& out);
+
+// Define PathKernels struct, the kernels compiled for one instruction set
+struct PathKernels
+{
+    // Euler - Maruyama kernels, indexed by ModelType
+    PathKernel euler[4];
+    // Exact log-normal steps on the subinterval grid (GBM)
+    PathKernel exact_steps;
+    // Exact terminal sampling with one normal per path (GBM), the dt of the constants is the whole maturity
+    PathKernel exact_terminal;
+    // Single precision Euler - Maruyama kernels, indexed by ModelType, and exact terminal sampling (GBM), drawing
+    // Box - Muller normals in float whatever params.generator, never cached
+    PathKernel euler_single[4];
+    PathKernel exact_terminal_single;
+    // Euler - Maruyama kernels that also propagate the tangents of the pathwise Greeks, indexed by ModelType
+    PathKernel greeks_euler[4];
+    // Exact terminal sampling with the tangents of the pathwise Greeks (GBM)
+    PathKernel greeks_exact_terminal;
+    // Coupled fine and coarse Euler - Maruyama kernels of multilevel Monte Carlo, indexed by ModelType
+    PathKernel coupled_euler[4];
+    // Euler - Maruyama kernels that also stream the statistics of the monitored spots, indexed by ModelType
+    PathKernel monitor_euler[4];
+    // Exact log-normal steps on the subinterval grid with the statistics of the monitored spots (GBM)
+    PathKernel monitor_exact_steps;
+    // Euler - Maruyama kernels that start from any subinterval and store the spots at the exercise dates,
+    // indexed by ModelType
+    PathKernel exercise_euler[4];
+    // Exact log-normal steps from any subinterval with the spots at the exercise dates (GBM)
+    PathKernel exercise_exact_steps;
+    // Exact terminal sampling of correlated GBM assets
+    BasketKernel basket_terminal;
+    // Heston paths with the QE variance scheme
+    HestonKernel heston_qe;
+    // Euler - Maruyama steps of the log-spot under the local volatility of params.local_vol, with GBM control paths
+    PathKernel local_vol_steps;
+    // Normals of the kernels on the subinterval grid, and the single normal per path of exact terminal sampling
+    NormalKernel grid_normals;
+    NormalKernel terminal_normals;
+};
+
+// Kernel tables of every instruction set
+const PathKernels& PathKernelsScalar();
+#if defined(MCPRICER_X86)
+const PathKernels& PathKernelsAVX2();
+const PathKernels& PathKernelsAVX512();
+#endif
+
+// Kernel table of the quasi-Monte Carlo engine, scalar code with params.seed selecting the Sobol scrambling
+// and the inverse normal CDF mapping the points whatever params.generator
+// The Euler - Maruyama and exact-steps kernels need one Sobol dimension per subinterval
+const PathKernels& PathKernelsSobol();
+
+// Get the kernel table of an instruction set, falling back to the widest one the CPU supports
+const PathKernels& SelectPathKernels(const SimdLevel& level);
+
+// Select the path kernel for a model, a scheme and an instruction set
+// Scheme::Auto uses exact log-normal steps for GBM and Euler - Maruyama for every other beta
+PathKernel SelectPathKernel(const SimdLevel& level, const ModelType& model, const Scheme& scheme = Scheme::Euler);
+
+// End of the conditional inclusion of the header file
+#endif
@@ -0,0 +1,42 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// PathKernelAVX2.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the AVX2 path kernel, compiled for AVX2 regardless of the project settings
+
+#include "CpuFeatures.hpp"
+
+#if defined(MCPRICER_X86)
+
+// Include the standard headers before enabling AVX2, so no shared inline code is compiled for it
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Enable AVX2 for the rest of this translation unit (MSVC accepts the intrinsics without flags)
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#define MCPRICER_SIMD_AVX2
+#include "PathKernelImpl.hpp"
+
+// AVX2 kernels, only selected when DetectSimdLevel reports AVX2
+const PathKernels& PathKernelsAVX2()
+{
+    static const PathKernels kernels = MakePathKernels<Avx2Vector, Avx2FloatVector>();
+    return kernels;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
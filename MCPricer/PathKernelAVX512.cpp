@@ -0,0 +1,42 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// PathKernelAVX512.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the AVX-512 path kernel, compiled for AVX-512 regardless of the project settings
+
+#include "CpuFeatures.hpp"
+
+#if defined(MCPRICER_X86)
+
+// Include the standard headers before enabling AVX-512, so no shared inline code is compiled for it
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Enable AVX-512 for the rest of this translation unit (MSVC accepts the intrinsics without flags)
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+#define MCPRICER_SIMD_AVX512
+#include "PathKernelImpl.hpp"
+
+// AVX-512 kernels, only selected when DetectSimdLevel reports AVX-512
+const PathKernels& PathKernelsAVX512()
+{
+    static const PathKernels kernels = MakePathKernels<Avx512Vector, Avx512FloatVector>();
+    return kernels;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
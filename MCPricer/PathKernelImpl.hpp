@@ -0,0 +1,1361 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// PathKernelImpl.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the generic body of the batched path kernels, included once per instruction set
+
+// If PATHKERNELIMPL_HPP is not defined
+#ifndef PATHKERNELIMPL_HPP
+// Define PATHKERNELIMPL_HPP
+#define PATHKERNELIMPL_HPP
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "PathKernel.hpp"
+#include "SimdMath.hpp"
+#include "Models.hpp"
+
+// Advance a block of paths by one subinterval, with the scheme and S^beta resolved at compile time by the step policy
+// The normals are multiplied by sign, -1 for the antithetic paths
+template <class V, class Step>
+inline void AdvanceBlock(typename V::Element* s, const typename V::Element* z, const typename V::Real& sign,
+    const typename V::Real& drift, const typename V::Real& diffusion, const typename V::Real& beta)
+{
+    for (long j = 0; j < block_paths; j += V::width)
+        V::Store(s + j, Step::template Advance<V>(V::Load(s + j), V::Mul(sign, V::Load(z + j)), drift, diffusion, beta));
+}
+
+// Write the first count lanes of a block to an output buffer
+// (templated on V so every instruction set keeps its own copy)
+template <class V>
+inline void WriteBlock(double* out, const double* s, const long& count)
+{
+    for (long j = 0; j < count; ++j)
+        out[j] = s[j];
+}
+
+// Widen the first count lanes of a single precision block to an output buffer
+// (templated on V so every instruction set keeps its own copy)
+template <class V>
+inline void WriteSingleBlock(double* out, const float* s, const long& count)
+{
+    for (long j = 0; j < count; ++j)
+        out[j] = static_cast<double>(s[j]);
+}
+
+// Get the cached normals of subinterval step for the block of paths starting at path (see NormalKernel)
+// A block aligned with the cache is read in place, any other is gathered lane by lane into z
+// (templated on V so every instruction set keeps its own copy)
+template <class V>
+inline const double* CachedNormals(const double* normals, const long& steps, const long& path, const long& step, double* z)
+{
+    // Offsets in std::ptrdiff_t, the tables of large simulations pass the range of a 32-bit long
+    if (path % block_paths == 0)
+        return normals + (static_cast<std::ptrdiff_t>(path / block_paths) * steps + step) * block_paths;
+
+    for (long j = 0; j < block_paths; ++j)
+    {
+        const long p = path + j;
+        z[j] = normals[(static_cast<std::ptrdiff_t>(p / block_paths) * steps + step) * block_paths + p % block_paths];
+    }
+
+    return z;
+}
+
+// Simulate paths [first_path, first_path + n_paths) block by block and write their terminal spots
+// Every lane draws the normals of its own path from the Philox counter (path, step pair, 0);
+// the antithetic and control paths reuse the same normals
+template <class V, class Step>
+void SimulateTerminalBlocks(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the model constants
+    const Real drift = V::Set(params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+    const Real beta = V::Set(params.beta);
+    const Real control_drift = V::Set(params.control_drift);
+    const Real control_diffusion = V::Set(params.control_diffusion);
+    const Real plus = V::Set(1.0);
+    const Real minus = V::Set(-1.0);
+
+    // Check once which paths are requested
+    const bool antithetic = out.antithetic != 0;
+    const bool control = out.control != 0;
+    const bool control_antithetic = out.control_antithetic != 0;
+
+    // Structure-of-arrays buffers for the spots and the two normals of a step pair
+    alignas(64) double s[block_paths];
+    alignas(64) double sa[block_paths];
+    alignas(64) double sc[block_paths];
+    alignas(64) double sca[block_paths];
+    alignas(64) double z0[block_paths];
+    alignas(64) double z1[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        // Re start every lane at the current underlying spot price
+        for (long j = 0; j < block_paths; ++j)
+            s[j] = sa[j] = sc[j] = sca[j] = params.S;
+
+        for (long a = 0; a < params.steps; a += 2)
+        {
+            // Draw the normals of subintervals a and a + 1 for every path of the block, unless they are cached
+            if (!params.normals)
+            {
+                for (long j = 0; j < block_paths; j += V::width)
+                {
+                    Real n0, n1;
+                    SimdMath<V>::Normals(params.generator, key0, key1,
+                        V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), static_cast<std::uint32_t>(a / 2), 0, n0, n1);
+                    V::Store(z0 + j, n0);
+                    V::Store(z1 + j, n1);
+                }
+            }
+
+            for (long k = a; k < a + 2 && k < params.steps; ++k)
+            {
+                const double* z = params.normals ? CachedNormals<V>(params.normals, params.steps, first_path + b, k, z0)
+                    : (k == a) ? z0 : z1;
+
+                AdvanceBlock<V, Step>(s, z, plus, drift, diffusion, beta);
+                if (antithetic) AdvanceBlock<V, Step>(sa, z, minus, drift, diffusion, beta);
+                if (control) AdvanceBlock<V, LogNormalStep>(sc, z, plus, control_drift, control_diffusion, beta);
+                if (control_antithetic) AdvanceBlock<V, LogNormalStep>(sca, z, minus, control_drift, control_diffusion, beta);
+            }
+        }
+
+        // Write the terminal spots, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        WriteBlock<V>(out.terminal + b, s, count);
+        if (antithetic) WriteBlock<V>(out.antithetic + b, sa, count);
+        if (control) WriteBlock<V>(out.control + b, sc, count);
+        if (control_antithetic) WriteBlock<V>(out.control_antithetic + b, sca, count);
+    }
+}
+
+// Sample the terminal spots of GBM exactly with a single normal per path, ignoring params.steps
+// Both normals of a pair are used: the counter (path, 0, 0) of lane j feeds lanes j and j + block_paths / 2
+// The path is its own GBM control, so the control buffers receive copies
+template <class V>
+void SimulateTerminalExact(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    const long half = block_paths / 2;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the constants of the whole maturity: (r - sigma^2 / 2) * T and sigma * sqrt(T)
+    const Real S0 = V::Set(params.S);
+    const Real drift = V::Set(params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+
+    alignas(64) double s[block_paths];
+    alignas(64) double sa[block_paths];
+    alignas(64) double zc[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        // Cached normals are stored in the lanes they drive, with a single subinterval per path
+        const double* cached = params.normals ? CachedNormals<V>(params.normals, 1, first_path + b, 0, zc) : 0;
+
+        for (long j = 0; j < half; j += V::width)
+        {
+            Real n0, n1;
+            if (cached)
+            {
+                n0 = V::Load(cached + j);
+                n1 = V::Load(cached + j + half);
+            }
+            else
+                SimdMath<V>::Normals(params.generator, key0, key1,
+                    V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), 0, 0, n0, n1);
+
+            // ST = S0 * exp((r - sigma^2 / 2) * T + sigma * sqrt(T) * Z)
+            V::Store(s + j, V::Mul(S0, SimdMath<V>::Exp(V::MulAdd(diffusion, n0, drift))));
+            V::Store(s + j + half, V::Mul(S0, SimdMath<V>::Exp(V::MulAdd(diffusion, n1, drift))));
+
+            if (out.antithetic)
+            {
+                V::Store(sa + j, V::Mul(S0, SimdMath<V>::Exp(V::Sub(drift, V::Mul(diffusion, n0)))));
+                V::Store(sa + j + half, V::Mul(S0, SimdMath<V>::Exp(V::Sub(drift, V::Mul(diffusion, n1)))));
+            }
+        }
+
+        // Write the terminal spots, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        WriteBlock<V>(out.terminal + b, s, count);
+        if (out.antithetic) WriteBlock<V>(out.antithetic + b, sa, count);
+        if (out.control) WriteBlock<V>(out.control + b, s, count);
+        if (out.control_antithetic) WriteBlock<V>(out.control_antithetic + b, sa, count);
+    }
+}
+
+// Single precision counterpart of SimulateTerminalBlocks for the float traits, with twice the lanes per vector
+// Every lane draws the normals of four subintervals from the Philox counter (path, step quad, 0) and steps float
+// spots; the terminal spots are widened to double, so the payoffs and their statistics stay in double precision.
+// The normals are drawn with Box - Muller, params.generator is ignored, or the cached double normals are rounded
+// to float, so float and double paths on the same table are driven by the same normals
+template <class V, class Step>
+void SimulateTerminalBlocksSingle(const KernelParams& params, const long& first_path, const long& n_paths,
+    const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the model constants, rounded to float
+    const Real drift = V::Set(params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+    const Real beta = V::Set(params.beta);
+    const Real control_drift = V::Set(params.control_drift);
+    const Real control_diffusion = V::Set(params.control_diffusion);
+    const Real plus = V::Set(1.0);
+    const Real minus = V::Set(-1.0);
+    const float S0 = static_cast<float>(params.S);
+
+    // Check once which paths are requested
+    const bool antithetic = out.antithetic != 0;
+    const bool control = out.control != 0;
+    const bool control_antithetic = out.control_antithetic != 0;
+
+    // Structure-of-arrays buffers for the spots and the four normals of a step quad
+    alignas(64) float s[block_paths];
+    alignas(64) float sa[block_paths];
+    alignas(64) float sc[block_paths];
+    alignas(64) float sca[block_paths];
+    alignas(64) float z[4][block_paths];
+    alignas(64) double zc[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        // Re start every lane at the current underlying spot price
+        for (long j = 0; j < block_paths; ++j)
+            s[j] = sa[j] = sc[j] = sca[j] = S0;
+
+        for (long a = 0; a < params.steps; a += 4)
+        {
+            // Draw the normals of subintervals a to a + 3 for every path of the block, or round the cached ones
+            if (params.normals)
+            {
+                for (long k = a; k < a + 4 && k < params.steps; ++k)
+                {
+                    const double* cached = CachedNormals<V>(params.normals, params.steps, first_path + b, k, zc);
+                    for (long j = 0; j < block_paths; ++j)
+                        z[k - a][j] = static_cast<float>(cached[j]);
+                }
+            }
+            else
+            {
+                for (long j = 0; j < block_paths; j += V::width)
+                {
+                    Real n[4];
+                    SimdMath<V>::NormalQuad(key0, key1, V::Sequence(static_cast<std::uint32_t>(first_path + b + j)),
+                        static_cast<std::uint32_t>(a / 4), 0, n);
+                    for (int q = 0; q < 4; ++q)
+                        V::Store(z[q] + j, n[q]);
+                }
+            }
+
+            for (long k = a; k < a + 4 && k < params.steps; ++k)
+            {
+                AdvanceBlock<V, Step>(s, z[k - a], plus, drift, diffusion, beta);
+                if (antithetic) AdvanceBlock<V, Step>(sa, z[k - a], minus, drift, diffusion, beta);
+                if (control) AdvanceBlock<V, LogNormalStep>(sc, z[k - a], plus, control_drift, control_diffusion, beta);
+                if (control_antithetic)
+                    AdvanceBlock<V, LogNormalStep>(sca, z[k - a], minus, control_drift, control_diffusion, beta);
+            }
+        }
+
+        // Write the terminal spots, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        WriteSingleBlock<V>(out.terminal + b, s, count);
+        if (antithetic) WriteSingleBlock<V>(out.antithetic + b, sa, count);
+        if (control) WriteSingleBlock<V>(out.control + b, sc, count);
+        if (control_antithetic) WriteSingleBlock<V>(out.control_antithetic + b, sca, count);
+    }
+}
+
+// Single precision counterpart of SimulateTerminalExact for the float traits, ignoring params.steps
+// The paths come in groups of 4 * block_paths on the absolute path index: lane j of group g draws the counter
+// (g * block_paths + j, 0, 0), whose normal q drives path g * 4 * block_paths + q * block_paths + j.
+// The groups cut by the ends of the range are simulated whole and only the requested paths written.
+// Cached double normals are instead rounded to float block by block, in the lanes of SimulateTerminalExact
+template <class V>
+void SimulateTerminalExactSingle(const KernelParams& params, const long& first_path, const long& n_paths,
+    const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    const long group = 4 * block_paths;
+    const long last = first_path + n_paths;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the constants of the whole maturity: (r - sigma^2 / 2) * T and sigma * sqrt(T)
+    const Real S0 = V::Set(params.S);
+    const Real drift = V::Set(params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+
+    alignas(64) float s[4 * block_paths];
+    alignas(64) float sa[4 * block_paths];
+
+    if (params.normals)
+    {
+        alignas(64) double zc[block_paths];
+        alignas(64) float z[block_paths];
+
+        for (long b = 0; b < n_paths; b += block_paths)
+        {
+            // Cached normals are stored in the lanes they drive, with a single subinterval per path
+            const double* cached = CachedNormals<V>(params.normals, 1, first_path + b, 0, zc);
+            for (long j = 0; j < block_paths; ++j)
+                z[j] = static_cast<float>(cached[j]);
+
+            for (long j = 0; j < block_paths; j += V::width)
+            {
+                const Real n = V::Load(z + j);
+                V::Store(s + j, V::Mul(S0, SimdMath<V>::Exp(V::MulAdd(diffusion, n, drift))));
+                if (out.antithetic)
+                    V::Store(sa + j, V::Mul(S0, SimdMath<V>::Exp(V::Sub(drift, V::Mul(diffusion, n)))));
+            }
+
+            // Write the terminal spots, dropping the lanes past the end of the range
+            const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+            WriteSingleBlock<V>(out.terminal + b, s, count);
+            if (out.antithetic) WriteSingleBlock<V>(out.antithetic + b, sa, count);
+            if (out.control) WriteSingleBlock<V>(out.control + b, s, count);
+            if (out.control_antithetic) WriteSingleBlock<V>(out.control_antithetic + b, sa, count);
+        }
+
+        return;
+    }
+
+    for (long g = first_path / group; g * group < last; ++g)
+    {
+        for (long j = 0; j < block_paths; j += V::width)
+        {
+            Real n[4];
+            SimdMath<V>::NormalQuad(key0, key1, V::Sequence(static_cast<std::uint32_t>(g * block_paths + j)), 0, 0, n);
+
+            // ST = S0 * exp((r - sigma^2 / 2) * T + sigma * sqrt(T) * Z)
+            for (int q = 0; q < 4; ++q)
+            {
+                V::Store(s + q * block_paths + j, V::Mul(S0, SimdMath<V>::Exp(V::MulAdd(diffusion, n[q], drift))));
+                if (out.antithetic)
+                    V::Store(sa + q * block_paths + j,
+                        V::Mul(S0, SimdMath<V>::Exp(V::Sub(drift, V::Mul(diffusion, n[q])))));
+            }
+        }
+
+        // Write the paths of the group inside the range, the path is its own GBM control
+        const long begin = (g * group < first_path) ? first_path : g * group;
+        const long end = (last < (g + 1) * group) ? last : (g + 1) * group;
+        const long offset = begin - g * group;
+        const long index = begin - first_path;
+
+        WriteSingleBlock<V>(out.terminal + index, s + offset, end - begin);
+        if (out.antithetic) WriteSingleBlock<V>(out.antithetic + index, sa + offset, end - begin);
+        if (out.control) WriteSingleBlock<V>(out.control + index, s + offset, end - begin);
+        if (out.control_antithetic) WriteSingleBlock<V>(out.control_antithetic + index, sa + offset, end - begin);
+    }
+}
+
+// Simulate paths [first_path, first_path + n_paths) with Euler - Maruyama and propagate the pathwise tangents
+// dS/dS0, dS/dsigma and dS/dr along every path: each step multiplies them by J = 1 + r * dt + sigma * sqrt(dt) * (S^beta)' * Z
+// and adds the explicit derivative of the step. Gamma uses the mixed estimator of the first step, whose density
+// depends on S0: G = dST/dS1 * (dk/dS0 + k * score) with k = dS1/dS0, dk/dS0 = -beta * S1 / S0^2
+// and score = -beta / S0 + Z1 * (1 + r * dt) / (sigma * sqrt(dt) * S0^beta) + Z1^2 * beta / S0
+template <class V, class Model>
+void SimulateGreeksBlocks(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the model constants
+    const Real drift = V::Set(params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+    const Real beta = V::Set(params.beta);
+    const Real dt = V::Set(params.dt);
+    const Real sqrt_dt = V::Set(std::sqrt(params.dt));
+    const Real one = V::Set(1.0);
+
+    // Constants of the first-step score: a = 1 + r * dt and the standard deviation of S1
+    const double S0 = params.S;
+    const double a = 1.0 + params.drift_const;
+    // S0^beta is evaluated with the vector power of the kernel, every instruction set keeps its own code
+    alignas(64) double power0[V::width];
+    V::Store(power0, Model::template Power<V>(V::Set(S0), beta));
+    const double sd1 = params.diffusion_const * power0[0];
+
+    // Structure-of-arrays buffers: spot, tangents, first-step values and the two normals of a step pair
+    alignas(64) double s[block_paths];
+    alignas(64) double d[block_paths];
+    alignas(64) double v[block_paths];
+    alignas(64) double rr[block_paths];
+    alignas(64) double k1[block_paths];
+    alignas(64) double s1[block_paths];
+    alignas(64) double zf[block_paths];
+    alignas(64) double z0[block_paths];
+    alignas(64) double z1[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        // Re start every lane at the current underlying spot price with zero tangents
+        for (long j = 0; j < block_paths; ++j)
+        {
+            s[j] = S0;
+            d[j] = 1.0;
+            v[j] = 0.0;
+            rr[j] = 0.0;
+        }
+
+        for (long a2 = 0; a2 < params.steps; a2 += 2)
+        {
+            // Draw the normals of subintervals a2 and a2 + 1 with the counters of the pricing kernels, unless they are cached
+            if (!params.normals)
+            {
+                for (long j = 0; j < block_paths; j += V::width)
+                {
+                    Real n0, n1;
+                    SimdMath<V>::Normals(params.generator, key0, key1,
+                        V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), static_cast<std::uint32_t>(a2 / 2), 0, n0, n1);
+                    V::Store(z0 + j, n0);
+                    V::Store(z1 + j, n1);
+                }
+            }
+
+            for (long k = a2; k < a2 + 2 && k < params.steps; ++k)
+            {
+                const double* z = params.normals ? CachedNormals<V>(params.normals, params.steps, first_path + b, k, z0)
+                    : (k == a2) ? z0 : z1;
+
+                for (long j = 0; j < block_paths; j += V::width)
+                {
+                    const Real S = V::Load(s + j);
+                    const Real Z = V::Load(z + j);
+                    const Real power = Model::template Power<V>(S, beta);
+
+                    // Jacobian of the step with respect to the spot
+                    const Real J = V::MulAdd(V::Mul(diffusion, Model::template Slope<V>(S, beta)), Z, V::Add(one, drift));
+                    const Real SN = EulerStep<Model>::template Advance<V>(S, Z, drift, diffusion, beta);
+
+                    // dS/dsigma gains sqrt(dt) * S^beta * Z and dS/dr gains dt * S
+                    V::Store(v + j, V::MulAdd(V::Load(v + j), J, V::Mul(V::Mul(sqrt_dt, power), Z)));
+                    V::Store(rr + j, V::MulAdd(V::Load(rr + j), J, V::Mul(dt, S)));
+
+                    // Keep the first step apart for the Gamma weight, dS/dS1 accumulates the later steps
+                    if (k == 0)
+                    {
+                        V::Store(k1 + j, J);
+                        V::Store(s1 + j, SN);
+                        V::Store(zf + j, Z);
+                    }
+                    else
+                        V::Store(d + j, V::Mul(V::Load(d + j), J));
+
+                    V::Store(s + j, SN);
+                }
+            }
+        }
+
+        // Write the terminal spots and the tangents, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        for (long j = 0; j < count; ++j)
+        {
+            const double score = -params.beta / S0 + zf[j] * a / sd1 + zf[j] * zf[j] * params.beta / S0;
+
+            out.terminal[b + j] = s[j];
+            out.delta[b + j] = d[j] * k1[j];
+            out.vega[b + j] = v[j];
+            out.rho[b + j] = rr[j];
+            out.gamma[b + j] = d[j] * (-params.beta * s1[j] / (S0 * S0) + k1[j] * score);
+        }
+    }
+}
+
+// Sample the terminal spots of GBM exactly with the tangents of the pathwise Greeks, using the normals of
+// SimulateTerminalExact: dST/dS0 = ST / S0, dST/dsigma = ST * (sqrt(T) * Z - sigma * T), dST/dr = ST * T
+// and the likelihood-ratio Gamma weight G = ST / S0 * (Z / (S0 * sigma * sqrt(T)) - 1 / S0)
+template <class V>
+void SimulateGreeksExact(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    const long half = block_paths / 2;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the constants of the whole maturity
+    const Real S0 = V::Set(params.S);
+    const Real drift = V::Set(params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+    const Real T = V::Set(params.dt);
+    const Real sqrt_T = V::Set(std::sqrt(params.dt));
+    const Real sigma_T = V::Set(params.sigma * params.dt);
+    const Real inv_S0 = V::Set(1.0 / params.S);
+    const Real inv_S0_sd = V::Set(1.0 / (params.S * params.diffusion_const));
+
+    alignas(64) double s[block_paths];
+    alignas(64) double d[block_paths];
+    alignas(64) double v[block_paths];
+    alignas(64) double rr[block_paths];
+    alignas(64) double g[block_paths];
+    alignas(64) double zc[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        // Cached normals are stored in the lanes they drive, with a single subinterval per path
+        const double* cached = params.normals ? CachedNormals<V>(params.normals, 1, first_path + b, 0, zc) : 0;
+
+        for (long j = 0; j < half; j += V::width)
+        {
+            Real n[2];
+            if (cached)
+            {
+                n[0] = V::Load(cached + j);
+                n[1] = V::Load(cached + j + half);
+            }
+            else
+                SimdMath<V>::Normals(params.generator, key0, key1,
+                    V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), 0, 0, n[0], n[1]);
+
+            for (long h = 0; h < 2; ++h)
+            {
+                const long lane = j + h * half;
+                const Real ST = V::Mul(S0, SimdMath<V>::Exp(V::MulAdd(diffusion, n[h], drift)));
+                const Real delta = V::Mul(ST, inv_S0);
+
+                V::Store(s + lane, ST);
+                V::Store(d + lane, delta);
+                V::Store(v + lane, V::Mul(ST, V::Sub(V::Mul(sqrt_T, n[h]), sigma_T)));
+                V::Store(rr + lane, V::Mul(ST, T));
+                V::Store(g + lane, V::Mul(delta, V::Sub(V::Mul(n[h], inv_S0_sd), inv_S0)));
+            }
+        }
+
+        // Write the terminal spots and the tangents, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        WriteBlock<V>(out.terminal + b, s, count);
+        WriteBlock<V>(out.delta + b, d, count);
+        WriteBlock<V>(out.vega + b, v, count);
+        WriteBlock<V>(out.rho + b, rr, count);
+        WriteBlock<V>(out.gamma + b, g, count);
+    }
+}
+
+// Simulate paths [first_path, first_path + n_paths) on two Euler - Maruyama grids for multilevel Monte Carlo:
+// the fine path takes params.steps subintervals (an even number) and the coarse path half as many, every coarse step
+// driven by the sum of the normals of its two fine steps, so sigma * sqrt(2 * dt) * Zc = sigma * sqrt(dt) * (Z0 + Z1)
+template <class V, class Model>
+void SimulateCoupledBlocks(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the model constants of the fine grid, the coarse subinterval is twice as long
+    const Real drift = V::Set(params.drift_const);
+    const Real coarse_drift = V::Set(2.0 * params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+    const Real beta = V::Set(params.beta);
+    const Real plus = V::Set(1.0);
+
+    // Structure-of-arrays buffers for the fine and coarse spots, the two fine normals and the coarse normal
+    alignas(64) double s[block_paths];
+    alignas(64) double sc[block_paths];
+    alignas(64) double z0[block_paths];
+    alignas(64) double z1[block_paths];
+    alignas(64) double zc[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        // Re start every lane at the current underlying spot price
+        for (long j = 0; j < block_paths; ++j)
+            s[j] = sc[j] = params.S;
+
+        for (long a = 0; a < params.steps; a += 2)
+        {
+            // Draw the normals of fine subintervals a and a + 1, which make up one coarse subinterval
+            for (long j = 0; j < block_paths; j += V::width)
+            {
+                Real n0, n1;
+                SimdMath<V>::Normals(params.generator, key0, key1,
+                    V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), static_cast<std::uint32_t>(a / 2), 0, n0, n1);
+                V::Store(z0 + j, n0);
+                V::Store(z1 + j, n1);
+                V::Store(zc + j, V::Add(n0, n1));
+            }
+
+            AdvanceBlock<V, EulerStep<Model> >(s, z0, plus, drift, diffusion, beta);
+            AdvanceBlock<V, EulerStep<Model> >(s, z1, plus, drift, diffusion, beta);
+            AdvanceBlock<V, EulerStep<Model> >(sc, zc, plus, coarse_drift, diffusion, beta);
+        }
+
+        // Write the terminal spots, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        WriteBlock<V>(out.terminal + b, s, count);
+        WriteBlock<V>(out.coarse + b, sc, count);
+    }
+}
+
+// Statistics streamed by a monitoring kernel, checked once per call
+struct MonitorFlags
+{
+    bool average;
+    bool geometric;
+    bool extremes;
+    bool survival;
+    // Barriers present, and crossings between the spots of the grid
+    bool lower;
+    bool upper;
+    bool bridge;
+};
+
+// Lanes of a block of monitored paths: the spots, their logs and the running statistics
+struct MonitorLanes
+{
+    alignas(64) double s[block_paths];
+    alignas(64) double log_s[block_paths];
+    alignas(64) double sum[block_paths];
+    alignas(64) double sum_log[block_paths];
+    alignas(64) double minimum[block_paths];
+    alignas(64) double maximum[block_paths];
+    alignas(64) double survival[block_paths];
+};
+
+// Start every lane of a block at the initial spot, a path starting on a barrier or beyond it is knocked at once
+// (templated on V so every instruction set keeps its own copy)
+template <class V>
+inline void StartMonitor(MonitorLanes& lanes, const KernelParams& params, const double& log_S0)
+{
+    const double alive = (params.S > params.lower_barrier && params.S < params.upper_barrier) ? 1.0 : 0.0;
+
+    for (long j = 0; j < block_paths; ++j)
+    {
+        lanes.s[j] = params.S;
+        lanes.log_s[j] = log_S0;
+        lanes.sum[j] = 0.0;
+        lanes.sum_log[j] = 0.0;
+        lanes.minimum[j] = params.S;
+        lanes.maximum[j] = params.S;
+        lanes.survival[j] = alive;
+    }
+}
+
+// Multiply the survival of the lanes by the probability of not crossing a barrier over a subinterval, given the
+// distances d0 and d1 of the log-spots at its ends to the barrier, positive on the side the path lives on.
+// A spot on the barrier or beyond it knocks the path; with the bridge, the path between two spots on the right side
+// touches the barrier with probability exp(-2 * d0 * d1 / v), v the variance of the log-spot over the subinterval
+// and scale = -2 / v
+template <class V>
+inline typename V::Real SurviveBarrier(const typename V::Real& survival, const typename V::Real& d0,
+    const typename V::Real& d1, const typename V::Real& scale, const bool& bridge)
+{
+    typedef typename V::Real Real;
+
+    const Real zero = V::Set(0.0);
+    const typename V::Mask alive = V::Less(zero, d1);
+    if (!bridge)
+        return V::Select(alive, survival, zero);
+
+    // The exponent is capped at 0, so a lane already knocked (d0 <= 0) never multiplies 0 by a large factor
+    const Real exponent = V::Min(V::Mul(scale, V::Mul(d0, d1)), zero);
+    return V::Select(alive, V::Mul(survival, V::Sub(V::Set(1.0), SimdMath<V>::Exp(exponent))), zero);
+}
+
+// Advance a block of monitored paths by one subinterval and update the statistics of the flags,
+// with the normals multiplied by sign (-1 for the antithetic paths)
+template <class V, class Step, class Model>
+inline void MonitorBlock(MonitorLanes& lanes, const double* z, const typename V::Real& sign, const typename V::Real& drift,
+    const typename V::Real& diffusion, const typename V::Real& beta, const MonitorFlags& flags,
+    const typename V::Real& log_lower, const typename V::Real& log_upper, const typename V::Real& bridge_scale)
+{
+    typedef typename V::Real Real;
+
+    for (long j = 0; j < block_paths; j += V::width)
+    {
+        const Real S = V::Load(lanes.s + j);
+        const Real SN = Step::template Advance<V>(S, V::Mul(sign, V::Load(z + j)), drift, diffusion, beta);
+        V::Store(lanes.s + j, SN);
+
+        if (flags.average)
+            V::Store(lanes.sum + j, V::Add(V::Load(lanes.sum + j), SN));
+
+        if (flags.extremes)
+        {
+            V::Store(lanes.minimum + j, V::Min(V::Load(lanes.minimum + j), SN));
+            V::Store(lanes.maximum + j, V::Max(V::Load(lanes.maximum + j), SN));
+        }
+
+        if (!flags.geometric && !flags.survival)
+            continue;
+
+        // Spots that the Euler - Maruyama steps drive to zero or below take the log of the smallest normal double
+        const Real log_SN = SimdMath<V>::Log(V::Max(SN, V::Set(DBL_MIN)));
+
+        if (flags.geometric)
+            V::Store(lanes.sum_log + j, V::Add(V::Load(lanes.sum_log + j), log_SN));
+
+        if (flags.survival)
+        {
+            const Real log_S = V::Load(lanes.log_s + j);
+
+            // The variance of the log-spot is sigma^2 * dt for GBM, and (sigma * S^(beta - 1))^2 * dt at the start
+            // of the subinterval for the other betas
+            Real scale = bridge_scale;
+            if (!std::is_same<Model, GBMModel>::value)
+            {
+                const Real local = V::Div(Model::template Power<V>(S, beta), V::Max(S, V::Set(DBL_MIN)));
+                scale = V::Div(scale, V::Mul(local, local));
+            }
+
+            Real survival = V::Load(lanes.survival + j);
+            if (flags.upper)
+                survival = SurviveBarrier<V>(survival, V::Sub(log_upper, log_S), V::Sub(log_upper, log_SN), scale, flags.bridge);
+            if (flags.lower)
+                survival = SurviveBarrier<V>(survival, V::Sub(log_S, log_lower), V::Sub(log_SN, log_lower), scale, flags.bridge);
+            V::Store(lanes.survival + j, survival);
+        }
+
+        V::Store(lanes.log_s + j, log_SN);
+    }
+}
+
+// Write the statistics of the first count lanes of a block to the requested buffers
+template <class V>
+inline void WriteMonitor(const MonitorBuffers& out, const long& b, const MonitorLanes& lanes, const long& count,
+    const long& steps)
+{
+    for (long j = 0; j < count; ++j)
+    {
+        if (out.average) out.average[b + j] = lanes.sum[j] / steps;
+        if (out.geometric) out.geometric[b + j] = std::exp(lanes.sum_log[j] / steps);
+        if (out.minimum) out.minimum[b + j] = lanes.minimum[j];
+        if (out.maximum) out.maximum[b + j] = lanes.maximum[j];
+        if (out.survival) out.survival[b + j] = lanes.survival[j];
+    }
+}
+
+// Simulate paths [first_path, first_path + n_paths) on the subinterval grid with the normals of SimulateTerminalBlocks
+// and stream the statistics requested by out.monitor in O(1) state per lane, so no path is ever stored:
+// the sums of the spots and of their logs, the running minimum and maximum, and the probability of staying between
+// the barriers of params. The antithetic paths stream the same statistics into out.monitor_antithetic
+template <class V, class Step, class Model>
+void SimulateMonitorBlocks(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the model constants
+    const Real drift = V::Set(params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+    const Real beta = V::Set(params.beta);
+    const Real plus = V::Set(1.0);
+    const Real minus = V::Set(-1.0);
+
+    // Check once which statistics are requested, a barrier at 0 or infinity is absent
+    MonitorFlags flags;
+    flags.average = out.monitor.average != 0;
+    flags.geometric = out.monitor.geometric != 0;
+    flags.extremes = out.monitor.minimum != 0 || out.monitor.maximum != 0;
+    flags.survival = out.monitor.survival != 0;
+    flags.lower = flags.survival && params.lower_barrier > 0.0;
+    flags.upper = flags.survival && params.upper_barrier < std::numeric_limits<double>::infinity();
+    flags.bridge = params.bridge;
+    const bool antithetic = out.antithetic != 0;
+
+    // Barriers in log-spot and -2 / (sigma^2 * dt) of the Brownian-bridge crossing probability
+    const Real log_lower = V::Set(flags.lower ? std::log(params.lower_barrier) : 0.0);
+    const Real log_upper = V::Set(flags.upper ? std::log(params.upper_barrier) : 0.0);
+    const Real bridge_scale = V::Set(-2.0 / (params.sigma * params.sigma * params.dt));
+    const double log_S0 = std::log(params.S);
+
+    // Structure-of-arrays lanes of the paths and of the antithetic paths, and the two normals of a step pair
+    MonitorLanes lanes;
+    MonitorLanes lanes_antithetic;
+    alignas(64) double z0[block_paths];
+    alignas(64) double z1[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        // Re start every lane at the current underlying spot price
+        StartMonitor<V>(lanes, params, log_S0);
+        if (antithetic) StartMonitor<V>(lanes_antithetic, params, log_S0);
+
+        for (long a = 0; a < params.steps; a += 2)
+        {
+            // Draw the normals of subintervals a and a + 1 for every path of the block, unless they are cached
+            if (!params.normals)
+            {
+                for (long j = 0; j < block_paths; j += V::width)
+                {
+                    Real n0, n1;
+                    SimdMath<V>::Normals(params.generator, key0, key1,
+                        V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), static_cast<std::uint32_t>(a / 2), 0, n0, n1);
+                    V::Store(z0 + j, n0);
+                    V::Store(z1 + j, n1);
+                }
+            }
+
+            for (long k = a; k < a + 2 && k < params.steps; ++k)
+            {
+                const double* z = params.normals ? CachedNormals<V>(params.normals, params.steps, first_path + b, k, z0)
+                    : (k == a) ? z0 : z1;
+
+                MonitorBlock<V, Step, Model>(lanes, z, plus, drift, diffusion, beta, flags, log_lower, log_upper, bridge_scale);
+                if (antithetic)
+                    MonitorBlock<V, Step, Model>(lanes_antithetic, z, minus, drift, diffusion, beta, flags, log_lower,
+                        log_upper, bridge_scale);
+            }
+        }
+
+        // Write the terminal spots and the statistics, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        WriteBlock<V>(out.terminal + b, lanes.s, count);
+        WriteMonitor<V>(out.monitor, b, lanes, count, params.steps);
+        if (antithetic)
+        {
+            WriteBlock<V>(out.antithetic + b, lanes_antithetic.s, count);
+            WriteMonitor<V>(out.monitor_antithetic, b, lanes_antithetic, count, params.steps);
+        }
+    }
+}
+
+// Simulate paths [first_path, first_path + n_paths) over subintervals [first_step, first_step + steps) from the
+// initial spots of out, or params.S, storing the spots every date_steps subintervals. The normals are those of
+// SimulateTerminalBlocks for the same subintervals, so a path continued from the spot it reached at a subinterval
+// is the path simulated from 0, bit for bit
+template <class V, class Step>
+void SimulateExerciseBlocks(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Broadcast the model constants
+    const Real drift = V::Set(params.drift_const);
+    const Real diffusion = V::Set(params.diffusion_const);
+    const Real beta = V::Set(params.beta);
+    const Real plus = V::Set(1.0);
+    const long last_step = params.first_step + params.steps;
+
+    // Structure-of-arrays state of the block and the two normals of a step pair
+    alignas(64) double s[block_paths];
+    alignas(64) double z0[block_paths];
+    alignas(64) double z1[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+
+        // Start every lane at its initial spot, the lanes past the end of the range at params.S
+        for (long j = 0; j < block_paths; ++j)
+            s[j] = (out.initial && j < count) ? out.initial[b + j] : params.S;
+
+        for (long k = params.first_step; k < last_step; ++k)
+        {
+            // Draw the normals of the step pair at its first subinterval, or at the first subinterval simulated
+            if (k % 2 == 0 || k == params.first_step)
+            {
+                for (long j = 0; j < block_paths; j += V::width)
+                {
+                    Real n0, n1;
+                    SimdMath<V>::Normals(params.generator, key0, key1,
+                        V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), static_cast<std::uint32_t>(k / 2), 0, n0, n1);
+                    V::Store(z0 + j, n0);
+                    V::Store(z1 + j, n1);
+                }
+            }
+
+            AdvanceBlock<V, Step>(s, (k % 2 == 0) ? z0 : z1, plus, drift, diffusion, beta);
+
+            // Store the spots at the end of an exercise date
+            const long elapsed = k + 1 - params.first_step;
+            if (out.dates && elapsed % params.date_steps == 0)
+            {
+                float* date = out.dates + (elapsed / params.date_steps - 1) * out.date_stride + b;
+                for (long j = 0; j < count; ++j)
+                    date[j] = static_cast<float>(s[j]);
+            }
+        }
+
+        WriteBlock<V>(out.terminal + b, s, count);
+    }
+}
+
+// Draw count normals of a block in pairs from a Philox stream, normal j of lane l at z[j * block_paths + l]
+template <class V>
+inline void DrawBlockNormals(const std::uint32_t& key0, const std::uint32_t& key1, const long& path, const long& count,
+    const std::uint32_t& stream, double* z)
+{
+    typedef typename V::Real Real;
+
+    for (long j = 0; j < count; j += 2)
+    {
+        for (long l = 0; l < block_paths; l += V::width)
+        {
+            Real n0, n1;
+            SimdMath<V>::NormalPair(key0, key1, V::Sequence(static_cast<std::uint64_t>(path + l)),
+                static_cast<std::uint32_t>(j / 2), stream, n0, n1);
+            V::Store(z + j * block_paths + l, n0);
+            if (j + 1 < count) V::Store(z + (j + 1) * block_paths + l, n1);
+        }
+    }
+}
+
+// Simulate the terminal spots of correlated GBM assets for paths [first_path, first_path + n_paths), a block of
+// paths at a time: the normals of the block are drawn once, then every asset combines the loading row with all the
+// lanes of the block, so the normals stay in the L1 cache and the products vectorize across the paths
+template <class V>
+void SimulateBasketBlocks(const BasketParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    const long assets = params.assets;
+    const bool antithetic = out.antithetic != 0;
+
+    // Common and idiosyncratic normals of a block
+    alignas(64) double z[max_basket_assets * block_paths];
+    alignas(64) double e[max_basket_assets * block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        DrawBlockNormals<V>(key0, key1, first_path + b, params.factors, 0, z);
+        if (params.residual)
+            DrawBlockNormals<V>(key0, key1, first_path + b, assets, 1, e);
+
+        double* block = out.terminal + b * assets;
+        double* block_antithetic = antithetic ? out.antithetic + b * assets : 0;
+
+        for (long i = 0; i < assets; ++i)
+        {
+            const double* row = params.loading + i * params.factors;
+            const long width = params.triangular ? i + 1 : params.factors;
+            const Real drift = V::Set(params.drift[i]);
+            const Real diffusion = V::Set(params.diffusion[i]);
+            const Real residual = V::Set(params.residual ? params.residual[i] : 0.0);
+
+            for (long l = 0; l < block_paths; l += V::width)
+            {
+                Real x = V::Set(0.0);
+                for (long j = 0; j < width; ++j)
+                    x = V::MulAdd(V::Set(row[j]), V::Load(z + j * block_paths + l), x);
+                if (params.residual)
+                    x = V::MulAdd(residual, V::Load(e + i * block_paths + l), x);
+
+                V::Store(block + i * block_paths + l, SimdMath<V>::Exp(V::MulAdd(diffusion, x, drift)));
+                if (antithetic)
+                    V::Store(block_antithetic + i * block_paths + l, SimdMath<V>::Exp(V::Sub(drift, V::Mul(diffusion, x))));
+            }
+        }
+    }
+}
+
+// Advance the log-spots of a block of paths by one subinterval under a local volatility, with the normals multiplied
+// by sign; the volatility is interpolated in log-spot on the rows lower and upper of the slices around the step and
+// blended with the weight of the upper one. x += r * dt - sigma^2 * dt / 2 + sigma * sqrt(dt) * Z keeps every step
+// a martingale after discounting, as sigma is frozen at the start of the step
+template <class V>
+inline void AdvanceLocalVolBlock(const LocalVolGrid& grid, const double* lower, const double* upper,
+    const typename V::Real& weight, double* x, const double* z, const typename V::Real& sign,
+    const typename V::Real& drift, const typename V::Real& sqrt_dt)
+{
+    typedef typename V::Real Real;
+
+    const Real origin = V::Set(grid.log_spot_min);
+    const Real inverse_spacing = V::Set(grid.inverse_spacing);
+    const Real last = V::Set(static_cast<double>(grid.nodes - 1));
+    const Real last_cell = V::Set(static_cast<double>(grid.nodes - 2));
+
+    for (long j = 0; j < block_paths; j += V::width)
+    {
+        const Real X = V::Load(x + j);
+
+        // Fractional node of the log-spot, clamped to the grid, and the cell it falls in
+        const Real u = V::Min(V::Max(V::Mul(V::Sub(X, origin), inverse_spacing), V::Set(0.0)), last);
+        const Real cell = V::Floor(V::Min(u, last_cell));
+        const Real fraction = V::Sub(u, cell);
+
+        // Linear interpolation within the cell on both slices, then in time
+        const Real lower_left = V::Gather(lower, cell);
+        const Real upper_left = V::Gather(upper, cell);
+        const Real lower_vol = V::MulAdd(fraction, V::Sub(V::Gather(lower + 1, cell), lower_left), lower_left);
+        const Real upper_vol = V::MulAdd(fraction, V::Sub(V::Gather(upper + 1, cell), upper_left), upper_left);
+        const Real diffusion = V::Mul(V::MulAdd(weight, V::Sub(upper_vol, lower_vol), lower_vol), sqrt_dt);
+
+        const Real step = V::Sub(drift, V::Mul(V::Set(0.5), V::Mul(diffusion, diffusion)));
+        V::Store(x + j, V::MulAdd(diffusion, V::Mul(sign, V::Load(z + j)), V::Add(X, step)));
+    }
+}
+
+// Simulate paths [first_path, first_path + n_paths) under the local volatility of params.local_vol and write their
+// terminal spots, drawing the normals as SimulateTerminalBlocks; the GBM control paths take exact log-normal steps
+// with params.control_drift and params.control_diffusion on the same normals
+// The slice and the time weight of every subinterval are found once per call, stepping through the slices in order,
+// so the step loop only reads them
+template <class V>
+void SimulateLocalVolBlocks(const KernelParams& params, const long& first_path, const long& n_paths, const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    const LocalVolGrid& grid = params.local_vol;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    // Rows of the slices around the start of every subinterval and the weight of the upper one
+    std::vector<const double*> lower(params.steps), upper(params.steps);
+    std::vector<double> weight(params.steps);
+    long slice = 0;
+    for (long k = 0; k < params.steps; ++k)
+    {
+        const double t = k * params.dt;
+        while (slice + 1 < grid.slices && grid.times[slice + 1] <= t)
+            ++slice;
+
+        lower[k] = grid.vols + slice * grid.stride;
+        upper[k] = (slice + 1 < grid.slices) ? lower[k] + grid.stride : lower[k];
+        weight[k] = (slice + 1 < grid.slices && t > grid.times[slice])
+            ? (t - grid.times[slice]) / (grid.times[slice + 1] - grid.times[slice]) : 0.0;
+    }
+
+    // Broadcast the constants
+    const Real drift = V::Set(params.drift_const);
+    const Real sqrt_dt = V::Set(std::sqrt(params.dt));
+    const Real beta = V::Set(1.0);
+    const Real control_drift = V::Set(params.control_drift);
+    const Real control_diffusion = V::Set(params.control_diffusion);
+    const Real plus = V::Set(1.0);
+    const Real minus = V::Set(-1.0);
+    const double log_S0 = std::log(params.S);
+
+    // Check once which paths are requested
+    const bool antithetic = out.antithetic != 0;
+    const bool control = out.control != 0;
+    const bool control_antithetic = out.control_antithetic != 0;
+
+    // Structure-of-arrays buffers for the log-spots, the control spots and the two normals of a step pair
+    alignas(64) double x[block_paths];
+    alignas(64) double xa[block_paths];
+    alignas(64) double sc[block_paths];
+    alignas(64) double sca[block_paths];
+    alignas(64) double z0[block_paths];
+    alignas(64) double z1[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        for (long j = 0; j < block_paths; ++j)
+        {
+            x[j] = xa[j] = log_S0;
+            sc[j] = sca[j] = params.S;
+        }
+
+        for (long a = 0; a < params.steps; a += 2)
+        {
+            // Draw the normals of subintervals a and a + 1 for every path of the block, unless they are cached
+            if (!params.normals)
+            {
+                for (long j = 0; j < block_paths; j += V::width)
+                {
+                    Real n0, n1;
+                    SimdMath<V>::Normals(params.generator, key0, key1,
+                        V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), static_cast<std::uint32_t>(a / 2), 0, n0, n1);
+                    V::Store(z0 + j, n0);
+                    V::Store(z1 + j, n1);
+                }
+            }
+
+            for (long k = a; k < a + 2 && k < params.steps; ++k)
+            {
+                const double* z = params.normals ? CachedNormals<V>(params.normals, params.steps, first_path + b, k, z0)
+                    : (k == a) ? z0 : z1;
+                const Real w = V::Set(weight[k]);
+
+                AdvanceLocalVolBlock<V>(grid, lower[k], upper[k], w, x, z, plus, drift, sqrt_dt);
+                if (antithetic) AdvanceLocalVolBlock<V>(grid, lower[k], upper[k], w, xa, z, minus, drift, sqrt_dt);
+                if (control) AdvanceBlock<V, LogNormalStep>(sc, z, plus, control_drift, control_diffusion, beta);
+                if (control_antithetic) AdvanceBlock<V, LogNormalStep>(sca, z, minus, control_drift, control_diffusion, beta);
+            }
+        }
+
+        // Write the terminal spots, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        for (long j = 0; j < count; ++j)
+        {
+            out.terminal[b + j] = std::exp(x[j]);
+            if (antithetic) out.antithetic[b + j] = std::exp(xa[j]);
+        }
+        if (control) WriteBlock<V>(out.control + b, sc, count);
+        if (control_antithetic) WriteBlock<V>(out.control_antithetic + b, sca, count);
+    }
+}
+
+// Advance the variances and log-spots of a block of Heston paths by one subinterval with the QE scheme, with the normals
+// multiplied by sign (-1 for the antithetic paths); both branches are evaluated on every lane and blended
+template <class V>
+inline void AdvanceHestonBlock(const HestonKernelParams& params, double* x, double* v, const double* zv, const double* zx,
+    const typename V::Real& sign)
+{
+    typedef typename V::Real Real;
+
+    const Real zero = V::Set(0.0);
+    const Real one = V::Set(1.0);
+
+    for (long j = 0; j < block_paths; j += V::width)
+    {
+        const Real V0 = V::Load(v + j);
+        const Real Zv = V::Mul(sign, V::Load(zv + j));
+
+        // Conditional mean and variance of v', and psi = s^2 / m^2
+        const Real m = V::MulAdd(V::Sub(V0, V::Set(params.theta)), V::Set(params.decay), V::Set(params.theta));
+        const Real s2 = V::MulAdd(V0, V::Set(params.variance_v), V::Set(params.variance_const));
+        const Real psi = V::Div(s2, V::Max(V::Mul(m, m), V::Set(DBL_MIN)));
+        const typename V::Mask quadratic = V::Less(psi, V::Set(params.psi_c));
+
+        // Quadratic branch: v' = a * (b + Zv)^2, with psi clamped so the lanes of the other branch stay finite
+        const Real inverse = V::Div(V::Set(2.0), V::Min(psi, V::Set(params.psi_c)));
+        const Real b2 = V::Add(V::Sub(inverse, one), V::Mul(V::Sqrt(inverse), V::Sqrt(V::Sub(inverse, one))));
+        const Real a = V::Div(m, V::Add(one, b2));
+        const Real b = V::Sqrt(b2);
+        const Real shifted = V::Add(b, Zv);
+        const Real v_quadratic = V::Mul(a, V::Mul(shifted, shifted));
+
+        // Exponential branch: v' = 0 with probability p, exponential of rate beta otherwise, from U = N(Zv)
+        const Real p = V::Div(V::Sub(psi, one), V::Add(psi, one));
+        const Real rate = V::Div(V::Sub(one, p), V::Max(m, V::Set(DBL_MIN)));
+        const Real U = SimdMath<V>::NormalCdf(Zv);
+        const Real ratio = V::Div(V::Sub(one, p), V::Max(V::Sub(one, U), V::Set(DBL_MIN)));
+        const Real v_exponential = V::Select(V::Less(p, U), V::Div(SimdMath<V>::Log(V::Max(ratio, one)), rate), zero);
+
+        const Real V1 = V::Select(quadratic, v_quadratic, v_exponential);
+
+        // k0, or the martingale correction -log E[exp(A * v')] - (k1 + k3 / 2) * v with A = k2 + k4 / 2, kept on the
+        // lanes where E[exp(A * v')] is finite (2 * A * a < 1, A < beta), which fails only for large rho / xi and steps
+        Real k0 = V::Set(params.k0);
+        if (params.martingale)
+        {
+            const Real A = V::Set(params.k2 + 0.5 * params.k4);
+            const Real denominator = V::Sub(one, V::Mul(V::Set(2.0), V::Mul(A, a)));
+            const Real excess = V::Sub(rate, A);
+            const Real log_quadratic = V::Sub(V::Div(V::Mul(A, V::Mul(b2, a)), denominator),
+                V::Mul(V::Set(0.5), SimdMath<V>::Log(V::Max(denominator, V::Set(DBL_MIN)))));
+            const Real log_exponential = SimdMath<V>::Log(V::Add(p,
+                V::Div(V::Mul(rate, V::Sub(one, p)), V::Max(excess, V::Set(DBL_MIN)))));
+            const Real corrected = V::Sub(V::Sub(zero, V::Select(quadratic, log_quadratic, log_exponential)),
+                V::Mul(V::Set(params.k1 + 0.5 * params.k3), V0));
+            k0 = V::Select(V::Less(zero, V::Select(quadratic, denominator, excess)), corrected, k0);
+        }
+
+        // Log-spot step driven by the independent normal Zx
+        const Real variance = V::Max(V::MulAdd(V::Set(params.k3), V0, V::Mul(V::Set(params.k4), V1)), zero);
+        Real X = V::Add(V::Load(x + j), V::Add(V::Set(params.drift), k0));
+        X = V::MulAdd(V::Set(params.k1), V0, X);
+        X = V::MulAdd(V::Set(params.k2), V1, X);
+        X = V::MulAdd(V::Sqrt(variance), V::Mul(sign, V::Load(zx + j)), X);
+
+        V::Store(x + j, X);
+        V::Store(v + j, V1);
+    }
+}
+
+// Simulate Heston paths [first_path, first_path + n_paths) with the QE scheme, drawing the pair of normals of every
+// subinterval from Philox (the variance normal first) and writing the terminal spots
+template <class V>
+void SimulateHestonBlocks(const HestonKernelParams& params, const long& first_path, const long& n_paths,
+    const PathBuffers& out)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    const bool antithetic = out.antithetic != 0;
+    const double log_S0 = std::log(params.S);
+
+    // Structure-of-arrays log-spots and variances of the paths and of the antithetic paths, and the step normals
+    alignas(64) double x[block_paths];
+    alignas(64) double v[block_paths];
+    alignas(64) double xa[block_paths];
+    alignas(64) double va[block_paths];
+    alignas(64) double zv[block_paths];
+    alignas(64) double zx[block_paths];
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        for (long j = 0; j < block_paths; ++j)
+        {
+            x[j] = xa[j] = log_S0;
+            v[j] = va[j] = params.v0;
+        }
+
+        for (long k = 0; k < params.steps; ++k)
+        {
+            for (long j = 0; j < block_paths; j += V::width)
+            {
+                Real n0, n1;
+                SimdMath<V>::NormalPair(key0, key1, V::Sequence(static_cast<std::uint64_t>(first_path + b + j)),
+                    static_cast<std::uint32_t>(k), 0, n0, n1);
+                V::Store(zv + j, n0);
+                V::Store(zx + j, n1);
+            }
+
+            AdvanceHestonBlock<V>(params, x, v, zv, zx, V::Set(1.0));
+            if (antithetic) AdvanceHestonBlock<V>(params, xa, va, zv, zx, V::Set(-1.0));
+        }
+
+        // Write the terminal spots, dropping the lanes past the end of the range
+        const long count = (n_paths - b < block_paths) ? n_paths - b : block_paths;
+        for (long j = 0; j < count; ++j)
+        {
+            out.terminal[b + j] = std::exp(x[j]);
+            if (antithetic) out.antithetic[b + j] = std::exp(xa[j]);
+        }
+    }
+}
+
+// Write the normals of the kernels on the subinterval grid for paths [first_path, first_path + n_paths),
+// block by block in the layout of NormalKernel, from the same Philox counters (path, step pair, 0)
+template <class V>
+void DrawGridNormals(const KernelParams& params, const long& first_path, const long& n_paths, double* normals)
+{
+    typedef typename V::Real Real;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        double* block = normals + static_cast<std::ptrdiff_t>(b / block_paths) * params.steps * block_paths;
+
+        for (long a = 0; a < params.steps; a += 2)
+        {
+            for (long j = 0; j < block_paths; j += V::width)
+            {
+                Real n0, n1;
+                SimdMath<V>::Normals(params.generator, key0, key1,
+                    V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), static_cast<std::uint32_t>(a / 2), 0, n0, n1);
+                V::Store(block + a * block_paths + j, n0);
+                if (a + 1 < params.steps) V::Store(block + (a + 1) * block_paths + j, n1);
+            }
+        }
+    }
+}
+
+// Write the single normal per path of exact terminal sampling for paths [first_path, first_path + n_paths),
+// the two normals of the counter (path, 0, 0) of lane j in lanes j and j + block_paths / 2 as in SimulateTerminalExact
+template <class V>
+void DrawTerminalNormals(const KernelParams& params, const long& first_path, const long& n_paths, double* normals)
+{
+    typedef typename V::Real Real;
+
+    const long half = block_paths / 2;
+
+    // Split the seed in the two Philox key words
+    const std::uint32_t key0 = static_cast<std::uint32_t>(params.seed);
+    const std::uint32_t key1 = static_cast<std::uint32_t>(params.seed >> 32);
+
+    for (long b = 0; b < n_paths; b += block_paths)
+    {
+        double* block = normals + b;
+
+        for (long j = 0; j < half; j += V::width)
+        {
+            Real n0, n1;
+            SimdMath<V>::Normals(params.generator, key0, key1,
+                V::Sequence(static_cast<std::uint64_t>(first_path + b + j)), 0, 0, n0, n1);
+            V::Store(block + j, n0);
+            V::Store(block + j + half, n1);
+        }
+    }
+}
+
+// Build the table of kernels for the traits V, with the single precision kernels on the float traits VF
+template <class V, class VF>
+PathKernels MakePathKernels()
+{
+    PathKernels kernels;
+
+    kernels.euler[static_cast<int>(ModelType::GBM)] = SimulateTerminalBlocks<V, EulerStep<GBMModel> >;
+    kernels.euler[static_cast<int>(ModelType::Sqrt)] = SimulateTerminalBlocks<V, EulerStep<SqrtModel> >;
+    kernels.euler[static_cast<int>(ModelType::Quadratic)] = SimulateTerminalBlocks<V, EulerStep<QuadraticModel> >;
+    kernels.euler[static_cast<int>(ModelType::CEV)] = SimulateTerminalBlocks<V, EulerStep<CEVModel> >;
+    kernels.exact_steps = SimulateTerminalBlocks<V, LogNormalStep>;
+    kernels.exact_terminal = SimulateTerminalExact<V>;
+
+    kernels.euler_single[static_cast<int>(ModelType::GBM)] = SimulateTerminalBlocksSingle<VF, EulerStep<GBMModel> >;
+    kernels.euler_single[static_cast<int>(ModelType::Sqrt)] = SimulateTerminalBlocksSingle<VF, EulerStep<SqrtModel> >;
+    kernels.euler_single[static_cast<int>(ModelType::Quadratic)] =
+        SimulateTerminalBlocksSingle<VF, EulerStep<QuadraticModel> >;
+    kernels.euler_single[static_cast<int>(ModelType::CEV)] = SimulateTerminalBlocksSingle<VF, EulerStep<CEVModel> >;
+    kernels.exact_terminal_single = SimulateTerminalExactSingle<VF>;
+
+    kernels.greeks_euler[static_cast<int>(ModelType::GBM)] = SimulateGreeksBlocks<V, GBMModel>;
+    kernels.greeks_euler[static_cast<int>(ModelType::Sqrt)] = SimulateGreeksBlocks<V, SqrtModel>;
+    kernels.greeks_euler[static_cast<int>(ModelType::Quadratic)] = SimulateGreeksBlocks<V, QuadraticModel>;
+    kernels.greeks_euler[static_cast<int>(ModelType::CEV)] = SimulateGreeksBlocks<V, CEVModel>;
+    kernels.greeks_exact_terminal = SimulateGreeksExact<V>;
+
+    kernels.coupled_euler[static_cast<int>(ModelType::GBM)] = SimulateCoupledBlocks<V, GBMModel>;
+    kernels.coupled_euler[static_cast<int>(ModelType::Sqrt)] = SimulateCoupledBlocks<V, SqrtModel>;
+    kernels.coupled_euler[static_cast<int>(ModelType::Quadratic)] = SimulateCoupledBlocks<V, QuadraticModel>;
+    kernels.coupled_euler[static_cast<int>(ModelType::CEV)] = SimulateCoupledBlocks<V, CEVModel>;
+
+    kernels.monitor_euler[static_cast<int>(ModelType::GBM)] = SimulateMonitorBlocks<V, EulerStep<GBMModel>, GBMModel>;
+    kernels.monitor_euler[static_cast<int>(ModelType::Sqrt)] = SimulateMonitorBlocks<V, EulerStep<SqrtModel>, SqrtModel>;
+    kernels.monitor_euler[static_cast<int>(ModelType::Quadratic)] =
+        SimulateMonitorBlocks<V, EulerStep<QuadraticModel>, QuadraticModel>;
+    kernels.monitor_euler[static_cast<int>(ModelType::CEV)] = SimulateMonitorBlocks<V, EulerStep<CEVModel>, CEVModel>;
+    kernels.monitor_exact_steps = SimulateMonitorBlocks<V, LogNormalStep, GBMModel>;
+
+    kernels.exercise_euler[static_cast<int>(ModelType::GBM)] = SimulateExerciseBlocks<V, EulerStep<GBMModel> >;
+    kernels.exercise_euler[static_cast<int>(ModelType::Sqrt)] = SimulateExerciseBlocks<V, EulerStep<SqrtModel> >;
+    kernels.exercise_euler[static_cast<int>(ModelType::Quadratic)] = SimulateExerciseBlocks<V, EulerStep<QuadraticModel> >;
+    kernels.exercise_euler[static_cast<int>(ModelType::CEV)] = SimulateExerciseBlocks<V, EulerStep<CEVModel> >;
+    kernels.exercise_exact_steps = SimulateExerciseBlocks<V, LogNormalStep>;
+    kernels.basket_terminal = SimulateBasketBlocks<V>;
+    kernels.heston_qe = SimulateHestonBlocks<V>;
+    kernels.local_vol_steps = SimulateLocalVolBlocks<V>;
+
+    kernels.grid_normals = DrawGridNormals<V>;
+    kernels.terminal_normals = DrawTerminalNormals<V>;
+
+    return kernels;
+}
+
+// End of the conditional inclusion of the header file
+#endif
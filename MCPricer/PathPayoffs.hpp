@@ -0,0 +1,186 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// PathPayoffs.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the path-dependent payoff policies evaluated by MonteCarlo::PricePathPayoff
+
+// If PATHPAYOFFS_HPP is not defined
+#ifndef PATHPAYOFFS_HPP
+// Define PATHPAYOFFS_HPP
+#define PATHPAYOFFS_HPP
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "Payoffs.hpp"
+
+// A path payoff policy is any copyable type with a const Monitoring() member, the statistics it reads, and a const
+// call operator taking the PathSummary of a path. The statistics are streamed by the monitoring kernels at the end
+// of every subinterval, so the paths are never stored and the memory does not grow with the number of subintervals.
+
+// Define PathSummary struct, the statistics of a monitored path (only the requested ones are set)
+struct PathSummary
+{
+    // Terminal spot
+    double terminal;
+    // Arithmetic and geometric averages of the spots at the end of the subintervals
+    double average;
+    double geometric;
+    // Minimum and maximum of the spots, the initial spot included
+    double minimum;
+    double maximum;
+    // Probability that the path stays strictly between the barriers (0 or 1 with discrete monitoring)
+    double survival;
+};
+
+// Define PathMonitoring struct, the statistics a path payoff reads and its barriers
+struct PathMonitoring
+{
+    bool average;
+    bool geometric;
+    bool extremes;
+    bool barrier;
+    // Barriers, 0 and infinity when absent
+    double lower_barrier;
+    double upper_barrier;
+    // Whether a path may also cross the barriers between two subintervals, with the Brownian-bridge probability
+    bool continuous;
+};
+
+// Averages of the Asian options
+enum class Averaging
+{
+    Arithmetic,
+    Geometric
+};
+
+// Barrier option types
+enum class BarrierType
+{
+    UpAndOut,
+    UpAndIn,
+    DownAndOut,
+    DownAndIn
+};
+
+// Barrier monitoring, at the end of every subinterval or continuous through the Brownian-bridge correction
+enum class BarrierMonitoring
+{
+    Discrete,
+    Continuous
+};
+
+// Strikes of the lookback options, the extreme of the path or a fixed strike
+enum class LookbackStrike
+{
+    Floating,
+    Fixed
+};
+
+// Define AsianPayoff policy, a call or put on the average of the spots at the end of the subintervals
+struct AsianPayoff
+{
+    // +1 for a call, -1 for a put
+    double phi;
+    // Strike price
+    double K;
+    // Arithmetic or geometric average
+    Averaging averaging;
+
+    AsianPayoff(const std::string& type, const double& strike, const Averaging& average = Averaging::Arithmetic)
+        : phi(PayoffSign(type, "AsianPayoff")), K(strike), averaging(average) {}
+
+    PathMonitoring Monitoring() const
+    {
+        PathMonitoring monitoring = PathMonitoring();
+        monitoring.average = averaging == Averaging::Arithmetic;
+        monitoring.geometric = averaging == Averaging::Geometric;
+        return monitoring;
+    }
+
+    double operator()(const PathSummary& path) const
+    {
+        const double value = phi * ((averaging == Averaging::Arithmetic ? path.average : path.geometric) - K);
+        return (value > 0.0) ? value : 0.0;
+    }
+};
+
+// Define BarrierPayoff policy, a call or put knocked out or in by a barrier
+// The knock-in payoff is the vanilla payoff times the probability of crossing, so in + out = vanilla path by path
+struct BarrierPayoff
+{
+    // +1 for a call, -1 for a put
+    double phi;
+    // Strike price
+    double K;
+    // Barrier level
+    double H;
+    // Barrier type and monitoring
+    BarrierType barrier;
+    BarrierMonitoring monitoring;
+
+    BarrierPayoff(const std::string& type, const double& strike, const double& level, const BarrierType& barrier_type,
+        const BarrierMonitoring& barrier_monitoring = BarrierMonitoring::Discrete)
+        : phi(PayoffSign(type, "BarrierPayoff")), K(strike), H(level), barrier(barrier_type),
+        monitoring(barrier_monitoring)
+    {
+        if (!(level > 0.0))
+            throw std::invalid_argument("BarrierPayoff: barrier must be positive");
+    }
+
+    PathMonitoring Monitoring() const
+    {
+        const bool up = barrier == BarrierType::UpAndOut || barrier == BarrierType::UpAndIn;
+
+        PathMonitoring path_monitoring = PathMonitoring();
+        path_monitoring.barrier = true;
+        path_monitoring.lower_barrier = up ? 0.0 : H;
+        path_monitoring.upper_barrier = up ? H : std::numeric_limits<double>::infinity();
+        path_monitoring.continuous = monitoring == BarrierMonitoring::Continuous;
+        return path_monitoring;
+    }
+
+    double operator()(const PathSummary& path) const
+    {
+        const double value = phi * (path.terminal - K);
+        if (!(value > 0.0)) return 0.0;
+
+        const bool out = barrier == BarrierType::UpAndOut || barrier == BarrierType::DownAndOut;
+        return value * (out ? path.survival : 1.0 - path.survival);
+    }
+};
+
+// Define LookbackPayoff policy, monitored at the end of every subinterval
+// Floating strike: the call pays ST - min and the put max - ST; fixed strike: the call pays (max - K)+ and the
+// put (K - min)+
+struct LookbackPayoff
+{
+    // +1 for a call, -1 for a put
+    double phi;
+    // Floating or fixed strike
+    LookbackStrike strike;
+    // Fixed strike price (unused with a floating strike)
+    double K;
+
+    LookbackPayoff(const std::string& type, const LookbackStrike& lookback_strike = LookbackStrike::Floating,
+        const double& fixed_strike = 0.0)
+        : phi(PayoffSign(type, "LookbackPayoff")), strike(lookback_strike), K(fixed_strike) {}
+
+    PathMonitoring Monitoring() const
+    {
+        PathMonitoring monitoring = PathMonitoring();
+        monitoring.extremes = true;
+        return monitoring;
+    }
+
+    double operator()(const PathSummary& path) const
+    {
+        if (strike == LookbackStrike::Floating)
+            return (phi > 0.0) ? path.terminal - path.minimum : path.maximum - path.terminal;
+
+        const double value = (phi > 0.0) ? path.maximum - K : K - path.minimum;
+        return (value > 0.0) ? value : 0.0;
+    }
+};
+
+// End of the conditional inclusion of the header file
+#endif
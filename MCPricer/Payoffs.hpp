@@ -0,0 +1,81 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Payoffs.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the payoff policies evaluated by MonteCarlo::PricePayoff
+
+// If PAYOFFS_HPP is not defined
+#ifndef PAYOFFS_HPP
+// Define PAYOFFS_HPP
+#define PAYOFFS_HPP
+
+#include <stdexcept>
+#include <string>
+
+// A payoff policy is any copyable type with a const call operator taking the terminal spot.
+// It is inlined into the payoff loop, so new payoffs need neither virtual calls nor changes to the kernels.
+// Lipschitz payoffs may also expose Derivative(ST), the slope used by the pathwise Greeks;
+// the digitals have none, their pathwise derivative vanishes almost everywhere.
+
+// Define CallPayoff policy
+struct CallPayoff
+{
+    // Strike price
+    double K;
+
+    explicit CallPayoff(const double& strike) : K(strike) {}
+
+    double operator()(const double& ST) const { return (ST > K) ? ST - K : 0.0; }
+
+    double Derivative(const double& ST) const { return (ST > K) ? 1.0 : 0.0; }
+};
+
+// Define PutPayoff policy
+struct PutPayoff
+{
+    // Strike price
+    double K;
+
+    explicit PutPayoff(const double& strike) : K(strike) {}
+
+    double operator()(const double& ST) const { return (K > ST) ? K - ST : 0.0; }
+
+    double Derivative(const double& ST) const { return (K > ST) ? -1.0 : 0.0; }
+};
+
+// Define DigitalCallPayoff policy (cash-or-nothing)
+struct DigitalCallPayoff
+{
+    // Strike price
+    double K;
+    // Cash amount paid above the strike
+    double cash;
+
+    DigitalCallPayoff(const double& strike, const double& amount = 1.0) : K(strike), cash(amount) {}
+
+    double operator()(const double& ST) const { return (ST > K) ? cash : 0.0; }
+};
+
+// Define DigitalPutPayoff policy (cash-or-nothing)
+struct DigitalPutPayoff
+{
+    // Strike price
+    double K;
+    // Cash amount paid below the strike
+    double cash;
+
+    DigitalPutPayoff(const double& strike, const double& amount = 1.0) : K(strike), cash(amount) {}
+
+    double operator()(const double& ST) const { return (K > ST) ? cash : 0.0; }
+};
+
+// Get +1 for a "Call" and -1 for a "Put", the sign of the payoff policies taking an option type
+inline double PayoffSign(const std::string& type, const std::string& name)
+{
+    if (type == "Call") return 1.0;
+    if (type == "Put") return -1.0;
+
+    throw std::invalid_argument(name + ": type must be Call or Put");
+}
+
+// End of the conditional inclusion of the header file
+#endif
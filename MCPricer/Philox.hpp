@@ -0,0 +1,101 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Philox.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the Philox counter-based random number generator
+
+// If PHILOX_HPP is not defined
+#ifndef PHILOX_HPP
+// Define PHILOX_HPP
+#define PHILOX_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Define Philox class (Philox4x32-10, Salmon et al. 2011)
+// The output is a pure function of (seed, counter), so any path and step can be reached in O(1)
+// Counter layout used by the engines: {path low word, path high word, step pair index, stream}
+class Philox
+{
+private:
+
+    // Declare the two key words derived from the seed
+    std::uint32_t m_key0;
+    std::uint32_t m_key1;
+
+    // Declare the round multipliers and key increments (Weyl sequence)
+    static const std::uint32_t M0 = 0xD2511F53u;
+    static const std::uint32_t M1 = 0xCD9E8D57u;
+    static const std::uint32_t W0 = 0x9E3779B9u;
+    static const std::uint32_t W1 = 0xBB67AE85u;
+
+public:
+
+    // Constructor
+    explicit Philox(const unsigned long long& seed = 5489) :
+        m_key0(static_cast<std::uint32_t>(seed)),
+        m_key1(static_cast<std::uint32_t>(seed >> 32))
+    {}
+
+    // Apply the ten Philox rounds to a counter, in place
+    void Generate(std::uint32_t x[4]) const
+    {
+        std::uint32_t k0 = m_key0;
+        std::uint32_t k1 = m_key1;
+
+        for (int round = 0; round < 10; ++round)
+        {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(M0) * x[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(M1) * x[2];
+
+            const std::uint32_t y0 = static_cast<std::uint32_t>(p1 >> 32) ^ x[1] ^ k0;
+            const std::uint32_t y1 = static_cast<std::uint32_t>(p1);
+            const std::uint32_t y2 = static_cast<std::uint32_t>(p0 >> 32) ^ x[3] ^ k1;
+            const std::uint32_t y3 = static_cast<std::uint32_t>(p0);
+
+            x[0] = y0; x[1] = y1; x[2] = y2; x[3] = y3;
+
+            k0 += W0;
+            k1 += W1;
+        }
+    }
+
+    // Map two 32-bit words to a double in [0, 1) with 52 random bits
+    static double Uniform(const std::uint32_t& hi, const std::uint32_t& lo)
+    {
+        const std::uint64_t bits = 0x3FF0000000000000ull
+            | (static_cast<std::uint64_t>(hi) << 20) | (lo >> 12);
+        double u;
+        std::memcpy(&u, &bits, sizeof(u));
+        return u - 1.0;
+    }
+
+    // Draw two uniforms for (path, index, stream): u0 in (0, 1] and u1 in [0, 1)
+    void UniformPair(const unsigned long long& path, const unsigned long& index, const unsigned long& stream,
+        double& u0, double& u1) const
+    {
+        std::uint32_t x[4] = { static_cast<std::uint32_t>(path), static_cast<std::uint32_t>(path >> 32),
+            static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(stream) };
+        Generate(x);
+
+        u0 = 1.0 - Uniform(x[0], x[1]);
+        u1 = Uniform(x[2], x[3]);
+    }
+
+    // Draw two independent standard normals for (path, index, stream) with the Box-Muller transform
+    void NormalPair(const unsigned long long& path, const unsigned long& index, const unsigned long& stream,
+        double& z0, double& z1) const
+    {
+        double u0, u1;
+        UniformPair(path, index, stream, u0, u1);
+
+        const double radius = std::sqrt(-2.0 * std::log(u0));
+        const double angle = 6.283185307179586 * u1;
+
+        z0 = radius * std::cos(angle);
+        z1 = radius * std::sin(angle);
+    }
+};
+
+// End of the conditional inclusion of the header file
+#endif
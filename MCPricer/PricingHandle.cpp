@@ -0,0 +1,135 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// PricingHandle.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the handles of the asynchronous pricing runs
+
+#include <limits>
+#include "PricingHandle.hpp"
+
+// Constructor
+PricingProgress::PricingProgress(const double& deadline) :
+    m_estimated(false),
+    m_status(PricingStatus::Running),
+    m_cancelled(false),
+    m_interrupted(false),
+    m_has_deadline(deadline > 0.0),
+    m_deadline(std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(deadline))),
+    m_future(m_promise.get_future().share())
+{
+    m_partial.price = 0.0;
+    m_partial.se = 0.0;
+    m_partial.simulations = 0;
+    m_partial.elapsed = 0.0;
+}
+
+// Publish the estimate of the batches finished so far
+void PricingProgress::Publish(const MCResult& partial)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_partial = partial;
+    m_estimated = true;
+}
+
+// Check whether the run must stop
+bool PricingProgress::Interrupted()
+{
+    if (m_interrupted.load())
+        return true;
+
+    // Remember the interruption, so the run stops as a whole even if the chunks see the clock at different times
+    if (m_cancelled.load() || (m_has_deadline && std::chrono::steady_clock::now() >= m_deadline))
+    {
+        m_interrupted = true;
+        return true;
+    }
+
+    return false;
+}
+
+// Get the seconds left until the deadline
+double PricingProgress::TimeLeft() const
+{
+    if (!m_has_deadline)
+        return std::numeric_limits<double>::infinity();
+
+    return std::chrono::duration<double>(m_deadline - std::chrono::steady_clock::now()).count();
+}
+
+// Finish the run with its final estimate
+void PricingProgress::Finish(const MCResult& result)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_partial = result;
+        m_estimated = result.simulations > 0;
+
+        if (!m_interrupted.load())
+            m_status = PricingStatus::Completed;
+        else
+            m_status = m_cancelled.load() ? PricingStatus::Cancelled : PricingStatus::DeadlineReached;
+    }
+
+    m_promise.set_value(result);
+    m_changed.notify_all();
+}
+
+// Finish the run with the exception that stopped it
+void PricingProgress::Fail(const std::exception_ptr& exception)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_status = PricingStatus::Failed;
+    }
+
+    m_promise.set_exception(exception);
+    m_changed.notify_all();
+}
+
+// Request the run to stop
+void PricingProgress::Cancel()
+{
+    m_cancelled = true;
+}
+
+// Get the estimate of the batches finished so far
+bool PricingProgress::Partial(MCResult& partial) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_estimated)
+        return false;
+
+    partial = m_partial;
+    return true;
+}
+
+// Get the state of the run
+PricingStatus PricingProgress::status() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_status;
+}
+
+// Wait until the run stops
+bool PricingProgress::WaitFor(const double& seconds) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_changed.wait_for(lock, std::chrono::duration<double>(seconds),
+        [this]() { return m_status != PricingStatus::Running; });
+}
+
+// Constructor
+PricingRun::PricingRun(const std::shared_ptr<PricingProgress>& progress, std::thread&& driver) :
+    m_progress(progress),
+    m_driver(std::move(driver))
+{
+}
+
+// Destructor
+PricingRun::~PricingRun()
+{
+    // Stop the run within one chunk and wait for its thread, which may still be using the thread pool
+    m_progress->Cancel();
+    if (m_driver.joinable())
+        m_driver.join();
+}
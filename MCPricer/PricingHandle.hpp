@@ -0,0 +1,158 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// PricingHandle.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the handles of the asynchronous pricing runs
+
+// If PRICINGHANDLE_HPP is not defined
+#ifndef PRICINGHANDLE_HPP
+// Define PRICINGHANDLE_HPP
+#define PRICINGHANDLE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "MCResult.hpp"
+
+// States of an asynchronous pricing run
+enum class PricingStatus
+{
+    // Simulating, the partial estimate improves after every batch
+    Running,
+    // Stopped by the target standard error, the relative tolerance, the time budget or the largest budget of simulations
+    Completed,
+    // Stopped by PricingHandle::Cancel, the result is the estimate of the batches finished before
+    Cancelled,
+    // Stopped by the deadline, the result is the estimate of the batches finished before
+    DeadlineReached,
+    // Stopped by an exception, rethrown by PricingHandle::Get
+    Failed
+};
+
+// Define PricingProgress class, the state shared by an asynchronous run and its handles
+// The engine publishes the estimate of every finished batch and polls Interrupted between chunks of paths,
+// so a cancelled run or a run past its deadline stops within one chunk and keeps the batches finished before
+class PricingProgress
+{
+private:
+
+    // Declare private member variables
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_changed;
+    MCResult m_partial;
+    bool m_estimated;
+    PricingStatus m_status;
+    std::atomic<bool> m_cancelled;
+    std::atomic<bool> m_interrupted;
+    bool m_has_deadline;
+    std::chrono::steady_clock::time_point m_deadline;
+    std::promise<MCResult> m_promise;
+    std::shared_future<MCResult> m_future;
+
+public:
+
+    // Constructor, a deadline of 0 seconds means no deadline
+    explicit PricingProgress(const double& deadline = 0.0);
+
+    // The handles share the progress, which can be neither copied nor assigned
+    PricingProgress(const PricingProgress&) = delete;
+    PricingProgress& operator=(const PricingProgress&) = delete;
+
+    // Publish the estimate of the batches finished so far (engine side)
+    void Publish(const MCResult& partial);
+
+    // Check whether the run must stop, because it was cancelled or its deadline has passed (engine side)
+    bool Interrupted();
+
+    // Get the seconds left until the deadline, infinite without deadline (engine side)
+    double TimeLeft() const;
+
+    // Finish the run with its final estimate or with the exception that stopped it (engine side)
+    void Finish(const MCResult& result);
+    void Fail(const std::exception_ptr& exception);
+
+    // Request the run to stop
+    void Cancel();
+
+    // Get the estimate of the batches finished so far; false, leaving partial unchanged, before the first one
+    bool Partial(MCResult& partial) const;
+
+    // Get the state of the run
+    PricingStatus status() const;
+
+    // Wait until the run stops, at most seconds; true when it has stopped
+    bool WaitFor(const double& seconds) const;
+
+    // Get the future of the final estimate
+    const std::shared_future<MCResult>& future() const { return m_future; }
+};
+
+// Define PricingRun class, the thread driving an asynchronous run, owned by the handles of the run
+// Its destructor cancels the run and joins the thread, so a run never outlives its handles
+class PricingRun
+{
+private:
+
+    // Declare private member variables
+    std::shared_ptr<PricingProgress> m_progress;
+    std::thread m_driver;
+
+public:
+
+    // Constructor
+    PricingRun(const std::shared_ptr<PricingProgress>& progress, std::thread&& driver);
+
+    // The thread has a single owner, the run can be neither copied nor assigned
+    PricingRun(const PricingRun&) = delete;
+    PricingRun& operator=(const PricingRun&) = delete;
+
+    // Destructor
+    ~PricingRun();
+};
+
+// Define PricingHandle class, a copyable handle to an asynchronous pricing run (see MonteCarlo::PriceAsync)
+// Dropping the last handle cancels the run and waits for it to stop, within one chunk of paths
+class PricingHandle
+{
+private:
+
+    // Declare private member variables
+    std::shared_ptr<PricingProgress> m_progress;
+    std::shared_ptr<PricingRun> m_run;
+
+public:
+
+    // Constructor, taking the thread that drives the run
+    PricingHandle(const std::shared_ptr<PricingProgress>& progress, std::thread&& driver)
+        : m_progress(progress), m_run(std::make_shared<PricingRun>(progress, std::move(driver))) {}
+
+    // Get the estimate of the batches finished so far: price, standard error, simulations and elapsed time;
+    // false, leaving partial unchanged, while there is no estimate yet
+    bool Progress(MCResult& partial) const { return m_progress->Partial(partial); }
+
+    // Get the state of the run
+    PricingStatus status() const { return m_progress->status(); }
+
+    // Check whether the run has stopped
+    bool done() const { return m_progress->status() != PricingStatus::Running; }
+
+    // Request the run to stop, Get then returns the estimate of the batches finished before
+    void Cancel() const { m_progress->Cancel(); }
+
+    // Wait until the run stops, at most seconds; true when it has stopped
+    bool WaitFor(const double& seconds) const { return m_progress->WaitFor(seconds); }
+
+    // Wait for the final estimate, rethrowing the exception of a failed run
+    MCResult Get() const { return m_progress->future().get(); }
+
+    // Get the future of the final estimate, to compose with other futures
+    const std::shared_future<MCResult>& future() const { return m_progress->future(); }
+};
+
+// End of the conditional inclusion of the header file
+#endif
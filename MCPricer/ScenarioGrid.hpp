@@ -0,0 +1,38 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// ScenarioGrid.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the scenario grids of the risk engine and the prices under every scenario
+
+// If SCENARIOGRID_HPP is not defined
+#ifndef SCENARIOGRID_HPP
+// Define SCENARIOGRID_HPP
+#define SCENARIOGRID_HPP
+
+#include <vector>
+#include "MCResult.hpp"
+
+// Define ScenarioGrid struct, the spot, volatility and rate shocks of a risk run
+// Every combination of the three shocks is a scenario, an empty list of shocks stands for no shock
+struct ScenarioGrid
+{
+    // Relative spot shocks, the shocked spot is S * (1 + shock)
+    std::vector<double> spot_shocks;
+    // Absolute volatility shifts, the shocked volatility is sigma + shift
+    std::vector<double> vol_shifts;
+    // Absolute rate shifts, the shocked rate is r + shift
+    std::vector<double> rate_shifts;
+};
+
+// Define ScenarioResult struct, the prices of a book of options under one scenario
+struct ScenarioResult
+{
+    // Shocked spot, volatility and rate of the scenario
+    double S;
+    double sigma;
+    double r;
+    // Price, standard error, simulations and elapsed time of every option of the book
+    std::vector<MCResult> prices;
+};
+
+// End of the conditional inclusion of the header file
+#endif
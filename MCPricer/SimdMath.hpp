@@ -0,0 +1,554 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// SimdMath.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the vector math functions (Philox, normal generators, exp, log, sin/cos, normal CDF) generic over the vector traits
+
+// If SIMDMATH_HPP is not defined
+#ifndef SIMDMATH_HPP
+// Define SIMDMATH_HPP
+#define SIMDMATH_HPP
+
+#include <cstdint>
+#include "NormalGenerators.hpp"
+#include "SimdVector.hpp"
+
+// All functions are templates over the traits of SimdVector.hpp, so every instruction set runs the same algorithm.
+// The polynomials use exact Taylor coefficients on reduced ranges, with truncation errors below 1e-16.
+
+// Define SimdMath class, a namespace of static vector functions
+template <class V>
+struct SimdMath
+{
+    typedef typename V::Real Real;
+    typedef typename V::Int Int;
+    typedef typename V::Mask Mask;
+
+    // Apply the ten Philox4x32 rounds to counters held as 32-bit values in 64-bit lanes (matches Philox::Generate)
+    static void Philox(Int x[4], std::uint32_t key0, std::uint32_t key1)
+    {
+        const Int mask = V::SetInt(0xFFFFFFFFull);
+        const Int m0 = V::SetInt(0xD2511F53u);
+        const Int m1 = V::SetInt(0xCD9E8D57u);
+
+        for (int round = 0; round < 10; ++round)
+        {
+            const Int p0 = V::MulLow32(m0, x[0]);
+            const Int p1 = V::MulLow32(m1, x[2]);
+
+            x[0] = V::Xor(V::Xor(V::template ShiftRight<32>(p1), x[1]), V::SetInt(key0));
+            x[1] = V::And(p1, mask);
+            x[2] = V::Xor(V::Xor(V::template ShiftRight<32>(p0), x[3]), V::SetInt(key1));
+            x[3] = V::And(p0, mask);
+
+            key0 += 0x9E3779B9u;
+            key1 += 0xBB67AE85u;
+        }
+    }
+
+    // Map two 32-bit words to a double in [0, 1) with 52 random bits (matches Philox::Uniform)
+    static Real Uniform(const Int& hi, const Int& lo)
+    {
+        const Int bits = V::Or(V::SetInt(0x3FF0000000000000ull),
+            V::Or(V::template ShiftLeft<20>(hi), V::template ShiftRight<12>(lo)));
+        return V::Sub(V::CastToReal(bits), V::Set(1.0));
+    }
+
+    // Natural logarithm of positive normal numbers, log(m * 2^e) = e * log(2) + 2 * atanh((m - 1) / (m + 1))
+    static Real Log(const Real& x)
+    {
+        const Int bits = V::CastToInt(x);
+
+        // Split x in mantissa m in [1, 2) and exponent e (converted exactly through the 2^52 trick)
+        Real m = V::CastToReal(V::Or(V::And(bits, V::SetInt(0x000FFFFFFFFFFFFFull)), V::SetInt(0x3FF0000000000000ull)));
+        Real e = V::Sub(V::CastToReal(V::Or(V::template ShiftRight<52>(bits), V::SetInt(0x4330000000000000ull))),
+            V::Set(4503599627370496.0 + 1023.0));
+
+        // Move m to [sqrt(1/2), sqrt(2)) so that |s| <= 0.1716
+        const Mask big = V::Less(V::Set(1.4142135623730951), m);
+        m = V::Select(big, V::Mul(m, V::Set(0.5)), m);
+        e = V::Select(big, V::Add(e, V::Set(1.0)), e);
+
+        const Real s = V::Div(V::Sub(m, V::Set(1.0)), V::Add(m, V::Set(1.0)));
+        const Real s2 = V::Mul(s, s);
+
+        // Series of atanh(s) / s up to s^20
+        Real p = V::Set(1.0 / 21);
+        p = V::MulAdd(p, s2, V::Set(1.0 / 19));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 17));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 15));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 13));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 11));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 9));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 7));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 5));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 3));
+        p = V::MulAdd(p, s2, V::Set(1.0));
+
+        // log(2) split in a head with trailing zeros and a tail, so e * head is exact
+        const Real log_m = V::Mul(V::Add(s, s), p);
+        return V::MulAdd(e, V::Set(0.693147180369123816490), V::MulAdd(e, V::Set(1.90821492927058770002e-10), log_m));
+    }
+
+    // Exponential, exp(x) = 2^n * exp(t) with |t| <= log(2) / 2, clamped to the normal range
+    static Real Exp(const Real& x)
+    {
+        const Real y = V::Min(V::Max(x, V::Set(-708.0)), V::Set(709.0));
+        const Real n = V::Floor(V::MulAdd(y, V::Set(1.4426950408889634), V::Set(0.5)));
+        const Real t = V::MulAdd(n, V::Set(-1.90821492927058770002e-10), V::MulAdd(n, V::Set(-0.693147180369123816490), y));
+
+        // Taylor series of exp(t) up to t^13
+        Real p = V::Set(1.0 / 6227020800.0);
+        p = V::MulAdd(p, t, V::Set(1.0 / 479001600.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 39916800.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 3628800.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 362880.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 40320.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 5040.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 720.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 120.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 24.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 6.0));
+        p = V::MulAdd(p, t, V::Set(0.5));
+        p = V::MulAdd(p, t, V::Set(1.0));
+        p = V::MulAdd(p, t, V::Set(1.0));
+
+        // Build 2^n from the integer bits of n + 1.5 * 2^52
+        const Int k = V::SubInt(V::CastToInt(V::Add(n, V::Set(6755399441055744.0))), V::SetInt(0x4338000000000000ull));
+        const Real scale = V::CastToReal(V::template ShiftLeft<52>(V::AddInt(k, V::SetInt(1023))));
+        return V::Mul(p, scale);
+    }
+
+    // Power of positive numbers through exp(b * log(x))
+    static Real Pow(const Real& x, const Real& b)
+    {
+        return Exp(V::Mul(b, Log(x)));
+    }
+
+    // Sine and cosine of 2 * pi * u for u in [0, 1), reduced to a quadrant angle in [0, pi / 2)
+    static void SinCos2Pi(const Real& u, Real& sin_out, Real& cos_out)
+    {
+        const Real q = V::Mul(u, V::Set(4.0));
+        const Real k = V::Floor(q);
+        const Real a = V::Mul(V::Sub(q, k), V::Set(1.5707963267948966));
+        const Real minus_a2 = V::Sub(V::Set(0.0), V::Mul(a, a));
+
+        // Taylor series of sin(a) / a up to a^20
+        Real s = V::Set(1.0 / 51090942171709440000.0);
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 121645100408832000.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 355687428096000.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 1307674368000.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 6227020800.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 39916800.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 362880.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 5040.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 120.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 6.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0));
+        s = V::Mul(s, a);
+
+        // Taylor series of cos(a) up to a^22
+        Real c = V::Set(1.0 / 1124000727777607680000.0);
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 2432902008176640000.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 6402373705728000.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 20922789888000.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 87178291200.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 479001600.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 3628800.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 40320.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 720.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 24.0));
+        c = V::MulAdd(c, minus_a2, V::Set(0.5));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0));
+
+        // Rotate by k quarter turns: odd quadrants swap sine and cosine, the signs follow the quadrant
+        const Mask odd = V::MaskOr(V::Equal(k, V::Set(1.0)), V::Equal(k, V::Set(3.0)));
+        const Mask cos_negative = V::MaskOr(V::Equal(k, V::Set(1.0)), V::Equal(k, V::Set(2.0)));
+        const Mask sin_negative = V::Less(V::Set(1.5), k);
+
+        const Real cos_abs = V::Select(odd, s, c);
+        const Real sin_abs = V::Select(odd, c, s);
+
+        cos_out = V::Select(cos_negative, V::Sub(V::Set(0.0), cos_abs), cos_abs);
+        sin_out = V::Select(sin_negative, V::Sub(V::Set(0.0), sin_abs), sin_abs);
+    }
+
+    // Standard normal density, exp(-x^2 / 2) / sqrt(2 * pi)
+    static Real NormalPdf(const Real& x)
+    {
+        return V::Mul(V::Set(0.39894228040143268), Exp(V::Mul(V::Set(-0.5), V::Mul(x, x))));
+    }
+
+    // Standard normal cumulative distribution, Hart's double precision algorithm 5666 as given by West (2005):
+    // a rational function times exp(-x^2 / 2) for |x| < 7.07 and a continued fraction beyond, both evaluated and blended.
+    // Measured against Boost: absolute error below 3e-16 over the whole line; relative error of the lower tail
+    // below 2e-14 down to x = -3, 1e-9 down to -6 and 1e-8 down to -37, where exp(-x^2 / 2) leaves the normal range
+    static Real NormalCdf(const Real& x)
+    {
+        const Real a = V::Max(x, V::Sub(V::Set(0.0), x));
+        const Real e = Exp(V::Mul(V::Set(-0.5), V::Mul(a, a)));
+
+        Real num = V::Set(3.52624965998911e-02);
+        num = V::MulAdd(num, a, V::Set(0.700383064443688));
+        num = V::MulAdd(num, a, V::Set(6.37396220353165));
+        num = V::MulAdd(num, a, V::Set(33.912866078383));
+        num = V::MulAdd(num, a, V::Set(112.079291497871));
+        num = V::MulAdd(num, a, V::Set(221.213596169931));
+        num = V::MulAdd(num, a, V::Set(220.206867912376));
+
+        Real den = V::Set(8.83883476483184e-02);
+        den = V::MulAdd(den, a, V::Set(1.75566716318264));
+        den = V::MulAdd(den, a, V::Set(16.064177579207));
+        den = V::MulAdd(den, a, V::Set(86.7807322029461));
+        den = V::MulAdd(den, a, V::Set(296.564248779674));
+        den = V::MulAdd(den, a, V::Set(637.333633378831));
+        den = V::MulAdd(den, a, V::Set(793.826512519948));
+        den = V::MulAdd(den, a, V::Set(440.413735824752));
+
+        // Continued fraction of the tail, 1 / (a + 1 / (a + 2 / (a + 3 / (a + 4 / (a + 0.65)))))
+        Real fraction = V::Add(a, V::Set(0.65));
+        fraction = V::Add(a, V::Div(V::Set(4.0), fraction));
+        fraction = V::Add(a, V::Div(V::Set(3.0), fraction));
+        fraction = V::Add(a, V::Div(V::Set(2.0), fraction));
+        fraction = V::Add(a, V::Div(V::Set(1.0), fraction));
+
+        const Real near = V::Div(V::Mul(e, num), den);
+        const Real far = V::Div(e, V::Mul(fraction, V::Set(2.506628274631)));
+        const Real tail = V::Select(V::Less(a, V::Set(7.07106781186547)), near, far);
+
+        // The tail is N(-|x|), reflect it for positive x
+        return V::Select(V::Less(V::Set(0.0), x), V::Sub(V::Set(1.0), tail), tail);
+    }
+
+    // Draw two vectors of standard normals for counters (path, index, stream), one path per lane (matches Philox::NormalPair)
+    static void NormalPair(const std::uint32_t& key0, const std::uint32_t& key1, const Int& path,
+        const std::uint32_t& index, const std::uint32_t& stream, Real& z0, Real& z1)
+    {
+        Int x[4] = { V::And(path, V::SetInt(0xFFFFFFFFull)), V::template ShiftRight<32>(path),
+            V::SetInt(index), V::SetInt(stream) };
+        Philox(x, key0, key1);
+
+        const Real u0 = V::Sub(V::Set(1.0), Uniform(x[0], x[1]));
+        const Real u1 = Uniform(x[2], x[3]);
+
+        const Real radius = V::Sqrt(V::Mul(V::Set(-2.0), Log(u0)));
+
+        Real sin_angle, cos_angle;
+        SinCos2Pi(u1, sin_angle, cos_angle);
+
+        z0 = V::Mul(radius, cos_angle);
+        z1 = V::Mul(radius, sin_angle);
+    }
+
+    // Inverse standard normal CDF of p in (0, 1), Acklam's rational approximations (matches InverseCumulativeNormal
+    // up to rounding): the central region and the tail of min(p, 1 - p) are both evaluated and blended
+    static Real InverseNormal(const Real& p)
+    {
+        const Mask upper = V::Less(V::Set(0.5), p);
+        const Real t = V::Select(upper, V::Sub(V::Set(1.0), p), p);
+
+        // Lower tail, reflected for the upper one
+        const Real q = V::Sqrt(V::Mul(V::Set(-2.0), Log(t)));
+
+        Real c = V::Set(-7.784894002430293e-03);
+        c = V::MulAdd(c, q, V::Set(-3.223964580411365e-01));
+        c = V::MulAdd(c, q, V::Set(-2.400758277161838e+00));
+        c = V::MulAdd(c, q, V::Set(-2.549732539343734e+00));
+        c = V::MulAdd(c, q, V::Set(4.374664141464968e+00));
+        c = V::MulAdd(c, q, V::Set(2.938163982698783e+00));
+
+        Real d = V::Set(7.784695709041462e-03);
+        d = V::MulAdd(d, q, V::Set(3.224671290700398e-01));
+        d = V::MulAdd(d, q, V::Set(2.445134137142996e+00));
+        d = V::MulAdd(d, q, V::Set(3.754408661907416e+00));
+        d = V::MulAdd(d, q, V::Set(1.0));
+
+        const Real lower_tail = V::Div(c, d);
+        const Real tail = V::Select(upper, V::Sub(V::Set(0.0), lower_tail), lower_tail);
+
+        // Central region
+        const Real s = V::Sub(p, V::Set(0.5));
+        const Real r = V::Mul(s, s);
+
+        Real a = V::Set(-3.969683028665376e+01);
+        a = V::MulAdd(a, r, V::Set(2.209460984245205e+02));
+        a = V::MulAdd(a, r, V::Set(-2.759285104469687e+02));
+        a = V::MulAdd(a, r, V::Set(1.383577518672690e+02));
+        a = V::MulAdd(a, r, V::Set(-3.066479806614716e+01));
+        a = V::MulAdd(a, r, V::Set(2.506628277459239e+00));
+
+        Real b = V::Set(-5.447609879822406e+01);
+        b = V::MulAdd(b, r, V::Set(1.615858368580409e+02));
+        b = V::MulAdd(b, r, V::Set(-1.556989798598866e+02));
+        b = V::MulAdd(b, r, V::Set(6.680131188771972e+01));
+        b = V::MulAdd(b, r, V::Set(-1.328068155288572e+01));
+        b = V::MulAdd(b, r, V::Set(1.0));
+
+        const Real central = V::Div(V::Mul(a, s), b);
+        return V::Select(V::Less(t, V::Set(0.02425)), tail, central);
+    }
+
+    // Resolve the lanes of a ziggurat draw x = u * x[i] outside the core of their layer with two uniforms u1 and u2
+    // of the counter (path, index, slow_stream): the other layers keep x when u1 puts it under the density in the
+    // wedge, and when some lane is left the base layer maps u1 to the tail beyond r by the inverse CDF of the tail,
+    // the rejected wedges taking |N^-1(u2)|, which is what the restart of the ziggurat would return
+    static Real ZigguratSlow(const ZigguratTable& table, const std::uint32_t& key0, const std::uint32_t& key1,
+        const Int& path, const std::uint32_t& index, const std::uint32_t& slow_stream, const Real& layer,
+        const Mask& slow, const Real& x)
+    {
+        Int w[4] = { V::And(path, V::SetInt(0xFFFFFFFFull)), V::template ShiftRight<32>(path),
+            V::SetInt(index), V::SetInt(slow_stream) };
+        Philox(w, key0, key1);
+
+        // Uniforms in (0, 1)
+        const Real u1 = V::Add(Uniform(w[0], w[1]), V::Set(1.0 / 9007199254740992.0));
+
+        const Real f_outer = V::Gather(table.f, layer);
+        const Real f_inner = V::Gather(table.f, V::Add(layer, V::Set(1.0)));
+        const Real y = V::MulAdd(u1, V::Sub(f_inner, f_outer), f_outer);
+        const Real density = Exp(V::Mul(V::Set(-0.5), V::Mul(x, x)));
+
+        // Tail and rejected wedge lanes, about 1 in 3000 lanes
+        const Mask base = V::Equal(layer, V::Set(0.0));
+        const Mask rejected = V::MaskAnd(slow, V::MaskOr(base, V::MaskOr(V::Less(density, y), V::Equal(density, y))));
+        if (!V::Any(rejected))
+            return x;
+
+        const Real u2 = V::Add(Uniform(w[2], w[3]), V::Set(1.0 / 9007199254740992.0));
+
+        // One inverse CDF serves both, N^-1(u1 * N(-r)) on the base layer and N^-1(u2) on the others
+        const Real inverse = InverseNormal(V::Select(base, V::Mul(u1, V::Set(table.tail)), u2));
+        return V::Select(rejected, V::Max(inverse, V::Sub(V::Set(0.0), inverse)), x);
+    }
+
+    // Ziggurat normal of the Philox words (hi, lo) of a lane: layer i from bits 0 to 7 of hi, the sign from bit 8
+    // and a uniform u from the last 20 bits of hi and the 32 of lo, u * x[i] when u < x[i + 1] / x[i], about 99.3%
+    // of the lanes; the others are resolved by ZigguratSlow
+    static Real ZigguratNormal(const ZigguratTable& table, const std::uint32_t& key0, const std::uint32_t& key1,
+        const Int& path, const std::uint32_t& index, const std::uint32_t& slow_stream, const Int& hi, const Int& lo)
+    {
+        // Layer index converted exactly through the 2^52 trick
+        const Real layer = V::Sub(V::CastToReal(V::Or(V::And(hi, V::SetInt(0xFF)), V::SetInt(0x4330000000000000ull))),
+            V::Set(4503599627370496.0));
+        const Real u = Uniform(lo, hi);
+
+        const Real ratio = V::Gather(table.ratio, layer);
+        Real x = V::Mul(u, V::Gather(table.x, layer));
+
+        const Mask slow = V::MaskOr(V::Less(ratio, u), V::Equal(ratio, u));
+        if (V::Any(slow))
+            x = ZigguratSlow(table, key0, key1, path, index, slow_stream, layer, slow, x);
+
+        // Move bit 8 of hi to the sign bit
+        return V::CastToReal(V::Xor(V::CastToInt(x), V::template ShiftLeft<55>(V::And(hi, V::SetInt(0x100)))));
+    }
+
+    // Draw two vectors of standard normals for counters (path, index, stream) with a generator, one path per lane
+    // Box - Muller matches NormalPair; the ziggurat resolves the draws outside the core of its layers on the streams
+    // stream + 2^31 (z0) and stream + 3 * 2^30 (z1), which the callers leave free
+    static void Normals(const NormalGenerator& generator, const std::uint32_t& key0, const std::uint32_t& key1,
+        const Int& path, const std::uint32_t& index, const std::uint32_t& stream, Real& z0, Real& z1)
+    {
+        if (generator == NormalGenerator::BoxMuller)
+        {
+            NormalPair(key0, key1, path, index, stream, z0, z1);
+            return;
+        }
+
+        Int x[4] = { V::And(path, V::SetInt(0xFFFFFFFFull)), V::template ShiftRight<32>(path),
+            V::SetInt(index), V::SetInt(stream) };
+        Philox(x, key0, key1);
+
+        if (generator == NormalGenerator::InverseCdf)
+        {
+            // Uniforms moved to (0, 1) by half a step of 2^-52
+            z0 = InverseNormal(V::Add(Uniform(x[0], x[1]), V::Set(1.0 / 9007199254740992.0)));
+            z1 = InverseNormal(V::Add(Uniform(x[2], x[3]), V::Set(1.0 / 9007199254740992.0)));
+            return;
+        }
+
+        const ZigguratTable& table = Ziggurat();
+        z0 = ZigguratNormal(table, key0, key1, path, index, stream + 0x80000000u, x[0], x[1]);
+        z1 = ZigguratNormal(table, key0, key1, path, index, stream + 0xC0000000u, x[2], x[3]);
+    }
+};
+
+// Define SimdMathSingle class, the single precision functions of the float traits, one 32-bit Philox word per lane
+// The polynomials are truncated where their error falls below the float rounding, about 6e-8 relative
+template <class V>
+struct SimdMathSingle
+{
+    typedef typename V::Real Real;
+    typedef typename V::Int Int;
+    typedef typename V::Mask Mask;
+
+    // Apply the ten Philox4x32 rounds to counters of 32-bit lanes (matches Philox::Generate)
+    static void Philox(Int x[4], std::uint32_t key0, std::uint32_t key1)
+    {
+        const Int m0 = V::SetInt(0xD2511F53u);
+        const Int m1 = V::SetInt(0xCD9E8D57u);
+
+        for (int round = 0; round < 10; ++round)
+        {
+            Int hi0, lo0, hi1, lo1;
+            V::MulWide32(m0, x[0], hi0, lo0);
+            V::MulWide32(m1, x[2], hi1, lo1);
+
+            x[0] = V::Xor(V::Xor(hi1, x[1]), V::SetInt(key0));
+            x[1] = lo1;
+            x[2] = V::Xor(V::Xor(hi0, x[3]), V::SetInt(key1));
+            x[3] = lo0;
+
+            key0 += 0x9E3779B9u;
+            key1 += 0xBB67AE85u;
+        }
+    }
+
+    // Natural logarithm of positive normal numbers, log(m * 2^e) = e * log(2) + 2 * atanh((m - 1) / (m + 1))
+    static Real Log(const Real& x)
+    {
+        const Int bits = V::CastToInt(x);
+
+        // Split x in mantissa m in [1, 2) and exponent e
+        Real m = V::CastToReal(V::Or(V::And(bits, V::SetInt(0x007FFFFFu)), V::SetInt(0x3F800000u)));
+        Real e = V::Sub(V::ConvertToReal(V::template ShiftRight<23>(bits)), V::Set(127.0));
+
+        // Move m to [sqrt(1/2), sqrt(2)) so that |s| <= 0.1716
+        const Mask big = V::Less(V::Set(1.4142135623730951), m);
+        m = V::Select(big, V::Mul(m, V::Set(0.5)), m);
+        e = V::Select(big, V::Add(e, V::Set(1.0)), e);
+
+        const Real s = V::Div(V::Sub(m, V::Set(1.0)), V::Add(m, V::Set(1.0)));
+        const Real s2 = V::Mul(s, s);
+
+        // Series of atanh(s) / s up to s^8
+        Real p = V::Set(1.0 / 9);
+        p = V::MulAdd(p, s2, V::Set(1.0 / 7));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 5));
+        p = V::MulAdd(p, s2, V::Set(1.0 / 3));
+        p = V::MulAdd(p, s2, V::Set(1.0));
+
+        // log(2) split in a head of 16 bits and a tail, so e * head is exact
+        const Real log_m = V::Mul(V::Add(s, s), p);
+        return V::MulAdd(e, V::Set(0.693145751953125), V::MulAdd(e, V::Set(1.428606765330187e-06), log_m));
+    }
+
+    // Exponential, exp(x) = 2^n * exp(t) with |t| <= log(2) / 2, clamped to the normal range
+    static Real Exp(const Real& x)
+    {
+        const Real y = V::Min(V::Max(x, V::Set(-87.0)), V::Set(88.0));
+
+        // Round y / log(2) to the nearest integer n by adding 1.5 * 2^23, which leaves n in the low mantissa bits
+        const Real shifted = V::MulAdd(y, V::Set(1.4426950408889634), V::Set(12582912.0));
+        const Real n = V::Sub(shifted, V::Set(12582912.0));
+        const Real t = V::MulAdd(n, V::Set(-1.428606765330187e-06), V::MulAdd(n, V::Set(-0.693145751953125), y));
+
+        // Taylor series of exp(t) up to t^7
+        Real p = V::Set(1.0 / 5040.0);
+        p = V::MulAdd(p, t, V::Set(1.0 / 720.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 120.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 24.0));
+        p = V::MulAdd(p, t, V::Set(1.0 / 6.0));
+        p = V::MulAdd(p, t, V::Set(0.5));
+        p = V::MulAdd(p, t, V::Set(1.0));
+        p = V::MulAdd(p, t, V::Set(1.0));
+
+        // Build 2^n from the integer bits of n + 1.5 * 2^23
+        const Int k = V::SubInt(V::CastToInt(shifted), V::SetInt(0x4B400000u));
+        const Real scale = V::CastToReal(V::template ShiftLeft<23>(V::AddInt(k, V::SetInt(127))));
+        return V::Mul(p, scale);
+    }
+
+    // Power of positive numbers through exp(b * log(x))
+    static Real Pow(const Real& x, const Real& b)
+    {
+        return Exp(V::Mul(b, Log(x)));
+    }
+
+    // Sine and cosine of 2 * pi * w / 2^32 from the top 24 bits of the words w: the top two bits select the quadrant
+    // and the next 22 the angle a in [0, pi / 2) within it
+    static void SinCos2Pi(const Int& w, Real& sin_out, Real& cos_out)
+    {
+        const Real a = V::Mul(V::ConvertToReal(V::And(V::template ShiftRight<8>(w), V::SetInt(0x003FFFFFu))),
+            V::Set(1.5707963267948966 / 4194304.0));
+        const Real minus_a2 = V::Sub(V::Set(0.0), V::Mul(a, a));
+
+        // Taylor series of sin(a) / a up to a^12
+        Real s = V::Set(1.0 / 6227020800.0);
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 39916800.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 362880.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 5040.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 120.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0 / 6.0));
+        s = V::MulAdd(s, minus_a2, V::Set(1.0));
+        s = V::Mul(s, a);
+
+        // Taylor series of cos(a) up to a^12
+        Real c = V::Set(1.0 / 479001600.0);
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 3628800.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 40320.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 720.0));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0 / 24.0));
+        c = V::MulAdd(c, minus_a2, V::Set(0.5));
+        c = V::MulAdd(c, minus_a2, V::Set(1.0));
+
+        // Rotate by the quadrant k on the bits: odd quadrants swap sine and cosine, the sine is negative
+        // in quadrants 2 and 3 and the cosine in quadrants 1 and 2
+        const Int k = V::template ShiftRight<30>(w);
+        const Int odd = V::SubInt(V::SetInt(0), V::And(k, V::SetInt(1)));
+        const Int s_bits = V::CastToInt(s);
+        const Int c_bits = V::CastToInt(c);
+        const Int swap = V::And(V::Xor(s_bits, c_bits), odd);
+
+        const Int sin_sign = V::And(w, V::SetInt(0x80000000u));
+        const Int cos_sign = V::template ShiftLeft<30>(V::And(V::AddInt(k, V::SetInt(1)), V::SetInt(2)));
+
+        sin_out = V::CastToReal(V::Xor(V::Xor(s_bits, swap), sin_sign));
+        cos_out = V::CastToReal(V::Xor(V::Xor(c_bits, swap), cos_sign));
+    }
+
+    // Draw four vectors of standard normals for counters (path, index, stream), one 32-bit path counter per lane:
+    // two Box - Muller pairs, each with the radius from one Philox word and the angle from the next
+    // The radius word maps to (0, 1] in steps of 2^-31, so the normals are bounded by 6.66 in absolute value
+    static void NormalQuad(const std::uint32_t& key0, const std::uint32_t& key1, const Int& path,
+        const std::uint32_t& index, const std::uint32_t& stream, Real z[4])
+    {
+        Int x[4] = { path, V::SetInt(0), V::SetInt(index), V::SetInt(stream) };
+        Philox(x, key0, key1);
+
+        for (int pair = 0; pair < 2; ++pair)
+        {
+            const Real u = V::Mul(V::Add(V::ConvertToReal(V::template ShiftRight<1>(x[2 * pair])), V::Set(0.5)),
+                V::Set(1.0 / 2147483648.0));
+            const Real radius = V::Sqrt(V::Mul(V::Set(-2.0), Log(u)));
+
+            Real sin_angle, cos_angle;
+            SinCos2Pi(x[2 * pair + 1], sin_angle, cos_angle);
+
+            z[2 * pair] = V::Mul(radius, cos_angle);
+            z[2 * pair + 1] = V::Mul(radius, sin_angle);
+        }
+    }
+};
+
+// The float traits use the single precision functions
+template <>
+struct SimdMath<ScalarFloatVector> : SimdMathSingle<ScalarFloatVector>
+{
+};
+
+#if defined(MCPRICER_SIMD_AVX2)
+template <>
+struct SimdMath<Avx2FloatVector> : SimdMathSingle<Avx2FloatVector>
+{
+};
+#endif
+
+#if defined(MCPRICER_SIMD_AVX512)
+template <>
+struct SimdMath<Avx512FloatVector> : SimdMathSingle<Avx512FloatVector>
+{
+};
+#endif
+
+// End of the conditional inclusion of the header file
+#endif
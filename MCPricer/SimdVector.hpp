@@ -0,0 +1,367 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// SimdVector.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the vector traits (scalar, AVX2 and AVX-512) used by the generic SIMD kernels
+
+// If SIMDVECTOR_HPP is not defined
+#ifndef SIMDVECTOR_HPP
+// Define SIMDVECTOR_HPP
+#define SIMDVECTOR_HPP
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Every traits class exposes the same static interface over a lane type:
+// Real holds doubles, Int holds 64-bit integers (used for bit manipulation and for 32-bit Philox words)
+// and Mask holds the result of a comparison.
+// The float traits (ScalarFloatVector, Avx2FloatVector, Avx512FloatVector) pack twice the lanes per register:
+// Real holds floats and Int 32-bit integers, one Philox word per lane, and Element names the lane type in memory.
+// The AVX traits are only visible in the translation units compiled for that instruction set,
+// selected by defining MCPRICER_SIMD_AVX2 or MCPRICER_SIMD_AVX512 before including this header.
+
+// Define ScalarVector traits, one lane in plain C++
+struct ScalarVector
+{
+    typedef double Real;
+    typedef std::uint64_t Int;
+    typedef bool Mask;
+    typedef double Element;
+
+    static const int width = 1;
+    // Smallest positive normal lane value
+    static constexpr double min_normal = DBL_MIN;
+
+    // Real lanes
+    static Real Set(const double& x) { return x; }
+    static Real Load(const double* p) { return *p; }
+    static void Store(double* p, const Real& x) { *p = x; }
+    static Real Add(const Real& a, const Real& b) { return a + b; }
+    static Real Sub(const Real& a, const Real& b) { return a - b; }
+    static Real Mul(const Real& a, const Real& b) { return a * b; }
+    static Real Div(const Real& a, const Real& b) { return a / b; }
+    static Real MulAdd(const Real& a, const Real& b, const Real& c) { return a * b + c; }
+    static Real Sqrt(const Real& a) { return std::sqrt(a); }
+    static Real Max(const Real& a, const Real& b) { return a > b ? a : b; }
+    static Real Min(const Real& a, const Real& b) { return a < b ? a : b; }
+    static Real Floor(const Real& a) { return std::floor(a); }
+    // Load base[index] in every lane, index holding non-negative whole numbers below 2^31
+    static Real Gather(const double* base, const Real& index) { return base[static_cast<std::int32_t>(index)]; }
+
+    // Comparisons and blends
+    static Mask Less(const Real& a, const Real& b) { return a < b; }
+    static Mask Equal(const Real& a, const Real& b) { return a == b; }
+    static Mask MaskOr(const Mask& a, const Mask& b) { return a || b; }
+    static Mask MaskAnd(const Mask& a, const Mask& b) { return a && b; }
+    static bool Any(const Mask& m) { return m; }
+    static Real Select(const Mask& m, const Real& a, const Real& b) { return m ? a : b; }
+
+    // Int lanes
+    static Int SetInt(const std::uint64_t& x) { return x; }
+    static Int Sequence(const std::uint64_t& first) { return first; }
+    static Int AddInt(const Int& a, const Int& b) { return a + b; }
+    static Int SubInt(const Int& a, const Int& b) { return a - b; }
+    static Int And(const Int& a, const Int& b) { return a & b; }
+    static Int Or(const Int& a, const Int& b) { return a | b; }
+    static Int Xor(const Int& a, const Int& b) { return a ^ b; }
+    template <int n> static Int ShiftLeft(const Int& a) { return a << n; }
+    template <int n> static Int ShiftRight(const Int& a) { return a >> n; }
+    // Full 64-bit product of the low 32 bits of every lane
+    static Int MulLow32(const Int& a, const Int& b) { return (a & 0xFFFFFFFFull) * (b & 0xFFFFFFFFull); }
+
+    // Bit reinterpretation
+    static Real CastToReal(const Int& a) { Real x; std::memcpy(&x, &a, sizeof(x)); return x; }
+    static Int CastToInt(const Real& a) { Int x; std::memcpy(&x, &a, sizeof(x)); return x; }
+};
+
+// Define ScalarFloatVector traits, one float lane in plain C++
+struct ScalarFloatVector
+{
+    typedef float Real;
+    typedef std::uint32_t Int;
+    typedef bool Mask;
+    typedef float Element;
+
+    static const int width = 1;
+    static constexpr float min_normal = FLT_MIN;
+
+    // Real lanes
+    static Real Set(const double& x) { return static_cast<float>(x); }
+    static Real Load(const float* p) { return *p; }
+    static void Store(float* p, const Real& x) { *p = x; }
+    static Real Add(const Real& a, const Real& b) { return a + b; }
+    static Real Sub(const Real& a, const Real& b) { return a - b; }
+    static Real Mul(const Real& a, const Real& b) { return a * b; }
+    static Real Div(const Real& a, const Real& b) { return a / b; }
+    static Real MulAdd(const Real& a, const Real& b, const Real& c) { return a * b + c; }
+    static Real Sqrt(const Real& a) { return std::sqrt(a); }
+    static Real Max(const Real& a, const Real& b) { return a > b ? a : b; }
+    static Real Min(const Real& a, const Real& b) { return a < b ? a : b; }
+
+    // Comparisons and blends
+    static Mask Less(const Real& a, const Real& b) { return a < b; }
+    static bool Any(const Mask& m) { return m; }
+    static Real Select(const Mask& m, const Real& a, const Real& b) { return m ? a : b; }
+
+    // Int lanes
+    static Int SetInt(const std::uint32_t& x) { return x; }
+    static Int Sequence(const std::uint32_t& first) { return first; }
+    static Int AddInt(const Int& a, const Int& b) { return a + b; }
+    static Int SubInt(const Int& a, const Int& b) { return a - b; }
+    static Int And(const Int& a, const Int& b) { return a & b; }
+    static Int Or(const Int& a, const Int& b) { return a | b; }
+    static Int Xor(const Int& a, const Int& b) { return a ^ b; }
+    template <int n> static Int ShiftLeft(const Int& a) { return a << n; }
+    template <int n> static Int ShiftRight(const Int& a) { return a >> n; }
+    // High and low words of the full 64-bit product of every lane
+    static void MulWide32(const Int& a, const Int& b, Int& hi, Int& lo)
+    {
+        const std::uint64_t product = static_cast<std::uint64_t>(a) * b;
+        hi = static_cast<Int>(product >> 32);
+        lo = static_cast<Int>(product);
+    }
+    // Value of lanes holding integers below 2^31, rounded to float
+    static Real ConvertToReal(const Int& a) { return static_cast<float>(static_cast<std::int32_t>(a)); }
+
+    // Bit reinterpretation
+    static Real CastToReal(const Int& a) { Real x; std::memcpy(&x, &a, sizeof(x)); return x; }
+    static Int CastToInt(const Real& a) { Int x; std::memcpy(&x, &a, sizeof(x)); return x; }
+};
+
+#if defined(MCPRICER_SIMD_AVX2) || defined(MCPRICER_SIMD_AVX512)
+#include <immintrin.h>
+#endif
+
+#if defined(MCPRICER_SIMD_AVX2)
+// Define Avx2Vector traits, four double lanes
+struct Avx2Vector
+{
+    typedef __m256d Real;
+    typedef __m256i Int;
+    typedef __m256d Mask;
+    typedef double Element;
+
+    static const int width = 4;
+    static constexpr double min_normal = DBL_MIN;
+
+    // Real lanes
+    static Real Set(const double& x) { return _mm256_set1_pd(x); }
+    static Real Load(const double* p) { return _mm256_loadu_pd(p); }
+    static void Store(double* p, const Real& x) { _mm256_storeu_pd(p, x); }
+    static Real Add(const Real& a, const Real& b) { return _mm256_add_pd(a, b); }
+    static Real Sub(const Real& a, const Real& b) { return _mm256_sub_pd(a, b); }
+    static Real Mul(const Real& a, const Real& b) { return _mm256_mul_pd(a, b); }
+    static Real Div(const Real& a, const Real& b) { return _mm256_div_pd(a, b); }
+    static Real MulAdd(const Real& a, const Real& b, const Real& c) { return _mm256_fmadd_pd(a, b, c); }
+    static Real Sqrt(const Real& a) { return _mm256_sqrt_pd(a); }
+    static Real Max(const Real& a, const Real& b) { return _mm256_max_pd(a, b); }
+    static Real Min(const Real& a, const Real& b) { return _mm256_min_pd(a, b); }
+    static Real Floor(const Real& a) { return _mm256_floor_pd(a); }
+    static Real Gather(const double* base, const Real& index)
+    {
+        // The masked form with every lane set, the plain one reads an undefined source register
+        return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, _mm256_cvttpd_epi32(index),
+            _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+    }
+
+    // Comparisons and blends
+    static Mask Less(const Real& a, const Real& b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static Mask Equal(const Real& a, const Real& b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static Mask MaskOr(const Mask& a, const Mask& b) { return _mm256_or_pd(a, b); }
+    static Mask MaskAnd(const Mask& a, const Mask& b) { return _mm256_and_pd(a, b); }
+    static bool Any(const Mask& m) { return _mm256_movemask_pd(m) != 0; }
+    static Real Select(const Mask& m, const Real& a, const Real& b) { return _mm256_blendv_pd(b, a, m); }
+
+    // Int lanes
+    static Int SetInt(const std::uint64_t& x) { return _mm256_set1_epi64x(static_cast<long long>(x)); }
+    static Int Sequence(const std::uint64_t& first)
+    {
+        return _mm256_add_epi64(SetInt(first), _mm256_set_epi64x(3, 2, 1, 0));
+    }
+    static Int AddInt(const Int& a, const Int& b) { return _mm256_add_epi64(a, b); }
+    static Int SubInt(const Int& a, const Int& b) { return _mm256_sub_epi64(a, b); }
+    static Int And(const Int& a, const Int& b) { return _mm256_and_si256(a, b); }
+    static Int Or(const Int& a, const Int& b) { return _mm256_or_si256(a, b); }
+    static Int Xor(const Int& a, const Int& b) { return _mm256_xor_si256(a, b); }
+    template <int n> static Int ShiftLeft(const Int& a) { return _mm256_slli_epi64(a, n); }
+    template <int n> static Int ShiftRight(const Int& a) { return _mm256_srli_epi64(a, n); }
+    static Int MulLow32(const Int& a, const Int& b) { return _mm256_mul_epu32(a, b); }
+
+    // Bit reinterpretation
+    static Real CastToReal(const Int& a) { return _mm256_castsi256_pd(a); }
+    static Int CastToInt(const Real& a) { return _mm256_castpd_si256(a); }
+};
+
+// Define Avx2FloatVector traits, eight float lanes
+struct Avx2FloatVector
+{
+    typedef __m256 Real;
+    typedef __m256i Int;
+    typedef __m256 Mask;
+    typedef float Element;
+
+    static const int width = 8;
+    static constexpr float min_normal = FLT_MIN;
+
+    // Real lanes
+    static Real Set(const double& x) { return _mm256_set1_ps(static_cast<float>(x)); }
+    static Real Load(const float* p) { return _mm256_loadu_ps(p); }
+    static void Store(float* p, const Real& x) { _mm256_storeu_ps(p, x); }
+    static Real Add(const Real& a, const Real& b) { return _mm256_add_ps(a, b); }
+    static Real Sub(const Real& a, const Real& b) { return _mm256_sub_ps(a, b); }
+    static Real Mul(const Real& a, const Real& b) { return _mm256_mul_ps(a, b); }
+    static Real Div(const Real& a, const Real& b) { return _mm256_div_ps(a, b); }
+    static Real MulAdd(const Real& a, const Real& b, const Real& c) { return _mm256_fmadd_ps(a, b, c); }
+    static Real Sqrt(const Real& a) { return _mm256_sqrt_ps(a); }
+    static Real Max(const Real& a, const Real& b) { return _mm256_max_ps(a, b); }
+    static Real Min(const Real& a, const Real& b) { return _mm256_min_ps(a, b); }
+
+    // Comparisons and blends
+    static Mask Less(const Real& a, const Real& b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static bool Any(const Mask& m) { return _mm256_movemask_ps(m) != 0; }
+    static Real Select(const Mask& m, const Real& a, const Real& b) { return _mm256_blendv_ps(b, a, m); }
+
+    // Int lanes
+    static Int SetInt(const std::uint32_t& x) { return _mm256_set1_epi32(static_cast<int>(x)); }
+    static Int Sequence(const std::uint32_t& first)
+    {
+        return _mm256_add_epi32(SetInt(first), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    }
+    static Int AddInt(const Int& a, const Int& b) { return _mm256_add_epi32(a, b); }
+    static Int SubInt(const Int& a, const Int& b) { return _mm256_sub_epi32(a, b); }
+    static Int And(const Int& a, const Int& b) { return _mm256_and_si256(a, b); }
+    static Int Or(const Int& a, const Int& b) { return _mm256_or_si256(a, b); }
+    static Int Xor(const Int& a, const Int& b) { return _mm256_xor_si256(a, b); }
+    template <int n> static Int ShiftLeft(const Int& a) { return _mm256_slli_epi32(a, n); }
+    template <int n> static Int ShiftRight(const Int& a) { return _mm256_srli_epi32(a, n); }
+    static void MulWide32(const Int& a, const Int& b, Int& hi, Int& lo)
+    {
+        // Even and odd lanes from two 32 x 32 -> 64-bit products, cheaper than the low product instruction
+        const Int even = _mm256_mul_epu32(a, b);
+        const Int odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+        hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+        lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    }
+    static Real ConvertToReal(const Int& a) { return _mm256_cvtepi32_ps(a); }
+
+    // Bit reinterpretation
+    static Real CastToReal(const Int& a) { return _mm256_castsi256_ps(a); }
+    static Int CastToInt(const Real& a) { return _mm256_castps_si256(a); }
+};
+#endif
+
+#if defined(MCPRICER_SIMD_AVX512)
+// Define Avx512Vector traits, eight double lanes
+struct Avx512Vector
+{
+    typedef __m512d Real;
+    typedef __m512i Int;
+    typedef __mmask8 Mask;
+    typedef double Element;
+
+    static const int width = 8;
+    static constexpr double min_normal = DBL_MIN;
+
+    // Real lanes
+    static Real Set(const double& x) { return _mm512_set1_pd(x); }
+    static Real Load(const double* p) { return _mm512_loadu_pd(p); }
+    static void Store(double* p, const Real& x) { _mm512_storeu_pd(p, x); }
+    static Real Add(const Real& a, const Real& b) { return _mm512_add_pd(a, b); }
+    static Real Sub(const Real& a, const Real& b) { return _mm512_sub_pd(a, b); }
+    static Real Mul(const Real& a, const Real& b) { return _mm512_mul_pd(a, b); }
+    static Real Div(const Real& a, const Real& b) { return _mm512_div_pd(a, b); }
+    static Real MulAdd(const Real& a, const Real& b, const Real& c) { return _mm512_fmadd_pd(a, b, c); }
+    static Real Sqrt(const Real& a) { return _mm512_sqrt_pd(a); }
+    static Real Max(const Real& a, const Real& b) { return _mm512_max_pd(a, b); }
+    static Real Min(const Real& a, const Real& b) { return _mm512_min_pd(a, b); }
+    static Real Floor(const Real& a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    static Real Gather(const double* base, const Real& index) { return _mm512_i32gather_pd(_mm512_cvttpd_epi32(index), base, 8); }
+
+    // Comparisons and blends
+    static Mask Less(const Real& a, const Real& b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static Mask Equal(const Real& a, const Real& b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    static Mask MaskOr(const Mask& a, const Mask& b) { return static_cast<Mask>(a | b); }
+    static Mask MaskAnd(const Mask& a, const Mask& b) { return static_cast<Mask>(a & b); }
+    static bool Any(const Mask& m) { return m != 0; }
+    static Real Select(const Mask& m, const Real& a, const Real& b) { return _mm512_mask_blend_pd(m, b, a); }
+
+    // Int lanes
+    static Int SetInt(const std::uint64_t& x) { return _mm512_set1_epi64(static_cast<long long>(x)); }
+    static Int Sequence(const std::uint64_t& first)
+    {
+        return _mm512_add_epi64(SetInt(first), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+    }
+    static Int AddInt(const Int& a, const Int& b) { return _mm512_add_epi64(a, b); }
+    static Int SubInt(const Int& a, const Int& b) { return _mm512_sub_epi64(a, b); }
+    static Int And(const Int& a, const Int& b) { return _mm512_and_si512(a, b); }
+    static Int Or(const Int& a, const Int& b) { return _mm512_or_si512(a, b); }
+    static Int Xor(const Int& a, const Int& b) { return _mm512_xor_si512(a, b); }
+    template <int n> static Int ShiftLeft(const Int& a) { return _mm512_slli_epi64(a, n); }
+    template <int n> static Int ShiftRight(const Int& a) { return _mm512_srli_epi64(a, n); }
+    static Int MulLow32(const Int& a, const Int& b) { return _mm512_mul_epu32(a, b); }
+
+    // Bit reinterpretation
+    static Real CastToReal(const Int& a) { return _mm512_castsi512_pd(a); }
+    static Int CastToInt(const Real& a) { return _mm512_castpd_si512(a); }
+};
+
+// Define Avx512FloatVector traits, sixteen float lanes
+struct Avx512FloatVector
+{
+    typedef __m512 Real;
+    typedef __m512i Int;
+    typedef __mmask16 Mask;
+    typedef float Element;
+
+    static const int width = 16;
+    static constexpr float min_normal = FLT_MIN;
+
+    // Real lanes
+    static Real Set(const double& x) { return _mm512_set1_ps(static_cast<float>(x)); }
+    static Real Load(const float* p) { return _mm512_loadu_ps(p); }
+    static void Store(float* p, const Real& x) { _mm512_storeu_ps(p, x); }
+    static Real Add(const Real& a, const Real& b) { return _mm512_add_ps(a, b); }
+    static Real Sub(const Real& a, const Real& b) { return _mm512_sub_ps(a, b); }
+    static Real Mul(const Real& a, const Real& b) { return _mm512_mul_ps(a, b); }
+    static Real Div(const Real& a, const Real& b) { return _mm512_div_ps(a, b); }
+    static Real MulAdd(const Real& a, const Real& b, const Real& c) { return _mm512_fmadd_ps(a, b, c); }
+    static Real Sqrt(const Real& a) { return _mm512_sqrt_ps(a); }
+    static Real Max(const Real& a, const Real& b) { return _mm512_max_ps(a, b); }
+    static Real Min(const Real& a, const Real& b) { return _mm512_min_ps(a, b); }
+
+    // Comparisons and blends
+    static Mask Less(const Real& a, const Real& b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static bool Any(const Mask& m) { return m != 0; }
+    static Real Select(const Mask& m, const Real& a, const Real& b) { return _mm512_mask_blend_ps(m, b, a); }
+
+    // Int lanes
+    static Int SetInt(const std::uint32_t& x) { return _mm512_set1_epi32(static_cast<int>(x)); }
+    static Int Sequence(const std::uint32_t& first)
+    {
+        return _mm512_add_epi32(SetInt(first), _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+    }
+    static Int AddInt(const Int& a, const Int& b) { return _mm512_add_epi32(a, b); }
+    static Int SubInt(const Int& a, const Int& b) { return _mm512_sub_epi32(a, b); }
+    static Int And(const Int& a, const Int& b) { return _mm512_and_si512(a, b); }
+    static Int Or(const Int& a, const Int& b) { return _mm512_or_si512(a, b); }
+    static Int Xor(const Int& a, const Int& b) { return _mm512_xor_si512(a, b); }
+    template <int n> static Int ShiftLeft(const Int& a) { return _mm512_slli_epi32(a, n); }
+    template <int n> static Int ShiftRight(const Int& a) { return _mm512_srli_epi32(a, n); }
+    static void MulWide32(const Int& a, const Int& b, Int& hi, Int& lo)
+    {
+        const Int even = _mm512_mul_epu32(a, b);
+        const Int odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+        hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+        lo = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+    }
+    static Real ConvertToReal(const Int& a) { return _mm512_cvtepi32_ps(a); }
+
+    // Bit reinterpretation
+    static Real CastToReal(const Int& a) { return _mm512_castsi512_ps(a); }
+    static Int CastToInt(const Real& a) { return _mm512_castps_si512(a); }
+};
+#endif
+
+// End of the conditional inclusion of the header file
+#endif
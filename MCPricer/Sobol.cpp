@@ -0,0 +1,154 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Sobol.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the Owen-scrambled Sobol low-discrepancy sequence
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "Sobol.hpp"
+
+namespace
+{
+    // Number of dimensions (after the first) with Joe - Kuo initial direction numbers
+    const unsigned int joe_kuo_dimensions = 20;
+
+    // Joe - Kuo initial direction numbers m_1 ... m_s of dimensions 2 to 21, in primitive polynomial order
+    const std::uint32_t joe_kuo_m[joe_kuo_dimensions][7] =
+    {
+        { 1 },
+        { 1, 3 },
+        { 1, 3, 1 },
+        { 1, 1, 1 },
+        { 1, 1, 3, 3 },
+        { 1, 3, 5, 13 },
+        { 1, 1, 5, 5, 17 },
+        { 1, 1, 5, 5, 5 },
+        { 1, 1, 7, 11, 19 },
+        { 1, 1, 5, 1, 1 },
+        { 1, 1, 1, 3, 11 },
+        { 1, 3, 5, 5, 31 },
+        { 1, 3, 3, 9, 7, 49 },
+        { 1, 1, 1, 15, 21, 21 },
+        { 1, 3, 1, 13, 27, 49 },
+        { 1, 1, 1, 15, 7, 5 },
+        { 1, 3, 1, 15, 13, 25 },
+        { 1, 1, 5, 5, 19, 61 },
+        { 1, 3, 7, 11, 23, 15, 103 },
+        { 1, 3, 7, 13, 13, 15, 69 }
+    };
+
+    // SplitMix64 hash, used for the initial direction numbers beyond the Joe - Kuo table
+    std::uint64_t SplitMix64(std::uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // Multiply two polynomials over GF(2) modulo poly of the given degree
+    std::uint64_t MulMod(std::uint64_t a, std::uint64_t b, const std::uint64_t& poly, const unsigned int& degree)
+    {
+        std::uint64_t result = 0;
+        while (b)
+        {
+            if (b & 1) result ^= a;
+            b >>= 1;
+            a <<= 1;
+            if ((a >> degree) & 1) a ^= poly;
+        }
+        return result;
+    }
+
+    // Raise x to the power e modulo poly
+    std::uint64_t PowX(std::uint64_t e, const std::uint64_t& poly, const unsigned int& degree)
+    {
+        std::uint64_t result = 1;
+        std::uint64_t base = (degree == 1) ? (2 ^ poly) : 2;
+        while (e)
+        {
+            if (e & 1) result = MulMod(result, base, poly, degree);
+            base = MulMod(base, base, poly, degree);
+            e >>= 1;
+        }
+        return result;
+    }
+
+    // A polynomial with non-zero constant term is primitive when x has order 2^degree - 1 modulo it
+    bool IsPrimitive(const std::uint64_t& poly, const unsigned int& degree)
+    {
+        const std::uint64_t order = (1ull << degree) - 1;
+        if (PowX(order, poly, degree) != 1)
+            return false;
+
+        // x^(order / p) must differ from 1 for every prime factor p of the order
+        std::uint64_t rest = order;
+        for (std::uint64_t p = 3; p * p <= rest; p += 2)
+        {
+            if (rest % p) continue;
+            if (PowX(order / p, poly, degree) == 1)
+                return false;
+            while (rest % p == 0) rest /= p;
+        }
+        if (rest > 1 && PowX(order / rest, poly, degree) == 1)
+            return false;
+
+        return true;
+    }
+}
+
+// Define the static constants, bound to references by the callers
+const unsigned int SobolSequence::bits_per_coordinate;
+const unsigned int SobolSequence::max_dimension;
+
+// Constructor
+SobolSequence::SobolSequence(const unsigned int& dimensions) :
+    m_direction(dimensions * bits_per_coordinate, 0),
+    m_dimensions(dimensions)
+{
+    if (dimensions == 0 || dimensions > max_dimension)
+        throw std::invalid_argument("SobolSequence: the number of dimensions must be between 1 and "
+            + std::to_string(max_dimension));
+
+    // The first dimension is the van der Corput sequence in base 2
+    for (unsigned int k = 0; k < bits_per_coordinate; ++k)
+        m_direction[k] = 1u << (bits_per_coordinate - 1 - k);
+
+    // Every further dimension takes the next primitive polynomial x^s + a_1 x^(s - 1) + ... + a_(s - 1) x + 1,
+    // ordered by degree and then by its coefficients as Joe - Kuo do
+    unsigned int d = 1;
+    for (unsigned int s = 1; d < dimensions; ++s)
+    {
+        for (std::uint64_t poly = (1ull << s) | 1; poly < (2ull << s) && d < dimensions; poly += 2)
+        {
+            if (!IsPrimitive(poly, s))
+                continue;
+
+            std::uint32_t* v = m_direction.data() + d * bits_per_coordinate;
+
+            // Initial direction numbers: odd m_k < 2^k, v_k = m_k / 2^k
+            for (unsigned int k = 0; k < s && k < bits_per_coordinate; ++k)
+            {
+                std::uint32_t m;
+                if (d - 1 < joe_kuo_dimensions)
+                    m = joe_kuo_m[d - 1][k];
+                else
+                    m = static_cast<std::uint32_t>(SplitMix64((static_cast<std::uint64_t>(d) << 6) | k)
+                        & ((1ull << (k + 1)) - 1)) | 1u;
+
+                v[k] = m << (bits_per_coordinate - 1 - k);
+            }
+
+            // Recurrence v_k = a_1 v_(k - 1) ^ ... ^ a_(s - 1) v_(k - s + 1) ^ v_(k - s) ^ (v_(k - s) >> s)
+            for (unsigned int k = s; k < bits_per_coordinate; ++k)
+            {
+                v[k] = v[k - s] ^ (v[k - s] >> s);
+                for (unsigned int j = 1; j < s; ++j)
+                    if ((poly >> (s - j)) & 1) v[k] ^= v[k - j];
+            }
+
+            ++d;
+        }
+    }
+}
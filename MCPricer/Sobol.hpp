@@ -0,0 +1,102 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Sobol.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the Owen-scrambled Sobol low-discrepancy sequence
+
+// If SOBOL_HPP is not defined
+#ifndef SOBOL_HPP
+// Define SOBOL_HPP
+#define SOBOL_HPP
+
+#include <cstdint>
+#include <vector>
+
+// Define SobolSequence class
+// The first 21 dimensions use the Joe - Kuo (new-joe-kuo-6.21201) direction numbers. Every further dimension uses
+// the next primitive polynomial over GF(2), found at construction, with odd initial direction numbers drawn
+// from a fixed hash, so no external data file is needed
+class SobolSequence
+{
+private:
+
+    // Declare the direction numbers, bits_per_coordinate words per dimension
+    std::vector<std::uint32_t> m_direction;
+    unsigned int m_dimensions;
+
+public:
+
+    // Number of bits of every coordinate, the sequence has 2^32 points
+    static const unsigned int bits_per_coordinate = 32;
+
+    // Largest number of dimensions supported, enough for 4096 Brownian-bridge subintervals
+    static const unsigned int max_dimension = 4096;
+
+    // Constructor
+    explicit SobolSequence(const unsigned int& dimensions);
+
+    // Get the direction numbers of a dimension
+    const std::uint32_t* direction(const unsigned int& dimension) const
+    {
+        return m_direction.data() + dimension * bits_per_coordinate;
+    }
+
+    // Get the number of dimensions
+    const unsigned int& dimensions() const { return m_dimensions; }
+
+    // Get coordinate dimension of the point of index n in Gray-code order
+    // Consecutive points differ by one direction number: x(n + 1) = x(n) ^ v[ctz(n + 1)]
+    std::uint32_t Point(const std::uint64_t& n, const unsigned int& dimension) const
+    {
+        const std::uint32_t* v = direction(dimension);
+        const std::uint64_t gray = n ^ (n >> 1);
+
+        std::uint32_t x = 0;
+        for (unsigned int k = 0; k < bits_per_coordinate; ++k)
+            if ((gray >> k) & 1) x ^= v[k];
+
+        return x;
+    }
+
+    // Get the first dimensions coordinates of the next point of the Gray-code order in place,
+    // n is the index of the current point
+    void Next(const std::uint64_t& n, std::uint32_t* x, const unsigned int& dimensions) const
+    {
+        // Index of the bit that changes in the Gray code of n + 1
+        unsigned int k = 0;
+        while (((n + 1) >> k & 1) == 0) ++k;
+
+        for (unsigned int d = 0; d < dimensions; ++d)
+            x[d] ^= m_direction[d * bits_per_coordinate + k];
+    }
+
+    // Owen (nested uniform) scrambling of a coordinate with the Laine - Karras hash (Burley 2020)
+    // Every seed gives an independent randomization that keeps the net properties of the sequence
+    static std::uint32_t Scramble(const std::uint32_t& x, const std::uint32_t& seed)
+    {
+        std::uint32_t y = ReverseBits(x);
+
+        y += seed;
+        y ^= y * 0x6C50B47Cu;
+        y ^= y * 0xB82F1E52u;
+        y ^= y * 0xC7AFE638u;
+        y ^= y * 0x8D22F6E6u;
+
+        return ReverseBits(y);
+    }
+
+    // Map a coordinate to the centre of its cell, a uniform in (0, 1)
+    static double Uniform(const std::uint32_t& x) { return (x + 0.5) * (1.0 / 4294967296.0); }
+
+    // Reverse the bits of a 32-bit word
+    static std::uint32_t ReverseBits(std::uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+        x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+};
+
+// End of the conditional inclusion of the header file
+#endif
@@ -0,0 +1,137 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// SobolKernel.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the quasi-Monte Carlo path kernels (scrambled Sobol points)
+
+#include <cstdint>
+#include <vector>
+#include "BrownianBridge.hpp"
+#include "InverseNormal.hpp"
+#include "Models.hpp"
+#include "PathKernel.hpp"
+#include "SimdMath.hpp"
+#include "SimdVector.hpp"
+#include "Sobol.hpp"
+
+namespace
+{
+    // Get the direction numbers, built once for every dimension the kernels may need
+    const SobolSequence& Sequence()
+    {
+        static const SobolSequence sequence(SobolSequence::max_dimension);
+        return sequence;
+    }
+
+    // Derive the scrambling seed of a dimension from the seed of the replicate
+    std::uint32_t DimensionSeed(const unsigned long long& seed, const unsigned int& dimension)
+    {
+        std::uint64_t x = seed + 0x9E3779B97F4A7C15ull * (dimension + 1);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<std::uint32_t>((x ^ (x >> 31)) >> 32);
+    }
+
+    // Simulate paths [first_path, first_path + n_paths) from consecutive Sobol points, one dimension per subinterval
+    // The normals are assigned to the subintervals in Brownian-bridge order; params.seed selects the scrambling
+    template <class Step>
+    void SimulateTerminalSobol(const KernelParams& params, const long& first_path, const long& n_paths,
+        const PathBuffers& out)
+    {
+        typedef ScalarVector V;
+
+        const SobolSequence& sobol = Sequence();
+        const unsigned int dimensions = static_cast<unsigned int>(params.steps);
+        const BrownianBridge bridge(params.steps);
+
+        // Define the buffers of one path: Sobol coordinates, scrambling seeds, normals, increments and bridge work
+        std::vector<std::uint32_t> x(dimensions);
+        std::vector<std::uint32_t> seeds(dimensions);
+        std::vector<double> z(dimensions);
+        std::vector<double> dz(dimensions);
+        std::vector<double> work(dimensions);
+
+        for (unsigned int d = 0; d < dimensions; ++d)
+        {
+            x[d] = sobol.Point(first_path, d);
+            seeds[d] = DimensionSeed(params.seed, d);
+        }
+
+        for (long i = 0; i < n_paths; ++i)
+        {
+            // Move to the next point of the Gray-code order
+            if (i) sobol.Next(first_path + i - 1, x.data(), dimensions);
+
+            // Scramble every coordinate and map it to a normal, then order the normals in time
+            for (unsigned int d = 0; d < dimensions; ++d)
+                z[d] = InverseCumulativeNormal(SobolSequence::Uniform(SobolSequence::Scramble(x[d], seeds[d])));
+            bridge.Increments(z.data(), dz.data(), work.data());
+
+            // Step the path and, on the same increments, its antithetic and GBM control paths
+            double s = params.S;
+            double sa = params.S;
+            double sc = params.S;
+            double sca = params.S;
+            for (long k = 0; k < params.steps; ++k)
+            {
+                s = Step::template Advance<V>(s, dz[k], params.drift_const, params.diffusion_const, params.beta);
+                if (out.antithetic)
+                    sa = Step::template Advance<V>(sa, -dz[k], params.drift_const, params.diffusion_const, params.beta);
+                if (out.control)
+                    sc = LogNormalStep::Advance<V>(sc, dz[k], params.control_drift, params.control_diffusion, params.beta);
+                if (out.control_antithetic)
+                    sca = LogNormalStep::Advance<V>(sca, -dz[k], params.control_drift, params.control_diffusion, params.beta);
+            }
+
+            out.terminal[i] = s;
+            if (out.antithetic) out.antithetic[i] = sa;
+            if (out.control) out.control[i] = sc;
+            if (out.control_antithetic) out.control_antithetic[i] = sca;
+        }
+    }
+
+    // Sample the terminal spots of GBM exactly from the first Sobol dimension
+    void SimulateTerminalSobolExact(const KernelParams& params, const long& first_path, const long& n_paths,
+        const PathBuffers& out)
+    {
+        typedef ScalarVector V;
+
+        const SobolSequence& sobol = Sequence();
+        const std::uint32_t seed = DimensionSeed(params.seed, 0);
+        std::uint32_t x = sobol.Point(first_path, 0);
+
+        for (long i = 0; i < n_paths; ++i)
+        {
+            if (i) sobol.Next(first_path + i - 1, &x, 1);
+
+            // ST = S0 * exp((r - sigma^2 / 2) * T + sigma * sqrt(T) * Z)
+            const double z = InverseCumulativeNormal(SobolSequence::Uniform(SobolSequence::Scramble(x, seed)));
+            out.terminal[i] = params.S * SimdMath<V>::Exp(params.drift_const + params.diffusion_const * z);
+            if (out.antithetic) out.antithetic[i] = params.S * SimdMath<V>::Exp(params.drift_const - params.diffusion_const * z);
+            if (out.control) out.control[i] = out.terminal[i];
+            if (out.control_antithetic) out.control_antithetic[i] = out.antithetic[i];
+        }
+    }
+
+    // Build the table of quasi-Monte Carlo kernels
+    PathKernels MakeSobolKernels()
+    {
+        // The Greeks kernels are not available for quasi-Monte Carlo
+        PathKernels kernels = PathKernels();
+
+        kernels.euler[static_cast<int>(ModelType::GBM)] = SimulateTerminalSobol<EulerStep<GBMModel> >;
+        kernels.euler[static_cast<int>(ModelType::Sqrt)] = SimulateTerminalSobol<EulerStep<SqrtModel> >;
+        kernels.euler[static_cast<int>(ModelType::Quadratic)] = SimulateTerminalSobol<EulerStep<QuadraticModel> >;
+        kernels.euler[static_cast<int>(ModelType::CEV)] = SimulateTerminalSobol<EulerStep<CEVModel> >;
+        kernels.exact_steps = SimulateTerminalSobol<LogNormalStep>;
+        kernels.exact_terminal = SimulateTerminalSobolExact;
+
+        return kernels;
+    }
+}
+
+// Get the table of quasi-Monte Carlo kernels
+const PathKernels& PathKernelsSobol()
+{
+    static const PathKernels kernels = MakeSobolKernels();
+    return kernels;
+}
@@ -0,0 +1,99 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// Statistics.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the running sample statistics of the Monte Carlo estimators
+
+// If STATISTICS_HPP is not defined
+#ifndef STATISTICS_HPP
+// Define STATISTICS_HPP
+#define STATISTICS_HPP
+
+// Variance-reduction techniques of the Monte Carlo estimator
+enum class VarianceReduction
+{
+    // Plain Monte Carlo
+    None,
+    // Antithetic paths: every normal draw Z is also used as -Z and the two payoffs are averaged
+    Antithetic,
+    // Control variate on the terminal spot, whose expectation is known for the simulated scheme
+    SpotControl,
+    // Control variate on the payoff of a GBM path driven by the same normals, whose expectation is the BSM price
+    BSMControl,
+    // Moment matching: the terminal spots are rescaled so their sample mean equals the expected terminal spot
+    MomentMatching
+};
+
+// Define SampleStatistics struct, the running moments of a sample x and of an optional control variate y
+// Welford's updates keep the means and centred sums accurate for any number of samples, and Chan's formulas merge
+// the statistics of disjoint sets of samples, such as those of every thread or batch
+struct SampleStatistics
+{
+    // Number of samples
+    double n;
+    // Means of x and y
+    double mean_x;
+    double mean_y;
+    // Sums of the squared deviations of x and y, and of the products of their deviations
+    double m2_x;
+    double m2_y;
+    double c_xy;
+
+    SampleStatistics() : n(0.0), mean_x(0.0), mean_y(0.0), m2_x(0.0), m2_y(0.0), c_xy(0.0) {}
+
+    // Add a sample without control variate
+    void Add(const double& x)
+    {
+        n += 1.0;
+        const double dx = x - mean_x;
+        mean_x += dx / n;
+        m2_x += dx * (x - mean_x);
+    }
+
+    // Add a sample with its control variate
+    void Add(const double& x, const double& y)
+    {
+        n += 1.0;
+        const double dx = x - mean_x;
+        const double dy = y - mean_y;
+        mean_x += dx / n;
+        mean_y += dy / n;
+        m2_x += dx * (x - mean_x);
+        m2_y += dy * (y - mean_y);
+        c_xy += dx * (y - mean_y);
+    }
+
+    // Merge the statistics of another set of samples
+    void Merge(const SampleStatistics& other)
+    {
+        if (other.n == 0.0) return;
+        if (n == 0.0)
+        {
+            *this = other;
+            return;
+        }
+
+        const double total = n + other.n;
+        const double dx = other.mean_x - mean_x;
+        const double dy = other.mean_y - mean_y;
+        const double weight = n * other.n / total;
+
+        mean_x += dx * other.n / total;
+        mean_y += dy * other.n / total;
+        m2_x += other.m2_x + dx * dx * weight;
+        m2_y += other.m2_y + dy * dy * weight;
+        c_xy += other.c_xy + dx * dy * weight;
+        n = total;
+    }
+
+    // Sample means
+    double MeanX() const { return mean_x; }
+    double MeanY() const { return mean_y; }
+
+    // Unbiased sample variances and covariance
+    double VarianceX() const { return m2_x / (n - 1.0); }
+    double VarianceY() const { return m2_y / (n - 1.0); }
+    double Covariance() const { return c_xy / (n - 1.0); }
+};
+
+// End of the conditional inclusion of the header file
+#endif
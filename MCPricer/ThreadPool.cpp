@@ -0,0 +1,224 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// ThreadPool.cpp
+// lvaro Snchez de Carlos
+// Description: this file contains the source code of the persistent work-stealing thread pool
+
+#include <algorithm>
+#include "ThreadPool.hpp"
+
+namespace
+{
+    // Pool and index of the worker running on this thread, so nested jobs are queued on the worker submitting them
+    thread_local ThreadPool* current_pool = 0;
+    thread_local std::size_t current_worker = 0;
+}
+
+// Constructor
+ThreadPool::ThreadPool(const unsigned int& threads) :
+    m_queued(0),
+    m_next_worker(0),
+    m_stop(false)
+{
+    for (unsigned int i = 0; i < threads; ++i)
+        m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+    // Start the threads once every queue exists, since any of them may steal from all the others
+    for (unsigned int i = 0; i < threads; ++i)
+        m_threads.push_back(std::thread(&ThreadPool::Run, this, static_cast<std::size_t>(i)));
+}
+
+// Destructor
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+// Get the pool shared by every pricer
+ThreadPool& ThreadPool::Global()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+// Get the default number of workers
+unsigned int ThreadPool::DefaultThreads()
+{
+    const unsigned int hardware = std::thread::hardware_concurrency();
+    return (hardware > 1) ? hardware - 1 : 0;
+}
+
+// Queue a ticket on a worker
+void ThreadPool::Push(const std::size_t& worker, const std::shared_ptr<Job>& job, const bool& hot)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_workers[worker]->mutex);
+        std::deque<std::shared_ptr<Job>>& queue = m_workers[worker]->queue[static_cast<int>(job->priority)];
+
+        if (hot)
+            queue.push_back(job);
+        else
+            queue.push_front(job);
+    }
+
+    // Count the ticket under the pool mutex, so a worker checking the count before sleeping cannot miss it
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_queued;
+    }
+    m_wake.notify_one();
+}
+
+// Take the ticket of highest priority
+bool ThreadPool::Pop(const std::size_t& worker, std::shared_ptr<Job>& job)
+{
+    const std::size_t n_workers = m_workers.size();
+
+    for (int priority = 0; priority < 3; ++priority)
+    {
+        // Look at the own queue first, then steal from the others starting with the next worker
+        for (std::size_t k = 0; k < n_workers; ++k)
+        {
+            const std::size_t victim = (worker + k) % n_workers;
+            std::lock_guard<std::mutex> lock(m_workers[victim]->mutex);
+            std::deque<std::shared_ptr<Job>>& queue = m_workers[victim]->queue[priority];
+
+            if (queue.empty()) continue;
+
+            // The own queue is taken from the hot end, the stolen tickets from the cold end
+            if (k == 0)
+            {
+                job = queue.back();
+                queue.pop_back();
+            }
+            else
+            {
+                job = queue.front();
+                queue.pop_front();
+            }
+
+            --m_queued;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Claim and run the next chunk of a job
+bool ThreadPool::RunChunk(Job& job)
+{
+    const long chunk = job.next.fetch_add(1);
+    if (chunk >= job.n_chunks)
+        return false;
+
+    // Skip the body once a chunk has failed, the chunk still counts as finished
+    if (!job.failed.load())
+    {
+        try
+        {
+            job.body(chunk);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (!job.failed.exchange(true))
+                job.exception = std::current_exception();
+        }
+    }
+
+    // The thread finishing the last chunk wakes the thread waiting for the job
+    if (--job.remaining == 0)
+    {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.done = true;
+        job.finished.notify_all();
+    }
+
+    return true;
+}
+
+// Loop of every worker thread
+void ThreadPool::Run(const std::size_t& worker)
+{
+    current_pool = this;
+    current_worker = worker;
+
+    for (;;)
+    {
+        std::shared_ptr<Job> job;
+
+        if (Pop(worker, job))
+        {
+            // Run one chunk and send the ticket back to the cold end, behind the tickets of the other jobs
+            if (RunChunk(*job) && job->next.load() < job->n_chunks)
+                Push(worker, job, false);
+            continue;
+        }
+
+        // Sleep until a ticket is queued or the pool stops
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this]() { return m_stop || m_queued.load() > 0; });
+
+        if (m_stop)
+            return;
+    }
+}
+
+// Submit a loop without waiting for it
+std::shared_ptr<ThreadPool::Job> ThreadPool::Submit(const long& n_chunks, const std::function<void(long)>& body,
+    const Priority& priority)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->body = body;
+    job->n_chunks = std::max(n_chunks, 0L);
+    job->priority = priority;
+    job->next = 0;
+    job->remaining = job->n_chunks;
+    job->failed = false;
+    job->done = job->n_chunks == 0;
+
+    // One ticket per worker at most, the waiting thread makes up for the last one
+    const long n_workers = static_cast<long>(m_workers.size());
+    const long tickets = std::min(job->n_chunks - 1, n_workers);
+
+    for (long t = 0; t < tickets; ++t)
+    {
+        // A worker keeps the first ticket of its nested jobs, the others are spread round-robin
+        const bool nested = current_pool == this;
+        const std::size_t worker = (nested && t == 0) ? current_worker : m_next_worker++ % m_workers.size();
+        Push(worker, job, true);
+    }
+
+    return job;
+}
+
+// Wait for a job
+void ThreadPool::Wait(const std::shared_ptr<Job>& job)
+{
+    // Help with the chunks nobody has claimed yet
+    while (RunChunk(*job))
+    {
+    }
+
+    // Wait for the chunks still running on the workers
+    {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->finished.wait(lock, [&job]() { return job->done; });
+    }
+
+    if (job->exception)
+        std::rethrow_exception(job->exception);
+}
+
+// Submit a loop and wait for it
+void ThreadPool::ParallelFor(const long& n_chunks, const std::function<void(long)>& body, const Priority& priority)
+{
+    Wait(Submit(n_chunks, body, priority));
+}
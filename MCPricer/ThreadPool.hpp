@@ -0,0 +1,123 @@
+// (C++) Monte Carlo Option Pricer with Euler - Maruyama Discretization
+// ThreadPool.hpp
+// lvaro Snchez de Carlos
+// Description: this file contains the header code of the persistent work-stealing thread pool
+
+// If THREADPOOL_HPP is not defined
+#ifndef THREADPOOL_HPP
+// Define THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Priorities of the jobs of the pool, every ready chunk of a higher priority runs before any chunk of a lower one
+enum class Priority
+{
+    High,
+    Normal,
+    Low
+};
+
+// Define ThreadPool class, a long-lived set of workers that run the chunks of many jobs at once
+// A job is a loop over n_chunks independent chunks. It is queued as a few tickets, each one running a chunk and
+// going back to the cold end of its queue while chunks are left, so the chunks of concurrent jobs interleave.
+// Workers take the tickets of their own queue from the hot end and steal from the cold end of the others.
+// The thread waiting for a job runs chunks of that job too, so nested jobs neither deadlock nor oversubscribe
+class ThreadPool
+{
+public:
+
+    // Define Job struct, the state of a loop shared by its tickets and the thread waiting for it
+    struct Job
+    {
+        // Loop body and number of chunks
+        std::function<void(long)> body;
+        long n_chunks;
+        Priority priority;
+        // Next chunk to claim and chunks not finished yet
+        std::atomic<long> next;
+        std::atomic<long> remaining;
+        // First exception thrown by the body, the chunks claimed after it are skipped
+        std::atomic<bool> failed;
+        std::exception_ptr exception;
+        // Completion flag, set by the thread finishing the last chunk
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done;
+    };
+
+private:
+
+    // Define Worker struct, the ticket queues of a worker, one per priority
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Job>> queue[3];
+    };
+
+    // Declare private member variables
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::atomic<long> m_queued;
+    std::atomic<std::size_t> m_next_worker;
+    bool m_stop;
+
+    // Declare Push private function, queueing a ticket on a worker, at the hot end for new tickets
+    void Push(const std::size_t& worker, const std::shared_ptr<Job>& job, const bool& hot);
+
+    // Declare Pop private function, taking the ticket of highest priority from the own queue or stolen from another
+    bool Pop(const std::size_t& worker, std::shared_ptr<Job>& job);
+
+    // Declare RunChunk private function, claiming and running the next chunk of a job; false when none is left
+    static bool RunChunk(Job& job);
+
+    // Declare Run private function, the loop of every worker thread
+    void Run(const std::size_t& worker);
+
+public:
+
+    // Constructor, the default leaves one core to the threads that submit and wait for the jobs
+    explicit ThreadPool(const unsigned int& threads = DefaultThreads());
+
+    // Destructor, stopping and joining the workers
+    ~ThreadPool();
+
+    // The workers keep a pointer to the pool, which can be neither copied nor assigned
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Get the pool shared by every pricer, created on first use
+    static ThreadPool& Global();
+
+    // Get the default number of workers, one less than the hardware threads
+    static unsigned int DefaultThreads();
+
+    // Submit a loop over n_chunks chunks without waiting for it, the workers get one ticket less than the chunks
+    // (none without workers), so every job must be passed to Wait, which runs the chunks left
+    std::shared_ptr<Job> Submit(const long& n_chunks, const std::function<void(long)>& body,
+        const Priority& priority = Priority::Normal);
+
+    // Wait for a job, running its unclaimed chunks on the calling thread, and rethrow the first exception of its body
+    void Wait(const std::shared_ptr<Job>& job);
+
+    // Submit a loop and wait for it, body(c) is called once for every chunk c in [0, n_chunks)
+    void ParallelFor(const long& n_chunks, const std::function<void(long)>& body,
+        const Priority& priority = Priority::Normal);
+
+    // Get the number of worker threads
+    std::size_t size() const { return m_threads.size(); }
+};
+
+// End of the conditional inclusion of the header file
+#endif